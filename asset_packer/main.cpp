@@ -0,0 +1,97 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// Packs asset files into a single memory mapped asset pack.
+// Directories are packed recursively. Entries are named by the paths
+// as specified, so run it from the directory the game loads files from.
+// usage: asset_packer [-z] pack_file path...
+//   -z  deflate the entries that shrink well
+
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "engine/arctic_platform.h"
+#include "engine/asset_pack.h"
+#include "engine/log.h"
+
+using namespace arctic;  // NOLINT
+
+namespace {
+
+void AddPath(const std::string &path, std::vector<std::string> *out_files) {
+  if (DoesDirectoryExist(path.c_str()) != kTrivalentTrue) {
+    out_files->push_back(path);
+    return;
+  }
+  std::deque<DirectoryEntry> entries;
+  if (!GetDirectoryEntries(path.c_str(), &entries)) {
+    std::fprintf(stderr, "Can't list the directory: %s\n", path.c_str());
+    return;
+  }
+  const std::string prefix = (path.empty() || path.back() == '/') ?
+    path : path + '/';
+  for (const DirectoryEntry &entry : entries) {
+    if (entry.title == "." || entry.title == "..") {
+      continue;
+    }
+    if (entry.is_directory == kTrivalentTrue) {
+      AddPath(prefix + entry.title, out_files);
+    } else if (entry.is_file == kTrivalentTrue) {
+      out_files->push_back(prefix + entry.title);
+    }
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  bool is_compressed = false;
+  int arg = 1;
+  if (arg < argc && std::strcmp(argv[arg], "-z") == 0) {
+    is_compressed = true;
+    ++arg;
+  }
+  if (argc - arg < 2) {
+    std::fprintf(stderr, "usage: asset_packer [-z] pack_file path...\n");
+    return 1;
+  }
+  const char *pack_file_name = argv[arg];
+  std::vector<std::string> file_names;
+  for (++arg; arg < argc; ++arg) {
+    AddPath(argv[arg], &file_names);
+  }
+
+  StartLogger();
+  const bool is_ok = WriteAssetPack(pack_file_name, file_names,
+    is_compressed);
+  StopLogger();
+  if (!is_ok) {
+    std::fprintf(stderr, "Can't create the asset pack, see log.txt\n");
+    return 1;
+  }
+  std::printf("Packed %d files into %s\n",
+    static_cast<int>(file_names.size()), pack_file_name);
+  return 0;
+}
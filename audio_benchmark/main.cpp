@@ -0,0 +1,147 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// Renders the sound mixer offline and reports how fast it mixes.
+// Needs no window and no sound device, so it runs on headless CI boxes.
+// usage: audio_benchmark [voices] [seconds] [file.ogg]
+
+#define _USE_MATH_DEFINES
+#include <algorithm>
+#include <chrono>  // NOLINT
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "engine/arctic_platform_sound.h"
+#include "engine/easy_sound.h"
+#include "engine/log.h"
+#include "engine/sound_offline_mixer.h"
+
+using namespace arctic;  // NOLINT
+
+namespace {
+
+enum class VoiceKind {
+  kWav,
+  k3d,
+  kOgg
+};
+
+Sound MakeToneSound(double duration_seconds, float freq) {
+  Sound sound;
+  sound.Create(duration_seconds);
+  Si16 *data = sound.RawData();
+  const Si32 size = sound.DurationSamples();
+  for (Si32 i = 0; i < size; ++i) {
+    const float t = static_cast<float>(i) / 44100.f;
+    const Si16 v = static_cast<Si16>(
+      std::sin(t * 2.f * static_cast<float>(M_PI) * freq) * 8000.f);
+    data[i * 2] = v;
+    data[i * 2 + 1] = v;
+  }
+  return sound;
+}
+
+void RunBenchmark(const char *name, VoiceKind kind, Si32 voice_count,
+    double seconds, const std::vector<Sound> &sounds,
+    OfflineSoundMixer *mixer) {
+  for (Si32 idx = 0; idx < voice_count; ++idx) {
+    const Sound &sound = sounds[static_cast<size_t>(idx) % sounds.size()];
+    if (kind == VoiceKind::k3d) {
+      const float angle = static_cast<float>(idx) * 0.7f;
+      StartSoundAtPosition(sound, 0.5f,
+        Vec3F(std::cos(angle) * 5.f, 0.f, std::sin(angle) * 5.f));
+    } else {
+      StartSound(sound, 0.5f);
+    }
+  }
+
+  std::vector<Si16> out(static_cast<size_t>(mixer->PeriodFrames()) * 2);
+  const Si32 period_count = static_cast<Si32>(
+    seconds * OfflineSoundMixer::kSampleRate / mixer->PeriodFrames());
+  const double period_ns = 1e9 * mixer->PeriodFrames() /
+    OfflineSoundMixer::kSampleRate;
+  // The first period picks the voices up and opens the decoders.
+  mixer->RenderPeriod(out.data());
+  double total_ns = 0.0;
+  double worst_ns = 0.0;
+  for (Si32 idx = 0; idx < period_count; ++idx) {
+    const auto begin = std::chrono::steady_clock::now();
+    mixer->RenderPeriod(out.data());
+    const auto end = std::chrono::steady_clock::now();
+    const double ns = static_cast<double>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - begin).count());
+    total_ns += ns;
+    worst_ns = std::max(worst_ns, ns);
+  }
+
+  for (const Sound &sound : sounds) {
+    StopSound(sound);
+  }
+  mixer->RenderPeriod(out.data());
+  mixer->RenderPeriod(out.data());
+
+  const double frames = static_cast<double>(period_count) *
+    mixer->PeriodFrames();
+  const double realtime_factor = period_ns * period_count /
+    std::max(total_ns, 1.0);
+  std::printf("%-12s %6d voices %10.2f ns/frame %10.1f voices/core"
+    " %8.1f%% underrun margin\n",
+    name, static_cast<int>(voice_count), total_ns / std::max(frames, 1.0),
+    realtime_factor * voice_count,
+    100.0 * (1.0 - worst_ns / period_ns));
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const Si32 voice_count = (argc > 1 ? std::atoi(argv[1]) : 64);
+  const double seconds = (argc > 2 ? std::atof(argv[2]) : 10.0);
+  const char *ogg_file_name = (argc > 3 ? argv[3] : nullptr);
+
+  StartLogger();
+  OfflineSoundMixer mixer(512);
+  std::printf("period %d frames, %.1f seconds of sound per run\n",
+    static_cast<int>(mixer.PeriodFrames()), seconds);
+
+  std::vector<Sound> tones;
+  for (Si32 idx = 0; idx < 4; ++idx) {
+    tones.push_back(MakeToneSound(seconds + 1.0, 220.f * (1.f + idx * 0.25f)));
+  }
+  RunBenchmark("wav", VoiceKind::kWav, voice_count, seconds, tones, &mixer);
+  RunBenchmark("3d", VoiceKind::k3d, voice_count, seconds, tones, &mixer);
+
+  if (ogg_file_name) {
+    std::vector<Sound> oggs(1);
+    oggs[0].Load(ogg_file_name, false);
+    RunBenchmark("ogg", VoiceKind::kOgg, voice_count, seconds, oggs, &mixer);
+    // The decode thread takes the decoding off the mixer thread.
+    SetSoundDecodeThread(true);
+    RunBenchmark("ogg+thread", VoiceKind::kOgg, voice_count, seconds, oggs,
+      &mixer);
+    SetSoundDecodeThread(false);
+  }
+
+  StopLogger();
+  return 0;
+}
@@ -259,9 +259,13 @@ void Render() {
     g_time_acc = 0.0;
   }
 
-  char fps_text[128];
-  snprintf(fps_text, sizeof(fps_text), u8"Mode: %s FPS: %.1F",
-      g_is_hw_enabled ? "Hardware" : "Sowfware", g_fps);
+  const HwSpriteBatchStats hw_stats = GetHwSpriteBatchStats();
+  char fps_text[192];
+  snprintf(fps_text, sizeof(fps_text),
+      u8"Mode: %s FPS: %.1F Batches: %lld Draw calls: %lld",
+      g_is_hw_enabled ? "Hardware" : "Sowfware", g_fps,
+      static_cast<long long>(hw_stats.batch_count),
+      static_cast<long long>(hw_stats.draw_call_count));
   g_font.Draw(fps_text, 0, ScreenSize().y - 1, kTextOriginTop);
 
   ShowFrame();
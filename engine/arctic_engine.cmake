@@ -0,0 +1,164 @@
+# Engine sources and platform libraries shared by the CMake projects that are
+# not generated by the wizard.
+#
+# Include it after project():
+#   set(ARCTIC_HEADLESS ON)   # optional, see below
+#   include(${CMAKE_SOURCE_DIR}/../engine/arctic_engine.cmake)
+#
+# It adds the engine definitions and include directories and sets:
+#   ARCTIC_ENGINE_SOURCES    engine sources to add to the executable
+#   ARCTIC_ENGINE_LIBRARIES  platform libraries to link the executable with
+#
+# ARCTIC_HEADLESS is for tools and benchmarks that have their own main() and
+# never open a window or a sound device. On Linux they are built from the
+# sources that need neither X11, OpenGL nor ALSA (sound mixing, files, asset
+# packs, logging, math, job queues), so they build on CI boxes without those
+# packages. Other platforms keep the file system in the windowing platform
+# file, so there headless targets still get the full engine, only without its
+# main().
+
+set(ARCTIC_ENGINE_DIR ${CMAKE_CURRENT_LIST_DIR})
+
+include_directories(${ARCTIC_ENGINE_DIR}/..)
+
+IF (ARCTIC_HEADLESS)
+  add_definitions(
+    -DARCTIC_NO_MAIN
+  )
+ENDIF (ARCTIC_HEADLESS)
+
+IF (ARCTIC_HEADLESS AND NOT APPLE AND NOT WIN32)
+  find_package(Threads REQUIRED)
+
+  add_definitions(
+    -DPLATFORM_LINUX
+  )
+
+  set(ARCTIC_ENGINE_SOURCES
+    ${ARCTIC_ENGINE_DIR}/arctic_math.cpp
+    ${ARCTIC_ENGINE_DIR}/arctic_mixer.cpp
+    ${ARCTIC_ENGINE_DIR}/arctic_platform_pi_byteorder.cpp
+    ${ARCTIC_ENGINE_DIR}/arctic_platform_pi_fatal.cpp
+    ${ARCTIC_ENGINE_DIR}/arctic_platform_pi_filesystem.cpp
+    ${ARCTIC_ENGINE_DIR}/arctic_sound.cpp
+    ${ARCTIC_ENGINE_DIR}/asset_pack.cpp
+    ${ARCTIC_ENGINE_DIR}/easy_files.cpp
+    ${ARCTIC_ENGINE_DIR}/easy_sound.cpp
+    ${ARCTIC_ENGINE_DIR}/easy_sound_instance.cpp
+    ${ARCTIC_ENGINE_DIR}/easy_sprite_instance.cpp
+    ${ARCTIC_ENGINE_DIR}/log.cpp
+    ${ARCTIC_ENGINE_DIR}/miniz.c
+    ${ARCTIC_ENGINE_DIR}/mtq_fixed_block_queue.cpp
+    ${ARCTIC_ENGINE_DIR}/mtq_spmc_array.cpp
+    ${ARCTIC_ENGINE_DIR}/quaternion.cpp
+    ${ARCTIC_ENGINE_DIR}/sound_handle.cpp
+    ${ARCTIC_ENGINE_DIR}/sound_mix_kernels.cpp
+    ${ARCTIC_ENGINE_DIR}/sound_offline_mixer.cpp
+    ${ARCTIC_ENGINE_DIR}/sound_stream.cpp
+    ${ARCTIC_ENGINE_DIR}/transform3f.cpp
+  )
+
+  set(ARCTIC_ENGINE_LIBRARIES
+    ${CMAKE_THREAD_LIBS_INIT}
+  )
+  return()
+ENDIF ()
+
+IF (APPLE)
+  FIND_LIBRARY(AUDIOTOOLBOX AudioToolbox)
+  FIND_LIBRARY(COREAUDIO CoreAudio)
+  FIND_LIBRARY(COREFOUNDATION CoreFoundation)
+  FIND_LIBRARY(COCOA Cocoa)
+  FIND_LIBRARY(GAMECONTROLLER GameController)
+  FIND_LIBRARY(OPENGL OpenGL)
+ELSE (APPLE)
+  find_package(ALSA REQUIRED)
+
+  find_library(EGL_LIBRARY NAMES EGL)
+  find_path(EGL_INCLUDE_DIR EGL/egl.h)
+  find_library(GLES_LIBRARY NAMES GLESv2)
+  find_path(GLES_INCLUDE_DIR GLES/gl.h)
+  IF (EGL_LIBRARY AND EGL_INCLUDE_DIR AND GLES_LIBRARY AND GLES_INCLUDE_DIR)
+    message(STATUS "GLES EGL mode")
+    set(EGL_MODE "EGL")
+  ELSE ()
+    message(STATUS "OPENGL GLX mode")
+  ENDIF()
+
+  IF (NOT EGL_MODE)
+    #only for opengl glx
+    set (OpenGL_GL_PREFERENCE "LEGACY")
+    find_package(OpenGL REQUIRED)
+  ENDIF (NOT EGL_MODE)
+
+  find_package(X11 REQUIRED)
+  find_package(Threads REQUIRED)
+ENDIF (APPLE)
+
+IF (APPLE)
+  add_definitions(
+    -DGL_SILENCE_DEPRECATION
+  )
+ELSE (APPLE)
+  IF (EGL_MODE)
+    #only for es egl
+    add_definitions(
+       -DPLATFORM_RPI
+    )
+  ELSE (EGL_MODE)
+    #only for opengl glx
+    add_definitions(
+       -DPLATFORM_LINUX
+    )
+  ENDIF (EGL_MODE)
+  add_definitions(
+   -DGLX
+   -DGL_GLEXT_PROTOTYPES
+  )
+ENDIF (APPLE)
+
+IF (EGL_MODE)
+  #only for  es egl
+  set (CMAKE_EXE_LINKER_FLAGS "${CMAKE_EXE_LINKER_FLAGS} -lGLESv2 -lEGL")
+ENDIF (EGL_MODE)
+
+IF (APPLE)
+file(GLOB ARCTIC_ENGINE_SOURCES
+    ${ARCTIC_ENGINE_DIR}/*.cpp
+    ${ARCTIC_ENGINE_DIR}/*.mm
+    ${ARCTIC_ENGINE_DIR}/*.c
+    ${ARCTIC_ENGINE_DIR}/*.h
+    ${ARCTIC_ENGINE_DIR}/*.hpp
+)
+ELSE (APPLE)
+file(GLOB ARCTIC_ENGINE_SOURCES
+    ${ARCTIC_ENGINE_DIR}/*.cpp
+    ${ARCTIC_ENGINE_DIR}/*.c
+    ${ARCTIC_ENGINE_DIR}/*.h
+    ${ARCTIC_ENGINE_DIR}/*.hpp
+)
+ENDIF (APPLE)
+file(GLOB ARCTIC_ENGINE_SOURCES_TO_REMOVE
+    ${ARCTIC_ENGINE_DIR}/arctic_platform_pi.cpp
+    ${ARCTIC_ENGINE_DIR}/byte_array.cpp
+    ${ARCTIC_ENGINE_DIR}/byte_array.h
+)
+list(REMOVE_ITEM ARCTIC_ENGINE_SOURCES ${ARCTIC_ENGINE_SOURCES_TO_REMOVE})
+
+IF (APPLE)
+set(ARCTIC_ENGINE_LIBRARIES
+  ${AUDIOTOOLBOX}
+  ${COREAUDIO}
+  ${COREFOUNDATION}
+  ${COCOA}
+  ${GAMECONTROLLER}
+  ${OPENGL}
+)
+ELSE (APPLE)
+set(ARCTIC_ENGINE_LIBRARIES
+  ${OPENGL_gl_LIBRARY}
+  ${X11_LIBRARIES}
+  ${CMAKE_THREAD_LIBS_INIT}
+  ${ALSA_LIBRARY}
+)
+ENDIF (APPLE)
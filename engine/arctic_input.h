@@ -259,13 +259,25 @@ struct InputMessage {
     kMouse = 1,
     kController = 2
   };
+  /// @brief Down state of every key, one bit per key code
+  struct KeyStateBits {
+    Ui32 bits[(kKeyCount + 31) / 32] = {0};
+
+    /// @brief Returns 1 if the key is down, 0 otherwise
+    Ui32 operator[](Si32 key_code) const {
+      return (bits[key_code >> 5] >> (key_code & 31)) & 1u;
+    }
+    void Set(Si32 key_code, bool is_down) {
+      const Ui32 mask = 1u << (key_code & 31);
+      bits[key_code >> 5] = (is_down ? (bits[key_code >> 5] | mask) :
+        (bits[key_code >> 5] & ~mask));
+    }
+  };
   struct Keyboard {
-    Ui32 state[kKeyCount] = {0};
+    KeyStateBits state;  // Key states after the message, set by the engine
     Ui32 key = 0;
     Ui32 key_state = 0;
     char characters[16]  = {0};
-    Ui32 queue[1024] = {0};
-    Ui32 queueLen = 0;
   };
   struct Mouse {
     Vec2F pos;
@@ -274,6 +286,7 @@ struct InputMessage {
   };
   struct Controller {
     Si32 controller_idx = 0;
+    Ui32 buttons = 0;  // Bit i is set while the button i is down
     float axis[kAxisCount] = {0};
   };
   Kind kind = kKeyboard;
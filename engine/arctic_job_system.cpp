@@ -0,0 +1,468 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "engine/arctic_job_system.h"
+
+#include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "engine/arctic_platform_fatal.h"
+#include "engine/mtq_mpmc_befsbfsp_allocator.h"
+#include "engine/mtq_mpsc_vinfarr.h"
+#include "engine/mtq_spmc_array.h"
+
+namespace arctic {
+
+static_assert(sizeof(Job) == Job::kSize, "Unexpected Job size");
+
+// Jobs pushed to a full queue run right away on the pushing thread.
+static const size_t kJobQueueSize = 4096;
+static const size_t kJobCacheSize = 64;
+
+// The owner thread pushes to its queue, the owner and the thieves pop.
+// The padding keeps the queues of different threads off the cache lines of
+// the other heap blocks, new does not align to 64 bytes before C++17.
+struct JobQueue {
+  JobQueue()
+    : jobs(kJobQueueSize) {
+  }
+  char padding_before[64];
+  SpmcArray<Job, false> jobs;
+  char padding_after[64];
+};
+
+static MpmcBestEffortFixedSizeBufferFixedSizePool<64, sizeof(Job)>
+  g_job_pool;
+static MpmcBestEffortFixedSizeBufferFixedSizePool<8, 4080>
+  g_main_thread_job_page_pool;
+static MpscVirtInfArray<Job*, TuneDeletePayloadFlag<false>,
+  TuneMemoryPoolFlag<true>> g_main_thread_jobs(&g_main_thread_job_page_pool);
+
+static std::mutex g_job_start_mutex;
+static std::atomic<bool> g_is_job_system_running = ATOMIC_VAR_INIT(false);
+// Set by SetJobSystemMainThread or StartJobSystem, or by the lazy start
+// if neither was called.
+static std::atomic<std::thread::id> g_main_thread_id;
+// Queue 0 belongs to the main thread, the rest to the workers.
+static std::vector<std::unique_ptr<JobQueue>> g_job_queues;
+static std::vector<std::thread> g_job_threads;
+
+// Jobs pushed by the threads that have no queue of their own.
+static std::mutex g_injected_jobs_mutex;
+static std::deque<Job*> g_injected_jobs;
+static std::atomic<Si32> g_injected_job_count = ATOMIC_VAR_INIT(0);
+
+// Jobs sitting in the queues, the workers sleep when it is 0.
+static std::atomic<Si64> g_queued_job_count = ATOMIC_VAR_INIT(0);
+static std::atomic<Si32> g_sleeping_worker_count = ATOMIC_VAR_INIT(0);
+static std::mutex g_job_sleep_mutex;
+static std::condition_variable g_job_sleep_condvar;
+static bool g_is_job_system_quitting = false;
+
+static std::atomic<Si32> g_job_worker_count = ATOMIC_VAR_INIT(0);
+
+static thread_local JobQueue *g_thread_job_queue = nullptr;
+static thread_local size_t g_thread_steal_index = 0;
+
+// Job records freed by the thread, linked through Job::next.
+static thread_local Job *g_thread_free_jobs = nullptr;
+static thread_local size_t g_thread_free_job_count = 0;
+
+Job *AllocateJob() {
+  Job *job = g_thread_free_jobs;
+  if (!job) {
+    return static_cast<Job*>(g_job_pool.alloc());
+  }
+  g_thread_free_jobs = job->next;
+  --g_thread_free_job_count;
+  return job;
+}
+
+void FreeJob(Job *job) {
+  if (g_thread_free_job_count < kJobCacheSize) {
+    job->next = g_thread_free_jobs;
+    g_thread_free_jobs = job;
+    ++g_thread_free_job_count;
+  } else {
+    g_job_pool.free(job);
+  }
+}
+
+static void ReleaseThreadFreeJobs() {
+  while (g_thread_free_jobs) {
+    Job *job = g_thread_free_jobs;
+    g_thread_free_jobs = job->next;
+    g_job_pool.free(job);
+  }
+  g_thread_free_job_count = 0;
+}
+
+static void EnqueueJob(Job *job);
+
+void AddJobToCounter(JobCounter *counter) {
+  if (counter->value_.fetch_add(1, std::memory_order_acq_rel) != 0) {
+    return;
+  }
+  // The job is not pushed yet, so nothing can finish the counter meanwhile.
+  // But the job that took the counter to 0 may not have closed the list yet,
+  // wait for it to do so before opening the list again.
+  Job *closed = JobCounter::ClosedList();
+  while (!counter->dependents_.compare_exchange_weak(closed, nullptr,
+      std::memory_order_acq_rel)) {
+    closed = JobCounter::ClosedList();
+    std::this_thread::yield();
+  }
+}
+
+void FinishJobOfCounter(JobCounter *counter) {
+  if (counter->value_.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+    return;
+  }
+  // The waits may return and destroy the counter right after the exchange.
+  Job *job = counter->dependents_.exchange(JobCounter::ClosedList(),
+    std::memory_order_acq_rel);
+  if (job == JobCounter::ClosedList()) {
+    job = nullptr;
+  }
+  while (job) {
+    Job *next = job->next;
+    job->next = nullptr;
+    EnqueueJob(job);
+    job = next;
+  }
+}
+
+static void ExecuteJob(Job *job) {
+  JobCounter *counter = job->counter;
+  job->run(job);
+  FreeJob(job);
+  if (counter) {
+    FinishJobOfCounter(counter);
+  }
+}
+
+static bool IsMainThread() {
+  return g_is_job_system_running.load(std::memory_order_acquire) &&
+    std::this_thread::get_id() == g_main_thread_id.load();
+}
+
+static JobQueue *GetThreadJobQueue() {
+  if (!g_thread_job_queue && IsMainThread()) {
+    return g_job_queues[0].get();
+  }
+  return g_thread_job_queue;
+}
+
+static void WakeUpWorker() {
+  if (g_sleeping_worker_count.load() > 0) {
+    std::lock_guard<std::mutex> lock(g_job_sleep_mutex);
+    g_job_sleep_condvar.notify_one();
+  }
+}
+
+static Job *PopJob() {
+  JobQueue *own_queue = GetThreadJobQueue();
+  if (own_queue) {
+    Job *job = own_queue->jobs.dequeue();
+    if (job) {
+      g_queued_job_count.fetch_sub(1);
+      return job;
+    }
+  }
+  if (g_injected_job_count.load(std::memory_order_acquire) > 0) {
+    std::lock_guard<std::mutex> lock(g_injected_jobs_mutex);
+    if (!g_injected_jobs.empty()) {
+      Job *job = g_injected_jobs.front();
+      g_injected_jobs.pop_front();
+      g_injected_job_count.fetch_sub(1, std::memory_order_relaxed);
+      g_queued_job_count.fetch_sub(1);
+      return job;
+    }
+  }
+  const size_t queue_count = g_job_queues.size();
+  for (size_t idx = 0; idx < queue_count; ++idx) {
+    g_thread_steal_index = (g_thread_steal_index + 1) % queue_count;
+    JobQueue *queue = g_job_queues[g_thread_steal_index].get();
+    if (queue == own_queue) {
+      continue;
+    }
+    Job *job = queue->jobs.dequeue();
+    if (job) {
+      g_queued_job_count.fetch_sub(1);
+      return job;
+    }
+  }
+  return nullptr;
+}
+
+// Runs one job, returns false if there was none to run.
+static bool RunOneJob(bool is_main_thread) {
+  if (is_main_thread) {
+    Job *job = g_main_thread_jobs.dequeue();
+    if (job) {
+      ExecuteJob(job);
+      return true;
+    }
+  }
+  Job *job = PopJob();
+  if (job) {
+    ExecuteJob(job);
+    return true;
+  }
+  return false;
+}
+
+static void JobWorkerThreadFunction(size_t queue_index) {
+  g_thread_job_queue = g_job_queues[queue_index].get();
+  g_thread_steal_index = queue_index;
+  while (true) {
+    if (RunOneJob(false)) {
+      continue;
+    }
+    // Spin a little before going to sleep, new jobs tend to come in bursts.
+    bool is_found = false;
+    for (Si32 spin = 0; spin < 64 && !is_found; ++spin) {
+      std::this_thread::yield();
+      is_found = RunOneJob(false);
+    }
+    if (is_found) {
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(g_job_sleep_mutex);
+    g_sleeping_worker_count.fetch_add(1);
+    g_job_sleep_condvar.wait(lock, [] {
+      return g_is_job_system_quitting || g_queued_job_count.load() > 0;
+    });
+    g_sleeping_worker_count.fetch_sub(1);
+    if (g_is_job_system_quitting && g_queued_job_count.load() == 0) {
+      break;
+    }
+  }
+  g_thread_job_queue = nullptr;
+  ReleaseThreadFreeJobs();
+}
+
+static void StartJobSystemLocked(Si32 worker_count) {
+  if (!worker_count) {
+    worker_count = std::max(1,
+      static_cast<Si32>(std::thread::hardware_concurrency()) - 1);
+  }
+  g_is_job_system_quitting = false;
+  for (Si32 idx = 0; idx <= worker_count; ++idx) {
+    g_job_queues.emplace_back(new JobQueue());
+  }
+  g_is_job_system_running.store(true, std::memory_order_release);
+  for (Si32 idx = 1; idx <= worker_count; ++idx) {
+    g_job_threads.emplace_back(JobWorkerThreadFunction,
+      static_cast<size_t>(idx));
+  }
+  g_job_worker_count.store(worker_count, std::memory_order_release);
+}
+
+static void StopJobSystemLocked() {
+  if (!g_is_job_system_running.load(std::memory_order_acquire)) {
+    return;
+  }
+  const bool is_main_thread = IsMainThread();
+  while (RunOneJob(is_main_thread)) {
+  }
+  {
+    std::lock_guard<std::mutex> lock(g_job_sleep_mutex);
+    g_is_job_system_quitting = true;
+  }
+  g_job_sleep_condvar.notify_all();
+  for (std::thread &thread : g_job_threads) {
+    thread.join();
+  }
+  g_job_threads.clear();
+  // Finish whatever the last jobs have pushed.
+  while (RunOneJob(is_main_thread)) {
+  }
+  g_job_worker_count.store(0, std::memory_order_release);
+  g_is_job_system_running.store(false, std::memory_order_release);
+  g_job_queues.clear();
+}
+
+static void EnsureJobSystemIsRunning() {
+  if (!g_is_job_system_running.load(std::memory_order_acquire)) {
+    std::lock_guard<std::mutex> lock(g_job_start_mutex);
+    if (!g_is_job_system_running.load(std::memory_order_acquire)) {
+      std::thread::id no_thread;
+      g_main_thread_id.compare_exchange_strong(no_thread,
+        std::this_thread::get_id());
+      StartJobSystemLocked(0);
+    }
+  }
+}
+
+// Pushes the job already counted by its counter.
+static void EnqueueJob(Job *job) {
+  EnsureJobSystemIsRunning();
+  JobQueue *queue = GetThreadJobQueue();
+  if (queue) {
+    if (!queue->jobs.enqueue(job)) {
+      ExecuteJob(job);
+      return;
+    }
+    g_queued_job_count.fetch_add(1);
+  } else {
+    {
+      std::lock_guard<std::mutex> lock(g_injected_jobs_mutex);
+      g_injected_jobs.push_back(job);
+      g_injected_job_count.fetch_add(1, std::memory_order_release);
+    }
+    g_queued_job_count.fetch_add(1);
+  }
+  WakeUpWorker();
+}
+
+void PushJob(Job *job) {
+  if (job->counter) {
+    AddJobToCounter(job->counter);
+  }
+  EnqueueJob(job);
+}
+
+void PushJobAfter(JobCounter *dependency, Job *job) {
+  Check(dependency != nullptr, "RunJobAfter called with nullptr dependency");
+  if (job->counter) {
+    // Counted now, so that waiting for the counter waits for the dependency.
+    AddJobToCounter(job->counter);
+  }
+  Job *head = dependency->dependents_.load(std::memory_order_acquire);
+  while (head != JobCounter::ClosedList()) {
+    job->next = head;
+    if (dependency->dependents_.compare_exchange_weak(head, job,
+        std::memory_order_acq_rel, std::memory_order_acquire)) {
+      return;
+    }
+  }
+  job->next = nullptr;
+  EnqueueJob(job);
+}
+
+void PushMainThreadJob(Job *job) {
+  if (job->counter) {
+    AddJobToCounter(job->counter);
+  }
+  EnsureJobSystemIsRunning();
+  g_main_thread_jobs.enqueue(job);
+}
+
+void ParallelForRanges(Si32 begin, Si32 end, Si32 grain,
+    void (*call)(void *context, Si32 from, Si32 to), void *context) {
+  if (end <= begin) {
+    return;
+  }
+  EnsureJobSystemIsRunning();
+  if (grain <= 0) {
+    // A few subranges per thread let the fast threads steal the slack.
+    const Si64 parts = 4 * (static_cast<Si64>(
+      g_job_worker_count.load(std::memory_order_acquire)) + 1);
+    grain = static_cast<Si32>(std::max<Si64>(1,
+      (static_cast<Si64>(end) - begin + parts - 1) / parts));
+  }
+  struct Range {
+    void (*call)(void *context, Si32 from, Si32 to);
+    void *context;
+    Si32 grain;
+    JobCounter counter;
+
+    // Hands the upper halves to the other threads, runs the rest.
+    void Split(Si32 from, Si32 to) {
+      while (to - from > grain) {
+        const Si32 middle = from + (to - from) / 2;
+        RunJob([this, middle, to]() {
+          Split(middle, to);
+        }, &counter);
+        to = middle;
+      }
+      call(context, from, to);
+    }
+  };
+  Range range;
+  range.call = call;
+  range.context = context;
+  range.grain = grain;
+  range.Split(begin, end);
+  WaitForJobs(range.counter);
+}
+
+void SetJobSystemMainThread() {
+  g_main_thread_id.store(std::this_thread::get_id());
+}
+
+void StartJobSystem(Si32 worker_count) {
+  std::lock_guard<std::mutex> lock(g_job_start_mutex);
+  StopJobSystemLocked();
+  g_main_thread_id.store(std::this_thread::get_id());
+  StartJobSystemLocked(std::max(0, worker_count));
+}
+
+void StopJobSystem() {
+  std::lock_guard<std::mutex> lock(g_job_start_mutex);
+  StopJobSystemLocked();
+}
+
+Si32 GetJobWorkerCount() {
+  return g_job_worker_count.load(std::memory_order_acquire);
+}
+
+void WaitForJobs(const JobCounter &counter) {
+  if (counter.IsDone()) {
+    return;
+  }
+  const bool is_main_thread = IsMainThread();
+  while (!counter.IsDone()) {
+    if (!RunOneJob(is_main_thread)) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void UpdateMainThreadJobs() {
+  if (!IsMainThread()) {
+    return;
+  }
+  while (Job *job = g_main_thread_jobs.dequeue()) {
+    ExecuteJob(job);
+  }
+}
+
+class JobSystemStopper {
+ public:
+  ~JobSystemStopper() {
+    StopJobSystem();
+  }
+};
+
+// Declared last, so the workers are joined before the state above is gone.
+static JobSystemStopper g_job_system_stopper;
+
+}  // namespace arctic
@@ -0,0 +1,203 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef ENGINE_ARCTIC_JOB_SYSTEM_H_
+#define ENGINE_ARCTIC_JOB_SYSTEM_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "engine/arctic_types.h"
+
+namespace arctic {
+
+/// @addtogroup global_utility
+/// @{
+
+struct Job;
+
+/// @brief Counts the unfinished jobs started with it
+/// @details A counter is done when all the jobs started with it are finished.
+///  A new counter is done. The counter may be reused once it is done.
+///  The counter must outlive the jobs started with it and the jobs waiting
+///  for it.
+class JobCounter {
+ public:
+  JobCounter()
+    : dependents_(ClosedList()) {
+  }
+  JobCounter(const JobCounter &) = delete;
+  JobCounter &operator=(const JobCounter &) = delete;
+
+  /// @brief Returns true if all the jobs started with the counter are finished
+  bool IsDone() const {
+    return dependents_.load(std::memory_order_acquire) == ClosedList();
+  }
+
+ private:
+  friend void AddJobToCounter(JobCounter *counter);
+  friend void FinishJobOfCounter(JobCounter *counter);
+  friend void PushJobAfter(JobCounter *dependency, Job *job);
+
+  static Job *ClosedList() {
+    return reinterpret_cast<Job *>(static_cast<uintptr_t>(1));
+  }
+
+  std::atomic<Si32> value_ = ATOMIC_VAR_INIT(0);
+  // Jobs to start once the counter is done, ClosedList() when done.
+  std::atomic<Job *> dependents_;
+};
+
+/// @brief A job record, allocated from the job pool
+struct Job {
+  static constexpr size_t kSize = 128;
+
+  void (*run)(Job *job) = nullptr;
+  JobCounter *counter = nullptr;
+  Job *next = nullptr;
+  alignas(16) Ui8 data[kSize - 32];
+};
+
+Job *AllocateJob();
+void FreeJob(Job *job);
+void PushJob(Job *job);
+void PushJobAfter(JobCounter *dependency, Job *job);
+void PushMainThreadJob(Job *job);
+void ParallelForRanges(Si32 begin, Si32 end, Si32 grain,
+  void (*call)(void *context, Si32 from, Si32 to), void *context);
+
+template <typename F, bool kIsInline =
+  sizeof(F) <= sizeof(Job::data) && alignof(F) <= alignof(Job)>
+struct JobPayload;
+
+template <typename F>
+struct JobPayload<F, true> {
+  static void Store(Job *job, F &&fn) {
+    new (job->data) F(std::move(fn));
+  }
+  static void Run(Job *job) {
+    F *fn = reinterpret_cast<F *>(job->data);
+    (*fn)();
+    fn->~F();
+  }
+};
+
+template <typename F>
+struct JobPayload<F, false> {
+  static void Store(Job *job, F &&fn) {
+    new (job->data) F *(new F(std::move(fn)));
+  }
+  static void Run(Job *job) {
+    F *fn = *reinterpret_cast<F **>(job->data);
+    (*fn)();
+    delete fn;
+  }
+};
+
+template <typename F>
+Job *MakeJob(F &&fn, JobCounter *counter) {
+  using Fn = typename std::decay<F>::type;
+  Job *job = AllocateJob();
+  job->run = &JobPayload<Fn>::Run;
+  job->counter = counter;
+  job->next = nullptr;
+  JobPayload<Fn>::Store(job, Fn(std::forward<F>(fn)));
+  return job;
+}
+
+/// @brief Makes the calling thread the main thread
+/// @details The main thread runs the RunMainThreadJob jobs. The engine calls
+///  it on init from the thread that calls ShowFrame. Without the engine, the
+///  thread that starts the job system becomes the main thread.
+void SetJobSystemMainThread();
+/// @brief Starts the worker threads of the job system
+/// @param [in] worker_count Number of worker threads, pass 0 to use all the
+///  hardware threads available but one.
+/// @details The calling thread becomes the main thread. Without the call,
+///  the job system starts on the first use.
+///  Stops the job system first if it is running.
+void StartJobSystem(Si32 worker_count = 0);
+/// @brief Finishes all the jobs started and stops the worker threads
+void StopJobSystem();
+/// @brief Returns the number of worker threads, 0 if the system is stopped
+Si32 GetJobWorkerCount();
+
+/// @brief Starts the job on the worker threads
+/// @param [in] fn Callable object with no arguments, small ones are stored
+///  in the pooled job record without any allocation.
+/// @param [in] counter Counter to count the job with, may be nullptr.
+/// @details Jobs started by a worker go to its own queue and the idle workers
+///  steal from it, so jobs may start more jobs.
+template <typename F>
+void RunJob(F &&fn, JobCounter *counter = nullptr) {
+  PushJob(MakeJob(std::forward<F>(fn), counter));
+}
+
+/// @brief Starts the job once all the jobs counted by dependency are finished
+/// @details The job is counted by counter right away, so waiting for counter
+///  waits for the dependency as well.
+template <typename F>
+void RunJobAfter(JobCounter *dependency, F &&fn,
+    JobCounter *counter = nullptr) {
+  PushJobAfter(dependency, MakeJob(std::forward<F>(fn), counter));
+}
+
+/// @brief Starts the job on the main thread
+/// @details Use it for the work that must happen on the thread owning the GL
+///  context. The jobs run in UpdateMainThreadJobs and while the main thread
+///  waits in WaitForJobs.
+template <typename F>
+void RunMainThreadJob(F &&fn, JobCounter *counter = nullptr) {
+  PushMainThreadJob(MakeJob(std::forward<F>(fn), counter));
+}
+
+/// @brief Blocks until the counter is done, running the jobs while waiting
+void WaitForJobs(const JobCounter &counter);
+
+/// @brief Runs the main thread jobs started so far
+/// @details ShowFrame calls it once per frame. Does nothing if called from
+///  any other thread than the main one.
+void UpdateMainThreadJobs();
+
+/// @brief Calls fn(from, to) for the subranges of [begin, end) in parallel
+/// @param [in] grain Maximum length of a subrange, pass 0 to pick one based
+///  on the number of worker threads.
+/// @details The calling thread takes part in the work and returns once all
+///  the subranges are done.
+template <typename F>
+void ParallelFor(Si32 begin, Si32 end, Si32 grain, F &&fn) {
+  using Fn = typename std::remove_reference<F>::type;
+  ParallelForRanges(begin, end, grain,
+    [](void *context, Si32 from, Si32 to) {
+      (*static_cast<Fn *>(context))(from, to);
+    }, const_cast<void *>(static_cast<const void *>(&fn)));
+}
+
+/// @}
+
+}  // namespace arctic
+
+#endif  // ENGINE_ARCTIC_JOB_SYSTEM_H_
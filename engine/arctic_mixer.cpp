@@ -25,11 +25,203 @@
 
 #include "engine/arctic_mixer.h"
 
+#include <algorithm>
+#include <chrono>  // NOLINT
+
+#include "engine/sound_mix_kernels.h"
+
 namespace arctic {
 
 template class MpmcBestEffortFixedSizeBufferFixedSizePool<8, 4080>;
 template class MpscVirtInfArray<SoundTask*, TuneDeletePayloadFlag<true>, TuneMemoryPoolFlag<true>>;
 template class SpmcArray<SoundTask, true>;
 
+void SoundMixerState::Cull3dVoices() {
+  const float max_distance = max_3d_distance.load();
+  const Si32 max_voices = max_3d_voices.load();
+  audible_3d_voices.clear();
+  for (SoundTask *sound : buffers) {
+    if (!sound->is_3d) {
+      continue;
+    }
+    const float distance = Length(sound->location.displacement -
+      head.loc.displacement);
+    sound->is_culled = (max_distance > 0.f && distance > max_distance);
+    if (!sound->is_culled) {
+      audible_3d_voices.emplace_back(
+        sound->volume / std::max(distance, 0.1f), sound);
+    }
+  }
+  // Voice stealing, the quietest voices above the limit keep time silently.
+  if (max_voices > 0 &&
+      static_cast<Si32>(audible_3d_voices.size()) > max_voices) {
+    std::nth_element(audible_3d_voices.begin(),
+      audible_3d_voices.begin() + max_voices, audible_3d_voices.end(),
+      [](const std::pair<float, SoundTask*> &a,
+          const std::pair<float, SoundTask*> &b) {
+        return a.first > b.first;
+      });
+    for (size_t idx = static_cast<size_t>(max_voices);
+        idx < audible_3d_voices.size(); ++idx) {
+      audible_3d_voices[idx].second->is_culled = true;
+    }
+  }
+}
+
+void SoundMixerState::ReleaseRetiredTasks() {
+  const bool is_running = is_decode_thread_running.load();
+  const Ui64 sweep_count = decode_sweep_count.load();
+  for (size_t idx = 0; idx < retired_tasks.size(); ++idx) {
+    // A sweep that could see the stream has ended once the count moved on.
+    if (!is_running || sweep_count > retired_tasks[idx].second) {
+      SoundTask *task = retired_tasks[idx].first;
+      task->stream.Close();
+      pool.enqueue(task);
+      retired_tasks[idx] = retired_tasks.back();
+      retired_tasks.pop_back();
+      --idx;
+    }
+  }
+}
+
+void SoundMixerState::PrepareStream(SoundTask *sound,
+    Si32 buffer_samples_per_channel) {
+  if (is_decode_thread_running.load()) {
+    if (sound->stream_slot < 0) {
+      for (Si32 slot = 0; slot < kMaxDecodedStreams; ++slot) {
+        if (decoded_streams[slot].load() == nullptr) {
+          sound->stream_slot = slot;
+          decoded_streams[slot].store(&sound->stream);
+          break;
+        }
+      }
+    }
+    if (sound->stream_slot >= 0) {
+      return;
+    }
+  } else if (sound->stream_slot >= 0) {
+    // The stopped thread no longer decodes, take the stream back.
+    decoded_streams[sound->stream_slot].store(nullptr);
+    sound->stream_slot = -1;
+  }
+  const Si32 buffered = sound->stream.BufferedFrames();
+  if (buffered < buffer_samples_per_channel) {
+    sound->stream.Decode(buffer_samples_per_channel - buffered);
+  }
+}
+
+void SoundMixerState::StartDecodeThread() {
+  if (is_decode_thread_running.load()) {
+    return;
+  }
+  if (decode_thread.joinable()) {
+    decode_thread.join();
+  }
+  do_quit_decode_thread.store(false);
+  is_decode_thread_running.store(true);
+  decode_thread = std::thread([this] { DecodeThreadFunction(); });
+}
+
+void SoundMixerState::StopDecodeThread() {
+  do_quit_decode_thread.store(true);
+  if (decode_thread.joinable()) {
+    decode_thread.join();
+  }
+}
+
+void SoundMixerState::DecodeThreadFunction() {
+  const Si32 kDecodeChunkFrames = 1024;
+  while (!do_quit_decode_thread.load()) {
+    Si32 decoded = 0;
+    for (std::atomic<SoundStream*> &slot : decoded_streams) {
+      SoundStream *stream = slot.load();
+      if (stream) {
+        decoded += stream->Decode(kDecodeChunkFrames);
+      }
+    }
+    decode_sweep_count.fetch_add(1);
+    if (decoded == 0) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+  }
+  is_decode_thread_running.store(false);
+}
+
+void SoundMixerState::MixSoundPlanar(Si32 buffer_samples_per_channel,
+    Si16 *tmp) {
+  ReleaseRetiredTasks();
+  InputTasksToMixerThread();
+  const SoundMixKernels &kernels = GetSoundMixKernels();
+  float master_volume_16 = static_cast<float>(
+    this->master_volume.load() / 32767.0);
+  float *mix_l = mix_buffer_l.data();
+  float *mix_r = mix_buffer_r.data();
+  std::fill(mix_l, mix_l + buffer_samples_per_channel, 0.f);
+  std::fill(mix_r, mix_r + buffer_samples_per_channel, 0.f);
+  Cull3dVoices();
+
+  for (Si32 idx = 0; idx < static_cast<Si32>(buffers.size()); ++idx) {
+    SoundTask &sound = *buffers[idx];
+    if (sound.is_3d) {
+      bool is_over = true;
+      for (Si32 channel_idx = 0; channel_idx < 2; ++channel_idx) {
+        if (sound.is_culled) {
+          SkipSound(&sound, channel_idx, buffer_samples_per_channel, 44100.0);
+        } else {
+          RenderSound<float>(
+              &sound, head, channel_idx,
+              (channel_idx == 0 ? mix_l : mix_r), 1, buffer_samples_per_channel, 44100.0,
+              master_volume_16);
+        }
+        if (sound.channel_playback_state[channel_idx].play_position * 44100.0 < sound.sound.DurationSamples()) {
+          is_over = false;
+        }
+      }
+      if (is_over) {
+        sound.sound.GetInstance()->DecPlaying();
+        ReleaseBufferAt(idx);
+        --idx;
+      }
+    } else {
+      Si32 size = 0;
+      bool is_over = false;
+      if (sound.stream.IsOpen()) {
+        PrepareStream(&sound, buffer_samples_per_channel);
+        size = sound.stream.Read(tmp, buffer_samples_per_channel);
+        is_over = sound.stream.IsEnded();
+      } else {
+        size = sound.sound.StreamOut(sound.next_position,
+            buffer_samples_per_channel,
+            tmp,
+            buffer_samples_per_channel * 2);
+        is_over = (size < buffer_samples_per_channel);
+      }
+      kernels.accumulate_stereo(mix_l, mix_r, tmp, size,
+        sound.volume * master_volume_16);
+      sound.next_position += size;
+
+      if (is_over) {
+        sound.sound.GetInstance()->DecPlaying();
+        ReleaseBufferAt(idx);
+        --idx;
+      }
+    }
+  }
+
+  kernels.compress_and_clip(mix_l, mix_r, buffer_samples_per_channel,
+    &compressor_level);
+}
+
+void SoundMixerState::MixSoundToSi16(Si16 *out,
+    Si32 buffer_samples_per_channel, Si16 *tmp) {
+  const Si32 part_size = static_cast<Si32>(mix_buffer_l.size());
+  for (Si32 done = 0; done < buffer_samples_per_channel; done += part_size) {
+    const Si32 size = std::min(part_size, buffer_samples_per_channel - done);
+    MixSoundPlanar(size, tmp);
+    GetSoundMixKernels().interleave_to_si16(out + done * 2,
+      mix_buffer_l.data(), mix_buffer_r.data(), size);
+  }
+}
+
 }  // namespace arctic
 
@@ -29,8 +29,11 @@
 #include <deque>  // NOLINT
 #include <mutex>  // NOLINT
 #include <string>
+#include <thread>  // NOLINT
+#include <utility>
 #include <vector>
 #include <array>
+#include <algorithm>
 
 #include "engine/arctic_types.h"
 #include "engine/easy_sound.h"
@@ -89,6 +92,20 @@ struct SoundSource {
 };
 
 
+// Number of frames RenderSound fetches and filters at a time
+constexpr Si32 kRenderSoundBlockFrames = 64;
+
+// Advances a voice that is not rendered this period, keeping it in time.
+inline void SkipSound(SoundTask *sound, Si32 channel_idx,
+    Si32 dst_size_samples, double dst_sample_rate) {
+  ChannelPlaybackState *channel = &sound->channel_playback_state[channel_idx];
+  channel->play_position += dst_size_samples / std::max(512.0, dst_sample_rate);
+  channel->acc = 0.f;
+  // Fade in from silence once the voice is rendered again.
+  channel->volume = 0.f;
+  channel->has_volume = true;
+}
+
 template <class T>
 void RenderSound(SoundTask *sound, const SoundListenerHead &head, Si32 channel_idx,
                  T *dst_buffer, Si32 dst_stride, Si32 dst_size_samples, double dst_sample_rate,
@@ -118,31 +135,106 @@ void RenderSound(SoundTask *sound, const SoundListenerHead &head, Si32 channel_i
 
   Si16 *src_buffer = sound->sound.GetInstance()->GetWavData();
   Si32 src_size_samples = sound->sound.DurationSamples();
+  if (!src_buffer || src_size_samples <= 0 || dst_size_samples <= 0) {
+    SkipSound(sound, channel_idx, dst_size_samples, dst_sample_rate);
+    return;
+  }
+
+  // The gain ramps from the previous period to avoid zipper noise.
+  const float start_volume = (channel->has_volume ? channel->volume : volume);
+  const float volume_step = (volume - start_volume) / static_cast<float>(dst_size_samples);
+
+  // The delay moves towards ear_delay by delay_change_speed per sample,
+  // so the source position is linear in the sample index while the delay
+  // ramps and again once it settles. Each piece is rendered as
+  // src_pos(i) = src_pos_0 + i * src_step.
+  const double src_start_pos = channel->play_position;
+  const double cur_delay = channel->delay;
+  const double delay_diff = ear_delay - cur_delay;
+  const double delay_sign = (delay_diff < 0.0 ? -1.0 : 1.0);
+  Si32 ramp_samples = 0;
+  if (delay_diff != 0.0) {
+    ramp_samples = static_cast<Si32>(std::min(
+      static_cast<double>(dst_size_samples),
+      std::ceil(std::abs(delay_diff) / delay_change_speed) - 1.0));
+    ramp_samples = std::max(ramp_samples, 0);
+  }
+  struct Piece {
+    Si32 begin;
+    Si32 end;
+    double src_pos_0;
+    double src_step;
+  };
+  const Piece pieces[2] = {
+    {0, ramp_samples,
+      (src_start_pos - cur_delay - delay_sign * delay_change_speed) * src_sample_rate,
+      (inv_dst_sample_rate - delay_sign * delay_change_speed) * src_sample_rate},
+    {ramp_samples, dst_size_samples,
+      (src_start_pos - ear_delay) * src_sample_rate,
+      inv_dst_sample_rate * src_sample_rate}};
 
-  double src_start_pos = channel->play_position;
-  double cur_delay = channel->delay;
   float acc = channel->acc;
-  Si32 dst_sample_idx = 0;
-  for (dst_sample_idx = 0; dst_sample_idx < dst_size_samples; ++dst_sample_idx) {
-    if (cur_delay != ear_delay) {
-      double delay_diff = ear_delay - cur_delay;
-      if (std::abs(delay_diff) > delay_change_speed) {
-        cur_delay += copysign(delay_change_speed, delay_diff);
-      } else {
-        cur_delay = ear_delay;
+  float fetched[kRenderSoundBlockFrames];
+  bool is_valid[kRenderSoundBlockFrames];
+  for (const Piece &piece : pieces) {
+    for (Si32 block_begin = piece.begin; block_begin < piece.end;
+        block_begin += kRenderSoundBlockFrames) {
+      const Si32 block_size = std::min(kRenderSoundBlockFrames, piece.end - block_begin);
+      // Positions relative to the block base stay small enough for float.
+      const double block_pos = piece.src_pos_0 + block_begin * piece.src_step;
+      const double block_base = std::floor(block_pos);
+      const Si32 base_idx = static_cast<Si32>(block_base);
+      const float frac_0 = static_cast<float>(block_pos - block_base);
+      const float step = static_cast<float>(piece.src_step);
+      T *dst = dst_buffer + dst_stride * block_begin;
+      float gain = start_volume + volume_step * static_cast<float>(block_begin);
+      const float last_pos = frac_0 + step * static_cast<float>(block_size - 1);
+      const Si32 first_idx = base_idx + static_cast<Si32>(std::min(frac_0, last_pos));
+      const Si32 last_idx = base_idx + static_cast<Si32>(std::max(frac_0, last_pos));
+      if (first_idx >= 0 && last_idx + 1 < src_size_samples) {
+        // The whole block lies inside the source, no clamping is needed.
+        const Si16 *src = src_buffer + src_stride * static_cast<std::ptrdiff_t>(base_idx);
+        for (Si32 i = 0; i < block_size; ++i) {
+          const float pos = frac_0 + step * static_cast<float>(i);
+          const Si32 int_pos = static_cast<Si32>(pos);
+          const float frac = pos - static_cast<float>(int_pos);
+          const float sample_0 = static_cast<float>(src[src_stride * int_pos]);
+          const float sample_1 = static_cast<float>(src[src_stride * int_pos + src_stride]);
+          acc = acc * acc_k + (sample_0 + (sample_1 - sample_0) * frac) * signal_k;
+          dst[dst_stride * i] += (T)(acc * gain);
+          gain += volume_step;
+        }
+        continue;
+      }
+      // Near the source edges the samples outside of it are skipped.
+      for (Si32 i = 0; i < block_size; ++i) {
+        const float pos = frac_0 + step * static_cast<float>(i);
+        const Si32 int_pos = static_cast<Si32>(pos);
+        const float frac = pos - static_cast<float>(int_pos);
+        const Si32 idx = base_idx + int_pos;
+        const bool valid = (static_cast<Ui32>(idx) < static_cast<Ui32>(src_size_samples));
+        const Si32 idx_0 = (valid ? idx : 0);
+        const Si32 idx_1 = std::min(idx_0 + 1, src_size_samples - 1);
+        const float sample_0 = static_cast<float>(src_buffer[src_stride * idx_0]);
+        const float sample_1 = static_cast<float>(src_buffer[src_stride * idx_1]);
+        fetched[i] = sample_0 + (sample_1 - sample_0) * frac;
+        is_valid[i] = valid;
+      }
+      for (Si32 i = 0; i < block_size; ++i) {
+        if (is_valid[i]) {
+          acc = acc * acc_k + fetched[i] * signal_k;
+          dst[dst_stride * i] += (T)(acc * gain);
+        }
+        gain += volume_step;
       }
-    }
-    double dst_time = dst_sample_idx * inv_dst_sample_rate;
-    double time_offset_in_src = dst_time + src_start_pos - cur_delay;
-    Si32 src_sample_idx = (Si32)(time_offset_in_src * src_sample_rate);
-    if (src_sample_idx >= 0 && src_sample_idx < src_size_samples) {
-      acc = acc * acc_k + src_buffer[src_stride * src_sample_idx] * signal_k;
-      dst_buffer[dst_stride * dst_sample_idx] += (T)(acc * volume);
     }
   }
-  channel->play_position = dst_sample_idx * inv_dst_sample_rate + src_start_pos;
-  channel->delay = cur_delay;
+  channel->play_position = dst_size_samples * inv_dst_sample_rate + src_start_pos;
+  channel->delay = (ramp_samples < dst_size_samples ? ear_delay :
+    cur_delay + delay_sign * delay_change_speed * dst_size_samples);
   channel->acc = acc;
+  channel->volume = volume;
+  channel->has_volume = true;
 }
 
 struct SoundMixerState {
@@ -153,32 +245,141 @@ struct SoundMixerState {
   MpscVirtInfArray<SoundTask*, TuneDeletePayloadFlag<true>, TuneMemoryPoolFlag<true>> tasks;
   SpmcArray<SoundTask, true> pool;
   static constexpr Si32 kPoolSize = 1024;
+  static constexpr Si32 kMixBufferSamples = 4096;
 
   // Mutex-protected state begin
   std::string error_description = "Error description is not set.";
   // Mixer-only state begin
   std::atomic<Ui64> next_uid = ATOMIC_VAR_INIT(2);
   std::atomic<float> master_volume = ATOMIC_VAR_INIT(0.7f);
+  // 3D voices further than this from the listener are not rendered, 0 is off
+  std::atomic<float> max_3d_distance = ATOMIC_VAR_INIT(0.f);
+  // Only this many of the loudest 3D voices are rendered, 0 is off
+  std::atomic<Si32> max_3d_voices = ATOMIC_VAR_INIT(0);
   std::vector<SoundTask*> buffers;
   SoundListenerHead head;
   float compressor_level = 1.f;
+  std::vector<float> mix_buffer_l;
+  std::vector<float> mix_buffer_r;
+  // Released tasks the decode thread may still touch, with the sweep count
+  // it must pass before they can return to the pool
+  std::vector<std::pair<SoundTask*, Ui64>> retired_tasks;
+  // Scratch list of the audible 3D voices and their estimated loudness
+  std::vector<std::pair<float, SoundTask*>> audible_3d_voices;
+
+  // Decode thread state begin
+  static constexpr Si32 kMaxDecodedStreams = 64;
+  std::array<std::atomic<SoundStream*>, kMaxDecodedStreams> decoded_streams;
+  std::atomic<Ui64> decode_sweep_count = ATOMIC_VAR_INIT(0);
+  std::atomic<bool> is_decode_thread_running = ATOMIC_VAR_INIT(false);
+  std::atomic<bool> do_quit_decode_thread = ATOMIC_VAR_INIT(false);
+  std::thread decode_thread;
 
   SoundMixerState()
       : tasks(&page_pool)
-      , pool(kPoolSize) {
+      , pool(kPoolSize)
+      , mix_buffer_l(kMixBufferSamples)
+      , mix_buffer_r(kMixBufferSamples) {
     for (Si32 i = 0; i < kPoolSize; ++i) {
       pool.enqueue(new SoundTask);
     }
+    for (std::atomic<SoundStream*> &slot : decoded_streams) {
+      slot.store(nullptr);
+    }
+    buffers.reserve(kPoolSize);
+    retired_tasks.reserve(kPoolSize);
+    audible_3d_voices.reserve(kPoolSize);
+  }
+
+  ~SoundMixerState() {
+    StopDecodeThread();
+  }
+
+  /// @brief Grows the planar mix buffers, call before the device starts
+  /// @param [in] buffer_samples_per_channel Frames the device asks for at once
+  void ReserveMixBuffers(Si32 buffer_samples_per_channel) {
+    if (static_cast<Si32>(mix_buffer_l.size()) < buffer_samples_per_channel) {
+      mix_buffer_l.resize(static_cast<size_t>(buffer_samples_per_channel));
+      mix_buffer_r.resize(static_cast<size_t>(buffer_samples_per_channel));
+    }
+  }
+
+  void AddVoice(SoundTask *buffer) {
+    buffer->buffer_idx = static_cast<Si32>(buffers.size());
+    buffers.push_back(buffer);
+    SoundInstance *instance = buffer->sound.GetInstance().get();
+    buffer->prev_instance_voice = nullptr;
+    buffer->next_instance_voice = instance->GetFirstVoice();
+    if (buffer->next_instance_voice) {
+      buffer->next_instance_voice->prev_instance_voice = buffer;
+    }
+    instance->SetFirstVoice(buffer);
+  }
+
+  /// @brief Returns the active voice the handle data points to or nullptr
+  SoundTask *FindVoice(SoundTask *target, Ui64 target_uid) {
+    if (target && target->buffer_idx >= 0
+        && target->buffer_idx < static_cast<Si32>(buffers.size())
+        && buffers[target->buffer_idx] == target
+        && target_uid != SoundTask::kInvalidSoundTaskUid
+        && target->uid == target_uid) {
+      return target;
+    }
+    return nullptr;
   }
 
   void ReleaseBufferAt(Si32 idx) {
     SoundTask *buffer = buffers[idx];
     buffers[idx] = buffers[buffers.size() - 1];
+    buffers[idx]->buffer_idx = idx;
     buffers.pop_back();
+    buffer->buffer_idx = -1;
+    if (buffer->prev_instance_voice) {
+      buffer->prev_instance_voice->next_instance_voice =
+        buffer->next_instance_voice;
+    } else {
+      buffer->sound.GetInstance()->SetFirstVoice(buffer->next_instance_voice);
+    }
+    if (buffer->next_instance_voice) {
+      buffer->next_instance_voice->prev_instance_voice =
+        buffer->prev_instance_voice;
+    }
+    buffer->prev_instance_voice = nullptr;
+    buffer->next_instance_voice = nullptr;
     buffer->uid = SoundTask::kInvalidSoundTaskUid;
+    if (buffer->stream_slot >= 0) {
+      decoded_streams[buffer->stream_slot].store(nullptr);
+      buffer->stream_slot = -1;
+      retired_tasks.emplace_back(buffer, decode_sweep_count.load());
+      return;
+    }
+    buffer->stream.Close();
     pool.enqueue(buffer);
   }
 
+  void StopVoice(SoundTask *buffer) {
+    buffer->sound.GetInstance()->DecPlaying();
+    ReleaseBufferAt(buffer->buffer_idx);
+  }
+
+  /// @brief Marks the 3D voices that are too far or too quiet to be rendered
+  void Cull3dVoices();
+
+  /// @brief Returns the retired tasks the decode thread no longer sees to the pool
+  void ReleaseRetiredTasks();
+
+  /// @brief Makes sure the streamed sound of a voice is being decoded,
+  /// by the decode thread if it runs or right here otherwise
+  void PrepareStream(SoundTask *sound, Si32 buffer_samples_per_channel);
+
+  /// @brief Starts the thread that decodes streamed sounds, called by the main thread
+  void StartDecodeThread();
+
+  /// @brief Stops the decode thread, called by the main thread
+  void StopDecodeThread();
+
+  void DecodeThreadFunction();
+
   void SetError(std::string description) {  //-V813
     std::lock_guard<std::mutex> lock(error_mutex);
     error_description = description;  //-V820
@@ -215,22 +416,17 @@ struct SoundMixerState {
       }
       switch (task->action) {
       case SoundTaskAction::kStart:
-        buffers.push_back(task);
+        AddVoice(task);
         task = nullptr;
         break;
       case SoundTaskAction::kStop:
-        {
-          Ui64 task_uid = task->target_uid;
-          for (Si32 idx = 0; idx < (Si32)buffers.size(); ++idx) {
-            SoundTask *buffer = buffers[idx];
-            if (task_uid == SoundTask::kInvalidSoundTaskUid
-                ? buffer->sound.GetInstance() == task->sound.GetInstance()
-                : task_uid == buffer->uid) {
-              buffer->sound.GetInstance()->DecPlaying();
-              ReleaseBufferAt(idx);
-              idx--;
-            }
+        if (task->target_uid == SoundTask::kInvalidSoundTaskUid) {
+          SoundInstance *instance = task->sound.GetInstance().get();
+          while (instance->GetFirstVoice()) {
+            StopVoice(instance->GetFirstVoice());
           }
+        } else if (SoundTask *voice = FindVoice(task->target_task, task->target_uid)) {
+          StopVoice(voice);
         }
         break;
       case SoundTaskAction::kSetHeadLocation:
@@ -238,28 +434,28 @@ struct SoundMixerState {
         head.UpdateEars();
         break;
       case SoundTaskAction::kSetLocation:
-        {
-          Ui64 task_uid = task->target_uid;
-          for (size_t idx = 0; idx < buffers.size(); ++idx) {
-            SoundTask *buffer = buffers[idx];
-            if (task_uid == SoundTask::kInvalidSoundTaskUid
-                ? buffer->sound.GetInstance() == task->sound.GetInstance()
-                : task_uid == buffer->uid) {
-
-              buffer->location = task->location;
-            }
+        if (task->target_uid == SoundTask::kInvalidSoundTaskUid) {
+          for (SoundTask *voice = task->sound.GetInstance()->GetFirstVoice();
+              voice; voice = voice->next_instance_voice) {
+            voice->location = task->location;
+          }
+        } else if (SoundTask *voice = FindVoice(task->target_task, task->target_uid)) {
+          voice->location = task->location;
+        }
+        break;
+      case SoundTaskAction::kSetLocations:
+        for (const SoundLocationUpdate &update : task->location_updates) {
+          if (SoundTask *voice = FindVoice(update.target_task, update.target_uid)) {
+            voice->location.displacement = update.position;
           }
         }
         break;
       case SoundTaskAction::kStart3d:
         task->is_3d = true;
         task->next_position = 0;
-        for (Si32 i = 0; i < 2; ++i) {
-          task->channel_playback_state[i].delay = 0.f;
-          task->channel_playback_state[i].play_position = 0.f;
-          task->channel_playback_state[i].acc = 0.f;
-        }
-        buffers.push_back(task);
+        task->channel_playback_state[0].Clear();
+        task->channel_playback_state[1].Clear();
+        AddVoice(task);
         task = nullptr;
         break;
       }
@@ -269,111 +465,33 @@ struct SoundMixerState {
     }
   }
 
-  inline float SoftClipSound(float d) {
-    constexpr float a = 0.97f;
-    constexpr float b = 1.f - a;
-    if (d > a) {
-      d -= a;
-      return (b * d) / (b + d) + a;
-    } else if (d < -a) {
-      d += a;
-      return (b * d) / (b - d) - a;
-    } else {
-      return d;
-    }
-  }
+  /// @brief Mixes the active sounds into mix_buffer_l and mix_buffer_r
+  /// @param [in] buffer_samples_per_channel Number of frames to mix,
+  ///   at most mix_buffer_l.size()
+  /// @param [in] tmp Scratch buffer of at least 2 * buffer_samples_per_channel samples
+  void MixSoundPlanar(Si32 buffer_samples_per_channel, Si16 *tmp);
+
+  /// @brief Mixes the active sounds into an interleaved 16-bit stereo buffer
+  /// @param [out] out Buffer of 2 * buffer_samples_per_channel samples
+  /// @param [in] buffer_samples_per_channel Number of frames to mix
+  /// @param [in] tmp Scratch buffer of at least 2 * buffer_samples_per_channel samples
+  void MixSoundToSi16(Si16 *out, Si32 buffer_samples_per_channel, Si16 *tmp);
 
   template <class T>
   void MixSound(T *mix_l, T *mix_r, Si32 mix_stride, Si32 buffer_samples_per_channel, Si16 *tmp) {
-    InputTasksToMixerThread();
-    float master_volume_16 = static_cast<float>(
-      this->master_volume.load() / 32767.0);
-    if (buffers.empty()) {
-      Si32 mix_idx = 0;
-      for (Si32 i = 0; i < buffer_samples_per_channel; ++i) {
-        mix_l[mix_idx] = 0.f;
-        mix_r[mix_idx] = 0.f;
+    // Requests longer than the mix buffers are mixed in parts,
+    // so the mixer thread never allocates.
+    const Si32 part_size = static_cast<Si32>(mix_buffer_l.size());
+    Si32 mix_idx = 0;
+    for (Si32 done = 0; done < buffer_samples_per_channel; done += part_size) {
+      const Si32 size = std::min(part_size, buffer_samples_per_channel - done);
+      MixSoundPlanar(size, tmp);
+      for (Si32 i = 0; i < size; ++i) {
+        mix_l[mix_idx] = static_cast<T>(mix_buffer_l[i]);
+        mix_r[mix_idx] = static_cast<T>(mix_buffer_r[i]);
         mix_idx += mix_stride;
       }
     }
-
-    for (Ui32 idx = 0; idx < buffers.size(); ++idx) {
-      SoundTask &sound = *buffers[idx];
-      if (sound.is_3d) {
-        if (idx == 0) {
-          Si32 mix_idx = 0;
-          for (Si32 i = 0; i < buffer_samples_per_channel; ++i) {
-            mix_l[mix_idx] = 0.f;
-            mix_r[mix_idx] = 0.f;
-            mix_idx += mix_stride;
-          }
-        }
-        bool is_over = true;
-        for (Si32 channel_idx = 0; channel_idx < 2; ++channel_idx) {
-          RenderSound<T>(
-              &sound, head, channel_idx,
-              (channel_idx == 0 ? mix_l : mix_r), 1, buffer_samples_per_channel, 44100.0,
-              master_volume_16);
-          if (sound.channel_playback_state[channel_idx].play_position * 44100.0 < sound.sound.DurationSamples()) {
-            is_over = false;
-          }
-        }
-        if (is_over) {
-          sound.sound.GetInstance()->DecPlaying();
-          ReleaseBufferAt(idx);
-          --idx;
-        }
-      } else {
-        Si32 size = sound.sound.StreamOut(sound.next_position,
-            buffer_samples_per_channel,
-            tmp,
-            buffer_samples_per_channel * 2);
-
-        Si16 *in_data = tmp;
-        float volume = sound.volume * master_volume_16;
-        Si32 mix_idx = 0;
-        if (idx == 0) {
-          for (Si32 i = 0; i < size; ++i) {
-            mix_l[mix_idx] = static_cast<float>(in_data[i * 2]) * volume;
-            mix_r[mix_idx] = static_cast<float>(in_data[i * 2 + 1]) * volume;
-            mix_idx += mix_stride;
-          }
-          mix_idx = size * mix_stride;
-          for (Si32 i = size; i < buffer_samples_per_channel; ++i) {
-            mix_l[mix_idx] = 0.f;
-            mix_r[mix_idx] = 0.f;
-            mix_idx += mix_stride;
-          }
-        } else {
-          for (Si32 i = 0; i < size; ++i) {
-            mix_l[mix_idx] += static_cast<float>(in_data[i * 2]) * volume;
-            mix_r[mix_idx] += static_cast<float>(in_data[i * 2 + 1]) * volume;
-            mix_idx += mix_stride;
-          }
-        }
-        sound.next_position += size;
-
-        if (size < buffer_samples_per_channel) {
-          sound.sound.GetInstance()->DecPlaying();
-          ReleaseBufferAt(idx);
-          --idx;
-        }
-      }
-    }
-
-    const float Attack = 1.f / (44100.f * 0.005f);
-    const float Release = 1.f / (44100.f * 0.2f);
-    for (Si32 frame = 0; frame < buffer_samples_per_channel; ++frame) {
-      float smax = std::max(std::abs(mix_l[frame]), std::abs(mix_r[frame]));
-      if (smax > compressor_level) {
-        compressor_level = compressor_level * (1.f - Attack) + smax * Attack;
-      } else {
-        compressor_level = compressor_level * (1.f - Release) + smax * Release;
-      }
-      float gain_k = (compressor_level > 1.f ? 1.f / compressor_level : 1.f);
-      mix_l[frame] = SoftClipSound(mix_l[frame] * gain_k);
-      mix_r[frame] = SoftClipSound(mix_r[frame] * gain_k);
-    }
   }
 };
 
@@ -40,6 +40,19 @@ struct DirectoryEntry {
   Trivalent is_directory = kTrivalentUnknown;
   Trivalent is_file = kTrivalentUnknown;
 };
+
+/// @brief A file opened for mapping into memory
+struct MappedFileHandle {
+  void *win = nullptr;  ///< File mapping object handle
+  int nix = -1;  ///< File descriptor
+};
+
+/// @brief A part of a file mapped into memory
+struct MappedFileView {
+  Ui8 *data = nullptr;  ///< Address of the part requested
+  Ui8 *base = nullptr;  ///< Address of the whole mapping
+  Ui64 base_size = 0;  ///< Size of the whole mapping
+};
 /// @}
 
 /// @addtogroup global_utility
@@ -52,6 +65,9 @@ void ExitProgram(Si32 exit_code = 0);
 /// @brief Swaps virtual frontbuffer and backbuffer and updates user input
 void Swap();
 
+/// @brief Updates user input without showing a new frame
+void SkipSwap();
+
 /// @brief Returns true if VSync is supported by the software and hardware
 /// @return true if VSync is supported by the software and hardware
 bool IsVSyncSupported();
@@ -121,6 +137,34 @@ std::string CanonicalizePath(const char *path);
 /// @return relative path *from* source *to* target
 std::string RelativePathFromTo(const char *from, const char *to);
 
+/// @brief Opens a file for mapping it into memory
+/// @param [in] file_name Path to the file
+/// @param [out] out_file Address of a handle to fill
+/// @param [out] out_size Address of a variable to fill with the file size
+/// @return true on success
+bool OpenMappedFile(const char *file_name, MappedFileHandle *out_file,
+    Ui64 *out_size);
+
+/// @brief Closes a file opened with OpenMappedFile
+/// The views mapped from the file stay valid.
+/// @param [in, out] file Handle of the file
+void CloseMappedFile(MappedFileHandle *file);
+
+/// @brief Maps a part of a file into memory
+/// The view is private and copy-on-write, so writes to it reach neither
+/// the file nor the other views of the file.
+/// @param [in] file Handle returned by OpenMappedFile
+/// @param [in] offset Offset of the part in the file
+/// @param [in] size Size of the part in bytes, greater than 0
+/// @param [out] out_view Address of a view to fill
+/// @return true on success
+bool MapFileView(const MappedFileHandle &file, Ui64 offset, Ui64 size,
+    MappedFileView *out_view);
+
+/// @brief Unmaps a view mapped with MapFileView
+/// @param [in, out] view The view to unmap
+void UnmapFileView(MappedFileView *view);
+
 /// @}
 
 }  // namespace arctic
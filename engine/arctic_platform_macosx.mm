@@ -33,7 +33,9 @@
 
 #include <arpa/inet.h>
 #include <dirent.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 
 #define _USE_MATH_DEFINES
@@ -390,19 +392,16 @@ isScroll: (bool)is_scroll {
   controller.axis[4] = c.rightTrigger.value;
   controller.axis[5] = c.leftTrigger.value;
 
-  msg.keyboard.state[arctic::kKeyController0Button0 + 32*controller_idx] = c.buttonA.pressed;
-  msg.keyboard.state[arctic::kKeyController0Button1 + 32*controller_idx] = c.buttonB.pressed;
-
-  msg.keyboard.state[arctic::kKeyController0Button3 + 32*controller_idx] = c.buttonX.pressed;
-  msg.keyboard.state[arctic::kKeyController0Button4 + 32*controller_idx] = c.buttonY.pressed;
-
-  msg.keyboard.state[arctic::kKeyController0Button6 + 32*controller_idx] = c.rightShoulder.pressed;
-  msg.keyboard.state[arctic::kKeyController0Button7 + 32*controller_idx] = c.leftShoulder.pressed;
-
-  msg.keyboard.state[arctic::kKeyController0Button24 + 32*controller_idx] = c.dpad.up.pressed;
-  msg.keyboard.state[arctic::kKeyController0Button25 + 32*controller_idx] = c.dpad.right.pressed;
-  msg.keyboard.state[arctic::kKeyController0Button26 + 32*controller_idx] = c.dpad.down.pressed;
-  msg.keyboard.state[arctic::kKeyController0Button27 + 32*controller_idx] = c.dpad.left.pressed;
+  controller.buttons = (c.buttonA.pressed ? 1u << 0 : 0u)
+    | (c.buttonB.pressed ? 1u << 1 : 0u)
+    | (c.buttonX.pressed ? 1u << 3 : 0u)
+    | (c.buttonY.pressed ? 1u << 4 : 0u)
+    | (c.rightShoulder.pressed ? 1u << 6 : 0u)
+    | (c.leftShoulder.pressed ? 1u << 7 : 0u)
+    | (c.dpad.up.pressed ? 1u << 24 : 0u)
+    | (c.dpad.right.pressed ? 1u << 25 : 0u)
+    | (c.dpad.down.pressed ? 1u << 26 : 0u)
+    | (c.dpad.left.pressed ? 1u << 27 : 0u);
 
   PushInputMessage(msg);
 }
@@ -811,6 +810,10 @@ void ExitProgram(Si32 exit_code) {
 
 void Swap() {
   [[g_main_view openGLContext] flushBuffer];
+  SkipSwap();
+}
+
+void SkipSwap() {
   PumpMessages();
 
   NSRect rect = [g_main_view convertRectToBacking: [g_main_view frame]];
@@ -993,6 +996,55 @@ std::string RelativePathFromTo(const char *from, const char *to) {
   return res.str();
 }
 
+bool OpenMappedFile(const char *file_name, MappedFileHandle *out_file,
+    Ui64 *out_size) {
+  Check(out_file && out_size,
+    "OpenMappedFile error, out_file and out_size can't be nullptr");
+  out_file->nix = open(file_name, O_RDONLY);
+  if (out_file->nix < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(out_file->nix, &info) != 0) {
+    CloseMappedFile(out_file);
+    return false;
+  }
+  *out_size = static_cast<Ui64>(info.st_size);
+  return true;
+}
+
+void CloseMappedFile(MappedFileHandle *file) {
+  if (file->nix >= 0) {
+    close(file->nix);
+    file->nix = -1;
+  }
+}
+
+bool MapFileView(const MappedFileHandle &file, Ui64 offset, Ui64 size,
+    MappedFileView *out_view) {
+  Check(out_view, "MapFileView error, out_view can't be nullptr");
+  const Ui64 granularity = static_cast<Ui64>(sysconf(_SC_PAGESIZE));
+  const Ui64 base_offset = offset - offset % granularity;
+  const Ui64 base_size = size + (offset - base_offset);
+  void *base = mmap(nullptr, static_cast<size_t>(base_size),
+    PROT_READ | PROT_WRITE, MAP_PRIVATE, file.nix,
+    static_cast<off_t>(base_offset));
+  if (base == MAP_FAILED) {
+    return false;
+  }
+  out_view->base = static_cast<Ui8*>(base);
+  out_view->base_size = base_size;
+  out_view->data = out_view->base + (offset - base_offset);
+  return true;
+}
+
+void UnmapFileView(MappedFileView *view) {
+  if (view->base) {
+    munmap(view->base, static_cast<size_t>(view->base_size));
+  }
+  *view = MappedFileView();
+}
+
 }  // namespace arctic
 
 #ifndef ARCTIC_NO_MAIN
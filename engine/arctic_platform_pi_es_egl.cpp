@@ -190,6 +190,11 @@ void Swap() {
   arctic::GetEngine()->OnWindowResize(g_window_width, g_window_height);
 }
 
+void SkipSwap() {
+  PumpMessages();
+  arctic::GetEngine()->OnWindowResize(g_window_width, g_window_height);
+}
+
 bool IsVSyncSupported() {
   return true;
 }
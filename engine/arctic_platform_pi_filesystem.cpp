@@ -29,13 +29,17 @@
 #ifdef ARCTIC_PLATFORM_PI
 
 #include <dirent.h>
+#include <fcntl.h>
 #include <cstring>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <deque>
+#include <ostream>
+#include <sstream>
 #include <string>
 
-#include "engine/easy.h"
+#include "engine/log.h"
 
 extern void EasyMain();
 
@@ -167,6 +171,55 @@ std::string RelativePathFromTo(const char *from, const char *to) {
   return res.str();
 }
 
+bool OpenMappedFile(const char *file_name, MappedFileHandle *out_file,
+    Ui64 *out_size) {
+  Check(out_file && out_size,
+    "OpenMappedFile error, out_file and out_size can't be nullptr");
+  out_file->nix = open(file_name, O_RDONLY);
+  if (out_file->nix < 0) {
+    return false;
+  }
+  struct stat info;
+  if (fstat(out_file->nix, &info) != 0) {
+    CloseMappedFile(out_file);
+    return false;
+  }
+  *out_size = static_cast<Ui64>(info.st_size);
+  return true;
+}
+
+void CloseMappedFile(MappedFileHandle *file) {
+  if (file->nix >= 0) {
+    close(file->nix);
+    file->nix = -1;
+  }
+}
+
+bool MapFileView(const MappedFileHandle &file, Ui64 offset, Ui64 size,
+    MappedFileView *out_view) {
+  Check(out_view, "MapFileView error, out_view can't be nullptr");
+  const Ui64 granularity = static_cast<Ui64>(sysconf(_SC_PAGESIZE));
+  const Ui64 base_offset = offset - offset % granularity;
+  const Ui64 base_size = size + (offset - base_offset);
+  void *base = mmap(nullptr, static_cast<size_t>(base_size),
+    PROT_READ | PROT_WRITE, MAP_PRIVATE, file.nix,
+    static_cast<off_t>(base_offset));
+  if (base == MAP_FAILED) {
+    return false;
+  }
+  out_view->base = static_cast<Ui8*>(base);
+  out_view->base_size = base_size;
+  out_view->data = out_view->base + (offset - base_offset);
+  return true;
+}
+
+void UnmapFileView(MappedFileView *view) {
+  if (view->base) {
+    munmap(view->base, static_cast<size_t>(view->base_size));
+  }
+  *view = MappedFileView();
+}
+
 
 }  // namespace arctic
 
@@ -205,6 +205,11 @@ void Swap() {
   arctic::GetEngine()->OnWindowResize(g_window_width, g_window_height);
 }
 
+void SkipSwap() {
+  PumpMessages();
+  arctic::GetEngine()->OnWindowResize(g_window_width, g_window_height);
+}
+
 bool IsVSyncSupported() {
   const char *extensions = (const char*)glGetString(GL_EXTENSIONS);
   if (strstr(extensions, "GLX_SGI_swap_control") == nullptr) {
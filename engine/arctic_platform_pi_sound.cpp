@@ -126,7 +126,6 @@ static unsigned int g_period_time_us = 10000;
 
 struct async_private_data {
   std::vector<Si16> samples;
-  std::vector<float> mix;
   std::vector<Si16> tmp;
   snd_async_handler_t *ahandler = nullptr;
   snd_pcm_t *handle = nullptr;
@@ -139,22 +138,8 @@ static async_private_data g_data;
 
 void MixSound() {
   async_private_data *data = &g_data;
-  float *mix_l = &data->mix[0];
-  float *mix_r = &data->mix[1];
-  Si32 mix_stride = 2;
-  Si32 buffer_samples_per_channel = data->period_size;
-
-  g_sound_mixer_state.MixSound(mix_l, mix_r, mix_stride, buffer_samples_per_channel, data->tmp.data());
-
-  // Convert to 16-bit integer format.
-  unsigned char *out_buffer = (unsigned char *)data->samples.data();
-  Si32 buffer_samples_total = data->period_size * 2;
-  for (Si32 i = 0; i < buffer_samples_total; ++i) {
-    Si16 res = static_cast<Si16>(Clamp(
-      data->mix[i] * 32767.f, -32767.f, 32767.f));
-    out_buffer[i * 2 + 0] = res & 0xff;
-    out_buffer[i * 2 + 1] = (res >> 8) & 0xff;
-  }
+  g_sound_mixer_state.MixSoundToSi16(data->samples.data(),
+    static_cast<Si32>(data->period_size), data->tmp.data());
 }
 
 static void SoundMixerCallback(snd_async_handler_t *ahandler) {
@@ -368,8 +353,9 @@ void StartSoundMixer(const char* output_device_name) {
 
   // start sound
   g_data.samples.resize(g_data.period_size * 2, 0);
-  g_data.mix.resize(g_data.period_size * 2, 0);
   g_data.tmp.resize(g_data.period_size * 2, 0);
+  g_sound_mixer_state.ReserveMixBuffers(
+    static_cast<Si32>(g_data.period_size));
   err = snd_async_add_pcm_handler(&g_data.ahandler, g_data.handle,
       SoundMixerCallback, &g_data);
   if (err == -ENOSYS) {
@@ -84,6 +84,12 @@ void StopSound(const SoundHandle &handle);
 void SetSoundListenerLocation(Transform3F location);
 void SetSoundSourcePosition(Sound sound, Vec3F position);
 void SetSoundSourcePosition(const SoundHandle &handle, Vec3F position);
+/// @brief Moves many playing sounds with a single mixer command
+/// @param handles Handles of the sounds to move
+/// @param positions New positions, one per handle
+/// @param count Number of handles and positions
+void SetSoundSourcePositions(const SoundHandle *handles,
+  const Vec3F *positions, Si32 count);
 SoundHandle StartSoundAtPosition(Sound sound, float volume, Vec3F position);
 
 /// @}
@@ -98,6 +104,20 @@ void SetMasterVolume(float volume);
 /// @return The master volume level
 float GetMasterVolume();
 
+/// @brief Limits the 3D voices the mixer renders.
+/// Voices that are not rendered keep playing silently and fade back in.
+/// @param max_distance Voices further than this from the listener
+/// are not rendered, 0.f disables distance culling.
+/// @param max_voices Only this many of the loudest voices are rendered,
+/// 0 disables voice stealing.
+void SetSound3dCulling(float max_distance, Si32 max_voices);
+
+/// @brief Enables or disables the background thread that decodes
+/// the sounds loaded with do_unpack == false ahead of the mixer.
+/// Without it the mixer thread decodes them as they play.
+/// @param is_enabled True to start the thread, false to stop it.
+void SetSoundDecodeThread(bool is_enabled);
+
 /// @brief Plays asynchronously the note specified for the duration specified.
 /// @param duration_seconds Sound duration in seconds.
 /// @param note Index of the note to play, index of C4 is 0, index of C#4 is 1, etc.
@@ -82,11 +82,13 @@ PFNGLCREATESHADERPROC glCreateShader = nullptr;
 PFNGLDELETEPROGRAMPROC glDeleteProgram = nullptr;
 PFNGLDELETESHADERPROC glDeleteShader = nullptr;
 PFNGLENABLEVERTEXATTRIBARRAYPROC glEnableVertexAttribArray = nullptr;
+PFNGLDISABLEVERTEXATTRIBARRAYPROC glDisableVertexAttribArray = nullptr;
 PFNGLGETPROGRAMIVPROC glGetProgramiv = nullptr;
 PFNGLGETPROGRAMINFOLOGPROC glGetProgramInfoLog = nullptr;
 PFNGLGETSHADERIVPROC glGetShaderiv = nullptr;
 PFNGLGETSHADERINFOLOGPROC glGetShaderInfoLog = nullptr;
 PFNGLGETUNIFORMLOCATIONPROC glGetUniformLocation = nullptr;
+PFNGLGETACTIVEUNIFORMPROC glGetActiveUniform = nullptr;
 PFNGLLINKPROGRAMPROC glLinkProgram = nullptr;
 PFNGLSHADERSOURCEPROC glShaderSource = nullptr;
 PFNGLUSEPROGRAMPROC glUseProgram = nullptr;
@@ -573,11 +575,13 @@ void LoadGl() {
   LoadGlFunction("glDeleteProgram", &glDeleteProgram);
   LoadGlFunction("glDeleteShader", &glDeleteShader);
   LoadGlFunction("glEnableVertexAttribArray", &glEnableVertexAttribArray);
+  LoadGlFunction("glDisableVertexAttribArray", &glDisableVertexAttribArray);
   LoadGlFunction("glGetProgramiv", &glGetProgramiv);
   LoadGlFunction("glGetProgramInfoLog", &glGetProgramInfoLog);
   LoadGlFunction("glGetShaderiv", &glGetShaderiv);
   LoadGlFunction("glGetShaderInfoLog", &glGetShaderInfoLog);
   LoadGlFunction("glGetUniformLocation", &glGetUniformLocation);
+  LoadGlFunction("glGetActiveUniform", &glGetActiveUniform);
   LoadGlFunction("glLinkProgram", &glLinkProgram);
   LoadGlFunction("glShaderSource", &glShaderSource);
   LoadGlFunction("glUseProgram", &glUseProgram);
@@ -742,7 +746,10 @@ void Swap() {
   HDC hdc = wglGetCurrentDC();
   BOOL res = SwapBuffers(hdc);
   CheckWithLastError(res != FALSE, "SwapBuffers error in Swap.");
+  SkipSwap();
+}
 
+void SkipSwap() {
   RECT client_rect;
   GetClientRect(g_system_info.window_handle, &client_rect);
 
@@ -752,7 +759,8 @@ void Swap() {
     SetWindowPos(g_system_info.inner_window_handle, 0, 0, 0,
       wid, hei, SWP_NOZORDER);
     RECT rect;
-    res = GetClientRect(g_system_info.inner_window_handle, &rect);
+    BOOL res = GetClientRect(g_system_info.inner_window_handle, &rect);
+    CheckWithLastError(res != FALSE, "GetClientRect error in SkipSwap.");
     g_window_width = wid;
     g_window_height = hei;
     arctic::GetEngine()->OnWindowResize(rect.right, rect.bottom);
@@ -903,6 +911,66 @@ std::string RelativePathFromTo(const char *from, const char *to) {
   return result;
 }
 
+bool OpenMappedFile(const char *file_name, MappedFileHandle *out_file,
+    Ui64 *out_size) {
+  Check(out_file && out_size,
+    "OpenMappedFile error, out_file and out_size can't be nullptr");
+  HANDLE file = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ,
+    nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    CloseHandle(file);
+    return false;
+  }
+  // The mapping object keeps the file open after its handle is closed.
+  out_file->win = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY,
+    0, 0, nullptr);
+  CloseHandle(file);
+  if (!out_file->win) {
+    return false;
+  }
+  *out_size = static_cast<Ui64>(size.QuadPart);
+  return true;
+}
+
+void CloseMappedFile(MappedFileHandle *file) {
+  if (file->win) {
+    CloseHandle(file->win);
+    file->win = nullptr;
+  }
+}
+
+bool MapFileView(const MappedFileHandle &file, Ui64 offset, Ui64 size,
+    MappedFileView *out_view) {
+  Check(out_view, "MapFileView error, out_view can't be nullptr");
+  SYSTEM_INFO system_info;
+  GetSystemInfo(&system_info);
+  const Ui64 granularity = system_info.dwAllocationGranularity;
+  const Ui64 base_offset = offset - offset % granularity;
+  const Ui64 base_size = size + (offset - base_offset);
+  void *base = MapViewOfFile(file.win, FILE_MAP_COPY,
+    static_cast<DWORD>(base_offset >> 32),
+    static_cast<DWORD>(base_offset & 0xffffffffull),
+    static_cast<SIZE_T>(base_size));
+  if (!base) {
+    return false;
+  }
+  out_view->base = static_cast<Ui8*>(base);
+  out_view->base_size = base_size;
+  out_view->data = out_view->base + (offset - base_offset);
+  return true;
+}
+
+void UnmapFileView(MappedFileView *view) {
+  if (view->base) {
+    UnmapViewOfFile(view->base);
+  }
+  *view = MappedFileView();
+}
+
 }  // namespace arctic
 
 int APIENTRY wWinMain(_In_ HINSTANCE instance_handle,
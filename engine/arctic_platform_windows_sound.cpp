@@ -161,10 +161,7 @@ void SoundMixerThreadFunction() {
   std::vector<WAVEHDR> wave_headers(buffer_count);
   std::vector<std::vector<Si16>> wave_buffers(buffer_count);
   std::vector<Si16> tmp(buffer_samples_total);
-  std::vector<float> mix(buffer_samples_total);
-  float *mix_l = &mix[0];
-  float *mix_r = &mix[1];
-  Si32 mix_stride = 2;
+  g_sound_mixer_state.ReserveMixBuffers(buffer_samples_per_channel);
   for (Ui32 i = 0; i < wave_headers.size(); ++i) {
     wave_buffers[i].resize(buffer_samples_total);
 
@@ -191,14 +188,8 @@ void SoundMixerThreadFunction() {
     }
     (*(volatile DWORD*)&wave_headers[cur_buffer_idx].dwFlags) &= ~WHDR_DONE;
 
-    g_sound_mixer_state.MixSound(mix_l, mix_r, mix_stride, buffer_samples_per_channel, tmp.data());
-
-    // Convert to 16-bit integer format.
-    Si16* out_data = &(wave_buffers[cur_buffer_idx][0]);
-    for (Si32 i = 0; i < buffer_samples_total; ++i) {
-      out_data[i] = static_cast<Si16>(Clamp(
-        mix[i] * 32767.f, -32767.f, 32767.f));
-    }
+    g_sound_mixer_state.MixSoundToSi16(&(wave_buffers[cur_buffer_idx][0]),
+      buffer_samples_per_channel, tmp.data());
 
     waveOutWrite(wave_out_handle,
       &wave_headers[cur_buffer_idx], sizeof(WAVEHDR));
@@ -27,7 +27,6 @@
 #include <cmath>
 #include "engine/arctic_mixer.h"
 #include "engine/arctic_platform_sound.h"
-#include "engine/easy.h"
 
 namespace arctic {
 
@@ -41,6 +40,9 @@ SoundHandle StartSound(Sound sound, float volume) {
       buffer->sound = sound;
       buffer->volume = volume;
       buffer->sound.GetInstance()->IncPlaying();
+      if (sound.GetInstance()->GetFormat() == kSoundDataVorbis) {
+        buffer->stream.Open(*sound.GetInstance());
+      }
       buffer->action = SoundTaskAction::kStart;  //-V1048
       buffer->is_playing = true;
       g_sound_mixer_state.AddSoundTask(buffer);
@@ -69,6 +71,7 @@ void StopSound(const SoundHandle &handle) {
       buffer->volume = 0.f;
       buffer->action = SoundTaskAction::kStop;
       buffer->target_uid = handle.GetUid();
+      buffer->target_task = handle.GetSoundTask();
       g_sound_mixer_state.AddSoundTask(buffer);
     }
   }
@@ -102,11 +105,31 @@ void SetSoundSourcePosition(const SoundHandle &handle, Vec3F position) {
       buffer->location.displacement = position;
       buffer->action = SoundTaskAction::kSetLocation;
       buffer->target_uid = handle.GetUid();
+      buffer->target_task = handle.GetSoundTask();
       g_sound_mixer_state.AddSoundTask(buffer);
     }
   }
 }
 
+void SetSoundSourcePositions(const SoundHandle *handles,
+    const Vec3F *positions, Si32 count) {
+  if (count <= 0) {
+    return;
+  }
+  SoundTask *buffer = g_sound_mixer_state.AllocateSoundTask();
+  if (buffer) {
+    buffer->location_updates.resize(static_cast<size_t>(count));
+    for (Si32 idx = 0; idx < count; ++idx) {
+      SoundLocationUpdate &update = buffer->location_updates[idx];
+      update.target_task = handles[idx].GetSoundTask();
+      update.target_uid = handles[idx].GetUid();
+      update.position = positions[idx];
+    }
+    buffer->action = SoundTaskAction::kSetLocations;
+    g_sound_mixer_state.AddSoundTask(buffer);
+  }
+}
+
 
 SoundHandle StartSoundAtPosition(Sound sound, float volume, Vec3F position) {
   if (sound.GetInstance()) {
@@ -137,6 +160,19 @@ float GetMasterVolume() {
   return g_sound_mixer_state.master_volume.load();
 }
 
+void SetSound3dCulling(float max_distance, Si32 max_voices) {
+  g_sound_mixer_state.max_3d_distance.store(max_distance);
+  g_sound_mixer_state.max_3d_voices.store(max_voices);
+}
+
+void SetSoundDecodeThread(bool is_enabled) {
+  if (is_enabled) {
+    g_sound_mixer_state.StartDecodeThread();
+  } else {
+    g_sound_mixer_state.StopDecodeThread();
+  }
+}
+
 Sound BeepAsync(float duration_seconds, Si32 note) {
   if (duration_seconds < 0.01f) {
     duration_seconds = 0.01f;
@@ -163,12 +199,4 @@ Sound BeepAsync(float duration_seconds, Si32 note) {
   return s;
 }
 
-void Beep(float duration_seconds, Si32 note) {
-  ShowFrame();
-  Sound s = BeepAsync(duration_seconds, note);
-  while (s.IsPlaying()) {
-    ;
-  }
-}
-
 }  // namespace arctic
@@ -0,0 +1,439 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "engine/asset_pack.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>  // NOLINT
+#include <sstream>
+#include <utility>
+
+#include "engine/arctic_platform.h"
+#include "engine/easy_files.h"
+#include "engine/easy_sound_instance.h"
+#include "engine/easy_sprite_instance.h"
+#include "engine/log.h"
+#include "engine/miniz.h"
+
+namespace arctic {
+
+// Asset pack file layout, all values are little-endian:
+//   AssetPackHeader
+//   entry names, not zero-terminated
+//   AssetPackEntry index sorted by name_hash, 64-byte aligned
+//   entry data blobs, each 64-byte aligned
+static const char kAssetPackMagic[8] = {'A', 'R', 'C', 'P', 'A', 'C', 'K', '1'};
+static const Ui32 kAssetPackVersion = 1;
+static const Ui64 kAssetPackAlignment = 64;
+
+enum AssetPackCompression {
+  kAssetPackStored = 0,
+  kAssetPackDeflated = 1
+};
+
+struct AssetPackHeader {
+  char magic[8];
+  Ui32 version;
+  Ui32 entry_count;
+  Ui64 names_offset;
+  Ui64 names_size;
+  Ui64 index_offset;
+  Ui64 reserved;
+};
+
+struct AssetPackEntry {
+  Ui64 name_hash;
+  Ui64 data_offset;
+  Ui64 stored_size;  // Size in the pack, differs from size if compressed.
+  Ui64 size;
+  Ui32 name_offset;
+  Ui32 name_length;
+  Ui32 type;
+  Ui32 compression;
+  Si32 width;
+  Si32 height;
+  Si32 pivot_x;
+  Si32 pivot_y;
+};
+
+struct MountedAssetPack {
+  std::string file_name;
+  MappedFileHandle file;
+  MappedFileView view;
+  // A second view of the whole pack to lend sprites and sounds from, so that
+  // writing to them never changes the view the data is copied from.
+  MappedFileView lent_view;
+  Ui8 *data = nullptr;
+  Ui64 size = 0;
+  const char *names = nullptr;
+  const AssetPackEntry *entries = nullptr;
+  Ui32 entry_count = 0;
+  // Set once a load of the sprite or sound entry got its data in place.
+  std::unique_ptr<std::atomic<bool>[]> is_entry_lent;
+
+  ~MountedAssetPack() {
+    UnmapFileView(&lent_view);
+    UnmapFileView(&view);
+    CloseMappedFile(&file);
+  }
+};
+
+static std::mutex g_asset_pack_mutex;
+static std::vector<std::shared_ptr<MountedAssetPack>> g_asset_packs;
+static std::atomic<Ui64> g_asset_pack_view_count = ATOMIC_VAR_INIT(0);
+static std::atomic<Ui64> g_asset_pack_copy_count = ATOMIC_VAR_INIT(0);
+
+static std::string NormalizeAssetPath(const char *file_name) {
+  std::string path(file_name);
+  std::replace(path.begin(), path.end(), '\\', '/');
+  size_t skip = 0;
+  while (path.compare(skip, 2, "./") == 0) {
+    skip += 2;
+  }
+  return path.substr(skip);
+}
+
+// FNV-1a
+static Ui64 AssetPathHash(const std::string &path) {
+  Ui64 hash = 14695981039346656037ull;
+  for (char c : path) {
+    hash ^= static_cast<Ui8>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+static bool IsRangeInside(Ui64 offset, Ui64 size, Ui64 total_size) {
+  return offset <= total_size && size <= total_size - offset;
+}
+
+static bool IsAssetPackValid(const MountedAssetPack &pack) {
+  if (pack.size < sizeof(AssetPackHeader)) {
+    return false;
+  }
+  const AssetPackHeader *header =
+    reinterpret_cast<const AssetPackHeader*>(pack.data);
+  if (memcmp(header->magic, kAssetPackMagic, sizeof(kAssetPackMagic)) != 0 ||
+      header->version != kAssetPackVersion ||
+      header->index_offset % kAssetPackAlignment != 0 ||
+      !IsRangeInside(header->names_offset, header->names_size, pack.size) ||
+      !IsRangeInside(header->index_offset,
+        static_cast<Ui64>(header->entry_count) * sizeof(AssetPackEntry),
+        pack.size)) {
+    return false;
+  }
+  const AssetPackEntry *entries =
+    reinterpret_cast<const AssetPackEntry*>(pack.data + header->index_offset);
+  for (Ui32 idx = 0; idx < header->entry_count; ++idx) {
+    const AssetPackEntry &entry = entries[idx];
+    if ((idx && entries[idx - 1].name_hash > entry.name_hash) ||
+        !IsRangeInside(entry.name_offset, entry.name_length,
+          header->names_size) ||
+        !IsRangeInside(entry.data_offset, entry.stored_size, pack.size) ||
+        entry.type > kAssetPackSound ||
+        entry.compression > kAssetPackDeflated ||
+        (entry.compression == kAssetPackStored &&
+          entry.stored_size != entry.size)) {
+      return false;
+    }
+    if (entry.type == kAssetPackSprite && (entry.width <= 0 ||
+        entry.height <= 0 || entry.size != static_cast<Ui64>(entry.width) *
+          static_cast<Ui64>(entry.height) * 4ull)) {
+      return false;
+    }
+    if (entry.type == kAssetPackSound && entry.size % 4 != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static const AssetPackEntry *FindAssetPackEntry(const MountedAssetPack &pack,
+    const std::string &path, Ui64 hash) {
+  const AssetPackEntry *end = pack.entries + pack.entry_count;
+  const AssetPackEntry *entry = std::lower_bound(pack.entries, end, hash,
+    [](const AssetPackEntry &a, Ui64 b) { return a.name_hash < b; });
+  for (; entry != end && entry->name_hash == hash; ++entry) {
+    if (entry->name_length == path.size() &&
+        memcmp(pack.names + entry->name_offset, path.data(),
+          path.size()) == 0) {
+      return entry;
+    }
+  }
+  return nullptr;
+}
+
+bool MountAssetPack(const char *file_name) {
+  Check(file_name, "MountAssetPack error, file_name can't be nullptr");
+  std::shared_ptr<MountedAssetPack> pack =
+    std::make_shared<MountedAssetPack>();
+  pack->file_name = file_name;
+  if (!OpenMappedFile(file_name, &pack->file, &pack->size) ||
+      pack->size < sizeof(AssetPackHeader) ||
+      !MapFileView(pack->file, 0, pack->size, &pack->view)) {
+    *Log() << "Error in MountAssetPack, can't map the file: \""
+      << file_name << "\".";
+    return false;
+  }
+  pack->data = pack->view.data;
+  if (!IsAssetPackValid(*pack)) {
+    *Log() << "Error in MountAssetPack, file: \""
+      << file_name << "\" is not a valid asset pack.";
+    return false;
+  }
+  const AssetPackHeader *header =
+    reinterpret_cast<const AssetPackHeader*>(pack->data);
+  pack->names = reinterpret_cast<const char*>(
+    pack->data + header->names_offset);
+  pack->entries = reinterpret_cast<const AssetPackEntry*>(
+    pack->data + header->index_offset);
+  pack->entry_count = header->entry_count;
+  if (!MapFileView(pack->file, 0, pack->size, &pack->lent_view)) {
+    *Log() << "Error in MountAssetPack, can't map the file: \""
+      << file_name << "\".";
+    return false;
+  }
+  pack->is_entry_lent.reset(new std::atomic<bool>[pack->entry_count]);
+  for (Ui32 idx = 0; idx < pack->entry_count; ++idx) {
+    pack->is_entry_lent[idx].store(false);
+  }
+  std::lock_guard<std::mutex> lock(g_asset_pack_mutex);
+  g_asset_packs.push_back(std::move(pack));
+  return true;
+}
+
+void UnmountAssetPacks() {
+  std::lock_guard<std::mutex> lock(g_asset_pack_mutex);
+  g_asset_packs.clear();
+}
+
+bool FindPackedAsset(const char *file_name, PackedAsset *out_asset) {
+  Check(out_asset, "FindPackedAsset error, out_asset can't be nullptr");
+  if (!file_name) {
+    return false;
+  }
+  std::shared_ptr<MountedAssetPack> pack;
+  const AssetPackEntry *entry = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(g_asset_pack_mutex);
+    if (g_asset_packs.empty()) {
+      return false;
+    }
+    const std::string path = NormalizeAssetPath(file_name);
+    const Ui64 hash = AssetPathHash(path);
+    for (auto it = g_asset_packs.rbegin(); it != g_asset_packs.rend(); ++it) {
+      entry = FindAssetPackEntry(**it, path, hash);
+      if (entry) {
+        pack = *it;
+        break;
+      }
+    }
+  }
+  if (!entry) {
+    return false;
+  }
+  out_asset->type = static_cast<AssetPackEntryType>(entry->type);
+  out_asset->size = entry->size;
+  out_asset->sprite_size = Vec2Si32(entry->width, entry->height);
+  out_asset->sprite_pivot = Vec2Si32(entry->pivot_x, entry->pivot_y);
+  const Ui8 *stored_data = pack->data + entry->data_offset;
+  if (entry->compression == kAssetPackStored) {
+    if (entry->type == kAssetPackFile) {
+      out_asset->data = pack->data + entry->data_offset;
+      out_asset->owner = std::move(pack);
+      return true;
+    }
+    // Sprites and sounds can be written to, so each load gets its own data.
+    // The first load of an entry uses it in place in the copy-on-write lent
+    // view, the later loads copy it.
+    const size_t entry_idx = static_cast<size_t>(entry - pack->entries);
+    if (!pack->is_entry_lent[entry_idx].exchange(true)) {
+      out_asset->data = pack->lent_view.data + entry->data_offset;
+      out_asset->owner = std::move(pack);
+      g_asset_pack_view_count.fetch_add(1);
+      return true;
+    }
+    g_asset_pack_copy_count.fetch_add(1);
+    std::shared_ptr<std::vector<Ui8>> buffer =
+      std::make_shared<std::vector<Ui8>>(stored_data,
+        stored_data + entry->size);
+    out_asset->data = buffer->data();
+    out_asset->owner = std::move(buffer);
+    return true;
+  }
+  std::shared_ptr<std::vector<Ui8>> buffer =
+    std::make_shared<std::vector<Ui8>>(static_cast<size_t>(entry->size));
+  mz_ulong size = static_cast<mz_ulong>(entry->size);
+  if (size != entry->size || mz_uncompress(buffer->data(), &size,
+        stored_data, static_cast<mz_ulong>(entry->stored_size)) != MZ_OK ||
+      size != entry->size) {
+    *Log() << "Error in FindPackedAsset, can't decompress file: \""
+      << file_name << "\" from the asset pack: \"" << pack->file_name
+      << "\".";
+    return false;
+  }
+  out_asset->data = buffer->data();
+  out_asset->owner = std::move(buffer);
+  return true;
+}
+
+AssetPackStats GetAssetPackStats() {
+  AssetPackStats stats;
+  stats.view_count = g_asset_pack_view_count.load();
+  stats.copy_count = g_asset_pack_copy_count.load();
+  return stats;
+}
+
+struct PendingAssetPackEntry {
+  std::string name;
+  AssetPackEntry entry;
+  std::vector<Ui8> data;
+};
+
+static void PrepareAssetPackEntry(std::vector<Ui8> file, bool is_compressed,
+    PendingAssetPackEntry *out_entry) {
+  AssetPackEntry &entry = out_entry->entry;
+  memset(&entry, 0, sizeof(entry));
+  entry.type = kAssetPackFile;
+  entry.name_hash = AssetPathHash(out_entry->name);
+  const char *last_dot = strrchr(out_entry->name.c_str(), '.');
+  if (last_dot && strcmp(last_dot, ".tga") == 0) {
+    Vec2Si32 pivot(0, 0);
+    std::shared_ptr<SpriteInstance> sprite =
+      LoadTga(file.data(), static_cast<Si64>(file.size()), &pivot);
+    if (sprite) {
+      entry.type = kAssetPackSprite;
+      entry.width = sprite->width();
+      entry.height = sprite->height();
+      entry.pivot_x = pivot.x;
+      entry.pivot_y = pivot.y;
+      const Ui8 *pixels = sprite->RawData();
+      out_entry->data.assign(pixels, pixels +
+        static_cast<size_t>(entry.width) * static_cast<size_t>(entry.height)
+          * 4);
+    }
+  } else if (last_dot && strcmp(last_dot, ".wav") == 0) {
+    std::shared_ptr<SoundInstance> sound =
+      LoadWav(file.data(), static_cast<Si64>(file.size()));
+    if (sound) {
+      entry.type = kAssetPackSound;
+      const Ui8 *samples = reinterpret_cast<const Ui8*>(sound->GetWavData());
+      out_entry->data.assign(samples, samples +
+        static_cast<size_t>(sound->GetDurationSamples()) * 4);
+    }
+  }
+  if (entry.type == kAssetPackFile) {
+    out_entry->data = std::move(file);
+  }
+  entry.size = out_entry->data.size();
+  entry.compression = kAssetPackStored;
+  // Compressed entries can't be used in place, so only compress
+  // the ones that shrink well.
+  if (is_compressed && entry.size >= kAssetPackAlignment &&
+      entry.size == static_cast<mz_ulong>(entry.size)) {
+    mz_ulong packed_size = mz_compressBound(
+      static_cast<mz_ulong>(entry.size));
+    std::vector<Ui8> packed(packed_size);
+    if (mz_compress2(packed.data(), &packed_size, out_entry->data.data(),
+          static_cast<mz_ulong>(entry.size), MZ_DEFAULT_LEVEL) == MZ_OK &&
+        packed_size < entry.size - entry.size / 4) {
+      packed.resize(packed_size);
+      out_entry->data.swap(packed);
+      entry.compression = kAssetPackDeflated;
+    }
+  }
+  entry.stored_size = out_entry->data.size();
+}
+
+static Ui64 AlignAssetPackOffset(Ui64 offset) {
+  return (offset + kAssetPackAlignment - 1) & ~(kAssetPackAlignment - 1);
+}
+
+bool WriteAssetPack(const char *pack_file_name,
+    const std::vector<std::string> &file_names, bool is_compressed) {
+  Check(pack_file_name, "WriteAssetPack error, pack_file_name can't be nullptr");
+  std::vector<PendingAssetPackEntry> entries(file_names.size());
+  for (size_t idx = 0; idx < file_names.size(); ++idx) {
+    std::vector<Ui8> file = ReadFile(file_names[idx].c_str(), true);
+    if (file.empty()) {
+      *Log() << "Error in WriteAssetPack, can't read the file: \""
+        << file_names[idx] << "\".";
+      return false;
+    }
+    entries[idx].name = NormalizeAssetPath(file_names[idx].c_str());
+    PrepareAssetPackEntry(std::move(file), is_compressed, &entries[idx]);
+  }
+  std::sort(entries.begin(), entries.end(),
+    [](const PendingAssetPackEntry &a, const PendingAssetPackEntry &b) {
+      return a.entry.name_hash < b.entry.name_hash ||
+        (a.entry.name_hash == b.entry.name_hash && a.name < b.name);
+    });
+
+  AssetPackHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, kAssetPackMagic, sizeof(kAssetPackMagic));
+  header.version = kAssetPackVersion;
+  header.entry_count = static_cast<Ui32>(entries.size());
+  header.names_offset = sizeof(AssetPackHeader);
+  for (size_t idx = 0; idx < entries.size(); ++idx) {
+    if (idx && entries[idx - 1].name == entries[idx].name) {
+      *Log() << "Error in WriteAssetPack, the file: \""
+        << entries[idx].name << "\" is specified more than once.";
+      return false;
+    }
+    entries[idx].entry.name_offset = static_cast<Ui32>(header.names_size);
+    entries[idx].entry.name_length =
+      static_cast<Ui32>(entries[idx].name.size());
+    header.names_size += entries[idx].name.size();
+  }
+  header.index_offset = AlignAssetPackOffset(
+    header.names_offset + header.names_size);
+  Ui64 offset = AlignAssetPackOffset(header.index_offset +
+    entries.size() * sizeof(AssetPackEntry));
+  for (PendingAssetPackEntry &entry : entries) {
+    entry.entry.data_offset = offset;
+    offset = AlignAssetPackOffset(offset + entry.entry.stored_size);
+  }
+
+  std::vector<Ui8> pack(static_cast<size_t>(offset), 0);
+  memcpy(pack.data(), &header, sizeof(header));
+  for (size_t idx = 0; idx < entries.size(); ++idx) {
+    const PendingAssetPackEntry &entry = entries[idx];
+    memcpy(pack.data() + header.names_offset + entry.entry.name_offset,
+      entry.name.data(), entry.name.size());
+    memcpy(pack.data() + header.index_offset + idx * sizeof(AssetPackEntry),
+      &entry.entry, sizeof(AssetPackEntry));
+    if (!entry.data.empty()) {
+      memcpy(pack.data() + entry.entry.data_offset, entry.data.data(),
+        entry.data.size());
+    }
+  }
+  WriteFile(pack_file_name, pack.data(), pack.size());
+  return true;
+}
+
+}  // namespace arctic
@@ -0,0 +1,102 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef ENGINE_ASSET_PACK_H_
+#define ENGINE_ASSET_PACK_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "engine/arctic_types.h"
+#include "engine/vec2si32.h"
+
+namespace arctic {
+
+/// @addtogroup global_files
+/// @{
+
+/// @brief Kind of data an asset pack entry holds
+enum AssetPackEntryType {
+  kAssetPackFile = 0,  ///< File data as is
+  kAssetPackSprite = 1,  ///< Rgba pixels of a decoded *.tga file
+  kAssetPackSound = 2  ///< 44100 Hz stereo Si16 samples of a decoded *.wav
+};
+
+/// @brief An asset found in a mounted asset pack
+struct PackedAsset {
+  AssetPackEntryType type = kAssetPackFile;
+  /// Sprite and sound data is owned by this asset alone and may be written
+  /// to. kAssetPackFile data is shared by all the loads and is read-only.
+  Ui8 *data = nullptr;
+  Ui64 size = 0;
+  Vec2Si32 sprite_size = Vec2Si32(0, 0);
+  Vec2Si32 sprite_pivot = Vec2Si32(0, 0);
+  /// Keeps the data alive, even after the pack is unmounted.
+  std::shared_ptr<void> owner;
+};
+
+/// @brief Counters of the sprites and sounds loaded from the stored entries
+struct AssetPackStats {
+  Ui64 view_count = 0;  ///< Used in place, in the copy-on-write pack view
+  Ui64 copy_count = 0;  ///< Copied out of the pack, as loaded before
+};
+
+/// @brief Mounts an asset pack so that files are loaded from it
+/// @details The pack file is memory mapped as a whole, with private
+/// copy-on-write views. The first load of a sprite or a sound uses its data
+/// in place, the later loads of the same one copy it.
+/// Packs mounted later take precedence over the ones mounted earlier.
+/// @param [in] file_name Path to the asset pack file
+/// @return true on success
+bool MountAssetPack(const char *file_name);
+
+/// @brief Unmounts all the asset packs
+/// @details Assets already loaded from the packs stay valid.
+void UnmountAssetPacks();
+
+/// @brief Looks the file specified up in the mounted asset packs
+/// @param [in] file_name Path to the file, as passed to Sprite::Load
+/// @param [out] out_asset Address of a PackedAsset to fill
+/// @return true if the file is found
+bool FindPackedAsset(const char *file_name, PackedAsset *out_asset);
+
+/// @brief Returns the counters of the asset loads since the start
+AssetPackStats GetAssetPackStats();
+
+/// @brief Creates an asset pack from the files specified
+/// @details *.tga files are stored as decoded Rgba pixels and *.wav files as
+/// decoded samples, so loading them from the pack needs no copying.
+/// Entries are looked up by the file names exactly as specified.
+/// @param [in] pack_file_name Path to the asset pack file to create
+/// @param [in] file_names Paths to the files to pack
+/// @param [in] is_compressed If true, entries that shrink well are deflated.
+/// Compressed entries are decompressed on each load.
+/// @return true on success
+bool WriteAssetPack(const char *pack_file_name,
+  const std::vector<std::string> &file_names, bool is_compressed);
+
+/// @}
+
+}  // namespace arctic
+
+#endif  // ENGINE_ASSET_PACK_H_
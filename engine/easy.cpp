@@ -25,14 +25,17 @@
 // IN THE SOFTWARE.
 
 #include <chrono>  // NOLINT
-#include <deque>
-#include <fstream>
 #include <limits>
 #include <thread>  // NOLINT
 #include <utility>
+#include <vector>
 
+#include "engine/arctic_job_system.h"
 #include "engine/arctic_platform.h"
 #include "engine/easy_advanced.h"
+#include "engine/easy_async_loading.h"
+#include "engine/easy_deferred_drawing.h"
+#include "engine/easy_dirty_rects.h"
 #include "engine/easy_drawing.h"
 #include "engine/easy_files.h"
 #include "engine/easy_input.h"
@@ -98,7 +101,9 @@ struct KeyState {
 };
 
 static KeyState g_key_state[kKeyCount];
-static std::deque<InputMessage> g_input_messages;
+static std::vector<InputMessage> g_input_messages;
+// Key states after the last message popped by ShowFrame
+static InputMessage::KeyStateBits g_key_state_bits;
 
 static Engine *g_engine = nullptr;
 static Vec2Si32 g_mouse_pos_prev = Vec2Si32(0, 0);
@@ -119,18 +124,20 @@ void DrawLine(Vec2Si32 a, Vec2Si32 b, Rgba color_a, Rgba color_b) {
   DrawLine(GetEngine()->GetBackbuffer(), a, b, color_a, color_b);
 }
 
-void DrawLine(Sprite to_sprite, Vec2Si32 a, Vec2Si32 b,
-    Rgba color_a, Rgba color_b) {
+static void DrawLineClipped(Sprite to_sprite, Vec2Si32 a, Vec2Si32 b,
+    Rgba color_a, Rgba color_b, Si32 clip_y_begin, Si32 clip_y_end) {
   Vec2Si32 ab = b - a;
   Vec2Si32 abs_ab(std::abs(ab.x), std::abs(ab.y));
   if (abs_ab.x >= abs_ab.y) {
     if (a.x > b.x) {
-      DrawLine(b, a, color_b, color_a);
+      DrawLineClipped(to_sprite, b, a, color_b, color_a,
+        clip_y_begin, clip_y_end);
     } else {
       Vec2Si32 back_size = to_sprite.Size();
       if (ab.x == 0) {
         if (a.x >= 0 && a.x < back_size.x &&
-            a.y >= 0 && a.y < back_size.y) {
+            a.y >= 0 && a.y < back_size.y &&
+            a.y >= clip_y_begin && a.y < clip_y_end) {
           to_sprite.RgbaData()[a.x + a.y * to_sprite.StridePixels()] = color_a;
         }
         return;
@@ -184,7 +191,7 @@ void DrawLine(Sprite to_sprite, Vec2Si32 a, Vec2Si32 b,
       Vec4Si32 rgba_12 = rgba_2 - rgba_1;
 
       if (x2 <= x1) {
-        if (x2 == x1) {
+        if (x2 == x1 && y1 >= clip_y_begin && y1 < clip_y_end) {
           Rgba color(static_cast<Ui8>(rgba_1.x),
             static_cast<Ui8>(rgba_1.y),
             static_cast<Ui8>(rgba_1.z),
@@ -206,19 +213,24 @@ void DrawLine(Sprite to_sprite, Vec2Si32 a, Vec2Si32 b,
           static_cast<Ui8>(rgba_16.y >> 16),
           static_cast<Ui8>(rgba_16.z >> 16),
           static_cast<Ui8>(rgba_16.w >> 16));
-        to_sprite.RgbaData()[x + (y_16 >> 16) * stride] = color;
+        Si32 y = y_16 >> 16;
+        if (y >= clip_y_begin && y < clip_y_end) {
+          to_sprite.RgbaData()[x + y * stride] = color;
+        }
         rgba_16 += rgba_12_16_step;
         y_16 += y12_16_step;
       }
     }
   } else {
     if (a.y > b.y) {
-      DrawLine(to_sprite, b, a, color_b, color_a);
+      DrawLineClipped(to_sprite, b, a, color_b, color_a,
+        clip_y_begin, clip_y_end);
     } else {
       Vec2Si32 back_size = to_sprite.Size();
       if (ab.y == 0) {
         if (a.y >= 0 && a.y < back_size.y &&
-          a.x >= 0 && a.x < back_size.x) {
+          a.x >= 0 && a.x < back_size.x &&
+          a.y >= clip_y_begin && a.y < clip_y_end) {
           to_sprite.RgbaData()[
             a.x + a.y * to_sprite.StridePixels()] = color_a;
         }
@@ -273,7 +285,7 @@ void DrawLine(Sprite to_sprite, Vec2Si32 a, Vec2Si32 b,
       Vec4Si32 rgba_12 = rgba_2 - rgba_1;
 
       if (y2 <= y1) {
-        if (y2 == y1) {
+        if (y2 == y1 && y1 >= clip_y_begin && y1 < clip_y_end) {
           Rgba color((Ui8)rgba_1.y, (Ui8)rgba_1.x,
             (Ui8)rgba_1.z, (Ui8)rgba_1.w);
           to_sprite.RgbaData()[
@@ -293,7 +305,9 @@ void DrawLine(Sprite to_sprite, Vec2Si32 a, Vec2Si32 b,
           static_cast<Ui8>(rgba_16.y >> 16u),
           static_cast<Ui8>(rgba_16.z >> 16u),
           static_cast<Ui8>(rgba_16.w >> 16u));
-        to_sprite.RgbaData()[(x_16 >> 16u) + y * stride] = color;
+        if (y >= clip_y_begin && y < clip_y_end) {
+          to_sprite.RgbaData()[(x_16 >> 16u) + y * stride] = color;
+        }
         rgba_16 += rgba_12_16_step;
         x_16 += x12_16_step;
       }
@@ -301,6 +315,31 @@ void DrawLine(Sprite to_sprite, Vec2Si32 a, Vec2Si32 b,
   }
 }
 
+static void DrawLineDeferred(const DeferredDrawCommand &command,
+    Si32 clip_y_begin, Si32 clip_y_end) {
+  DrawLineClipped(command.to_sprite, command.point[0], command.point[1],
+    command.color[0], command.color[1], clip_y_begin, clip_y_end);
+}
+
+void DrawLine(Sprite to_sprite, Vec2Si32 a, Vec2Si32 b,
+    Rgba color_a, Rgba color_b) {
+  MarkSpriteDirty(to_sprite, std::min(a.x, b.x), std::min(a.y, b.y),
+    std::max(a.x, b.x) + 1, std::max(a.y, b.y) + 1);
+  if (IsDeferredDrawingTarget(to_sprite)) {
+    DeferredDrawCommand command;
+    command.draw = DrawLineDeferred;
+    command.to_sprite = to_sprite;
+    command.point[0] = a;
+    command.point[1] = b;
+    command.color[0] = color_a;
+    command.color[1] = color_b;
+    DeferDrawing(command, std::min(a.y, b.y), std::max(a.y, b.y) + 1);
+    return;
+  }
+  FlushDeferredDrawingBeforeWrite(to_sprite);
+  DrawLineClipped(to_sprite, a, b, color_a, color_b, 0, to_sprite.Height());
+}
+
 void DrawTriangle(Vec2Si32 a, Vec2Si32 b, Vec2Si32 c, Rgba color) {
   DrawTriangle(GetEngine()->GetBackbuffer(), a, b, c, color, color, color);
 }
@@ -318,7 +357,7 @@ inline void DrawTrianglePart(Rgba *dst, Si32 stride,
         float dxdy1, float dxdy2,
         Vec4F dcdy1, Vec4F dcdy2,
         Si32 width, Si32 height,
-        Si32 y1, Si32 y2) {
+        Si32 y1, Si32 y2, Si32 clip_y_begin, Si32 clip_y_end) {
     Si32 y = y1;
     if (y1 < 0) {
         Si32 yc = std::min(0, y2);
@@ -329,8 +368,17 @@ inline void DrawTrianglePart(Rgba *dst, Si32 stride,
         *rgba_a += dcdy1 * d;
         *rgba_b += dcdy2 * d;
     }
-    Si32 ye = std::min(height, y2);
+    Si32 ye = std::min(std::min(height, clip_y_end), y2);
     dst += y * stride;
+    // Step over the rows above the clip window the same way as drawing does
+    // so that the result does not depend on the clipping.
+    for (; y < std::min(clip_y_begin, ye); y++) {
+        *x1 += dxdy1;
+        *x2 += dxdy2;
+        *rgba_a += dcdy1;
+        *rgba_b += dcdy2;
+        dst += stride;
+    }
     for (; y < ye; y++) {
         Si32 x1i = static_cast<Si32>(*x1);
         Si32 x2i = static_cast<Si32>(*x2);
@@ -386,8 +434,10 @@ void DrawTriangle(Vec2Si32 a, Vec2Si32 b, Vec2Si32 c,
   DrawTriangle(GetEngine()->GetBackbuffer(), a, b, c, color_a, color_b, color_c);
 }
 
-void DrawTriangle(Sprite to_sprite, Vec2Si32 a, Vec2Si32 b, Vec2Si32 c,
-    Rgba color_a, Rgba color_b, Rgba color_c) {
+static void DrawTriangleClipped(Sprite to_sprite,
+    Vec2Si32 a, Vec2Si32 b, Vec2Si32 c,
+    Rgba color_a, Rgba color_b, Rgba color_c,
+    Si32 clip_y_begin, Si32 clip_y_end) {
   if (a.y > b.y) {
       std::swap(a, b);
       std::swap(color_a, color_b);
@@ -446,7 +496,8 @@ void DrawTriangle(Sprite to_sprite, Vec2Si32 a, Vec2Si32 b, Vec2Si32 c,
           rgba2 = rgba_b;
           DrawTrianglePart(dst, stride, &x1, &x2, &rgba1, &rgba2,
               dxdy1, dxdy2,
-              dcdy1, dcdy2, width, height, a.y, c.y);
+              dcdy1, dcdy2, width, height, a.y, c.y,
+              clip_y_begin, clip_y_end);
           return;
       }
       if (a.y < b.y) {
@@ -458,7 +509,8 @@ void DrawTriangle(Sprite to_sprite, Vec2Si32 a, Vec2Si32 b, Vec2Si32 c,
           rgba2 = rgba_a;
           DrawTrianglePart(dst, stride, &x1, &x2, &rgba1, &rgba2,
               dxdy1, dxdy2,
-              dcdy1, dcdy2, width, height, a.y, b.y);
+              dcdy1, dcdy2, width, height, a.y, b.y,
+              clip_y_begin, clip_y_end);
       }
       if (b.y < c.y) {
           dxdy2 = dxdy_bc;
@@ -467,7 +519,8 @@ void DrawTriangle(Sprite to_sprite, Vec2Si32 a, Vec2Si32 b, Vec2Si32 c,
           rgba2 = rgba_b;
           DrawTrianglePart(dst, stride, &x1, &x2, &rgba1, &rgba2,
               dxdy1, dxdy2,
-              dcdy1, dcdy2, width, height, b.y, c.y);
+              dcdy1, dcdy2, width, height, b.y, c.y,
+              clip_y_begin, clip_y_end);
       }
   } else {
       // b is at the left side
@@ -482,7 +535,8 @@ void DrawTriangle(Sprite to_sprite, Vec2Si32 a, Vec2Si32 b, Vec2Si32 c,
           rgba2 = rgba_a;
           DrawTrianglePart(dst, stride, &x1, &x2, &rgba1, &rgba2,
               dxdy1, dxdy2,
-              dcdy1, dcdy2, width, height, a.y, c.y);
+              dcdy1, dcdy2, width, height, a.y, c.y,
+              clip_y_begin, clip_y_end);
           return;
       }
       if (a.y < b.y) {
@@ -494,7 +548,8 @@ void DrawTriangle(Sprite to_sprite, Vec2Si32 a, Vec2Si32 b, Vec2Si32 c,
           rgba2 = rgba_a;
           DrawTrianglePart(dst, stride, &x1, &x2, &rgba1, &rgba2,
               dxdy1, dxdy2,
-              dcdy1, dcdy2, width, height, a.y, b.y);
+              dcdy1, dcdy2, width, height, a.y, b.y,
+              clip_y_begin, clip_y_end);
       }
       if (b.y < c.y) {
           dxdy1 = dxdy_bc;
@@ -503,21 +558,57 @@ void DrawTriangle(Sprite to_sprite, Vec2Si32 a, Vec2Si32 b, Vec2Si32 c,
           rgba1 = rgba_b;
           DrawTrianglePart(dst, stride, &x1, &x2, &rgba1, &rgba2,
               dxdy1, dxdy2,
-              dcdy1, dcdy2, width, height, b.y, c.y);
+              dcdy1, dcdy2, width, height, b.y, c.y,
+              clip_y_begin, clip_y_end);
       }
   }
 }
 
+static void DrawTriangleDeferred(const DeferredDrawCommand &command,
+    Si32 clip_y_begin, Si32 clip_y_end) {
+  DrawTriangleClipped(command.to_sprite,
+    command.point[0], command.point[1], command.point[2],
+    command.color[0], command.color[1], command.color[2],
+    clip_y_begin, clip_y_end);
+}
+
+void DrawTriangle(Sprite to_sprite, Vec2Si32 a, Vec2Si32 b, Vec2Si32 c,
+    Rgba color_a, Rgba color_b, Rgba color_c) {
+  // The edges are stepped in floats, leave a pixel for the rounding.
+  MarkSpriteDirty(to_sprite, std::min(std::min(a.x, b.x), c.x) - 1,
+    std::min(std::min(a.y, b.y), c.y),
+    std::max(std::max(a.x, b.x), c.x) + 2,
+    std::max(std::max(a.y, b.y), c.y) + 1);
+  if (IsDeferredDrawingTarget(to_sprite)) {
+    DeferredDrawCommand command;
+    command.draw = DrawTriangleDeferred;
+    command.to_sprite = to_sprite;
+    command.point[0] = a;
+    command.point[1] = b;
+    command.point[2] = c;
+    command.color[0] = color_a;
+    command.color[1] = color_b;
+    command.color[2] = color_c;
+    DeferDrawing(command, std::min(std::min(a.y, b.y), c.y),
+      std::max(std::max(a.y, b.y), c.y) + 1);
+    return;
+  }
+  FlushDeferredDrawingBeforeWrite(to_sprite);
+  DrawTriangleClipped(to_sprite, a, b, c, color_a, color_b, color_c,
+    0, to_sprite.Height());
+}
+
 void DrawRectangle(Vec2Si32 ll, Vec2Si32 ur, Rgba color) {
   DrawRectangle(GetEngine()->GetBackbuffer(), ll, ur, color);
 }
 
-void DrawRectangle(Sprite to_sprite, Vec2Si32 ll, Vec2Si32 ur, Rgba color) {
+static void DrawRectangleClipped(Sprite to_sprite, Vec2Si32 ll, Vec2Si32 ur,
+    Rgba color, Si32 clip_y_begin, Si32 clip_y_end) {
   Vec2Si32 limit = to_sprite.Size();
   Si32 x1 = std::max(std::min(ll.x, ur.x), 0);
   Si32 x2 = std::min(std::max(ll.x, ur.x) + 1, limit.x);
-  Si32 y1 = std::max(std::min(ll.y, ur.y), 0);
-  Si32 y2 = std::min(std::max(ll.y, ur.y) + 1, limit.y);
+  Si32 y1 = std::max(std::max(std::min(ll.y, ur.y), 0), clip_y_begin);
+  Si32 y2 = std::min(std::min(std::max(ll.y, ur.y) + 1, limit.y), clip_y_end);
   if (x1 < x2 && y1 < y2) {
     Rgba *data = to_sprite.RgbaData();
     Si32 stride = to_sprite.StridePixels();
@@ -535,7 +626,31 @@ void DrawRectangle(Sprite to_sprite, Vec2Si32 ll, Vec2Si32 ur, Rgba color) {
   }
 }
 
-void SetPixel(const Sprite &to_sprite, Si32 x, Si32 y, Rgba color) {
+static void DrawRectangleDeferred(const DeferredDrawCommand &command,
+    Si32 clip_y_begin, Si32 clip_y_end) {
+  DrawRectangleClipped(command.to_sprite, command.point[0], command.point[1],
+    command.color[0], clip_y_begin, clip_y_end);
+}
+
+void DrawRectangle(Sprite to_sprite, Vec2Si32 ll, Vec2Si32 ur, Rgba color) {
+  MarkSpriteDirty(to_sprite, std::min(ll.x, ur.x), std::min(ll.y, ur.y),
+    std::max(ll.x, ur.x) + 1, std::max(ll.y, ur.y) + 1);
+  if (IsDeferredDrawingTarget(to_sprite)) {
+    DeferredDrawCommand command;
+    command.draw = DrawRectangleDeferred;
+    command.to_sprite = to_sprite;
+    command.point[0] = ll;
+    command.point[1] = ur;
+    command.color[0] = color;
+    DeferDrawing(command, std::min(ll.y, ur.y), std::max(ll.y, ur.y) + 1);
+    return;
+  }
+  FlushDeferredDrawingBeforeWrite(to_sprite);
+  DrawRectangleClipped(to_sprite, ll, ur, color, 0, to_sprite.Height());
+}
+
+static void SetPixelUnclipped(const Sprite &to_sprite, Si32 x, Si32 y,
+    Rgba color) {
   Rgba *data = const_cast<Rgba*>(to_sprite.RgbaData());
   Si32 stride = to_sprite.StridePixels();
   if (x >= 0 && x < to_sprite.Width() && y >= 0 && y < to_sprite.Height()) {
@@ -543,21 +658,39 @@ void SetPixel(const Sprite &to_sprite, Si32 x, Si32 y, Rgba color) {
   }
 }
 
-void SetPixel(Si32 x, Si32 y, Rgba color) {
-  Sprite to_sprite = GetEngine()->GetBackbuffer();
-  Rgba *data = to_sprite.RgbaData();
-  Si32 stride = to_sprite.StridePixels();
-  if (x >= 0 && x < to_sprite.Width() && y >= 0 && y < to_sprite.Height()) {
-    data[x + y * stride] = color;
+// The command covers a single row, so the band always contains it.
+static void SetPixelDeferred(const DeferredDrawCommand &command,
+    Si32, Si32) {
+  SetPixelUnclipped(command.to_sprite, command.point[0].x, command.point[0].y,
+    command.color[0]);
+}
+
+void SetPixel(const Sprite &to_sprite, Si32 x, Si32 y, Rgba color) {
+  MarkSpriteDirty(to_sprite, x, y, x + 1, y + 1);
+  if (IsDeferredDrawingTarget(to_sprite)) {
+    DeferredDrawCommand command;
+    command.draw = SetPixelDeferred;
+    command.to_sprite = to_sprite;
+    command.point[0] = Vec2Si32(x, y);
+    command.color[0] = color;
+    DeferDrawing(command, y, y + 1);
+    return;
   }
+  FlushDeferredDrawingBeforeWrite(to_sprite);
+  SetPixelUnclipped(to_sprite, x, y, color);
 }
 
-void ReplaceColor(Sprite to_sprite, Rgba old_color, Rgba new_color) {
+void SetPixel(Si32 x, Si32 y, Rgba color) {
+  SetPixel(GetEngine()->GetBackbuffer(), x, y, color);
+}
+
+static void ReplaceColorClipped(Sprite to_sprite, Rgba old_color,
+    Rgba new_color, Si32 clip_y_begin, Si32 clip_y_end) {
   Rgba *data = to_sprite.RgbaData();
   Si32 stride = to_sprite.StridePixels();
-  const Si32 height = to_sprite.Height();
+  const Si32 height = std::min(to_sprite.Height(), clip_y_end);
   const Si32 width = to_sprite.Width();
-  for (Si32 y = 0; y < height; ++y) {
+  for (Si32 y = std::max(0, clip_y_begin); y < height; ++y) {
     Rgba *p_begin = data + stride * y;
     Rgba *p_end = p_begin + width;
     for (Rgba *p = p_begin; p < p_end; ++p) {
@@ -568,7 +701,30 @@ void ReplaceColor(Sprite to_sprite, Rgba old_color, Rgba new_color) {
   }
 }
 
+static void ReplaceColorDeferred(const DeferredDrawCommand &command,
+    Si32 clip_y_begin, Si32 clip_y_end) {
+  ReplaceColorClipped(command.to_sprite, command.color[0], command.color[1],
+    clip_y_begin, clip_y_end);
+}
+
+void ReplaceColor(Sprite to_sprite, Rgba old_color, Rgba new_color) {
+  MarkSpriteDirty(to_sprite, 0, 0, to_sprite.Width(), to_sprite.Height());
+  if (IsDeferredDrawingTarget(to_sprite)) {
+    DeferredDrawCommand command;
+    command.draw = ReplaceColorDeferred;
+    command.to_sprite = to_sprite;
+    command.color[0] = old_color;
+    command.color[1] = new_color;
+    DeferDrawing(command, 0, to_sprite.Height());
+    return;
+  }
+  FlushDeferredDrawingBeforeWrite(to_sprite);
+  ReplaceColorClipped(to_sprite, old_color, new_color,
+    0, to_sprite.Height());
+}
+
 Rgba GetPixel(const Sprite &from_sprite, Si32 x, Si32 y) {
+  FlushDeferredDrawingBeforeRead(from_sprite);
   const Rgba *data = from_sprite.RgbaData();
   Si32 stride = from_sprite.StridePixels();
   if (x >= 0 && x < from_sprite.Width() && y >= 0 && y < from_sprite.Height()) {
@@ -579,14 +735,7 @@ Rgba GetPixel(const Sprite &from_sprite, Si32 x, Si32 y) {
 }
 
 Rgba GetPixel(Si32 x, Si32 y) {
-  Sprite from_sprite = GetEngine()->GetBackbuffer();
-  Rgba *data = from_sprite.RgbaData();
-  Si32 stride = from_sprite.StridePixels();
-  if (x >= 0 && x < from_sprite.Width() && y >= 0 && y < from_sprite.Height()) {
-    return data[x + y * stride];
-  } else {
-    return Rgba(0, 0, 0);
-  }
+  return GetPixel(GetEngine()->GetBackbuffer(), x, y);
 }
 
 void DrawCircle(Vec2Si32 c, Si32 r, Rgba color) {
@@ -601,7 +750,8 @@ void DrawOval(Vec2Si32 c, Vec2Si32 r, Rgba color) {
   DrawOval(GetEngine()->GetBackbuffer(), c, r, color);
 }
 
-void DrawOval(Sprite to_sprite, Vec2Si32 c, Vec2Si32 r, Rgba color) {
+static void DrawOvalClipped(Sprite to_sprite, Vec2Si32 c, Vec2Si32 r,
+    Rgba color, Si32 clip_y_begin, Si32 clip_y_end) {
   Sprite back = to_sprite;
   Vec2Si32 limit = back.Size();
   MathTables &tables = GetEngine()->GetMathTables();
@@ -612,8 +762,8 @@ void DrawOval(Sprite to_sprite, Vec2Si32 c, Vec2Si32 r, Rgba color) {
   if (r.x >= 0) {
     // from c up
     {
-      Si32 y1 = std::max(c.y + 1, 0);
-      Si32 y2 = std::min(c.y + r.y + 1, limit.y);
+      Si32 y1 = std::max(std::max(c.y + 1, 0), clip_y_begin);
+      Si32 y2 = std::min(std::min(c.y + r.y + 1, limit.y), clip_y_end);
       if (y1 < y2) {
         for (Si32 y = y1; y < y2; ++y) {
           Si32 table_y = (tables.cicrle_16_16_mask * (y - c.y)
@@ -631,7 +781,8 @@ void DrawOval(Sprite to_sprite, Vec2Si32 c, Vec2Si32 r, Rgba color) {
       }
     }
     // center line
-    if (c.y > 0 && c.y < limit.y) {
+    if (c.y > 0 && c.y < limit.y &&
+        c.y >= clip_y_begin && c.y < clip_y_end) {
       Si32 x1 = std::max(c.x - r.x, 0);
       Si32 x2 = std::min(c.x + r.x, limit.x - 1);
       Rgba *p = data + stride * c.y + x1;
@@ -643,8 +794,8 @@ void DrawOval(Sprite to_sprite, Vec2Si32 c, Vec2Si32 r, Rgba color) {
 
     // from bottom to c
     {
-      Si32 y1 = std::max(c.y - r.y, 0);
-      Si32 y2 = std::min(c.y, limit.y);
+      Si32 y1 = std::max(std::max(c.y - r.y, 0), clip_y_begin);
+      Si32 y2 = std::min(std::min(c.y, limit.y), clip_y_end);
       if (y1 < y2) {
         for (Si32 y = y1; y < y2; ++y) {
           Si32 table_y = (tables.cicrle_16_16_mask * (c.y - y)
@@ -665,12 +816,40 @@ void DrawOval(Sprite to_sprite, Vec2Si32 c, Vec2Si32 r, Rgba color) {
   }
 }
 
+static void DrawOvalDeferred(const DeferredDrawCommand &command,
+    Si32 clip_y_begin, Si32 clip_y_end) {
+  DrawOvalClipped(command.to_sprite, command.point[0], command.point[1],
+    command.color[0], clip_y_begin, clip_y_end);
+}
+
+void DrawOval(Sprite to_sprite, Vec2Si32 c, Vec2Si32 r, Rgba color) {
+  MarkSpriteDirty(to_sprite, c.x - std::abs(r.x), c.y - std::abs(r.y),
+    c.x + std::abs(r.x) + 1, c.y + std::abs(r.y) + 1);
+  if (IsDeferredDrawingTarget(to_sprite)) {
+    DeferredDrawCommand command;
+    command.draw = DrawOvalDeferred;
+    command.to_sprite = to_sprite;
+    command.point[0] = c;
+    command.point[1] = r;
+    command.color[0] = color;
+    DeferDrawing(command, c.y - std::abs(r.y), c.y + std::abs(r.y) + 1);
+    return;
+  }
+  FlushDeferredDrawingBeforeWrite(to_sprite);
+  DrawOvalClipped(to_sprite, c, r, color, 0, to_sprite.Height());
+}
+
 void ShowFrame() {
   GetEngine()->Draw2d();
+  UpdateAsyncLoading();
+  UpdateMainThreadJobs();
 
   for (Si32 i = 0; i < kKeyCount; ++i) {
     g_key_state[i].OnShowFrame();
   }
+  for (Si32 i = 0; i < kKeyCount; ++i) {
+    g_key_state_bits.Set(i, g_key_state[i].IsDown());
+  }
   InputMessage message;
   g_mouse_pos_prev = g_mouse_pos;
   g_mouse_wheel_delta = 0;
@@ -679,6 +858,8 @@ void ShowFrame() {
     if (message.kind == InputMessage::kKeyboard) {
       g_key_state[message.keyboard.key].OnStateChange(
         message.keyboard.key_state == 1);
+      g_key_state_bits.Set(static_cast<Si32>(message.keyboard.key),
+        message.keyboard.key_state == 1);
     } else if (message.kind == InputMessage::kMouse) {
       message.mouse.backbuffer_pos =
         GetEngine()->MouseToBackbuffer(message.mouse.pos);
@@ -687,6 +868,8 @@ void ShowFrame() {
       if (message.keyboard.key != kKeyCount) {
         g_key_state[message.keyboard.key].OnStateChange(
           message.keyboard.key_state == 1);
+        g_key_state_bits.Set(static_cast<Si32>(message.keyboard.key),
+          message.keyboard.key_state == 1);
       }
     } else if (message.kind == InputMessage::kController) {
       if (message.controller.controller_idx >= 0 &&
@@ -696,13 +879,13 @@ void ShowFrame() {
         }
         for (Si32 button_idx = 0; button_idx < 32; ++button_idx) {
           Si32 key_code = kKeyController0Button0 + 32 * message.controller.controller_idx + button_idx;
-          g_key_state[key_code].OnControllerState(message.keyboard.state[key_code] == 1);
+          const bool is_down = ((message.controller.buttons >> button_idx) & 1u) != 0;
+          g_key_state[key_code].OnControllerState(is_down);
+          g_key_state_bits.Set(key_code, is_down);
         }
       }
     }
-    for (Si32 i = 0; i < kKeyCount; ++i) {
-      message.keyboard.state[i] = g_key_state[i].IsDown() ? 1 : 0;
-    }
+    message.keyboard.state = g_key_state_bits;
     g_input_messages.push_back(message);
   }
   g_mouse_move = g_mouse_pos - g_mouse_pos_prev;
@@ -998,93 +1181,12 @@ void Sleep(double duration_seconds) {
     std::chrono::duration<double>(duration_seconds));
 }
 
-std::vector<Ui8> ReadFile(const char *file_name, bool is_bulletproof) {
-  std::ifstream in(file_name, std::ios_base::in | std::ios_base::binary);
-  std::vector<Ui8> data;
-  if (in.rdstate() & std::ios_base::failbit) {
-    if (is_bulletproof) {
-      return data;
-    }
-    Check(false, "Error in ReadFile. Can't open the file, file_name: ",
-      file_name);
-  }
-  in.exceptions(std::ios_base::goodbit);
-  in.seekg(0, std::ios_base::end);
-  if (in.rdstate() & std::ios_base::failbit) {
-    if (is_bulletproof) {
-      in.close();
-      return data;
-    }
-    Check(false, "Error in ReadFile. Can't seek to the end, file_name: ",
-      file_name);
-  }
-    std::streampos pos = in.tellg();
-  if (pos == std::streampos(-1)) {
-    if (is_bulletproof) {
-      in.close();
-      return data;
-    }
-    Check(false, "Error in ReadFile."
-      " Can't determine file size via tellg, file_name: ",
-      file_name);
-  }
-  in.seekg(0, std::ios_base::beg);
-  if (in.rdstate() & std::ios_base::failbit) {
-    if (is_bulletproof) {
-      in.close();
-      return data;
-    }
-    Check(false, "Error in ReadFile. Can't seek to the beg, file_name: ",
-      file_name);
-  }
-
-  if (static_cast<Ui64>(pos) > 0ull) {
-    data.resize(static_cast<size_t>(pos));
-    in.read(reinterpret_cast<char*>(data.data()), pos);
-    if (in.rdstate() != std::ios_base::goodbit) {
-      if (is_bulletproof) {
-        in.close();
-        data.clear();
-        return data;
-      }
-      Check((in.rdstate() & (std::ios_base::failbit | std::ios_base::eofbit))
-          != (std::ios_base::failbit | std::ios_base::eofbit),
-        "Error in ReadFile."
-        " Can't read the data, eofbit is set, file_name: ",
-        file_name);
-      Check(!(in.rdstate() & std::ios_base::badbit),
-        "Error in ReadFile."
-        " Can't read the data, badbit is set, file_name: ",
-        file_name);
-      Check(in.rdstate() == std::ios_base::goodbit,
-        "Error in ReadFile."
-        " Can't read the data, non-goodbit, file_name: ",
-        file_name);
-    }
+void Beep(float duration_seconds, Si32 note) {
+  ShowFrame();
+  Sound s = BeepAsync(duration_seconds, note);
+  while (s.IsPlaying()) {
+    ;
   }
-  in.close();
-  Check(!(in.rdstate() & std::ios_base::failbit) || is_bulletproof,
-    "Error in ReadFile. Can't close the file, file_name: ",
-    file_name);
-  return data;
-}
-
-void WriteFile(const char *file_name, const Ui8 *data, const Ui64 data_size) {
-    std::ofstream out(file_name,
-      std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
-    Check(!(out.rdstate() & std::ios_base::failbit),
-      "Error in WriteFile. Can't create/open the file, file_name: ",
-      file_name);
-    out.exceptions(std::ios_base::goodbit);
-    out.write(reinterpret_cast<const char*>(data),
-      static_cast<std::streamsize>(data_size));
-    Check(!(out.rdstate() & std::ios_base::badbit),
-      "Error in WriteFile. Can't write the file, file_name: ",
-      file_name);
-    out.close();
-    Check(!(out.rdstate() & std::ios_base::failbit),
-      "Error in WriteFile. Can't close the file, file_name: ",
-      file_name);
 }
 
 Engine *GetEngine() {
@@ -24,11 +24,16 @@
 #define ENGINE_EASY_H_
 
 #include "engine/arctic_input.h"
+#include "engine/arctic_job_system.h"
 #include "engine/arctic_types.h"
 #include "engine/csv.h"
 #include "engine/easy_advanced.h"
+#include "engine/easy_async_loading.h"
+#include "engine/easy_deferred_drawing.h"
+#include "engine/easy_dirty_rects.h"
 #include "engine/easy_drawing.h"
 #include "engine/easy_files.h"
+#include "engine/easy_hw_sprite_batch.h"
 #include "engine/easy_input.h"
 #include "engine/easy_sound.h"
 #include "engine/easy_sprite.h"
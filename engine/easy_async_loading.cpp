@@ -0,0 +1,302 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "engine/easy_async_loading.h"
+
+#include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
+#include <limits>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+namespace arctic {
+
+class AsyncLoadingPool {
+ public:
+  ~AsyncLoadingPool() {
+    Stop();
+  }
+
+  Si32 WorkerCount() const {
+    return static_cast<Si32>(threads_.size());
+  }
+
+  void Start(Si32 worker_count) {
+    Stop();
+    is_quitting_ = false;
+    for (Si32 idx = 0; idx < worker_count; ++idx) {
+      threads_.emplace_back(&AsyncLoadingPool::WorkerThreadFunction, this);
+    }
+  }
+
+  // Finishes the jobs pushed already and stops the worker threads.
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      is_quitting_ = true;
+    }
+    work_condvar_.notify_all();
+    for (std::thread &thread : threads_) {
+      thread.join();
+    }
+    threads_.clear();
+  }
+
+  void Push(std::function<void()> job) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      jobs_.push_back(std::move(job));
+    }
+    work_condvar_.notify_one();
+  }
+
+ private:
+  void WorkerThreadFunction() {
+    while (true) {
+      std::function<void()> job;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_condvar_.wait(lock, [this] {
+          return is_quitting_ || !jobs_.empty();
+        });
+        if (jobs_.empty()) {
+          return;
+        }
+        job = std::move(jobs_.front());
+        jobs_.pop_front();
+      }
+      job();
+    }
+  }
+
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable work_condvar_;
+  std::deque<std::function<void()>> jobs_;
+  bool is_quitting_ = false;
+};
+
+struct AsyncHwSpriteUpload {
+  std::shared_ptr<AsyncAsset<HwSprite>::State> state;
+  Sprite sprite;
+};
+
+static std::mutex g_async_mutex;
+static std::condition_variable g_async_condvar;
+static std::deque<AsyncHwSpriteUpload> g_async_uploads;
+static Si32 g_async_load_count = 0;
+static Si32 g_async_ready_count = 0;
+// Set once the caller saw the whole batch ready, the next load starts anew.
+static bool g_is_async_batch_done_seen = false;
+static Si64 g_async_upload_budget = 8 << 20;
+static Si32 g_async_thread_count = 0;
+// Declared last, so the workers are joined before the state above is gone.
+static AsyncLoadingPool g_async_pool;
+
+static void FinishAsyncLoad(AsyncLoadState *state) {
+  {
+    std::lock_guard<std::mutex> lock(g_async_mutex);
+    state->is_ready.store(true, std::memory_order_release);
+    ++g_async_ready_count;
+  }
+  g_async_condvar.notify_all();
+}
+
+template <typename T>
+static AsyncAsset<T> StartAsyncLoad(
+    std::function<void(std::shared_ptr<typename AsyncAsset<T>::State>)>
+      load) {
+  std::shared_ptr<typename AsyncAsset<T>::State> state =
+    std::make_shared<typename AsyncAsset<T>::State>();
+  {
+    std::lock_guard<std::mutex> lock(g_async_mutex);
+    if (g_is_async_batch_done_seen) {
+      // The previous batch was seen done, so start counting a new batch.
+      g_async_load_count = 0;
+      g_async_ready_count = 0;
+      g_is_async_batch_done_seen = false;
+    }
+    ++g_async_load_count;
+  }
+  if (!g_async_pool.WorkerCount()) {
+    Si32 thread_count = g_async_thread_count;
+    if (!thread_count) {
+      thread_count = std::max(1,
+        static_cast<Si32>(std::thread::hardware_concurrency()) - 1);
+    }
+    g_async_pool.Start(thread_count);
+  }
+  g_async_pool.Push([state, load]() {
+    load(state);
+  });
+  return AsyncAsset<T>(state);
+}
+
+// Uploads at least one texture, stops as soon as the budget is spent.
+static void UploadAsyncHwSprites(Si64 budget) {
+  Si64 uploaded = 0;
+  while (true) {
+    AsyncHwSpriteUpload upload;
+    {
+      std::lock_guard<std::mutex> lock(g_async_mutex);
+      if (g_async_uploads.empty() || (uploaded && uploaded >= budget)) {
+        return;
+      }
+      upload = std::move(g_async_uploads.front());
+      g_async_uploads.pop_front();
+    }
+    if (upload.sprite.SpriteInstance()) {
+      HwSprite &sprite = upload.state->asset;
+      sprite.LoadFromSoftwareSprite(upload.sprite);
+      // HwSprite::Load ignores the origin stored in the file as well.
+      sprite.SetPivot(Vec2Si32(0, 0));
+      uploaded += static_cast<Si64>(upload.sprite.Width()) *
+        upload.sprite.Height() * static_cast<Si64>(sizeof(Rgba));
+    }
+    FinishAsyncLoad(upload.state.get());
+  }
+}
+
+void WaitForAsyncLoad(const AsyncLoadState &state) {
+  std::unique_lock<std::mutex> lock(g_async_mutex);
+  while (!state.is_ready.load(std::memory_order_acquire)) {
+    if (!g_async_uploads.empty()) {
+      lock.unlock();
+      UploadAsyncHwSprites(std::numeric_limits<Si64>::max());
+      lock.lock();
+      continue;
+    }
+    g_async_condvar.wait(lock);
+  }
+}
+
+AsyncAsset<Sprite> LoadSpriteAsync(const char *file_name) {
+  return LoadSpriteAsync(std::string(file_name ? file_name : ""));
+}
+
+AsyncAsset<Sprite> LoadSpriteAsync(const std::string &file_name) {
+  return StartAsyncLoad<Sprite>(
+    [file_name](std::shared_ptr<AsyncAsset<Sprite>::State> state) {
+      state->asset.Load(file_name);
+      FinishAsyncLoad(state.get());
+    });
+}
+
+AsyncAsset<HwSprite> LoadHwSpriteAsync(const char *file_name) {
+  return LoadHwSpriteAsync(std::string(file_name ? file_name : ""));
+}
+
+AsyncAsset<HwSprite> LoadHwSpriteAsync(const std::string &file_name) {
+  return StartAsyncLoad<HwSprite>(
+    [file_name](std::shared_ptr<AsyncAsset<HwSprite>::State> state) {
+      AsyncHwSpriteUpload upload;
+      upload.state = std::move(state);
+      upload.sprite.Load(file_name);
+      {
+        std::lock_guard<std::mutex> lock(g_async_mutex);
+        g_async_uploads.push_back(std::move(upload));
+      }
+      // Wake up the waits, they upload the textures.
+      g_async_condvar.notify_all();
+    });
+}
+
+AsyncAsset<Sound> LoadSoundAsync(const char *file_name, bool do_unpack) {
+  return LoadSoundAsync(std::string(file_name ? file_name : ""), do_unpack);
+}
+
+AsyncAsset<Sound> LoadSoundAsync(const std::string &file_name,
+    bool do_unpack) {
+  return StartAsyncLoad<Sound>(
+    [file_name, do_unpack](std::shared_ptr<AsyncAsset<Sound>::State> state) {
+      state->asset.Load(file_name, do_unpack);
+      FinishAsyncLoad(state.get());
+    });
+}
+
+AsyncAsset<Font> LoadFontAsync(const char *file_name) {
+  return LoadFontAsync(std::string(file_name ? file_name : ""));
+}
+
+AsyncAsset<Font> LoadFontAsync(const std::string &file_name) {
+  return StartAsyncLoad<Font>(
+    [file_name](std::shared_ptr<AsyncAsset<Font>::State> state) {
+      state->asset.Load(file_name.c_str());
+      FinishAsyncLoad(state.get());
+    });
+}
+
+void UpdateAsyncLoading() {
+  UploadAsyncHwSprites(g_async_upload_budget);
+}
+
+void SetAsyncLoadingUploadBudget(Si64 bytes_per_frame) {
+  g_async_upload_budget = bytes_per_frame;
+}
+
+void SetAsyncLoadingThreadCount(Si32 thread_count) {
+  WaitForAsyncLoading();
+  g_async_pool.Stop();
+  g_async_thread_count = std::max(0, thread_count);
+}
+
+Si32 GetAsyncLoadCount() {
+  std::lock_guard<std::mutex> lock(g_async_mutex);
+  return g_async_load_count;
+}
+
+Si32 GetAsyncLoadReadyCount() {
+  std::lock_guard<std::mutex> lock(g_async_mutex);
+  return g_async_ready_count;
+}
+
+bool IsAsyncLoadingDone() {
+  std::lock_guard<std::mutex> lock(g_async_mutex);
+  if (g_async_ready_count != g_async_load_count) {
+    return false;
+  }
+  g_is_async_batch_done_seen = true;
+  return true;
+}
+
+void WaitForAsyncLoading() {
+  std::unique_lock<std::mutex> lock(g_async_mutex);
+  while (g_async_ready_count != g_async_load_count) {
+    if (!g_async_uploads.empty()) {
+      lock.unlock();
+      UploadAsyncHwSprites(std::numeric_limits<Si64>::max());
+      lock.lock();
+      continue;
+    }
+    g_async_condvar.wait(lock);
+  }
+  g_is_async_batch_done_seen = true;
+}
+
+}  // namespace arctic
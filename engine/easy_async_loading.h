@@ -0,0 +1,140 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef ENGINE_EASY_ASYNC_LOADING_H_
+#define ENGINE_EASY_ASYNC_LOADING_H_
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "engine/arctic_platform_fatal.h"
+#include "engine/arctic_types.h"
+#include "engine/easy_hw_sprite.h"
+#include "engine/easy_sound.h"
+#include "engine/easy_sprite.h"
+#include "engine/font.h"
+
+namespace arctic {
+
+/// @addtogroup global_files
+/// @{
+
+/// @brief State shared by an asynchronous load and its AsyncAsset handles
+struct AsyncLoadState {
+  std::atomic<bool> is_ready = ATOMIC_VAR_INIT(false);
+};
+
+/// @brief Blocks until the load is ready
+/// @details Uploads the pending HwSprite data while waiting, so call it from
+///  the thread that calls ShowFrame.
+void WaitForAsyncLoad(const AsyncLoadState &state);
+
+/// @brief Handle of an asset being loaded on the worker threads
+/// @details Copies of the handle refer to the same asset. If the load fails,
+///  the asset is left empty, just like with the synchronous Load.
+template <typename T>
+class AsyncAsset {
+ public:
+  struct State : AsyncLoadState {
+    T asset;
+  };
+
+  AsyncAsset() = default;
+  explicit AsyncAsset(std::shared_ptr<State> state)
+    : state_(std::move(state)) {
+  }
+
+  /// @brief Returns true if the handle refers to a load
+  bool IsValid() const {
+    return state_ != nullptr;
+  }
+
+  /// @brief Returns true if the asset is loaded and can be used
+  bool IsReady() const {
+    return state_ && state_->is_ready.load(std::memory_order_acquire);
+  }
+
+  /// @brief Blocks until the asset is loaded and returns it
+  T &Get() {
+    Check(state_ != nullptr, "AsyncAsset::Get called for an empty handle");
+    WaitForAsyncLoad(*state_);
+    return state_->asset;
+  }
+
+ private:
+  std::shared_ptr<State> state_;
+};
+
+/// @brief Starts loading a sprite from file on the worker threads
+AsyncAsset<Sprite> LoadSpriteAsync(const char *file_name);
+/// @brief Starts loading a sprite from file on the worker threads
+AsyncAsset<Sprite> LoadSpriteAsync(const std::string &file_name);
+/// @brief Starts loading a hardware sprite from file
+/// @details The file is decoded on the worker threads, the texture is
+///  uploaded by UpdateAsyncLoading on the thread that calls ShowFrame.
+AsyncAsset<HwSprite> LoadHwSpriteAsync(const char *file_name);
+/// @brief Starts loading a hardware sprite from file
+AsyncAsset<HwSprite> LoadHwSpriteAsync(const std::string &file_name);
+/// @brief Starts loading a sound from file on the worker threads
+/// @param [in] do_unpack If true, *.ogg files are decoded on the worker
+AsyncAsset<Sound> LoadSoundAsync(const char *file_name,
+  bool do_unpack = true);
+/// @brief Starts loading a sound from file on the worker threads
+AsyncAsset<Sound> LoadSoundAsync(const std::string &file_name,
+  bool do_unpack = true);
+/// @brief Starts loading a font from file on the worker threads
+AsyncAsset<Font> LoadFontAsync(const char *file_name);
+/// @brief Starts loading a font from file on the worker threads
+AsyncAsset<Font> LoadFontAsync(const std::string &file_name);
+
+/// @brief Uploads the decoded HwSprite data to the GPU
+/// @details ShowFrame calls it once per frame. Uploads at least one texture
+///  and stops as soon as the per frame upload budget is spent.
+void UpdateAsyncLoading();
+/// @brief Sets the number of bytes UpdateAsyncLoading may upload per frame
+void SetAsyncLoadingUploadBudget(Si64 bytes_per_frame);
+/// @brief Sets the number of worker threads loading the assets
+/// @details Pass 0 to use all the hardware threads available but one.
+///  Waits for the loads in progress before changing the pool.
+void SetAsyncLoadingThreadCount(Si32 thread_count);
+
+/// @brief Returns the number of loads started in the current batch
+/// @details A batch ends once IsAsyncLoadingDone returned true or
+///  WaitForAsyncLoading returned. The next load starts a new batch, so the
+///  counts never go back while a loading screen polls them.
+Si32 GetAsyncLoadCount();
+/// @brief Returns how many of the GetAsyncLoadCount loads are ready
+Si32 GetAsyncLoadReadyCount();
+/// @brief Returns true if all the loads started are ready
+bool IsAsyncLoadingDone();
+/// @brief Blocks until all the loads started are ready
+/// @details Uploads the pending HwSprite data while waiting, so call it from
+///  the thread that calls ShowFrame.
+void WaitForAsyncLoading();
+
+/// @}
+
+}  // namespace arctic
+
+#endif  // ENGINE_EASY_ASYNC_LOADING_H_
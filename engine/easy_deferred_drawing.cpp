@@ -0,0 +1,289 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "engine/easy_deferred_drawing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT
+#include <functional>
+#include <mutex>  // NOLINT
+#include <thread>  // NOLINT
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "engine/easy_advanced.h"
+#include "engine/easy_sprite_instance.h"
+#include "engine/engine.h"
+
+namespace arctic {
+
+struct RecordedDrawCommand {
+  // Rows of the sprite instance the command may change.
+  Si32 y_begin;
+  Si32 y_end;
+  // Offset of the target sprite rows relative to the sprite instance rows.
+  Si32 ref_y;
+  DeferredDrawCommand command;
+};
+
+class DeferredDrawingPool {
+ public:
+  ~DeferredDrawingPool() {
+    Stop();
+  }
+
+  Si32 WorkerCount() const {
+    return static_cast<Si32>(threads_.size());
+  }
+
+  void Start(Si32 worker_count) {
+    Stop();
+    is_quitting_ = false;
+    for (Si32 idx = 0; idx < worker_count; ++idx) {
+      threads_.emplace_back(&DeferredDrawingPool::WorkerThreadFunction, this);
+    }
+  }
+
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      is_quitting_ = true;
+    }
+    work_condvar_.notify_all();
+    for (std::thread &thread : threads_) {
+      thread.join();
+    }
+    threads_.clear();
+  }
+
+  // Calls band_function for each band in [0, band_count) on the worker
+  // threads and the calling thread, returns when all the bands are done.
+  void Run(Si32 band_count, const std::function<void(Si32)> &band_function) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      band_function_ = &band_function;
+      band_count_ = band_count;
+      next_band_.store(0);
+      busy_worker_count_ = WorkerCount();
+      ++generation_;
+    }
+    work_condvar_.notify_all();
+    RunBands();
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      done_condvar_.wait(lock, [this] { return busy_worker_count_ == 0; });
+      band_function_ = nullptr;
+    }
+  }
+
+ private:
+  void RunBands() {
+    for (Si32 band = next_band_.fetch_add(1); band < band_count_;
+        band = next_band_.fetch_add(1)) {
+      (*band_function_)(band);
+    }
+  }
+
+  void WorkerThreadFunction() {
+    Ui64 done_generation = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        work_condvar_.wait(lock, [this, done_generation] {
+          return is_quitting_ || generation_ != done_generation;
+        });
+        if (is_quitting_) {
+          return;
+        }
+        done_generation = generation_;
+      }
+      RunBands();
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        --busy_worker_count_;
+        if (busy_worker_count_ == 0) {
+          done_condvar_.notify_one();
+        }
+      }
+    }
+  }
+
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable work_condvar_;
+  std::condition_variable done_condvar_;
+  bool is_quitting_ = false;
+  Ui64 generation_ = 0;
+  Si32 busy_worker_count_ = 0;
+  Si32 band_count_ = 0;
+  const std::function<void(Si32)> *band_function_ = nullptr;
+  std::atomic<Si32> next_band_ = ATOMIC_VAR_INIT(0);
+};
+
+static bool g_is_deferred_drawing = false;
+static bool g_is_deferred_target_backbuffer = true;
+static Sprite g_deferred_target;
+static Si32 g_deferred_thread_count = 0;
+static std::vector<RecordedDrawCommand> g_deferred_commands;
+static std::unordered_set<const SpriteInstance*> g_deferred_sources;
+static std::vector<std::vector<Si32>> g_deferred_bands;
+static DeferredDrawingPool g_deferred_pool;
+
+static const SpriteInstance *DeferredTargetInstance() {
+  if (g_is_deferred_target_backbuffer) {
+    return GetEngine()->GetBackbuffer().SpriteInstance().get();
+  }
+  return g_deferred_target.SpriteInstance().get();
+}
+
+void SetDeferredDrawing(bool is_enabled) {
+  FlushDeferredDrawing();
+  g_is_deferred_drawing = is_enabled;
+  g_is_deferred_target_backbuffer = true;
+  g_deferred_target = Sprite();
+}
+
+void SetDeferredDrawing(bool is_enabled, Sprite target) {
+  FlushDeferredDrawing();
+  g_is_deferred_drawing = is_enabled;
+  g_is_deferred_target_backbuffer = false;
+  g_deferred_target = target;
+}
+
+bool IsDeferredDrawing() {
+  return g_is_deferred_drawing;
+}
+
+void SetDeferredDrawingThreadCount(Si32 thread_count) {
+  FlushDeferredDrawing();
+  g_deferred_thread_count = std::max(0, thread_count);
+}
+
+Si32 GetDeferredDrawingThreadCount() {
+  if (g_deferred_thread_count) {
+    return g_deferred_thread_count;
+  }
+  return std::max(1, static_cast<Si32>(std::thread::hardware_concurrency()));
+}
+
+void FlushDeferredDrawing() {
+  if (g_deferred_commands.empty()) {
+    return;
+  }
+  const Si32 height = DeferredTargetInstance()->height();
+  const Si32 band_count = (height + kDeferredDrawingBandHeight - 1)
+    / kDeferredDrawingBandHeight;
+  if (static_cast<Si32>(g_deferred_bands.size()) < band_count) {
+    g_deferred_bands.resize(static_cast<size_t>(band_count));
+  }
+  for (std::vector<Si32> &band : g_deferred_bands) {
+    band.clear();
+  }
+  for (size_t idx = 0; idx < g_deferred_commands.size(); ++idx) {
+    const RecordedDrawCommand &recorded = g_deferred_commands[idx];
+    const Si32 band_begin = recorded.y_begin / kDeferredDrawingBandHeight;
+    const Si32 band_end = (recorded.y_end - 1) / kDeferredDrawingBandHeight;
+    for (Si32 band = band_begin; band <= band_end; ++band) {
+      g_deferred_bands[static_cast<size_t>(band)].push_back(
+        static_cast<Si32>(idx));
+    }
+  }
+
+  const Si32 worker_count = GetDeferredDrawingThreadCount() - 1;
+  if (g_deferred_pool.WorkerCount() != worker_count) {
+    g_deferred_pool.Start(worker_count);
+  }
+  g_deferred_pool.Run(band_count, [height](Si32 band) {
+    const Si32 y_begin = band * kDeferredDrawingBandHeight;
+    const Si32 y_end = std::min(height, y_begin + kDeferredDrawingBandHeight);
+    for (Si32 idx : g_deferred_bands[static_cast<size_t>(band)]) {
+      const RecordedDrawCommand &recorded =
+        g_deferred_commands[static_cast<size_t>(idx)];
+      recorded.command.draw(recorded.command,
+        y_begin - recorded.ref_y, y_end - recorded.ref_y);
+    }
+  });
+
+  g_deferred_commands.clear();
+  g_deferred_sources.clear();
+}
+
+bool IsDeferredDrawingTarget(const Sprite &to_sprite) {
+  return g_is_deferred_drawing && to_sprite.SpriteInstance() &&
+    to_sprite.SpriteInstance().get() == DeferredTargetInstance();
+}
+
+void DeferDrawing(const DeferredDrawCommand &command,
+    Si32 y_begin, Si32 y_end) {
+  const Sprite &to_sprite = command.to_sprite;
+  const SpriteInstance *from_instance =
+    command.from_sprite.SpriteInstance().get();
+  if (from_instance && from_instance == to_sprite.SpriteInstance().get()) {
+    // Bands can't read the rows other bands are writing, draw it right away.
+    FlushDeferredDrawing();
+    command.draw(command, y_begin, y_end);
+    return;
+  }
+  const Si32 ref_y = to_sprite.RefPos().y;
+  const Si32 instance_y_begin = std::max(0, y_begin + ref_y);
+  const Si32 instance_y_end = std::min(to_sprite.SpriteInstance()->height(),
+    y_end + ref_y);
+  if (instance_y_begin >= instance_y_end) {
+    return;
+  }
+  g_deferred_commands.emplace_back();
+  RecordedDrawCommand &recorded = g_deferred_commands.back();
+  recorded.y_begin = instance_y_begin;
+  recorded.y_end = instance_y_end;
+  recorded.ref_y = ref_y;
+  recorded.command = command;
+  if (from_instance) {
+    g_deferred_sources.insert(from_instance);
+  }
+}
+
+void FlushDeferredDrawingBeforeRead(const Sprite &sprite) {
+  if (g_deferred_commands.empty()) {
+    return;
+  }
+  if (sprite.SpriteInstance().get() == DeferredTargetInstance()) {
+    FlushDeferredDrawing();
+  }
+}
+
+void FlushDeferredDrawingBeforeWrite(const Sprite &sprite) {
+  if (g_deferred_commands.empty()) {
+    return;
+  }
+  const SpriteInstance *instance = sprite.SpriteInstance().get();
+  if (instance == DeferredTargetInstance() ||
+      g_deferred_sources.count(instance)) {
+    FlushDeferredDrawing();
+  }
+}
+
+}  // namespace arctic
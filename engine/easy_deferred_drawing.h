@@ -0,0 +1,109 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef ENGINE_EASY_DEFERRED_DRAWING_H_
+#define ENGINE_EASY_DEFERRED_DRAWING_H_
+
+#include "engine/arctic_types.h"
+#include "engine/easy_sprite.h"
+#include "engine/rgba.h"
+#include "engine/vec2f.h"
+#include "engine/vec2si32.h"
+
+namespace arctic {
+
+/// @addtogroup global_advanced
+/// @{
+
+/// @brief Height of the horizontal bands the deferred drawing is split into
+const Si32 kDeferredDrawingBandHeight = 32;
+
+/// @brief Enables or disables the deferred drawing to the backbuffer
+/// @details While enabled, software drawing calls targeting the backbuffer
+///  are recorded instead of being executed. The recorded commands are binned
+///  into horizontal bands and the bands are rasterized in parallel by a pool
+///  of worker threads when the frame is shown. The commands of a band are
+///  executed in the recording order, so the result is exactly the same as
+///  with the immediate drawing.
+///  Calls that read the backbuffer (GetPixel, drawing the backbuffer to
+///  some other sprite) and calls that write to a sprite used as a source by
+///  the recorded commands flush the commands first.
+///  Code writing to RgbaData() directly must call FlushDeferredDrawing first.
+void SetDeferredDrawing(bool is_enabled);
+/// @brief Enables or disables the deferred drawing to the target sprite
+/// @details Works just like SetDeferredDrawing(bool), but records the calls
+///  that draw to the target sprite instead of the backbuffer.
+void SetDeferredDrawing(bool is_enabled, Sprite target);
+/// @brief Returns true if the deferred drawing is enabled
+bool IsDeferredDrawing();
+/// @brief Sets the number of threads rasterizing the deferred commands
+/// @details The calling thread counts as one of them.
+///  Pass 0 to use all the hardware threads available.
+void SetDeferredDrawingThreadCount(Si32 thread_count);
+/// @brief Returns the number of threads rasterizing the deferred commands
+Si32 GetDeferredDrawingThreadCount();
+/// @brief Executes all the recorded drawing commands
+void FlushDeferredDrawing();
+
+struct DeferredDrawCommand;
+
+/// @brief Draws the rows [clip_y_begin, clip_y_end) of the command target
+typedef void (*DeferredDrawFunction)(const DeferredDrawCommand &command,
+  Si32 clip_y_begin, Si32 clip_y_end);
+
+/// @brief Recorded drawing command
+/// @details Holds the arguments of a drawing call by value, the draw
+///  function knows which of them are used. The commands are stored in
+///  a vector that keeps its capacity between the frames, so recording
+///  a command does not allocate memory.
+struct DeferredDrawCommand {
+  DeferredDrawFunction draw = nullptr;
+  Sprite to_sprite;
+  Sprite from_sprite;  ///< Sprite the command reads from, may be empty.
+  Vec2Si32 point[4];
+  Vec2F vertex[4];
+  Vec2F tex_coord[4];
+  Rgba color[3];
+  DrawBlendingMode blending_mode = kDrawBlendingModeCopyRgba;
+  DrawFilterMode filter_mode = kFilterNearest;
+};
+
+/// @brief Returns true if the calls drawing to the sprite should be recorded
+bool IsDeferredDrawingTarget(const Sprite &to_sprite);
+/// @brief Records a drawing command for the deferred execution
+/// @param [in] command Command to record, its to_sprite is the target.
+/// @param [in] y_begin First row of to_sprite the command may change.
+/// @param [in] y_end Row after the last row of to_sprite the command may change.
+void DeferDrawing(const DeferredDrawCommand &command,
+  Si32 y_begin, Si32 y_end);
+/// @brief Flushes the recorded commands if they change the sprite pixels
+/// @details Call it before reading the sprite pixels immediately.
+void FlushDeferredDrawingBeforeRead(const Sprite &sprite);
+/// @brief Flushes the recorded commands if they access the sprite pixels
+/// @details Call it before changing the sprite pixels immediately.
+void FlushDeferredDrawingBeforeWrite(const Sprite &sprite);
+
+/// @}
+
+}  // namespace arctic
+
+#endif  // ENGINE_EASY_DEFERRED_DRAWING_H_
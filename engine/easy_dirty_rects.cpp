@@ -0,0 +1,176 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "engine/easy_dirty_rects.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "engine/easy_advanced.h"
+#include "engine/easy_sprite_instance.h"
+#include "engine/engine.h"
+
+namespace arctic {
+
+static DirtyRects::Rect UniteRects(const DirtyRects::Rect &a,
+    const DirtyRects::Rect &b) {
+  DirtyRects::Rect rect;
+  rect.x_begin = std::min(a.x_begin, b.x_begin);
+  rect.y_begin = std::min(a.y_begin, b.y_begin);
+  rect.x_end = std::max(a.x_end, b.x_end);
+  rect.y_end = std::max(a.y_end, b.y_end);
+  return rect;
+}
+
+static bool IsWorthMerging(const DirtyRects::Rect &a,
+    const DirtyRects::Rect &b) {
+  if (a.x_begin < b.x_end && b.x_begin < a.x_end &&
+      a.y_begin < b.y_end && b.y_begin < a.y_end) {
+    // Overlapping rectangles would upload the same pixels twice.
+    return true;
+  }
+  return UniteRects(a, b).Area() <= a.Area() + b.Area();
+}
+
+void DirtyRects::Add(Si32 x_begin, Si32 y_begin, Si32 x_end, Si32 y_end) {
+  if (x_begin >= x_end || y_begin >= y_end) {
+    return;
+  }
+  Rect rect;
+  rect.x_begin = x_begin;
+  rect.y_begin = y_begin;
+  rect.x_end = x_end;
+  rect.y_end = y_end;
+  Si32 idx = 0;
+  while (idx < count_) {
+    if (IsWorthMerging(rect, rects_[idx])) {
+      // The grown rectangle may reach the ones checked already.
+      rect = UniteRects(rect, rects_[idx]);
+      --count_;
+      rects_[idx] = rects_[count_];
+      idx = 0;
+    } else {
+      ++idx;
+    }
+  }
+  rects_[count_] = rect;
+  ++count_;
+  if (count_ <= kMaxDirtyRects) {
+    return;
+  }
+  Si64 best_growth = std::numeric_limits<Si64>::max();
+  Si32 best_a = 0;
+  Si32 best_b = 1;
+  for (Si32 a = 0; a < count_; ++a) {
+    for (Si32 b = a + 1; b < count_; ++b) {
+      Si64 growth = UniteRects(rects_[a], rects_[b]).Area() -
+        rects_[a].Area() - rects_[b].Area();
+      if (growth < best_growth) {
+        best_growth = growth;
+        best_a = a;
+        best_b = b;
+      }
+    }
+  }
+  rect = UniteRects(rects_[best_a], rects_[best_b]);
+  --count_;
+  rects_[best_b] = rects_[count_];
+  --count_;
+  rects_[best_a] = rects_[count_];
+  Add(rect.x_begin, rect.y_begin, rect.x_end, rect.y_end);
+}
+
+static bool g_is_dirty_tracking = false;
+static bool g_is_skip_unchanged_frames = false;
+static bool g_is_frame_changed = true;
+static DirtyRects g_backbuffer_dirty_rects;
+
+void SetBackbufferDirtyTracking(bool is_enabled) {
+  g_is_dirty_tracking = is_enabled;
+  g_backbuffer_dirty_rects.Clear();
+  // The texture may be missing the changes made while not tracking.
+  MarkBackbufferDirty();
+}
+
+bool IsBackbufferDirtyTracking() {
+  return g_is_dirty_tracking;
+}
+
+void SetSkipUnchangedFrames(bool is_enabled) {
+  g_is_skip_unchanged_frames = is_enabled;
+}
+
+bool IsSkipUnchangedFrames() {
+  return g_is_skip_unchanged_frames;
+}
+
+void MarkBackbufferDirty() {
+  if (!g_is_dirty_tracking) {
+    return;
+  }
+  const Sprite &backbuffer = GetEngine()->GetBackbuffer();
+  g_backbuffer_dirty_rects.Add(0, 0, backbuffer.Width(), backbuffer.Height());
+}
+
+void MarkBackbufferDirty(Si32 x_begin, Si32 y_begin, Si32 x_end, Si32 y_end) {
+  if (!g_is_dirty_tracking) {
+    return;
+  }
+  g_backbuffer_dirty_rects.Add(x_begin, y_begin, x_end, y_end);
+}
+
+void MarkSpriteDirty(const Sprite &sprite,
+    Si32 x_begin, Si32 y_begin, Si32 x_end, Si32 y_end) {
+  if (!g_is_dirty_tracking || !sprite.SpriteInstance() ||
+      sprite.SpriteInstance() !=
+        GetEngine()->GetBackbuffer().SpriteInstance()) {
+    return;
+  }
+  const Vec2Si32 ref_pos = sprite.RefPos();
+  g_backbuffer_dirty_rects.Add(
+    ref_pos.x + std::max(x_begin, 0),
+    ref_pos.y + std::max(y_begin, 0),
+    ref_pos.x + std::min(x_end, sprite.Width()),
+    ref_pos.y + std::min(y_end, sprite.Height()));
+}
+
+void MarkFrameChanged() {
+  g_is_frame_changed = true;
+}
+
+const DirtyRects &GetBackbufferDirtyRects() {
+  return g_backbuffer_dirty_rects;
+}
+
+bool IsFrameChanged() {
+  return g_is_frame_changed || !g_backbuffer_dirty_rects.IsEmpty();
+}
+
+void ClearBackbufferDirtyState() {
+  g_backbuffer_dirty_rects.Clear();
+  g_is_frame_changed = false;
+}
+
+}  // namespace arctic
@@ -0,0 +1,117 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef ENGINE_EASY_DIRTY_RECTS_H_
+#define ENGINE_EASY_DIRTY_RECTS_H_
+
+#include "engine/arctic_types.h"
+#include "engine/easy_sprite.h"
+
+namespace arctic {
+
+/// @addtogroup global_advanced
+/// @{
+
+/// @brief Maximum number of rectangles a DirtyRects keeps apart
+const Si32 kMaxDirtyRects = 8;
+
+/// @brief A bounded set of rectangles covering the changed pixels
+/// @details Rectangles that overlap or touch are merged. When there are too
+///  many rectangles the pair that grows the covered area the least is merged.
+class DirtyRects {
+ public:
+  /// @brief Rectangle [x_begin, x_end) x [y_begin, y_end)
+  struct Rect {
+    Si32 x_begin;
+    Si32 y_begin;
+    Si32 x_end;
+    Si32 y_end;
+
+    Si64 Area() const {
+      return static_cast<Si64>(x_end - x_begin) *
+        static_cast<Si64>(y_end - y_begin);
+    }
+  };
+
+  /// @brief Adds the rectangle [x_begin, x_end) x [y_begin, y_end)
+  void Add(Si32 x_begin, Si32 y_begin, Si32 x_end, Si32 y_end);
+  /// @brief Removes all the rectangles
+  void Clear() {
+    count_ = 0;
+  }
+  /// @brief Returns true if there are no rectangles
+  bool IsEmpty() const {
+    return count_ == 0;
+  }
+  /// @brief Returns the number of rectangles
+  Si32 Count() const {
+    return count_;
+  }
+  /// @brief Returns the rectangle with the index
+  const Rect &operator[](Si32 idx) const {
+    return rects_[idx];
+  }
+
+ private:
+  Rect rects_[kMaxDirtyRects + 1];
+  Si32 count_ = 0;
+};
+
+/// @brief Enables or disables the tracking of the changed backbuffer pixels
+/// @details While enabled, only the parts of the backbuffer changed by the
+///  drawing calls since the last ShowFrame are uploaded to the GPU.
+///  Code writing to the backbuffer RgbaData() directly must call
+///  MarkBackbufferDirty to get the changes shown.
+void SetBackbufferDirtyTracking(bool is_enabled);
+/// @brief Returns true if the tracking of the changed backbuffer pixels is on
+bool IsBackbufferDirtyTracking();
+/// @brief Enables or disables skipping the frames that show no changes
+/// @details Works only while the backbuffer dirty tracking is enabled.
+///  ShowFrame still updates the user input when the frame is skipped,
+///  but it does not wait for the VSync.
+void SetSkipUnchangedFrames(bool is_enabled);
+/// @brief Returns true if the frames that show no changes are skipped
+bool IsSkipUnchangedFrames();
+/// @brief Marks the whole backbuffer as changed
+void MarkBackbufferDirty();
+/// @brief Marks the backbuffer rectangle [x_begin, x_end) x [y_begin, y_end)
+///  as changed
+void MarkBackbufferDirty(Si32 x_begin, Si32 y_begin, Si32 x_end, Si32 y_end);
+/// @brief Marks the sprite rectangle [x_begin, x_end) x [y_begin, y_end)
+///  as changed if the sprite is a part of the backbuffer
+void MarkSpriteDirty(const Sprite &sprite,
+  Si32 x_begin, Si32 y_begin, Si32 x_end, Si32 y_end);
+/// @brief Makes the next frame show even if the backbuffer is not changed
+/// @details Hardware sprite drawing and window resizing call it.
+void MarkFrameChanged();
+/// @brief Returns the changed backbuffer rectangles
+const DirtyRects &GetBackbufferDirtyRects();
+/// @brief Returns true if there is anything new to show
+bool IsFrameChanged();
+/// @brief Forgets the changes after they are shown
+void ClearBackbufferDirtyState();
+
+/// @}
+
+}  // namespace arctic
+
+#endif  // ENGINE_EASY_DIRTY_RECTS_H_
@@ -0,0 +1,125 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2017 - 2020 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "engine/easy_files.h"
+
+#include <fstream>
+
+#include "engine/arctic_platform_fatal.h"
+#include "engine/asset_pack.h"
+
+namespace arctic {
+
+std::vector<Ui8> ReadFile(const char *file_name, bool is_bulletproof) {
+  PackedAsset asset;
+  if (FindPackedAsset(file_name, &asset) && asset.type == kAssetPackFile) {
+    return std::vector<Ui8>(asset.data, asset.data + asset.size);
+  }
+  std::ifstream in(file_name, std::ios_base::in | std::ios_base::binary);
+  std::vector<Ui8> data;
+  if (in.rdstate() & std::ios_base::failbit) {
+    if (is_bulletproof) {
+      return data;
+    }
+    Check(false, "Error in ReadFile. Can't open the file, file_name: ",
+      file_name);
+  }
+  in.exceptions(std::ios_base::goodbit);
+  in.seekg(0, std::ios_base::end);
+  if (in.rdstate() & std::ios_base::failbit) {
+    if (is_bulletproof) {
+      in.close();
+      return data;
+    }
+    Check(false, "Error in ReadFile. Can't seek to the end, file_name: ",
+      file_name);
+  }
+    std::streampos pos = in.tellg();
+  if (pos == std::streampos(-1)) {
+    if (is_bulletproof) {
+      in.close();
+      return data;
+    }
+    Check(false, "Error in ReadFile."
+      " Can't determine file size via tellg, file_name: ",
+      file_name);
+  }
+  in.seekg(0, std::ios_base::beg);
+  if (in.rdstate() & std::ios_base::failbit) {
+    if (is_bulletproof) {
+      in.close();
+      return data;
+    }
+    Check(false, "Error in ReadFile. Can't seek to the beg, file_name: ",
+      file_name);
+  }
+
+  if (static_cast<Ui64>(pos) > 0ull) {
+    data.resize(static_cast<size_t>(pos));
+    in.read(reinterpret_cast<char*>(data.data()), pos);
+    if (in.rdstate() != std::ios_base::goodbit) {
+      if (is_bulletproof) {
+        in.close();
+        data.clear();
+        return data;
+      }
+      Check((in.rdstate() & (std::ios_base::failbit | std::ios_base::eofbit))
+          != (std::ios_base::failbit | std::ios_base::eofbit),
+        "Error in ReadFile."
+        " Can't read the data, eofbit is set, file_name: ",
+        file_name);
+      Check(!(in.rdstate() & std::ios_base::badbit),
+        "Error in ReadFile."
+        " Can't read the data, badbit is set, file_name: ",
+        file_name);
+      Check(in.rdstate() == std::ios_base::goodbit,
+        "Error in ReadFile."
+        " Can't read the data, non-goodbit, file_name: ",
+        file_name);
+    }
+  }
+  in.close();
+  Check(!(in.rdstate() & std::ios_base::failbit) || is_bulletproof,
+    "Error in ReadFile. Can't close the file, file_name: ",
+    file_name);
+  return data;
+}
+
+void WriteFile(const char *file_name, const Ui8 *data, const Ui64 data_size) {
+    std::ofstream out(file_name,
+      std::ios_base::binary | std::ios_base::out | std::ios_base::trunc);
+    Check(!(out.rdstate() & std::ios_base::failbit),
+      "Error in WriteFile. Can't create/open the file, file_name: ",
+      file_name);
+    out.exceptions(std::ios_base::goodbit);
+    out.write(reinterpret_cast<const char*>(data),
+      static_cast<std::streamsize>(data_size));
+    Check(!(out.rdstate() & std::ios_base::badbit),
+      "Error in WriteFile. Can't write the file, file_name: ",
+      file_name);
+    out.close();
+    Check(!(out.rdstate() & std::ios_base::failbit),
+      "Error in WriteFile. Can't close the file, file_name: ",
+      file_name);
+}
+
+}  // namespace arctic
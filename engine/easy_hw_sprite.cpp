@@ -34,11 +34,15 @@
 #include <sstream>
 
 #include "engine/arctic_types.h"
+#include "engine/asset_pack.h"
 #include "engine/vec2f.h"
 #include "engine/vec3f.h"
 #include "engine/log.h"
 #include "engine/easy_advanced.h"
+#include "engine/easy_deferred_drawing.h"
+#include "engine/easy_dirty_rects.h"
 #include "engine/easy_files.h"
+#include "engine/easy_hw_sprite_batch.h"
 #include "engine/rgba.h"
 #include "engine/gl_state.h"
 
@@ -49,6 +53,16 @@ void HwSprite::DrawSprite(const std::shared_ptr<GlProgram> &gl_program, const Un
     const HwSprite &from_sprite, const float from_x, const float from_y, const float from_width, const float from_height,
     Rgba in_color, DrawBlendingMode blending_mode, DrawFilterMode filter_mode, float angle_radians, float zoom) {
 
+    MarkFrameChanged();
+    if (gl_program == GetEngine()->GetDefaultSpriteProgram()
+        && gl_program_uniforms.Size() == 0
+        && BatchHwSpriteDraw(to_sprite, Vec2F(to_x_pivot, to_y_pivot),
+          Vec2F(zoom * to_width / from_width, zoom * to_height / from_height),
+          from_sprite, in_color, blending_mode, filter_mode, angle_radians)) {
+      return;
+    }
+    FlushHwSpriteBatch();
+    CountHwSpriteDrawCall();
     from_sprite.UpdateVertexBuffer(angle_radians);
     from_sprite.gl_buffer_->Bind();
     ARCTIC_GL_CHECK_ERROR(glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 16, 0));
@@ -294,14 +308,29 @@ void HwSprite::Load(const char *file_name) {
     return;
   }
   if (strcmp(last_dot, ".tga") == 0) {
-    std::vector<Ui8> data = ReadFile(file_name, true);
-    if (data.empty()) {
-      *Log() << "Error in HwSprite::Load, file: \""
-        << file_name << "\" could not be loaded (data is empty)."
-          " Not loading sprite.";
-      return;
+    PackedAsset asset;
+    std::vector<Ui8> data;
+    if (FindPackedAsset(file_name, &asset) &&
+        asset.type == kAssetPackSprite) {
+      sprite_instance_ = std::make_shared<HwSpriteInstance>(
+        asset.sprite_size.x, asset.sprite_size.y);
+      sprite_instance_->texture().SetData(asset.data,
+        asset.sprite_size.x, asset.sprite_size.y);
+    } else {
+      if (!asset.data) {
+        data = ReadFile(file_name, true);
+        asset.data = data.data();
+        asset.size = data.size();
+      }
+      if (asset.size == 0) {
+        *Log() << "Error in HwSprite::Load, file: \""
+          << file_name << "\" could not be loaded (data is empty)."
+            " Not loading sprite.";
+        return;
+      }
+      sprite_instance_ = HwSpriteInstance::LoadTga(asset.data,
+        static_cast<Si64>(asset.size));
     }
-    sprite_instance_ = HwSpriteInstance::LoadTga(data.data(), static_cast<Si64>(data.size()));
     ref_pos_ = Vec2Si32(0, 0);
     ref_size_ = sprite_instance_ ? Vec2Si32(sprite_instance_->width(),
       sprite_instance_->height()) : Vec2Si32(0, 0);
@@ -326,6 +355,7 @@ void HwSprite::Load(const std::string &file_name) {
 }
 
 void HwSprite::LoadFromSoftwareSprite(Sprite sw_sprite) {
+    FlushDeferredDrawingBeforeRead(sw_sprite);
     const std::shared_ptr<SpriteInstance> &sw_sprite_instance = sw_sprite.SpriteInstance();
     sprite_instance_ = std::make_shared<HwSpriteInstance>(sw_sprite_instance->width(), sw_sprite_instance->height());
     sprite_instance_->texture().UpdateData(sw_sprite_instance->RawData());
@@ -415,6 +445,8 @@ void HwSprite::Clear(Rgba color) {
     return;
   }
 
+  MarkFrameChanged();
+  FlushHwSpriteBatch();
   sprite_instance_->framebuffer().Bind();
   glClearColor(
     static_cast<float>(color.r) / 255.0f,
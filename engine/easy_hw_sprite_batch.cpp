@@ -0,0 +1,209 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "engine/easy_hw_sprite_batch.h"
+
+#include <cmath>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+#include "engine/arctic_platform.h"
+#include "engine/easy_advanced.h"
+#include "engine/easy_hw_sprite.h"
+#include "engine/engine.h"
+#include "engine/gl_buffer.h"
+#include "engine/gl_program.h"
+#include "engine/gl_state.h"
+#include "engine/log.h"
+#include "engine/opengl.h"
+#include "engine/vec4si32.h"
+
+namespace arctic {
+
+namespace {
+
+struct HwSpriteBatch {
+  std::shared_ptr<HwSpriteInstance> to_instance;
+  std::shared_ptr<HwSpriteInstance> from_instance;
+  Vec4Si32 viewport = Vec4Si32(0, 0, 0, 0);
+  DrawBlendingMode blending_mode = kDrawBlendingModeCopyRgba;
+  DrawFilterMode filter_mode = kFilterNearest;
+  std::vector<HwSpriteBatchVertex> vertices;
+  std::unique_ptr<GlBuffer> buffer;
+};
+
+}  // namespace
+
+static bool g_is_hw_sprite_batching = true;
+static HwSpriteBatch g_hw_sprite_batch;
+static HwSpriteBatchStats g_hw_sprite_stats;
+static HwSpriteBatchStats g_hw_sprite_last_frame_stats;
+
+void SetHwSpriteBatching(bool is_enabled) {
+  if (!is_enabled) {
+    FlushHwSpriteBatch();
+  }
+  g_is_hw_sprite_batching = is_enabled;
+}
+
+bool IsHwSpriteBatching() {
+  return g_is_hw_sprite_batching;
+}
+
+void FlushHwSpriteBatch() {
+  HwSpriteBatch &batch = g_hw_sprite_batch;
+  if (batch.vertices.empty()) {
+    return;
+  }
+  if (!batch.buffer) {
+    batch.buffer = std::make_unique<GlBuffer>();
+    batch.buffer->Create(nullptr, 0);
+  }
+  // Orphan the buffer each time so the driver does not stall on the
+  // previous batch still being drawn.
+  batch.buffer->SetData(batch.vertices.data(),
+    batch.vertices.size() * sizeof(HwSpriteBatchVertex), GL_STREAM_DRAW);
+  const GLsizei stride = static_cast<GLsizei>(sizeof(HwSpriteBatchVertex));
+  ARCTIC_GL_CHECK_ERROR(glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride,
+    reinterpret_cast<void*>(offsetof(HwSpriteBatchVertex, pos))));
+  ARCTIC_GL_CHECK_ERROR(glEnableVertexAttribArray(0));
+  ARCTIC_GL_CHECK_ERROR(glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride,
+    reinterpret_cast<void*>(offsetof(HwSpriteBatchVertex, tex))));
+  ARCTIC_GL_CHECK_ERROR(glEnableVertexAttribArray(1));
+  ARCTIC_GL_CHECK_ERROR(glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride,
+    reinterpret_cast<void*>(offsetof(HwSpriteBatchVertex, color))));
+  ARCTIC_GL_CHECK_ERROR(glEnableVertexAttribArray(2));
+
+  const std::shared_ptr<GlProgram> &program = GetEngine()->GetBatchedSpriteProgram();
+  program->Bind();
+  program->SetUniform("s_texture", 0);
+  program->SetUniform("to_sprite_size", Vec2F(
+    static_cast<float>(batch.viewport.z), static_cast<float>(batch.viewport.w)));
+  program->SetUniform("is_solid_color",
+    static_cast<int>(batch.blending_mode == kDrawBlendingModeSolidColor));
+
+  batch.to_instance->framebuffer().Bind();
+  GlState::SetViewport(batch.viewport.x, batch.viewport.y,
+    batch.viewport.z, batch.viewport.w);
+  GlTexture2D &texture = batch.from_instance->texture();
+  texture.SetFilterMode(batch.filter_mode);
+  texture.Bind(0);
+  GlState::SetBlending(batch.blending_mode);
+
+  ARCTIC_GL_CHECK_ERROR(glDrawArrays(GL_TRIANGLES, 0,
+    static_cast<GLsizei>(batch.vertices.size())));
+  // The other programs do not feed the color attribute.
+  ARCTIC_GL_CHECK_ERROR(glDisableVertexAttribArray(2));
+
+  ++g_hw_sprite_stats.batch_count;
+  ++g_hw_sprite_stats.draw_call_count;
+  batch.vertices.clear();
+  batch.to_instance = nullptr;
+  batch.from_instance = nullptr;
+}
+
+HwSpriteBatchStats GetHwSpriteBatchStats() {
+  return g_hw_sprite_last_frame_stats;
+}
+
+void AppendHwSpriteQuad(Vec2F pivot, Vec2F scale, Vec2Si32 from_size,
+    Vec2Si32 from_pivot, float angle_radians, Rgba color,
+    std::vector<HwSpriteBatchVertex> *out_vertices) {
+  const float sin_a = sinf(angle_radians);
+  const float cos_a = cosf(angle_radians);
+  const Vec2F left = Vec2F(-cos_a, -sin_a) * static_cast<float>(from_pivot.x);
+  const Vec2F right = Vec2F(cos_a, sin_a) * static_cast<float>(from_size.x - from_pivot.x);
+  const Vec2F up = Vec2F(-sin_a, cos_a) * static_cast<float>(from_size.y - from_pivot.y);
+  const Vec2F down = Vec2F(sin_a, -cos_a) * static_cast<float>(from_pivot.y);
+
+  // d c
+  // a b
+  const Vec2F a = (left + down) * scale + pivot;
+  const Vec2F b = (right + down) * scale + pivot;
+  const Vec2F c = (right + up) * scale + pivot;
+  const Vec2F d = (left + up) * scale + pivot;
+
+  const HwSpriteBatchVertex kVerts[] = {
+    {a, Vec2F(0.0f, 0.0f), color},
+    {b, Vec2F(1.0f, 0.0f), color},
+    {c, Vec2F(1.0f, 1.0f), color},
+
+    {d, Vec2F(0.0f, 1.0f), color},
+    {a, Vec2F(0.0f, 0.0f), color},
+    {c, Vec2F(1.0f, 1.0f), color},
+  };
+  out_vertices->insert(out_vertices->end(), std::begin(kVerts), std::end(kVerts));
+}
+
+bool BatchHwSpriteDraw(const HwSprite &to_sprite, Vec2F pivot, Vec2F scale,
+    const HwSprite &from_sprite, Rgba in_color, DrawBlendingMode blending_mode,
+    DrawFilterMode filter_mode, float angle_radians) {
+  if (!g_is_hw_sprite_batching || !to_sprite.sprite_instance()
+      || !from_sprite.sprite_instance()) {
+    return false;
+  }
+  HwSpriteBatch &batch = g_hw_sprite_batch;
+  const Vec4Si32 viewport(to_sprite.Pivot().x, to_sprite.Pivot().y,
+    to_sprite.Width(), to_sprite.Height());
+  if (!batch.vertices.empty()
+      && (batch.to_instance != to_sprite.sprite_instance()
+        || batch.from_instance != from_sprite.sprite_instance()
+        || batch.viewport != viewport
+        || batch.blending_mode != blending_mode
+        || batch.filter_mode != filter_mode)) {
+    FlushHwSpriteBatch();
+  }
+  if (batch.vertices.empty()) {
+    batch.to_instance = to_sprite.sprite_instance();
+    batch.from_instance = from_sprite.sprite_instance();
+    batch.viewport = viewport;
+    batch.blending_mode = blending_mode;
+    batch.filter_mode = filter_mode;
+  }
+  const bool is_colored = (blending_mode == kDrawBlendingModeColorize
+    || blending_mode == kDrawBlendingModeSolidColor);
+  AppendHwSpriteQuad(pivot, scale, from_sprite.Size(), from_sprite.Pivot(),
+    angle_radians, is_colored ? in_color : Rgba(255, 255, 255, 255),
+    &batch.vertices);
+  ++g_hw_sprite_stats.sprite_count;
+  return true;
+}
+
+void CountHwSpriteDrawCall() {
+  ++g_hw_sprite_stats.sprite_count;
+  ++g_hw_sprite_stats.draw_call_count;
+}
+
+void FinishHwSpriteBatchFrame() {
+  FlushHwSpriteBatch();
+  g_hw_sprite_last_frame_stats = g_hw_sprite_stats;
+  g_hw_sprite_stats = HwSpriteBatchStats();
+}
+
+}  // namespace arctic
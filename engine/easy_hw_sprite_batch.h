@@ -0,0 +1,102 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef ENGINE_EASY_HW_SPRITE_BATCH_H_
+#define ENGINE_EASY_HW_SPRITE_BATCH_H_
+
+#include <memory>
+#include <vector>
+
+#include "engine/arctic_types.h"
+#include "engine/easy_sprite.h"
+#include "engine/rgba.h"
+#include "engine/vec2f.h"
+#include "engine/vec2si32.h"
+
+namespace arctic {
+
+class HwSprite;
+
+/// @addtogroup global_advanced
+/// @{
+
+/// @brief HwSprite drawing counters
+struct HwSpriteBatchStats {
+  /// @brief Number of sprites drawn
+  Si64 sprite_count = 0;
+  /// @brief Number of merged draw calls issued for the batched sprites
+  Si64 batch_count = 0;
+  /// @brief Number of draw calls issued for all the sprites
+  Si64 draw_call_count = 0;
+};
+
+/// @brief Vertex of a batched sprite quad in the target sprite coordinates
+struct HwSpriteBatchVertex {
+  Vec2F pos;
+  Vec2F tex;
+  Rgba color;
+};
+
+/// @brief Enables or disables merging of the HwSprite draw calls
+/// @details While enabled, consecutive draws with the default sprite program
+///  and no custom uniforms that share the target, the texture, the filter
+///  mode and the blending mode are transformed on the CPU and drawn with a
+///  single draw call from a streaming vertex buffer. The pending batch is
+///  flushed when the state changes, before any draw that can not be merged,
+///  before HwSprite::Clear and when the frame is shown, so the result is the
+///  same as with the immediate drawing. Enabled by default.
+///  Code accessing the sprite textures or framebuffers directly must call
+///  FlushHwSpriteBatch first.
+void SetHwSpriteBatching(bool is_enabled);
+/// @brief Returns true if the HwSprite draw calls are merged
+bool IsHwSpriteBatching();
+/// @brief Issues the draw call for the pending batch of sprites
+void FlushHwSpriteBatch();
+/// @brief Returns the counters of the last shown frame
+HwSpriteBatchStats GetHwSpriteBatchStats();
+
+/// @brief Appends the two triangles of a sprite quad
+/// @param [in] pivot Position of the sprite pivot in the target.
+/// @param [in] scale Scale applied to the rotated quad.
+/// @param [in] from_size Size of the sprite drawn.
+/// @param [in] from_pivot Pivot of the sprite drawn.
+/// @param [in] angle_radians Rotation angle around the pivot.
+/// @param [in] color Vertex color.
+/// @param [out] out_vertices Vector to append the 6 vertices to.
+void AppendHwSpriteQuad(Vec2F pivot, Vec2F scale, Vec2Si32 from_size,
+  Vec2Si32 from_pivot, float angle_radians, Rgba color,
+  std::vector<HwSpriteBatchVertex> *out_vertices);
+/// @brief Queues a sprite draw into the pending batch
+/// @return false if the draw can not be batched and must be drawn immediately
+bool BatchHwSpriteDraw(const HwSprite &to_sprite, Vec2F pivot, Vec2F scale,
+  const HwSprite &from_sprite, Rgba in_color, DrawBlendingMode blending_mode,
+  DrawFilterMode filter_mode, float angle_radians);
+/// @brief Counts a sprite drawn with a draw call of its own
+void CountHwSpriteDrawCall();
+/// @brief Flushes the pending batch and starts counting the next frame
+void FinishHwSpriteBatchFrame();
+
+/// @}
+
+}  // namespace arctic
+
+#endif  // ENGINE_EASY_HW_SPRITE_BATCH_H_
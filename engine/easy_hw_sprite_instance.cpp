@@ -32,6 +32,7 @@
 #include <sstream>
 
 #include "engine/arctic_platform.h"
+#include "engine/easy_hw_sprite_batch.h"
 #include "engine/log.h"
 #include "engine/rgba.h"
 #include "engine/opengl.h"
@@ -45,6 +46,11 @@ namespace arctic {
     framebuffer_.Create(texture_);
   }
 
+  void HwSpriteInstance::UpdateData(const void *data) {
+    FlushHwSpriteBatch();
+    texture_.UpdateData(data);
+  }
+
   std::shared_ptr<HwSpriteInstance> HwSpriteInstance::LoadTga(const Ui8 *data, const Si64 size) {
     std::shared_ptr<SpriteInstance> sw_sprite = arctic::LoadTga(data, size);
     std::shared_ptr<HwSpriteInstance> sprite = std::make_shared<HwSpriteInstance>(sw_sprite->width(), sw_sprite->height());
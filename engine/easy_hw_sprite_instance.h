@@ -59,6 +59,11 @@ class HwSpriteInstance {
       return texture_.height();
   }
 
+  /// @brief Replaces the pixels of the texture
+  /// @details Draws the pending sprite batch first, as it may still
+  ///  read or write the old pixels.
+  void UpdateData(const void *data);
+
   /// @brief Creates a sprite instance from *.tga file data
   static std::shared_ptr<HwSpriteInstance> LoadTga(const Ui8 *data,
       const Si64 size);
@@ -29,8 +29,10 @@
 #include <vector>
 #include <sstream>
 #include <algorithm>
+#include <utility>
 
 #include "engine/arctic_platform.h"
+#include "engine/asset_pack.h"
 #include "engine/log.h"
 #include "engine/easy_files.h"
 #include "engine/easy_sound_instance.h"
@@ -52,27 +54,46 @@ void Sound::Load(const char *file_name, bool do_unpack, std::vector<Ui8> *in_dat
   Check(!!file_name, "Error in Sound::Load, file_name is nullptr.");
   const char *last_dot = strrchr(file_name, '.');
   Check(!!last_dot, "Error in Sound::Load, file_name has no extension.");
+  PackedAsset asset;
+  if (!in_data && (strcmp(last_dot, ".wav") == 0 ||
+        strcmp(last_dot, ".ogg") == 0) &&
+      FindPackedAsset(file_name, &asset)) {
+    if (asset.type == kAssetPackSound) {
+      sound_instance_ = std::make_shared<SoundInstance>(kSoundDataWav,
+        asset.data, asset.size, std::move(asset.owner));
+      return;
+    }
+    if (strcmp(last_dot, ".ogg") == 0 && !do_unpack) {
+      sound_instance_ = std::make_shared<SoundInstance>(kSoundDataVorbis,
+        asset.data, asset.size, std::move(asset.owner));
+      return;
+    }
+  }
   if (strcmp(last_dot, ".wav") == 0) {
-    if (!in_data) {
+    if (!in_data && !asset.data) {
       loaded_data = ReadFile(file_name, true);
       in_data = &loaded_data;
     }
-    if (!in_data->empty()) {
-      sound_instance_ = LoadWav(in_data->data(), static_cast<Si64>(in_data->size()));
+    const Ui8 *data = in_data ? in_data->data() : asset.data;
+    const Ui64 data_size = in_data ? in_data->size() : asset.size;
+    if (data_size) {
+      sound_instance_ = LoadWav(data, static_cast<Si64>(data_size));
       if (sound_instance_ == nullptr) {
         Log("Error loading file \"", file_name, "\"");
       }
     }
   } else if (strcmp(last_dot, ".ogg") == 0) {
-    if (!in_data) {
+    if (!in_data && !asset.data) {
       loaded_data = ReadFile(file_name, true);
       in_data = &loaded_data;
     }
-    if (!in_data->empty()) {
+    const Ui8 *data = in_data ? in_data->data() : asset.data;
+    const Ui64 data_size = in_data ? in_data->size() : asset.size;
+    if (data_size) {
       if (do_unpack) {
         int error = 0;
-        vorbis_codec_ = stb_vorbis_open_memory(in_data->data(),
-          static_cast<int>(in_data->size()), &error, nullptr);
+        vorbis_codec_ = stb_vorbis_open_memory(data,
+          static_cast<int>(data_size), &error, nullptr);
         if (vorbis_codec_) {
           Ui32 size = stb_vorbis_stream_length_in_samples(vorbis_codec_);
           sound_instance_ = std::make_shared<SoundInstance>(size);
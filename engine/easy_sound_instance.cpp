@@ -27,6 +27,7 @@
 
 #include <cstring>
 #include <sstream>
+#include <utility>
 
 #include "engine/arctic_platform.h"
 #include "engine/log.h"
@@ -85,20 +86,30 @@ SoundInstance::SoundInstance(std::vector<Ui8> vorbis_file) {
   std::memcpy(data_.data(), vorbis_file.data(), vorbis_file.size());
 }
 
+SoundInstance::SoundInstance(SoundDataFormat format, Ui8 *data, Ui64 size,
+    std::shared_ptr<void> owner) {
+  format_ = format;
+  playing_count_ = 0;
+  external_data_ = data;
+  external_size_ = size;
+  external_owner_ = std::move(owner);
+}
+
 Si16* SoundInstance::GetWavData() {
   if (format_ == kSoundDataWav) {
-    return static_cast<Si16*>(static_cast<void*>(data_.data()));
+    return static_cast<Si16*>(static_cast<void*>(
+      external_data_ ? external_data_ : data_.data()));
   } else {
     return nullptr;
   }
 }
 
 Ui8* SoundInstance::GetVorbisData() const {
-  return const_cast<Ui8*>(data_.data());
+  return external_data_ ? external_data_ : const_cast<Ui8*>(data_.data());
 }
 
 Si32 SoundInstance::GetVorbisSize() const {
-  return static_cast<Si32>(data_.size());
+  return static_cast<Si32>(external_data_ ? external_size_ : data_.size());
 }
 
 SoundDataFormat SoundInstance::GetFormat() const {
@@ -107,7 +118,8 @@ SoundDataFormat SoundInstance::GetFormat() const {
 
 Si32 SoundInstance::GetDurationSamples() {
   if (format_ == kSoundDataWav) {
-    return static_cast<Si32>(data_.size() / 4);
+    return static_cast<Si32>(
+      (external_data_ ? external_size_ : data_.size()) / 4);
   } else {
     return 0;
   }
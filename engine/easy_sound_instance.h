@@ -31,6 +31,8 @@
 
 namespace arctic {
 
+struct SoundTask;
+
 /// @addtogroup global_advanced
 /// @{
 
@@ -42,10 +44,22 @@ enum SoundDataFormat {
 class SoundInstance {
   SoundDataFormat format_;
   std::vector<Ui8> data_;
+  // Data stored outside of data_, like in a mapped asset pack.
+  Ui8 *external_data_ = nullptr;
+  Ui64 external_size_ = 0;
+  std::shared_ptr<void> external_owner_;
   std::atomic<Si32> playing_count_;
+  SoundTask *first_voice_ = nullptr;
  public:
   explicit SoundInstance(Ui32 wav_samples);
   explicit SoundInstance(std::vector<Ui8> vorbis_file);
+  /// @brief Creates a sound instance that uses the data specified
+  /// without copying it
+  /// @param [in] format kSoundDataWav for 44100 Hz interleaved stereo Si16
+  /// samples, kSoundDataVorbis for *.ogg file data
+  /// @param [in] owner Keeps the data alive while the instance exists
+  SoundInstance(SoundDataFormat format, Ui8 *data, Ui64 size,
+    std::shared_ptr<void> owner);
   Si16* GetWavData();
   Ui8* GetVorbisData() const;
   Si32 GetVorbisSize() const;
@@ -54,6 +68,14 @@ class SoundInstance {
   bool IsPlaying();
   void IncPlaying();
   void DecPlaying();
+  /// @brief Returns the first mixer voice playing this instance.
+  /// Used by the mixer thread only.
+  SoundTask *GetFirstVoice() const {
+    return first_voice_;
+  }
+  void SetFirstVoice(SoundTask *voice) {
+    first_voice_ = voice;
+  }
 };
 
 
@@ -28,16 +28,23 @@
 
 #include <cstring>
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
 #include <utility>
 #include <vector>
 #include <sstream>
 
+#include "engine/arctic_job_system.h"
 #include "engine/arctic_types.h"
+#include "engine/asset_pack.h"
 #include "engine/vec2f.h"
 #include "engine/log.h"
 #include "engine/easy_advanced.h"
+#include "engine/easy_deferred_drawing.h"
+#include "engine/easy_dirty_rects.h"
 #include "engine/easy_files.h"
+#include "engine/easy_sprite_blend.h"
 #include "engine/rgba.h"
 
 namespace arctic {
@@ -51,7 +58,7 @@ template<DrawBlendingMode kBlendingMode, DrawFilterMode kFilterMode>
 void DrawTriangle(Sprite to_sprite,
     Vec2F a, Vec2F b, Vec2F c,
     Vec2F tex_a, Vec2F tex_b, Vec2F tex_c,
-    Sprite texture, Rgba in_color) {
+    Sprite texture, Rgba in_color, Si32 clip_y_begin, Si32 clip_y_end) {
   if (a.y > b.y) {
     std::swap(a, b);
     std::swap(tex_a, tex_b);
@@ -401,6 +408,10 @@ void DrawTriangle(Sprite to_sprite,
   // Fill
   Si32 tex_stride = texture.StridePixels();
   const Rgba * const tex_data = texture.RgbaData();
+  // Edges are computed for the whole triangle so that the rows are the same
+  // no matter which part of them is clipped.
+  first_y = std::max(first_y, clip_y_begin);
+  last_y = std::min(last_y, clip_y_end - 1);
   for (Si32 y = first_y; y <= last_y; ++y) {
     const Edge &edge_l = edge[y * 2];
     const Edge &edge_r = edge[y * 2 + 1];
@@ -548,23 +559,81 @@ void DrawTriangle(Sprite to_sprite,
   }
 }
 
+// Blending a fully transparent pixel leaves the destination pixel as is.
+static constexpr bool IsTransparentSkipped(DrawBlendingMode blending_mode) {
+  return blending_mode != kDrawBlendingModeCopyRgba &&
+    blending_mode != kDrawBlendingModeAdd;
+}
+
+// Blending a fully opaque pixel just copies it.
+static constexpr bool IsOpaqueCopied(DrawBlendingMode blending_mode) {
+  return blending_mode == kDrawBlendingModeCopyRgba ||
+    blending_mode == kDrawBlendingModeAlphaBlend ||
+    blending_mode == kDrawBlendingModePremultipliedAlphaBlend;
+}
+
+// Draws the pixels [k_begin, k_end) of a row scaled with the nearest
+// filter. Pixel k takes the source pixel from_x_b + k * step / 65536.
+template<DrawBlendingMode kBlendingMode>
+static void DrawNearestRowPart(Rgba *to, const Rgba *from_line,
+    const Si32 from_x_b, const Si32 from_x_step_16,
+    const Si32 k_begin, const Si32 k_end, const bool is_opaque,
+    BlendRowFunction blend_row, Rgba in_color) {
+  // Source pixels are fetched into a small buffer and then blended
+  // by the row function, so the blending runs on whole vectors.
+  const Si32 kRowChunk = 256;
+  Rgba row_chunk[kRowChunk];
+  // Copying needs no blending, so fetch right into the destination.
+  const bool is_copy = (kBlendingMode == kDrawBlendingModeCopyRgba ||
+    (is_opaque && IsOpaqueCopied(kBlendingMode)));
+  Si32 from_x_acc_16 = k_begin * from_x_step_16;
+  for (Si32 k = k_begin; k < k_end;) {
+    const Si32 chunk_size = std::min(k_end - k, kRowChunk);
+    Rgba *fetched = (is_copy ? to + k : row_chunk);
+    for (Si32 idx = 0; idx < chunk_size; ++idx) {
+      fetched[idx] = from_line[from_x_b + (from_x_acc_16 >> 16)];
+      from_x_acc_16 += from_x_step_16;
+    }
+    if (!is_copy) {
+      blend_row(to + k, row_chunk, chunk_size, in_color);
+    }
+    k += chunk_size;
+  }
+}
+
+// Returns the first pixel k of a row scaled with the nearest filter that
+// takes a source pixel at or after from_x_disp.
+static Si32 FirstNearestPixel(const Si32 from_x_b, const Si32 from_x_step_16,
+    const Si32 from_x_disp) {
+  if (from_x_disp <= from_x_b) {
+    return 0;
+  }
+  return static_cast<Si32>(
+    (static_cast<Si64>(from_x_disp - from_x_b) * 65536 + from_x_step_16 - 1)
+      / from_x_step_16);
+}
+
 template<DrawBlendingMode kBlendingMode, DrawFilterMode kFilterMode>
 void DrawSprite(Sprite *to_sprite,
     const Si32 to_x_pivot, const Si32 to_y_pivot,
     const Si32 to_width, const Si32 to_height,
     const Sprite &from_sprite, const Si32 from_x, const Si32 from_y,
     const Si32 from_width, const Si32 from_height,
-    Rgba in_color) {
+    Rgba in_color, Si32 clip_y_begin, Si32 clip_y_end) {
   if (!from_width || !from_height || !to_width || !to_height) {
     return;
   }
   const Si32 from_stride_pixels = from_sprite.StridePixels();
   const Si32 to_stride_pixels = to_sprite->StridePixels();
+  const BlendRowFunction blend_row = GetBlendRowFunction(kBlendingMode);
+  const BlendRowFunction copy_row =
+    GetBlendRowFunction(kDrawBlendingModeCopyRgba);
+  const SpriteInstance &from_instance = *from_sprite.SpriteInstance();
+  // Position of the from pixels in the sprite instance the runs describe.
+  const Vec2Si32 from_ref = from_sprite.RefPos() + Vec2Si32(from_x, from_y);
 
   if (to_width == from_width && to_height == from_height
-      && !from_sprite.IsRef() && !from_sprite.Opaque().empty()) {
-    const std::vector<SpanSi32> &opaque = from_sprite.Opaque();
-
+      && from_instance.HasPixelRuns() && IsTransparentSkipped(kBlendingMode)) {
     const Si32 to_x = to_x_pivot - from_sprite.Pivot().x;
     const Si32 to_y = to_y_pivot - from_sprite.Pivot().y;
 
@@ -575,110 +644,33 @@ void DrawSprite(Sprite *to_sprite,
       + from_y * from_stride_pixels
       + from_x;
 
-    const Si32 to_y_db = (to_y >= 0 ? 0 : -to_y);
-    const Si32 to_y_d_max = to_sprite->Height() - to_y;
+    const Si32 to_y_db = std::max(to_y >= 0 ? 0 : -to_y, clip_y_begin - to_y);
+    const Si32 to_y_d_max = std::min(to_sprite->Height(), clip_y_end) - to_y;
     const Si32 to_y_de = (to_height < to_y_d_max ? to_height : to_y_d_max);
 
-    const Si32 k_to_x_db = (to_x >= 0 ? 0 : -to_x);
+    const Si32 to_x_db = (to_x >= 0 ? 0 : -to_x);
     const Si32 to_x_d_max = to_sprite->Width() - to_x;
-    const Si32 k_to_x_de = (to_width < to_x_d_max ? to_width : to_x_d_max);
-    const Si32 from_x_ab = k_to_x_db + from_x;
-    const Si32 from_x_ae = k_to_x_de + from_x;
+    const Si32 to_x_de = (to_width < to_x_d_max ? to_width : to_x_d_max);
 
     for (Si32 to_y_disp = to_y_db; to_y_disp < to_y_de; ++to_y_disp) {
       const Si32 from_y_disp = to_y_disp;
-
-      Si32 from_x_acc = 0;
-      const SpanSi32 &span = opaque[static_cast<size_t>(from_y + to_y_disp)];
-
-      Si32 to_x_db = k_to_x_db;
-      if (span.begin > from_x_ab) {
-        to_x_db += span.begin - from_x_ab;
+      const PixelRun *run = from_instance.RowRunsBegin(from_ref.y + to_y_disp);
+      const PixelRun *run_end = from_instance.RowRunsEnd(from_ref.y + to_y_disp);
+      if (run == run_end) {
+        continue;
       }
-      Si32 to_x_de = k_to_x_de;
-      if (span.end < from_x_ae) {
-        Si32 offset = span.end - from_x_ae;
-        to_x_de += offset;
-      }
-
       const Rgba *from_line = from + from_y_disp * from_stride_pixels;
       Rgba *to_line = to + to_y_disp * to_stride_pixels;
-
-      for (Si32 to_x_disp = to_x_db; to_x_disp < to_x_de; ++to_x_disp) {
-        Rgba *to_rgba = to_line + to_x_disp;
-        const Si32 from_x_disp = to_x_db + from_x_acc;
-        from_x_acc++;
-        const Rgba *from_rgba = from_line + from_x_disp;
-        Rgba color = *from_rgba;
-        if (kBlendingMode == kDrawBlendingModeCopyRgba) {
-          to_rgba->rgba = from_rgba->rgba;
-        } else if (kBlendingMode == kDrawBlendingModeAlphaBlend) {
-          if (color.a == 255) {
-            to_rgba->rgba = color.rgba;
-          } else if (color.a) {
-            Ui32 m = 255 - color.a;
-            Ui32 rb = (to_rgba->rgba & 0x00ff00fful) * m;
-            Ui32 g = ((to_rgba->rgba & 0x0000ff00ul) >> 8u) * m;
-            Ui32 m2 = color.a;
-            Ui32 rb2 = (color.rgba & 0x00ff00fful) * m2;
-            Ui32 g2 = ((color.rgba & 0x0000ff00ul) >> 8u) * m2;
-            to_rgba->rgba = (((rb + rb2) >> 8u) & 0x00ff00fful) |
-            ((g + g2) & 0x0000ff00ul);
-          }
-        } else if (kBlendingMode == kDrawBlendingModePremultipliedAlphaBlend) {
-          if (color.a == 255) {
-            to_rgba->rgba = color.rgba;;
-          } else if (color.a) {
-            Ui32 m = 255 - color.a;
-            Ui32 rb = ((to_rgba->rgba & 0x00ff00fful) * m) >> 8u;
-            Ui32 g = ((to_rgba->rgba & 0x0000ff00ul) >> 8u) * m;
-            Ui32 rb2 = (color.rgba & 0x00ff00fful);
-            Ui32 g2 = (color.rgba & 0x0000ff00ul);
-            to_rgba->rgba = ((rb + rb2) & 0x00ff00fful) | ((g + g2) & 0x0000ff00ul);
-          }
-        } else if (kBlendingMode == kDrawBlendingModeColorize) {
-          Ui32 ca = (Ui32(color.a) * (Ui32(in_color.a) + 1u)) >> 8u;
-          if (ca == 255) {
-            Ui32 r2 = (Ui32(color.r) * (Ui32(in_color.r) + 1)) >> 8u;
-            Ui32 g2 = (Ui32(color.g) * (Ui32(in_color.g) + 1)) >> 8u;
-            Ui32 b2 = (Ui32(color.b) * (Ui32(in_color.b) + 1)) >> 8u;
-            to_rgba->rgba = Rgba((Ui8)r2, (Ui8)g2, (Ui8)b2).rgba;
-          } else if (ca) {
-            Ui32 m = 255 - ca;
-            Ui32 rb = (to_rgba->rgba & 0x00ff00fful) * m;
-            Ui32 g = ((to_rgba->rgba & 0x0000ff00ul) >> 8u) * m;
-
-            Ui32 m2 = ca;
-            Ui32 rb2_ = (((color.rgba & 0x00ff00fful) * m2) & 0xff00ff00u) >> 8u;
-            Ui32 rb2  = ((rb2_ & 0x00ff0000u) * ((in_color.rgba & 0x00ff0000u) >> 16u)) | ((rb2_ & 0x000000ffu) * (in_color.rgba & 0x000000ffu));
-            Ui32 g2 = (Ui32(color.g) * m2 * (Ui32(in_color.g) + 1)) >> 8u;
-
-            to_rgba->rgba = (((rb + rb2) >> 8u) & 0x00ff00fful) | ((g + g2) & 0x0000ff00ul);
-          }
-        } else if (kBlendingMode == kDrawBlendingModeSolidColor) {
-          Ui32 ca = (Ui32(color.a) * (Ui32(in_color.a) + 1u)) >> 8u;
-          if (ca == 255) {
-            to_rgba->rgba = in_color.rgba;
-          } else if (ca) {
-            Ui32 m = 255 - ca;
-            Ui32 rb = (to_rgba->rgba & 0x00ff00fful) * m;
-            Ui32 g = ((to_rgba->rgba & 0x0000ff00ul) >> 8u) * m;
-            
-            Ui32 rb2 = (in_color.rgba & 0x00ff00fful) * ca;
-            Ui32 g2 = ((in_color.rgba & 0x0000ff00ul) >> 8u) * ca;
-
-            to_rgba->rgba = (((rb + rb2) >> 8u) & 0x00ff00fful) | ((g + g2) & 0x0000ff00ul);
-          }
-        } else if (kBlendingMode == kDrawBlendingModeAdd) {
-          Ui32 r2 = Ui32(color.r) + Ui32(to_rgba->r);
-          Ui32 g2 = Ui32(color.g) + Ui32(to_rgba->g);
-          Ui32 b2 = Ui32(color.b) + Ui32(to_rgba->b);
-          r2 = r2 > 255 ? 255 : r2;
-          g2 = g2 > 255 ? 255 : g2;
-          b2 = b2 > 255 ? 255 : b2;
-          to_rgba->rgba = Rgba((Ui8)r2, (Ui8)g2, (Ui8)b2).rgba;
-        } else {  // Unknown blending mode!
-          to_rgba->rgba = color.rgba;
+      for (; run != run_end; ++run) {
+        const Si32 x_b = std::max(run->begin - from_ref.x, to_x_db);
+        const Si32 x_e = std::min(run->end - from_ref.x, to_x_de);
+        if (x_b >= x_e) {
+          continue;
+        }
+        if (run->is_opaque && IsOpaqueCopied(kBlendingMode)) {
+          copy_row(to_line + x_b, from_line + x_b, x_e - x_b, in_color);
+        } else {
+          blend_row(to_line + x_b, from_line + x_b, x_e - x_b, in_color);
         }
       }
     }
@@ -698,15 +690,24 @@ void DrawSprite(Sprite *to_sprite,
     + from_x;
 
   const Si32 to_y_db = (to_y >= 0 ? 0 : -to_y);
-  const Si32 to_y_d_max = to_sprite->Height() - to_y;
+  const Si32 to_y_d_max = std::min(to_sprite->Height(), clip_y_end) - to_y;
   const Si32 to_y_de = (to_height < to_y_d_max ? to_height : to_y_d_max);
+  // Rows above the clip window are stepped over, not skipped, to keep
+  // the source row sequence the same as without clipping.
+  const Si32 to_y_clip_db = clip_y_begin - to_y;
 
   const Si32 to_x_db = (to_x >= 0 ? 0 : -to_x);
   const Si32 to_x_d_max = to_sprite->Width() - to_x;
   const Si32 to_x_de = (to_width < to_x_d_max ? to_width : to_x_d_max);
 
+  // Source pixels are fetched into a small buffer and then blended
+  // by the row function, so the blending runs on whole vectors.
+  const Si32 kRowChunk = 256;
+  Rgba row_chunk[kRowChunk];
+
   const Si32 from_y_step_16 = 65536 * from_height / to_height;
-  Si32 from_y_disp_16 = Si32((65535ull * from_height * to_y_db) / to_height);
+  // Rows clipped at the top take the same source rows as when not clipped.
+  Si32 from_y_disp_16 = from_y_step_16 * to_y_db;
   Si32 from_y_acc_16 = 0;
   if (kFilterMode == kFilterBilinear) {
     from_y_acc_16 = -32767;
@@ -722,125 +723,95 @@ void DrawSprite(Sprite *to_sprite,
 
     Si32 from_y_disp = ((from_y_disp_16 + from_y_acc_16) / 65536);
     from_y_acc_16 += from_y_step_16;
+    if (to_y_disp < to_y_clip_db) {
+      if (from_y_acc_16 > 0) {
+        from_y_8 = (static_cast<Ui32>(from_y_acc_16) & 65535ul) >> 8u;
+      }
+      continue;
+    }
 
     const Rgba *from_line_0 = from + from_y_disp * from_stride_pixels;
     const Rgba *from_line_1 = from +
       std::min(from_height - 1, from_y_disp + 1) * from_stride_pixels;
     Rgba *to_line = to + to_y_disp * to_stride_pixels;
 
+    if (kFilterMode == kFilterNearest) {
+      Rgba *to_row = to_line + to_x_db;
+      const Si32 count = to_x_de - to_x_db;
+      if (!from_instance.HasPixelRuns() ||
+          !IsTransparentSkipped(kBlendingMode)) {
+        DrawNearestRowPart<kBlendingMode>(to_row, from_line_0,
+          from_x_b, from_x_step_16, 0, count, false, blend_row, in_color);
+        continue;
+      }
+      const PixelRun *run = from_instance.RowRunsBegin(from_ref.y + from_y_disp);
+      const PixelRun *run_end = from_instance.RowRunsEnd(from_ref.y + from_y_disp);
+      if (run == run_end) {
+        continue;
+      }
+      for (; run != run_end; ++run) {
+        const Si32 k_b = std::min(count, FirstNearestPixel(from_x_b,
+          from_x_step_16, run->begin - from_ref.x));
+        const Si32 k_e = std::min(count, FirstNearestPixel(from_x_b,
+          from_x_step_16, run->end - from_ref.x));
+        DrawNearestRowPart<kBlendingMode>(to_row, from_line_0,
+          from_x_b, from_x_step_16, k_b, k_e, run->is_opaque,
+          blend_row, in_color);
+      }
+      continue;
+    }
+
     Ui32 from_x_8 = 0;
     Si32 from_x_disp_00 = from_x_b;
-    Si32 from_x_disp_01 = from_x_b + 1;
     Rgba *to_rgba = to_line + to_x_db;
-    for (Si32 to_x_disp = to_x_db; to_x_disp < to_x_de; ++to_x_disp) {
-      from_x_acc_16 += from_x_step_16;
-
-      Rgba color;
-      if (kFilterMode == kFilterNearest) {
-        color = *(from_line_0 + from_x_disp_00);
-      } else if (kFilterMode == kFilterBilinear) {
-        Rgba color00 = *(from_line_0 + from_x_disp_00);
-        Rgba color01 = *(from_line_0 + from_x_disp_00 + 1);
-        Rgba color10 = *(from_line_1 + from_x_disp_00);
-        Rgba color11 = *(from_line_1 + from_x_disp_00 + 1);
-        color = Rgba(
-           (Ui8)(((Ui32(color00.r) * ((255 - from_x_8) * (255 - from_y_8))) +
-            (Ui32(color01.r) * ((from_x_8) * (255 - from_y_8))) +
-            (Ui32(color10.r) * ((255 - from_x_8) * (from_y_8))) +
-            (Ui32(color11.r) * ((from_x_8) * (from_y_8)))) >> 16u),
-           (Ui8)(((Ui32(color00.g) * ((255 - from_x_8) * (255 - from_y_8))) +
-            (Ui32(color01.g) * ((from_x_8) * (255 - from_y_8))) +
-            (Ui32(color10.g) * ((255 - from_x_8) * (from_y_8))) +
-            (Ui32(color11.g) * ((from_x_8) * (from_y_8)))) >> 16u),
-           (Ui8)(((Ui32(color00.b) * ((255 - from_x_8) * (255 - from_y_8))) +
-            (Ui32(color01.b) * ((from_x_8) * (255 - from_y_8))) +
-            (Ui32(color10.b) * ((255 - from_x_8) * (from_y_8))) +
-            (Ui32(color11.b) * ((from_x_8) * (from_y_8)))) >> 16u),
-           (Ui8)(((Ui32(color00.a) * ((255 - from_x_8) * (255 - from_y_8))) +
-            (Ui32(color01.a) * ((from_x_8) * (255 - from_y_8))) +
-            (Ui32(color10.a) * ((255 - from_x_8) * (from_y_8))) +
-            (Ui32(color11.a) * ((from_x_8) * (from_y_8)))) >> 16u));
-      }
-
-
-      if (kBlendingMode == kDrawBlendingModeCopyRgba) {
-        to_rgba->rgba = color.rgba;
-      } else if (kBlendingMode == kDrawBlendingModeAlphaBlend) {
-        if (color.a == 255) {
-          to_rgba->rgba = color.rgba;
-        } else if (color.a) {
-          Ui32 m = 255 - color.a;
-          Ui32 rb = (to_rgba->rgba & 0x00ff00fful) * m;
-          Ui32 g = ((to_rgba->rgba & 0x0000ff00ul) >> 8u) * m;
-          Ui32 m2 = color.a;
-          Ui32 rb2 = (color.rgba & 0x00ff00fful) * m2;
-          Ui32 g2 = ((color.rgba & 0x0000ff00ul) >> 8u) * m2;
-          to_rgba->rgba = (((rb + rb2) >> 8u) & 0x00ff00fful) |
-            ((g + g2) & 0x0000ff00ul);
-        }
-      } else if (kBlendingMode == kDrawBlendingModePremultipliedAlphaBlend) {
-        if (color.a == 255) {
-          to_rgba->rgba = color.rgba;;
-        } else if (color.a) {
-          Ui32 m = 255 - color.a;
-          Ui32 rb = ((to_rgba->rgba & 0x00ff00fful) * m) >> 8u;
-          Ui32 g = ((to_rgba->rgba & 0x0000ff00ul) >> 8u) * m;
-          Ui32 rb2 = (color.rgba & 0x00ff00fful);
-          Ui32 g2 = (color.rgba & 0x0000ff00ul);
-          to_rgba->rgba = ((rb + rb2) & 0x00ff00fful) | ((g + g2) & 0x0000ff00ul);
+    for (Si32 to_x_disp = to_x_db; to_x_disp < to_x_de;) {
+      const Si32 chunk_size = std::min(to_x_de - to_x_disp, kRowChunk);
+      // Copying needs no blending, so fetch right into the destination.
+      Rgba *fetched = (kBlendingMode == kDrawBlendingModeCopyRgba ?
+        to_rgba : row_chunk);
+      for (Si32 idx = 0; idx < chunk_size; ++idx) {
+        from_x_acc_16 += from_x_step_16;
+
+        Rgba color;
+        if (kFilterMode == kFilterNearest) {
+          color = *(from_line_0 + from_x_disp_00);
+        } else if (kFilterMode == kFilterBilinear) {
+          const Si32 from_x_disp_01 =
+            std::min(from_width - 1, from_x_disp_00 + 1);
+          Rgba color00 = *(from_line_0 + from_x_disp_00);
+          Rgba color01 = *(from_line_0 + from_x_disp_01);
+          Rgba color10 = *(from_line_1 + from_x_disp_00);
+          Rgba color11 = *(from_line_1 + from_x_disp_01);
+          color = Rgba(
+             (Ui8)(((Ui32(color00.r) * ((255 - from_x_8) * (255 - from_y_8))) +
+              (Ui32(color01.r) * ((from_x_8) * (255 - from_y_8))) +
+              (Ui32(color10.r) * ((255 - from_x_8) * (from_y_8))) +
+              (Ui32(color11.r) * ((from_x_8) * (from_y_8)))) >> 16u),
+             (Ui8)(((Ui32(color00.g) * ((255 - from_x_8) * (255 - from_y_8))) +
+              (Ui32(color01.g) * ((from_x_8) * (255 - from_y_8))) +
+              (Ui32(color10.g) * ((255 - from_x_8) * (from_y_8))) +
+              (Ui32(color11.g) * ((from_x_8) * (from_y_8)))) >> 16u),
+             (Ui8)(((Ui32(color00.b) * ((255 - from_x_8) * (255 - from_y_8))) +
+              (Ui32(color01.b) * ((from_x_8) * (255 - from_y_8))) +
+              (Ui32(color10.b) * ((255 - from_x_8) * (from_y_8))) +
+              (Ui32(color11.b) * ((from_x_8) * (from_y_8)))) >> 16u),
+             (Ui8)(((Ui32(color00.a) * ((255 - from_x_8) * (255 - from_y_8))) +
+              (Ui32(color01.a) * ((from_x_8) * (255 - from_y_8))) +
+              (Ui32(color10.a) * ((255 - from_x_8) * (from_y_8))) +
+              (Ui32(color11.a) * ((from_x_8) * (from_y_8)))) >> 16u));
         }
-      } else if (kBlendingMode == kDrawBlendingModeColorize) {
-        Ui32 ca = (Ui32(color.a) * (Ui32(in_color.a) + 1)) >> 8u;
-        if (ca == 255) {
-          Ui32 r2 = (Ui32(color.r) * (Ui32(in_color.r) + 1)) >> 8u;
-          Ui32 g2 = (Ui32(color.g) * (Ui32(in_color.g) + 1)) & 0xff00u;
-          Ui32 b2 = ((Ui32(color.b) * (Ui32(in_color.b) + 1)) << 8u)
-            & 0xff0000ull;
-          to_rgba->rgba = r2 | g2 | b2;
-        } else if (ca) {
-          Ui32 m = 255 - ca;
-          Ui32 rb = (to_rgba->rgba & 0x00ff00fful) * m;
-          Ui32 g = ((to_rgba->rgba & 0x0000ff00ul) >> 8u) * m;
-
-          Ui32 m2 = ca;
-          Ui32 rb2_ = (((color.rgba & 0x00ff00fful) * m2) & 0xff00ff00u) >> 8u;
-          Ui32 rb2  = ((rb2_ & 0x00ff0000u) * ((in_color.rgba & 0x00ff0000u) >> 16u)) | ((rb2_ & 0x000000ffu) * (in_color.rgba & 0x000000ffu));
-          Ui32 g2 = (Ui32(color.g) * m2 * (Ui32(in_color.g) + 1)) >> 8u;
+        fetched[idx] = color;
 
-          to_rgba->rgba = (((rb + rb2) >> 8u) & 0x00ff00fful) | ((g + g2) & 0x0000ff00ul);
+        if (from_x_acc_16 > 0) {
+          from_x_8 = (static_cast<Ui32>(from_x_acc_16) & 65535ul) >> 8u;
+          from_x_disp_00 = from_x_b + static_cast<Si32>((static_cast<Ui32>(from_x_acc_16) >> 16u));
         }
-      } else if (kBlendingMode == kDrawBlendingModeSolidColor) {
-        Ui32 ca = (Ui32(color.a) * (Ui32(in_color.a) + 1u)) >> 8u;
-        if (ca == 255) {
-          to_rgba->rgba = in_color.rgba;
-        } else if (ca) {
-          Ui32 m = 255 - ca;
-          Ui32 rb = (to_rgba->rgba & 0x00ff00fful) * m;
-          Ui32 g = ((to_rgba->rgba & 0x0000ff00ul) >> 8u) * m;
-          
-          Ui32 rb2 = (in_color.rgba & 0x00ff00fful) * ca;
-          Ui32 g2 = ((in_color.rgba & 0x0000ff00ul) >> 8u) * ca;
-
-          to_rgba->rgba = (((rb + rb2) >> 8u) & 0x00ff00fful) | ((g + g2) & 0x0000ff00ul);
-        }
-      } else if (kBlendingMode == kDrawBlendingModeAdd) {
-        Ui32 r2 = Ui32(color.r) + Ui32(to_rgba->r);
-        Ui32 g2 = Ui32(color.g) + Ui32(to_rgba->g);
-        Ui32 b2 = Ui32(color.b) + Ui32(to_rgba->b);
-        r2 = r2 > 255 ? 255 : r2;
-        g2 = g2 > 255 ? 255 : g2;
-        b2 = b2 > 255 ? 255 : b2;
-        to_rgba->rgba = Rgba((Ui8)r2, (Ui8)g2, (Ui8)b2).rgba;
-      } else {  // Unknown blending mode!
-        to_rgba->rgba = color.rgba;
       }
-
-      if (from_x_acc_16 > 0) {
-        from_x_8 = (static_cast<Ui32>(from_x_acc_16) & 65535ul) >> 8u;
-        from_x_disp_00 = from_x_b + static_cast<Si32>((static_cast<Ui32>(from_x_acc_16) >> 16u));
-        from_x_disp_01 = from_x_disp_00 + 1;
+      if (kBlendingMode != kDrawBlendingModeCopyRgba) {
+        blend_row(to_rgba, row_chunk, chunk_size, in_color);
       }
-      ++to_rgba;
+      to_rgba += chunk_size;
+      to_x_disp += chunk_size;
     }
     if (from_y_acc_16 > 0) {
       from_y_8 = (static_cast<Ui32>(from_y_acc_16) & 65535ul) >> 8u;
@@ -853,61 +824,544 @@ template void DrawSprite<kDrawBlendingModeCopyRgba, kFilterNearest>(
   const Si32 to_width, const Si32 to_height,
   const Sprite &from_sprite, const Si32 from_x, const Si32 from_y,
   const Si32 from_width, const Si32 from_height,
-  Rgba color);
+  Rgba color, Si32 clip_y_begin, Si32 clip_y_end);
 template void DrawSprite<kDrawBlendingModeAlphaBlend, kFilterNearest>(
   Sprite *to_sprite, const Si32 to_x_pivot, const Si32 to_y_pivot,
   const Si32 to_width, const Si32 to_height,
   const Sprite &from_sprite, const Si32 from_x, const Si32 from_y,
   const Si32 from_width, const Si32 from_height,
-  Rgba color);
+  Rgba color, Si32 clip_y_begin, Si32 clip_y_end);
 template void DrawSprite<kDrawBlendingModePremultipliedAlphaBlend, kFilterNearest>(
   Sprite *to_sprite, const Si32 to_x_pivot, const Si32 to_y_pivot,
   const Si32 to_width, const Si32 to_height,
   const Sprite &from_sprite, const Si32 from_x, const Si32 from_y,
   const Si32 from_width, const Si32 from_height,
-  Rgba color);
+  Rgba color, Si32 clip_y_begin, Si32 clip_y_end);
 template void DrawSprite<kDrawBlendingModeColorize, kFilterNearest>(
   Sprite *to_sprite, const Si32 to_x_pivot, const Si32 to_y_pivot,
   const Si32 to_width, const Si32 to_height,
   const Sprite &from_sprite, const Si32 from_x, const Si32 from_y,
   const Si32 from_width, const Si32 from_height,
-  Rgba color);
+  Rgba color, Si32 clip_y_begin, Si32 clip_y_end);
 template void DrawSprite<kDrawBlendingModeSolidColor, kFilterNearest>(
   Sprite *to_sprite, const Si32 to_x_pivot, const Si32 to_y_pivot,
   const Si32 to_width, const Si32 to_height,
   const Sprite &from_sprite, const Si32 from_x, const Si32 from_y,
   const Si32 from_width, const Si32 from_height,
-  Rgba color);
+  Rgba color, Si32 clip_y_begin, Si32 clip_y_end);
 template void DrawSprite<kDrawBlendingModeCopyRgba, kFilterBilinear>(
   Sprite *to_sprite, const Si32 to_x_pivot, const Si32 to_y_pivot,
   const Si32 to_width, const Si32 to_height,
   const Sprite &from_sprite, const Si32 from_x, const Si32 from_y,
   const Si32 from_width, const Si32 from_height,
-  Rgba color);
+  Rgba color, Si32 clip_y_begin, Si32 clip_y_end);
 template void DrawSprite<kDrawBlendingModeAlphaBlend, kFilterBilinear>(
   Sprite *to_sprite, const Si32 to_x_pivot, const Si32 to_y_pivot,
   const Si32 to_width, const Si32 to_height,
   const Sprite &from_sprite, const Si32 from_x, const Si32 from_y,
   const Si32 from_width, const Si32 from_height,
-  Rgba color);
+  Rgba color, Si32 clip_y_begin, Si32 clip_y_end);
 template void DrawSprite<kDrawBlendingModePremultipliedAlphaBlend, kFilterBilinear>(
   Sprite *to_sprite, const Si32 to_x_pivot, const Si32 to_y_pivot,
   const Si32 to_width, const Si32 to_height,
   const Sprite &from_sprite, const Si32 from_x, const Si32 from_y,
   const Si32 from_width, const Si32 from_height,
-  Rgba color);
+  Rgba color, Si32 clip_y_begin, Si32 clip_y_end);
 template void DrawSprite<kDrawBlendingModeColorize, kFilterBilinear>(
   Sprite *to_sprite, const Si32 to_x_pivot, const Si32 to_y_pivot,
   const Si32 to_width, const Si32 to_height,
   const Sprite &from_sprite, const Si32 from_x, const Si32 from_y,
   const Si32 from_width, const Si32 from_height,
-  Rgba color);
+  Rgba color, Si32 clip_y_begin, Si32 clip_y_end);
 template void DrawSprite<kDrawBlendingModeSolidColor, kFilterBilinear>(
   Sprite *to_sprite, const Si32 to_x_pivot, const Si32 to_y_pivot,
   const Si32 to_width, const Si32 to_height,
   const Sprite &from_sprite, const Si32 from_x, const Si32 from_y,
   const Si32 from_width, const Si32 from_height,
-  Rgba color);
+  Rgba color, Si32 clip_y_begin, Si32 clip_y_end);
+
+
+static void DrawSpriteClipped(Sprite *to_sprite,
+    const Si32 to_x_pivot, const Si32 to_y_pivot,
+    const Si32 to_width, const Si32 to_height,
+    const Sprite &from_sprite, const Si32 from_x, const Si32 from_y,
+    const Si32 from_width, const Si32 from_height,
+    DrawBlendingMode blending_mode, DrawFilterMode filter_mode,
+    Rgba in_color, Si32 clip_y_begin, Si32 clip_y_end) {
+  switch (filter_mode) {
+    case kFilterNearest:
+      switch (blending_mode) {
+        default:
+        case kDrawBlendingModeCopyRgba:
+          DrawSprite<kDrawBlendingModeCopyRgba, kFilterNearest>(to_sprite,
+            to_x_pivot, to_y_pivot, to_width, to_height,
+            from_sprite, from_x, from_y, from_width, from_height,
+            in_color, clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModeAlphaBlend:
+          DrawSprite<kDrawBlendingModeAlphaBlend, kFilterNearest>(to_sprite,
+            to_x_pivot, to_y_pivot, to_width, to_height,
+            from_sprite, from_x, from_y, from_width, from_height,
+            in_color, clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModePremultipliedAlphaBlend:
+          DrawSprite<kDrawBlendingModePremultipliedAlphaBlend, kFilterNearest>(to_sprite,
+            to_x_pivot, to_y_pivot, to_width, to_height,
+            from_sprite, from_x, from_y, from_width, from_height,
+            in_color, clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModeColorize:
+          DrawSprite<kDrawBlendingModeColorize, kFilterNearest>(to_sprite,
+            to_x_pivot, to_y_pivot, to_width, to_height,
+            from_sprite, from_x, from_y, from_width, from_height,
+            in_color, clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModeSolidColor:
+          DrawSprite<kDrawBlendingModeSolidColor, kFilterNearest>(to_sprite,
+            to_x_pivot, to_y_pivot, to_width, to_height,
+            from_sprite, from_x, from_y, from_width, from_height,
+            in_color, clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModeAdd:
+          DrawSprite<kDrawBlendingModeAdd, kFilterNearest>(to_sprite,
+            to_x_pivot, to_y_pivot, to_width, to_height,
+            from_sprite, from_x, from_y, from_width, from_height,
+            in_color, clip_y_begin, clip_y_end);
+          break;
+      }
+      break;
+    case kFilterBilinear:
+      switch (blending_mode) {
+        default:
+        case kDrawBlendingModeCopyRgba:
+          DrawSprite<kDrawBlendingModeCopyRgba, kFilterBilinear>(to_sprite,
+            to_x_pivot, to_y_pivot, to_width, to_height,
+            from_sprite, from_x, from_y, from_width, from_height,
+            in_color, clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModeAlphaBlend:
+          DrawSprite<kDrawBlendingModeAlphaBlend, kFilterBilinear>(to_sprite,
+            to_x_pivot, to_y_pivot, to_width, to_height,
+            from_sprite, from_x, from_y, from_width, from_height,
+            in_color, clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModePremultipliedAlphaBlend:
+          DrawSprite<kDrawBlendingModePremultipliedAlphaBlend, kFilterBilinear>(to_sprite,
+            to_x_pivot, to_y_pivot, to_width, to_height,
+            from_sprite, from_x, from_y, from_width, from_height,
+            in_color, clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModeColorize:
+          DrawSprite<kDrawBlendingModeColorize, kFilterBilinear>(to_sprite,
+            to_x_pivot, to_y_pivot, to_width, to_height,
+            from_sprite, from_x, from_y, from_width, from_height,
+            in_color, clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModeSolidColor:
+          DrawSprite<kDrawBlendingModeSolidColor, kFilterBilinear>(to_sprite,
+            to_x_pivot, to_y_pivot, to_width, to_height,
+            from_sprite, from_x, from_y, from_width, from_height,
+            in_color, clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModeAdd:
+          DrawSprite<kDrawBlendingModeAdd, kFilterBilinear>(to_sprite,
+            to_x_pivot, to_y_pivot, to_width, to_height,
+            from_sprite, from_x, from_y, from_width, from_height,
+            in_color, clip_y_begin, clip_y_end);
+          break;
+      }
+      break;
+  }
+}
+
+static void DrawTriangleClipped(Sprite to_sprite,
+    Vec2F a, Vec2F b, Vec2F c,
+    Vec2F ta, Vec2F tb, Vec2F tc,
+    Sprite texture,
+    DrawBlendingMode blending_mode, DrawFilterMode filter_mode, Rgba in_color,
+    Si32 clip_y_begin, Si32 clip_y_end) {
+  switch (filter_mode) {
+    case kFilterNearest:
+      switch (blending_mode) {
+        case kDrawBlendingModeCopyRgba:
+          DrawTriangle<kDrawBlendingModeCopyRgba, kFilterNearest>(to_sprite,
+            a, b, c, ta, tb, tc, texture, in_color,
+            clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModeAlphaBlend:
+          DrawTriangle<kDrawBlendingModeAlphaBlend, kFilterNearest>(to_sprite,
+            a, b, c, ta, tb, tc, texture, in_color,
+            clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModePremultipliedAlphaBlend:
+          DrawTriangle<kDrawBlendingModePremultipliedAlphaBlend, kFilterNearest>(to_sprite,
+            a, b, c, ta, tb, tc, texture, in_color,
+            clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModeColorize:
+          DrawTriangle<kDrawBlendingModeColorize, kFilterNearest>(to_sprite,
+            a, b, c, ta, tb, tc, texture, in_color,
+            clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModeSolidColor:
+          DrawTriangle<kDrawBlendingModeSolidColor, kFilterNearest>(to_sprite,
+            a, b, c, ta, tb, tc, texture, in_color,
+            clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModeAdd:
+          DrawTriangle<kDrawBlendingModeAdd, kFilterNearest>(to_sprite,
+            a, b, c, ta, tb, tc, texture, in_color,
+            clip_y_begin, clip_y_end);
+          break;
+      }
+      break;
+    case kFilterBilinear:
+      switch (blending_mode) {
+        case kDrawBlendingModeCopyRgba:
+          DrawTriangle<kDrawBlendingModeCopyRgba, kFilterBilinear>(to_sprite,
+            a, b, c, ta, tb, tc, texture, in_color,
+            clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModeAlphaBlend:
+          DrawTriangle<kDrawBlendingModeAlphaBlend, kFilterBilinear>(to_sprite,
+            a, b, c, ta, tb, tc, texture, in_color,
+            clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModePremultipliedAlphaBlend:
+          DrawTriangle<kDrawBlendingModePremultipliedAlphaBlend, kFilterBilinear>(to_sprite,
+            a, b, c, ta, tb, tc, texture, in_color,
+            clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModeColorize:
+          DrawTriangle<kDrawBlendingModeColorize, kFilterBilinear>(to_sprite,
+            a, b, c, ta, tb, tc, texture, in_color,
+            clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModeSolidColor:
+          DrawTriangle<kDrawBlendingModeSolidColor, kFilterBilinear>(to_sprite,
+            a, b, c, ta, tb, tc, texture, in_color,
+            clip_y_begin, clip_y_end);
+          break;
+        case kDrawBlendingModeAdd:
+          DrawTriangle<kDrawBlendingModeAdd, kFilterBilinear>(to_sprite,
+            a, b, c, ta, tb, tc, texture, in_color,
+            clip_y_begin, clip_y_end);
+          break;
+      }
+
+      break;
+  }
+}
+
+// Returns the rows [begin, end) the textured triangles may cover.
+static Vec2Si32 TriangleRows(Vec2F a, Vec2F b, Vec2F c) {
+  const float min_y = std::min(std::min(a.y, b.y), c.y);
+  const float max_y = std::max(std::max(a.y, b.y), c.y);
+  return Vec2Si32(static_cast<Si32>(std::floor(min_y)),
+    static_cast<Si32>(std::floor(max_y)) + 1);
+}
+
+static void DrawSpriteDeferred(const DeferredDrawCommand &command,
+    Si32 clip_y_begin, Si32 clip_y_end) {
+  Sprite to_sprite = command.to_sprite;
+  DrawSpriteClipped(&to_sprite, command.point[0].x, command.point[0].y,
+    command.point[1].x, command.point[1].y, command.from_sprite,
+    command.point[2].x, command.point[2].y,
+    command.point[3].x, command.point[3].y,
+    command.blending_mode, command.filter_mode, command.color[0],
+    clip_y_begin, clip_y_end);
+}
+
+static void DrawTriangleDeferred(const DeferredDrawCommand &command,
+    Si32 clip_y_begin, Si32 clip_y_end) {
+  DrawTriangleClipped(command.to_sprite,
+    command.vertex[0], command.vertex[1], command.vertex[2],
+    command.tex_coord[0], command.tex_coord[1], command.tex_coord[2],
+    command.from_sprite, command.blending_mode, command.filter_mode,
+    command.color[0], clip_y_begin, clip_y_end);
+}
+
+static void MarkTriangleDirty(const Sprite &to_sprite,
+    Vec2F a, Vec2F b, Vec2F c) {
+  const float min_x = std::min(std::min(a.x, b.x), c.x);
+  const float max_x = std::max(std::max(a.x, b.x), c.x);
+  const Vec2Si32 rows = TriangleRows(a, b, c);
+  MarkSpriteDirty(to_sprite, static_cast<Si32>(std::floor(min_x)), rows.x,
+    static_cast<Si32>(std::floor(max_x)) + 1, rows.y);
+}
+
+// Rotated sprites smaller than this are not drawn.
+static const float kMinRotatedZoom = 1.f / 4096.f;
+
+// Maps the destination pixels of a rotated and zoomed sprite back to its
+// source pixels in 16.16 fixed point. The destination pixel (x, y) maps to
+// u = u_origin_16 + (x - origin.x) * du_dx_16 + (y - origin.y) * du_dy_16
+// and v likewise, the source pixel (u, v) covers [u - 0.5, u + 0.5).
+struct RotatedSpriteMapping {
+  Vec2Si32 origin;
+  Si64 u_origin_16;
+  Si64 v_origin_16;
+  Si64 du_dx_16;
+  Si64 dv_dx_16;
+  Si64 du_dy_16;
+  Si64 dv_dy_16;
+};
+
+static RotatedSpriteMapping MakeRotatedSpriteMapping(float to_x, float to_y,
+    float angle_radians, float zoom, Vec2Si32 pivot) {
+  const double sin_a = std::sin(static_cast<double>(angle_radians)) / zoom;
+  const double cos_a = std::cos(static_cast<double>(angle_radians)) / zoom;
+  RotatedSpriteMapping map;
+  map.origin = Vec2Si32(static_cast<Si32>(std::floor(to_x)),
+    static_cast<Si32>(std::floor(to_y)));
+  const double dx = static_cast<double>(map.origin.x) - to_x;
+  const double dy = static_cast<double>(map.origin.y) - to_y;
+  map.u_origin_16 = std::llround(
+    (static_cast<double>(pivot.x) + cos_a * dx + sin_a * dy) * 65536.0);
+  map.v_origin_16 = std::llround(
+    (static_cast<double>(pivot.y) - sin_a * dx + cos_a * dy) * 65536.0);
+  map.du_dx_16 = std::llround(cos_a * 65536.0);
+  map.dv_dx_16 = std::llround(-sin_a * 65536.0);
+  map.du_dy_16 = std::llround(sin_a * 65536.0);
+  map.dv_dy_16 = std::llround(cos_a * 65536.0);
+  return map;
+}
+
+// Computes the destination rectangle [min, max) a rotated sprite may cover.
+static void RotatedSpriteBounds(float to_x, float to_y,
+    float angle_radians, float zoom, Vec2Si32 pivot, Vec2Si32 size,
+    Vec2Si32 *out_min, Vec2Si32 *out_max) {
+  const float sin_a = sinf(angle_radians) * zoom;
+  const float cos_a = cosf(angle_radians) * zoom;
+  const float u[2] = {-0.5f - static_cast<float>(pivot.x),
+    static_cast<float>(size.x - pivot.x) - 0.5f};
+  const float v[2] = {-0.5f - static_cast<float>(pivot.y),
+    static_cast<float>(size.y - pivot.y) - 0.5f};
+  Vec2F min_f(to_x, to_y);
+  Vec2F max_f(to_x, to_y);
+  for (Si32 i = 0; i < 4; ++i) {
+    const Vec2F corner(to_x + cos_a * u[i & 1] - sin_a * v[i >> 1],
+      to_y + sin_a * u[i & 1] + cos_a * v[i >> 1]);
+    min_f = Vec2F(std::min(min_f.x, corner.x), std::min(min_f.y, corner.y));
+    max_f = Vec2F(std::max(max_f.x, corner.x), std::max(max_f.y, corner.y));
+  }
+  *out_min = Vec2Si32(static_cast<Si32>(std::floor(min_f.x)),
+    static_cast<Si32>(std::floor(min_f.y)));
+  *out_max = Vec2Si32(static_cast<Si32>(std::floor(max_f.x)) + 1,
+    static_cast<Si32>(std::floor(max_f.y)) + 1);
+}
+
+static Si64 FloorDiv(Si64 a, Si64 b) {
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+// Narrows the steps [*k_begin, *k_end) to the ones that keep
+// value + k * step within [min_value, max_value].
+static void ClipAffineSteps(Si64 value, Si64 step,
+    Si64 min_value, Si64 max_value, Si64 *k_begin, Si64 *k_end) {
+  if (step == 0) {
+    if (value < min_value || value > max_value) {
+      *k_end = *k_begin;
+    }
+    return;
+  }
+  if (step < 0) {
+    value = -value;
+    step = -step;
+    const Si64 negated_min = -max_value;
+    max_value = -min_value;
+    min_value = negated_min;
+  }
+  *k_begin = std::max(*k_begin, -FloorDiv(value - min_value, step));
+  *k_end = std::min(*k_end, FloorDiv(max_value - value, step) + 1);
+}
+
+// Finds the source pixel rectangle [min, max] out of which all the pixels
+// are fully transparent. Returns false if the sprite has no such pixels.
+// Sets is_opaque if all the pixels of the sprite are fully opaque.
+static bool VisiblePixelBounds(const Sprite &sprite,
+    Vec2Si32 *out_min, Vec2Si32 *out_max, bool *out_is_opaque) {
+  const SpriteInstance &instance = *sprite.SpriteInstance();
+  const Vec2Si32 ref = sprite.RefPos();
+  const Si32 width = sprite.Width();
+  Vec2Si32 min(width, sprite.Height());
+  Vec2Si32 max(-1, -1);
+  bool is_opaque = true;
+  for (Si32 y = 0; y < sprite.Height(); ++y) {
+    Si32 opaque_end = ref.x;
+    for (const PixelRun *run = instance.RowRunsBegin(ref.y + y);
+        run != instance.RowRunsEnd(ref.y + y); ++run) {
+      const Si32 begin = std::max(run->begin - ref.x, 0);
+      const Si32 end = std::min(run->end - ref.x, width);
+      if (begin >= end) {
+        continue;
+      }
+      min = Vec2Si32(std::min(min.x, begin), std::min(min.y, y));
+      max = Vec2Si32(std::max(max.x, end - 1), y);
+      if (run->is_opaque && run->begin <= opaque_end) {
+        opaque_end = std::max(opaque_end, run->end);
+      }
+    }
+    is_opaque = is_opaque && opaque_end >= ref.x + width;
+  }
+  *out_min = min;
+  *out_max = max;
+  *out_is_opaque = is_opaque;
+  return max.y >= 0;
+}
+
+// Draws a rotated and zoomed sprite. Walks the destination rows once and
+// clips each of them to the source rectangle exactly, so the pixels are
+// mapped with no edge tests and all the fetches stay inside the source.
+template<DrawFilterMode kFilterMode>
+static void DrawRotatedSprite(Sprite to_sprite,
+    const RotatedSpriteMapping &map, const Sprite &from_sprite,
+    DrawBlendingMode blending_mode, Rgba in_color,
+    Si32 clip_y_begin, Si32 clip_y_end) {
+  const Si32 from_width = from_sprite.Width();
+  const Si32 from_height = from_sprite.Height();
+  if (!from_width || !from_height) {
+    return;
+  }
+  Vec2Si32 from_min(0, 0);
+  Vec2Si32 from_max(from_width - 1, from_height - 1);
+  bool is_opaque = false;
+  if (from_sprite.SpriteInstance()->HasPixelRuns()) {
+    Vec2Si32 visible_min;
+    Vec2Si32 visible_max;
+    const bool is_visible = VisiblePixelBounds(from_sprite,
+      &visible_min, &visible_max, &is_opaque);
+    if (IsTransparentSkipped(blending_mode)) {
+      if (!is_visible) {
+        return;
+      }
+      // Bilinear filtering blends in the pixels next to the visible ones.
+      const Si32 margin = (kFilterMode == kFilterBilinear ? 1 : 0);
+      from_min = Vec2Si32(std::max(visible_min.x - margin, 0),
+        std::max(visible_min.y - margin, 0));
+      from_max = Vec2Si32(std::min(visible_max.x + margin, from_width - 1),
+        std::min(visible_max.y + margin, from_height - 1));
+    }
+  }
+  const Si64 u_min_16 = static_cast<Si64>(from_min.x) * 65536 - 32768;
+  const Si64 u_max_16 = static_cast<Si64>(from_max.x) * 65536 + 32767;
+  const Si64 v_min_16 = static_cast<Si64>(from_min.y) * 65536 - 32768;
+  const Si64 v_max_16 = static_cast<Si64>(from_max.y) * 65536 + 32767;
+
+  // Copying needs no blending, so fetch right into the destination.
+  // Bilinear filtering does not keep the opaque pixels fully opaque.
+  const bool is_copy = (blending_mode == kDrawBlendingModeCopyRgba ||
+    (kFilterMode == kFilterNearest && is_opaque &&
+      IsOpaqueCopied(blending_mode)));
+  const BlendRowFunction blend_row = GetBlendRowFunction(blending_mode);
+  const BilinearRowFunction bilinear_row = GetBilinearRowFunction();
+  const Rgba *from = from_sprite.RgbaData();
+  const Si32 from_stride = from_sprite.StridePixels();
+  const Si32 to_stride = to_sprite.StridePixels();
+  const Si32 to_width = to_sprite.Width();
+  // Source pixels are fetched into small buffers and then filtered and
+  // blended by the row functions, so these run on whole vectors.
+  const Si32 kRowChunk = 256;
+  Rgba row_chunk[kRowChunk];
+  Rgba color00[kFilterMode == kFilterBilinear ? kRowChunk : 1];
+  Rgba color01[kFilterMode == kFilterBilinear ? kRowChunk : 1];
+  Rgba color10[kFilterMode == kFilterBilinear ? kRowChunk : 1];
+  Rgba color11[kFilterMode == kFilterBilinear ? kRowChunk : 1];
+  Ui32 from_x_8[kFilterMode == kFilterBilinear ? kRowChunk : 1];
+  Ui32 from_y_8[kFilterMode == kFilterBilinear ? kRowChunk : 1];
+  const Si32 u_last_16 = (from_width - 1) * 65536;
+  const Si32 v_last_16 = (from_height - 1) * 65536;
+  // The steps wrap around just like the signed values would, the values
+  // of the pixels inside the source fit Si32.
+  const Ui32 du = static_cast<Ui32>(map.du_dx_16);
+  const Ui32 dv = static_cast<Ui32>(map.dv_dx_16);
+
+  const Si32 y_begin = std::max(clip_y_begin, 0);
+  const Si32 y_end = std::min(clip_y_end, to_sprite.Height());
+  for (Si32 y = y_begin; y < y_end; ++y) {
+    const Si64 dy = y - map.origin.y;
+    const Si64 u_row = map.u_origin_16 + dy * map.du_dy_16 -
+      map.origin.x * map.du_dx_16;
+    const Si64 v_row = map.v_origin_16 + dy * map.dv_dy_16 -
+      map.origin.x * map.dv_dx_16;
+    Si64 x_begin = 0;
+    Si64 x_end = to_width;
+    ClipAffineSteps(u_row, map.du_dx_16, u_min_16, u_max_16, &x_begin, &x_end);
+    ClipAffineSteps(v_row, map.dv_dx_16, v_min_16, v_max_16, &x_begin, &x_end);
+    if (x_begin >= x_end) {
+      continue;
+    }
+    Ui32 u = static_cast<Ui32>(u_row + x_begin * map.du_dx_16);
+    Ui32 v = static_cast<Ui32>(v_row + x_begin * map.dv_dx_16);
+    Rgba *to_row = to_sprite.RgbaData() + y * to_stride + x_begin;
+    const Si32 count = static_cast<Si32>(x_end - x_begin);
+    for (Si32 k = 0; k < count;) {
+      const Si32 chunk_size = std::min(count - k, kRowChunk);
+      Rgba *fetched = (is_copy ? to_row + k : row_chunk);
+      if (kFilterMode == kFilterNearest) {
+        for (Si32 idx = 0; idx < chunk_size; ++idx) {
+          fetched[idx] = from[((v + 32768u) >> 16) * from_stride +
+            ((u + 32768u) >> 16)];
+          u += du;
+          v += dv;
+        }
+      } else {
+        for (Si32 idx = 0; idx < chunk_size; ++idx) {
+          const Si32 u_16 = std::min(std::max(static_cast<Si32>(u), 0),
+            u_last_16);
+          const Si32 v_16 = std::min(std::max(static_cast<Si32>(v), 0),
+            v_last_16);
+          const Si32 x0 = u_16 >> 16;
+          const Si32 y0 = v_16 >> 16;
+          const Rgba *line_0 = from + y0 * from_stride;
+          const Rgba *line_1 = (y0 + 1 < from_height ?
+            line_0 + from_stride : line_0);
+          const Si32 x1 = (x0 + 1 < from_width ? x0 + 1 : x0);
+          color00[idx] = line_0[x0];
+          color01[idx] = line_0[x1];
+          color10[idx] = line_1[x0];
+          color11[idx] = line_1[x1];
+          from_x_8[idx] = (static_cast<Ui32>(u_16) >> 8u) & 255u;
+          from_y_8[idx] = (static_cast<Ui32>(v_16) >> 8u) & 255u;
+          u += du;
+          v += dv;
+        }
+        bilinear_row(fetched, color00, color01, color10, color11,
+          from_x_8, from_y_8, chunk_size);
+      }
+      if (!is_copy) {
+        blend_row(to_row + k, row_chunk, chunk_size, in_color);
+      }
+      k += chunk_size;
+    }
+  }
+}
+
+static void DrawRotatedSpriteClipped(Sprite to_sprite,
+    const RotatedSpriteMapping &map, const Sprite &from_sprite,
+    DrawBlendingMode blending_mode, DrawFilterMode filter_mode, Rgba in_color,
+    Si32 clip_y_begin, Si32 clip_y_end) {
+  if (filter_mode == kFilterBilinear) {
+    DrawRotatedSprite<kFilterBilinear>(to_sprite, map, from_sprite,
+      blending_mode, in_color, clip_y_begin, clip_y_end);
+  } else {
+    DrawRotatedSprite<kFilterNearest>(to_sprite, map, from_sprite,
+      blending_mode, in_color, clip_y_begin, clip_y_end);
+  }
+}
+
+// The command keeps the rotation parameters and the mapping is rebuilt
+// for each band, it is the same for the same parameters.
+static void DrawRotatedSpriteDeferred(const DeferredDrawCommand &command,
+    Si32 clip_y_begin, Si32 clip_y_end) {
+  const RotatedSpriteMapping map = MakeRotatedSpriteMapping(
+    command.vertex[0].x, command.vertex[0].y,
+    command.vertex[1].x, command.vertex[1].y, command.point[0]);
+  DrawRotatedSpriteClipped(command.to_sprite, map, command.from_sprite,
+    command.blending_mode, command.filter_mode, command.color[0],
+    std::max(clip_y_begin, command.point[1].y),
+    std::min(clip_y_end, command.point[2].y));
+}
 
 
 Sprite::Sprite() {
@@ -970,6 +1424,22 @@ void Sprite::Load(const char *file_name) {
       " Not loading sprite.";
     return;
   }
+  PackedAsset asset;
+  if (FindPackedAsset(file_name, &asset)) {
+    if (asset.type != kAssetPackSprite) {
+      LoadFromData(asset.data, asset.size, file_name);
+      return;
+    }
+    // Packed sprites are used in place, the mapping is copy-on-write.
+    pivot_ = asset.sprite_pivot;
+    sprite_instance_ = std::make_shared<arctic::SpriteInstance>(
+      asset.sprite_size.x, asset.sprite_size.y, asset.data,
+      std::move(asset.owner));
+    ref_pos_ = Vec2Si32(0, 0);
+    ref_size_ = asset.sprite_size;
+    UpdateOpaqueSpans();
+    return;
+  }
   const char *last_dot = strrchr(file_name, '.');
   if (!last_dot) {
     *Log() << "Error in Sprite::Load, file: \""
@@ -1033,11 +1503,12 @@ void Sprite::Create(const Vec2Si32 size) {
 }
 
 void Sprite::Create(const Si32 width, const Si32 height) {
+  // The new instance is zero-filled, so there is nothing to clear. Not
+  // touching the drawing state lets worker threads create sprites.
   sprite_instance_ = std::make_shared<arctic::SpriteInstance>(width, height);
   ref_pos_ = Vec2Si32(0, 0);
   ref_size_ = Vec2Si32(width, height);
   pivot_ = Vec2Si32(0, 0);
-  Clear();
 }
 
 void Sprite::InvReference(const Sprite &from, const Si32 from_x, const Si32 from_inv_y,
@@ -1058,35 +1529,98 @@ void Sprite::Reference(const Sprite &from, const Si32 from_x, const Si32 from_y,
   sprite_instance_ = from.sprite_instance_;
 }
 
-void Sprite::Clear() {
-  if (!sprite_instance_) {
+// Clears larger than this many bytes write around the cache, otherwise they
+// would evict everything else and read each line before overwriting it.
+// The smaller ones are better left in the cache for the drawing that follows.
+static const Si64 kStreamingClearBytes = 16 << 20;
+
+static bool IsSpriteJobSized(Si64 pixel_count) {
+  const Si64 threshold = GetSpriteJobPixelThreshold();
+  return threshold > 0 && pixel_count >= threshold;
+}
+
+// Sprite::Clear fills the rows starting from the top of the sprite instance,
+// the clip window is in the rows of the sprite itself.
+static void ClearClipped(Sprite sprite, Rgba color,
+    Si32 clip_y_begin, Si32 clip_y_end) {
+  const Si32 ref_y = sprite.RefPos().y;
+  const Si32 y_begin = std::max(0, clip_y_begin + ref_y);
+  const Si32 y_end = std::min(sprite.Height(), clip_y_end + ref_y);
+  const Si32 stride = sprite.StridePixels();
+  const bool is_streaming = static_cast<Si64>(sprite.Width()) *
+    sprite.Height() * static_cast<Si64>(sizeof(Rgba)) >= kStreamingClearBytes;
+  const FillRowFunction fill_row = GetFillRowFunction();
+  Rgba *begin = reinterpret_cast<Rgba*>(sprite.RawData()) + y_begin * stride;
+  if (stride == sprite.Width()) {
+    // The rows are contiguous, fill them in one go.
+    fill_row(begin, std::max(0, y_end - y_begin) * stride, color, is_streaming);
     return;
   }
-  const size_t size = static_cast<size_t>(ref_size_.x) * sizeof(Rgba);
-  Ui8 *data = sprite_instance_->RawData();
-  const Si32 stride = StrideBytes();
-  for (Si32 y = 0; y < ref_size_.y; ++y) {
-    memset(data, 0, size);
-    data += stride;
+  for (Si32 y = y_begin; y < y_end; ++y) {
+    fill_row(begin, sprite.Width(), color, is_streaming);
+    begin += stride;
   }
 }
 
+void Sprite::Clear() {
+  Clear(Rgba(0, 0, 0, 0));
+}
+
+static void ClearDeferred(const DeferredDrawCommand &command,
+    Si32 clip_y_begin, Si32 clip_y_end) {
+  ClearClipped(command.to_sprite, command.color[0], clip_y_begin, clip_y_end);
+}
+
 void Sprite::Clear(Rgba color) {
   if (!sprite_instance_) {
     return;
   }
-  const Si32 stride = StridePixels();
-  Rgba *begin = reinterpret_cast<Rgba*>(sprite_instance_->RawData());
-  Rgba *end = begin + ref_size_.x;
-  for (Si32 y = 0; y < ref_size_.y; ++y) {
-    Rgba *p = begin;
-    while (p != end) {
-      p->rgba = color.rgba;
-      p++;
-    }
-    begin += stride;
-    end += stride;
+  MarkSpriteDirty(*this, 0, 0, ref_size_.x, ref_size_.y);
+  const Sprite sprite = *this;
+  if (IsDeferredDrawingTarget(*this)) {
+    DeferredDrawCommand command;
+    command.draw = ClearDeferred;
+    command.to_sprite = *this;
+    command.color[0] = color;
+    DeferDrawing(command, -ref_pos_.y, ref_size_.y - ref_pos_.y);
+    return;
   }
+  FlushDeferredDrawingBeforeWrite(*this);
+  if (IsSpriteJobSized(static_cast<Si64>(ref_size_.x) * ref_size_.y)) {
+    ParallelFor(-ref_pos_.y, ref_size_.y - ref_pos_.y, 0,
+      [&sprite, color](Si32 clip_y_begin, Si32 clip_y_end) {
+        ClearClipped(sprite, color, clip_y_begin, clip_y_end);
+      });
+    return;
+  }
+  ClearClipped(*this, color, -ref_pos_.y, ref_size_.y - ref_pos_.y);
+}
+
+// Transforms the source rows [y_begin, y_end) of a width by height block.
+// Each band of the source rows lands in a band of the destination rows
+// or columns, so the bands can be transformed in parallel.
+static void TransformPixelRows(TransformPixelsFunction transform_pixels,
+    Rgba *to, Si32 to_stride, const Rgba *from, Si32 from_stride,
+    Si32 width, Si32 height, CloneTransform transform,
+    Si32 y_begin, Si32 y_end) {
+  switch (transform) {
+    case kCloneRotateCw90:
+      to += y_begin;
+      break;
+    case kCloneRotateCcw90:
+      to += height - y_end;
+      break;
+    case kCloneRotate180:
+    case kCloneMirrorUd:
+      to += static_cast<Si64>(height - y_end) * to_stride;
+      break;
+    default:
+      to += static_cast<Si64>(y_begin) * to_stride;
+      break;
+  }
+  transform_pixels(to, to_stride,
+    from + static_cast<Si64>(y_begin) * from_stride, from_stride,
+    width, y_end - y_begin, transform);
 }
 
 void Sprite::Clone(Sprite from, CloneTransform transform) {
@@ -1136,18 +1670,23 @@ void Sprite::Clone(Sprite from, CloneTransform transform) {
     }
   }
 
-  Si32 wid = from.Width();
-  Si32 hei = from.Height();
-  Si32 src_stride = from.StridePixels();
-  Si32 dst_stride = StridePixels();
-  Rgba *src_data = from.RgbaData();
+  FlushDeferredDrawingBeforeRead(from);
+  const Si32 wid = from.Width();
+  const Si32 hei = from.Height();
+  const Si32 src_stride = from.StridePixels();
+  const Si32 dst_stride = StridePixels();
+  const Rgba *src_data = from.RgbaData();
   Rgba *dst_data = RgbaData();
-  for (Si32 y = 0; y < hei; ++y) {
-    for (Si32 x = 0; x < wid; ++x) {
-      Vec2Si32 dst_pos = dst_base + dst_dir_y * y + dst_dir_x * x;
-      dst_data[dst_pos.y * dst_stride + dst_pos.x] =
-        src_data[y * src_stride + x];
-    }
+  const TransformPixelsFunction transform_pixels =
+    GetTransformPixelsFunction();
+  if (IsSpriteJobSized(static_cast<Si64>(wid) * hei)) {
+    ParallelFor(0, hei, 0, [=](Si32 y_begin, Si32 y_end) {
+      TransformPixelRows(transform_pixels, dst_data, dst_stride,
+        src_data, src_stride, wid, hei, transform, y_begin, y_end);
+    });
+  } else {
+    TransformPixelRows(transform_pixels, dst_data, dst_stride,
+      src_data, src_stride, wid, hei, transform, 0, hei);
   }
 
   SetPivot(dst_base + from.Pivot().x * dst_dir_x + from.Pivot().y * dst_dir_y);
@@ -1167,94 +1706,8 @@ void Sprite::Draw(Sprite to_sprite,
   if (!sprite_instance_) {
     return;
   }
-  switch (filter_mode) {
-    case kFilterNearest:
-      switch (blending_mode) {
-        case kDrawBlendingModeAlphaBlend:
-          DrawSprite<kDrawBlendingModeAlphaBlend, kFilterNearest>(&to_sprite,
-            to_x_pivot, to_y_pivot,
-            Width(), Height(),
-            *this, 0, 0, Width(), Height(),
-            color);
-          break;
-        case kDrawBlendingModePremultipliedAlphaBlend:
-          DrawSprite<kDrawBlendingModePremultipliedAlphaBlend, kFilterNearest>(&to_sprite,
-            to_x_pivot, to_y_pivot,
-            Width(), Height(),
-            *this, 0, 0, Width(), Height(),
-            color);
-          break;
-        case kDrawBlendingModeCopyRgba:
-          DrawSprite<kDrawBlendingModeCopyRgba, kFilterNearest>(&to_sprite,
-            to_x_pivot, to_y_pivot,
-            Width(), Height(),
-            *this, 0, 0, Width(), Height(),
-            color);
-          break;
-        case kDrawBlendingModeColorize:
-          DrawSprite<kDrawBlendingModeColorize, kFilterNearest>(&to_sprite,
-            to_x_pivot, to_y_pivot,
-            Width(), Height(),
-            *this, 0, 0, Width(), Height(),
-            color);
-          break;
-        case kDrawBlendingModeSolidColor:
-          DrawSprite<kDrawBlendingModeSolidColor, kFilterNearest>(&to_sprite,
-            to_x_pivot, to_y_pivot,
-            Width(), Height(),
-            *this, 0, 0, Width(), Height(),
-            color);
-          break;
-        case kDrawBlendingModeAdd:
-          DrawSprite<kDrawBlendingModeAdd, kFilterNearest>(&to_sprite,
-            to_x_pivot, to_y_pivot,
-            Width(), Height(),
-            *this, 0, 0, Width(), Height(),
-            color);
-          break;
-      }
-      break;
-    case kFilterBilinear:
-      switch (blending_mode) {
-        case kDrawBlendingModeAlphaBlend:
-          DrawSprite<kDrawBlendingModeAlphaBlend, kFilterBilinear>(&to_sprite,
-            to_x_pivot, to_y_pivot,
-            Width(), Height(),
-            *this, 0, 0, Width(), Height(), color);
-          break;
-        case kDrawBlendingModePremultipliedAlphaBlend:
-          DrawSprite<kDrawBlendingModePremultipliedAlphaBlend, kFilterBilinear>(&to_sprite,
-            to_x_pivot, to_y_pivot,
-            Width(), Height(),
-            *this, 0, 0, Width(), Height(), color);
-          break;
-        case kDrawBlendingModeCopyRgba:
-          DrawSprite<kDrawBlendingModeCopyRgba, kFilterBilinear>(&to_sprite,
-            to_x_pivot, to_y_pivot,
-            Width(), Height(),
-            *this, 0, 0, Width(), Height(), color);
-          break;
-        case kDrawBlendingModeColorize:
-          DrawSprite<kDrawBlendingModeColorize, kFilterBilinear>(&to_sprite,
-            to_x_pivot, to_y_pivot,
-            Width(), Height(),
-            *this, 0, 0, Width(), Height(), color);
-          break;
-        case kDrawBlendingModeSolidColor:
-          DrawSprite<kDrawBlendingModeSolidColor, kFilterBilinear>(&to_sprite,
-            to_x_pivot, to_y_pivot,
-            Width(), Height(),
-            *this, 0, 0, Width(), Height(), color);
-          break;
-        case kDrawBlendingModeAdd:
-          DrawSprite<kDrawBlendingModeAdd, kFilterBilinear>(&to_sprite,
-            to_x_pivot, to_y_pivot,
-            Width(), Height(),
-            *this, 0, 0, Width(), Height(), color);
-          break;
-      }
-      break;
-  }
+  Draw(to_x_pivot, to_y_pivot, Width(), Height(), 0, 0, Width(), Height(),
+    to_sprite, blending_mode, filter_mode, color);
 }
 
 
@@ -1300,114 +1753,36 @@ void Sprite::Draw(const float to_x, const float to_y,
   if (!sprite_instance_) {
     return;
   }
-  Vec2F pivot = Vec2F(to_x, to_y);
-  float sin_a = sinf(angle_radians) * zoom;
-  float cos_a = cosf(angle_radians) * zoom;
-  Vec2F left = Vec2F(-cos_a, -sin_a) * static_cast<float>(pivot_.x);
-  Vec2F right = Vec2F(cos_a, sin_a) *
-    static_cast<float>(Width() - 1 - pivot_.x);
-  Vec2F up = Vec2F(-sin_a, cos_a) * static_cast<float>(Height() - 1 - pivot_.y);
-  Vec2F down = Vec2F(sin_a, -cos_a) * static_cast<float>(pivot_.y);
-
-  // d c
-  // a b
-  Vec2F a(pivot + left + down);
-  Vec2F b(pivot + right + down);
-  Vec2F c(pivot + right + up);
-  Vec2F d(pivot + left + up);
-
-  Vec2F ta(0.01f,
-    0.01f);
-  Vec2F tb(static_cast<float>(ref_size_.x) - 1.01f,
-    0.01f);
-  Vec2F tc(static_cast<float>(ref_size_.x) - 1.01f,
-    static_cast<float>(ref_size_.y) - 1.01f);
-  Vec2F td(0.01f,
-    static_cast<float>(ref_size_.y) - 1.01f);
-
-  switch (filter_mode) {
-    case kFilterNearest:
-      switch (blending_mode) {
-        case kDrawBlendingModeCopyRgba:
-          DrawTriangle<kDrawBlendingModeCopyRgba, kFilterNearest>(to_sprite,
-            a, b, c, ta, tb, tc, *this, in_color);
-          DrawTriangle<kDrawBlendingModeCopyRgba, kFilterNearest>(to_sprite,
-            d, a, c, td, ta, tc, *this, in_color);
-          break;
-        case kDrawBlendingModeAlphaBlend:
-          DrawTriangle<kDrawBlendingModeAlphaBlend, kFilterNearest>(to_sprite,
-            a, b, c, ta, tb, tc, *this, in_color);
-          DrawTriangle<kDrawBlendingModeAlphaBlend, kFilterNearest>(to_sprite,
-            d, a, c, td, ta, tc, *this, in_color);
-          break;
-        case kDrawBlendingModePremultipliedAlphaBlend:
-          DrawTriangle<kDrawBlendingModePremultipliedAlphaBlend, kFilterNearest>(to_sprite,
-            a, b, c, ta, tb, tc, *this, in_color);
-          DrawTriangle<kDrawBlendingModePremultipliedAlphaBlend, kFilterNearest>(to_sprite,
-            d, a, c, td, ta, tc, *this, in_color);
-          break;
-        case kDrawBlendingModeColorize:
-          DrawTriangle<kDrawBlendingModeColorize, kFilterNearest>(to_sprite,
-            a, b, c, ta, tb, tc, *this, in_color);
-          DrawTriangle<kDrawBlendingModeColorize, kFilterNearest>(to_sprite,
-            d, a, c, td, ta, tc, *this, in_color);
-          break;
-        case kDrawBlendingModeSolidColor:
-          DrawTriangle<kDrawBlendingModeSolidColor, kFilterNearest>(to_sprite,
-            a, b, c, ta, tb, tc, *this, in_color);
-          DrawTriangle<kDrawBlendingModeSolidColor, kFilterNearest>(to_sprite,
-            d, a, c, td, ta, tc, *this, in_color);
-          break;
-        case kDrawBlendingModeAdd:
-          DrawTriangle<kDrawBlendingModeAdd, kFilterNearest>(to_sprite,
-            a, b, c, ta, tb, tc, *this, in_color);
-          DrawTriangle<kDrawBlendingModeAdd, kFilterNearest>(to_sprite,
-            d, a, c, td, ta, tc, *this, in_color);
-          break;
-      }
-      break;
-    case kFilterBilinear:
-      switch (blending_mode) {
-        case kDrawBlendingModeCopyRgba:
-          DrawTriangle<kDrawBlendingModeCopyRgba, kFilterBilinear>(to_sprite,
-            a, b, c, ta, tb, tc, *this, in_color);
-          DrawTriangle<kDrawBlendingModeCopyRgba, kFilterBilinear>(to_sprite,
-            d, a, c, td, ta, tc, *this, in_color);
-          break;
-        case kDrawBlendingModeAlphaBlend:
-          DrawTriangle<kDrawBlendingModeAlphaBlend, kFilterBilinear>(to_sprite,
-            a, b, c, ta, tb, tc, *this, in_color);
-          DrawTriangle<kDrawBlendingModeAlphaBlend, kFilterBilinear>(to_sprite,
-            d, a, c, td, ta, tc, *this, in_color);
-          break;
-        case kDrawBlendingModePremultipliedAlphaBlend:
-          DrawTriangle<kDrawBlendingModePremultipliedAlphaBlend, kFilterBilinear>(to_sprite,
-            a, b, c, ta, tb, tc, *this, in_color);
-          DrawTriangle<kDrawBlendingModePremultipliedAlphaBlend, kFilterBilinear>(to_sprite,
-            d, a, c, td, ta, tc, *this, in_color);
-          break;
-        case kDrawBlendingModeColorize:
-          DrawTriangle<kDrawBlendingModeColorize, kFilterBilinear>(to_sprite,
-            a, b, c, ta, tb, tc, *this, in_color);
-          DrawTriangle<kDrawBlendingModeColorize, kFilterBilinear>(to_sprite,
-            d, a, c, td, ta, tc, *this, in_color);
-          break;
-        case kDrawBlendingModeSolidColor:
-          DrawTriangle<kDrawBlendingModeSolidColor, kFilterBilinear>(to_sprite,
-            a, b, c, ta, tb, tc, *this, in_color);
-          DrawTriangle<kDrawBlendingModeSolidColor, kFilterBilinear>(to_sprite,
-            d, a, c, td, ta, tc, *this, in_color);
-          break;
-        case kDrawBlendingModeAdd:
-          DrawTriangle<kDrawBlendingModeAdd, kFilterBilinear>(to_sprite,
-            a, b, c, ta, tb, tc, *this, in_color);
-          DrawTriangle<kDrawBlendingModeAdd, kFilterBilinear>(to_sprite,
-            d, a, c, td, ta, tc, *this, in_color);
-          break;
-      }
-
-      break;
+  if (!(std::abs(zoom) >= kMinRotatedZoom)) {
+    return;
+  }
+  const RotatedSpriteMapping map = MakeRotatedSpriteMapping(to_x, to_y,
+    angle_radians, zoom, pivot_);
+  Vec2Si32 min;
+  Vec2Si32 max;
+  RotatedSpriteBounds(to_x, to_y, angle_radians, zoom, pivot_, ref_size_,
+    &min, &max);
+  MarkSpriteDirty(to_sprite, min.x, min.y, max.x, max.y);
+  if (IsDeferredDrawingTarget(to_sprite)) {
+    DeferredDrawCommand command;
+    command.draw = DrawRotatedSpriteDeferred;
+    command.to_sprite = to_sprite;
+    command.from_sprite = *this;
+    command.vertex[0] = Vec2F(to_x, to_y);
+    command.vertex[1] = Vec2F(angle_radians, zoom);
+    command.point[0] = pivot_;
+    command.point[1] = min;
+    command.point[2] = max;
+    command.color[0] = in_color;
+    command.blending_mode = blending_mode;
+    command.filter_mode = filter_mode;
+    DeferDrawing(command, min.y, max.y);
+    return;
   }
+  FlushDeferredDrawingBeforeRead(*this);
+  FlushDeferredDrawingBeforeWrite(to_sprite);
+  DrawRotatedSpriteClipped(to_sprite, map, *this,
+    blending_mode, filter_mode, in_color, min.y, max.y);
 }
 
 void DrawTriangle(Sprite to_sprite,
@@ -1415,65 +1790,29 @@ void DrawTriangle(Sprite to_sprite,
     Vec2F ta, Vec2F tb, Vec2F tc,
     Sprite texture,
     DrawBlendingMode blending_mode, DrawFilterMode filter_mode, Rgba in_color) {
-  switch (filter_mode) {
-    case kFilterNearest:
-      switch (blending_mode) {
-        case kDrawBlendingModeCopyRgba:
-          DrawTriangle<kDrawBlendingModeCopyRgba, kFilterNearest>(to_sprite,
-            a, b, c, ta, tb, tc, texture, in_color);
-          break;
-        case kDrawBlendingModeAlphaBlend:
-          DrawTriangle<kDrawBlendingModeAlphaBlend, kFilterNearest>(to_sprite,
-            a, b, c, ta, tb, tc, texture, in_color);
-          break;
-        case kDrawBlendingModePremultipliedAlphaBlend:
-          DrawTriangle<kDrawBlendingModePremultipliedAlphaBlend, kFilterNearest>(to_sprite,
-            a, b, c, ta, tb, tc, texture, in_color);
-          break;
-        case kDrawBlendingModeColorize:
-          DrawTriangle<kDrawBlendingModeColorize, kFilterNearest>(to_sprite,
-            a, b, c, ta, tb, tc, texture, in_color);
-          break;
-        case kDrawBlendingModeSolidColor:
-          DrawTriangle<kDrawBlendingModeSolidColor, kFilterNearest>(to_sprite,
-            a, b, c, ta, tb, tc, texture, in_color);
-          break;
-        case kDrawBlendingModeAdd:
-          DrawTriangle<kDrawBlendingModeAdd, kFilterNearest>(to_sprite,
-            a, b, c, ta, tb, tc, texture, in_color);
-          break;
-      }
-      break;
-    case kFilterBilinear:
-      switch (blending_mode) {
-        case kDrawBlendingModeCopyRgba:
-          DrawTriangle<kDrawBlendingModeCopyRgba, kFilterBilinear>(to_sprite,
-            a, b, c, ta, tb, tc, texture, in_color);
-          break;
-        case kDrawBlendingModeAlphaBlend:
-          DrawTriangle<kDrawBlendingModeAlphaBlend, kFilterBilinear>(to_sprite,
-            a, b, c, ta, tb, tc, texture, in_color);
-          break;
-        case kDrawBlendingModePremultipliedAlphaBlend:
-          DrawTriangle<kDrawBlendingModePremultipliedAlphaBlend, kFilterBilinear>(to_sprite,
-            a, b, c, ta, tb, tc, texture, in_color);
-          break;
-        case kDrawBlendingModeColorize:
-          DrawTriangle<kDrawBlendingModeColorize, kFilterBilinear>(to_sprite,
-            a, b, c, ta, tb, tc, texture, in_color);
-          break;
-        case kDrawBlendingModeSolidColor:
-          DrawTriangle<kDrawBlendingModeSolidColor, kFilterBilinear>(to_sprite,
-            a, b, c, ta, tb, tc, texture, in_color);
-          break;
-        case kDrawBlendingModeAdd:
-          DrawTriangle<kDrawBlendingModeAdd, kFilterBilinear>(to_sprite,
-            a, b, c, ta, tb, tc, texture, in_color);
-          break;
-      }
-
-      break;
+  MarkTriangleDirty(to_sprite, a, b, c);
+  if (IsDeferredDrawingTarget(to_sprite)) {
+    DeferredDrawCommand command;
+    command.draw = DrawTriangleDeferred;
+    command.to_sprite = to_sprite;
+    command.from_sprite = texture;
+    command.vertex[0] = a;
+    command.vertex[1] = b;
+    command.vertex[2] = c;
+    command.tex_coord[0] = ta;
+    command.tex_coord[1] = tb;
+    command.tex_coord[2] = tc;
+    command.color[0] = in_color;
+    command.blending_mode = blending_mode;
+    command.filter_mode = filter_mode;
+    const Vec2Si32 rows = TriangleRows(a, b, c);
+    DeferDrawing(command, rows.x, rows.y);
+    return;
   }
+  FlushDeferredDrawingBeforeRead(texture);
+  FlushDeferredDrawingBeforeWrite(to_sprite);
+  DrawTriangleClipped(to_sprite, a, b, c, ta, tb, tc, texture,
+    blending_mode, filter_mode, in_color, 0, to_sprite.Height());
 }
 
 void Sprite::Draw(const Si32 to_x, const Si32 to_y,
@@ -1545,82 +1884,36 @@ void Sprite::Draw(const Si32 to_x_pivot, const Si32 to_y_pivot,
     const Si32 from_width, const Si32 from_height,
     Sprite to_sprite, DrawBlendingMode blending_mode,
     DrawFilterMode filter_mode, Rgba in_color) const {
-  if (!sprite_instance_) {
+  if (!sprite_instance_ || !from_width || !from_height) {
     return;
   }
-  switch (filter_mode) {
-      case kFilterNearest:
-      switch (blending_mode) {
-        default:
-        case kDrawBlendingModeCopyRgba:
-          DrawSprite<kDrawBlendingModeCopyRgba, kFilterNearest>(&to_sprite,
-              to_x_pivot, to_y_pivot, to_width, to_height,
-              *this, from_x, from_y, from_width, from_height,
-              in_color);
-          break;
-        case kDrawBlendingModeAlphaBlend:
-          DrawSprite<kDrawBlendingModeAlphaBlend, kFilterNearest>(&to_sprite,
-              to_x_pivot, to_y_pivot, to_width, to_height,
-              *this, from_x, from_y, from_width, from_height,
-              in_color);
-          break;
-        case kDrawBlendingModePremultipliedAlphaBlend:
-          DrawSprite<kDrawBlendingModePremultipliedAlphaBlend, kFilterNearest>(&to_sprite,
-              to_x_pivot, to_y_pivot, to_width, to_height,
-              *this, from_x, from_y, from_width, from_height,
-              in_color);
-          break;
-        case kDrawBlendingModeColorize:
-          DrawSprite<kDrawBlendingModeColorize, kFilterNearest>(&to_sprite,
-              to_x_pivot, to_y_pivot, to_width, to_height,
-              *this, from_x, from_y, from_width, from_height,
-              in_color);
-          break;
-        case kDrawBlendingModeSolidColor:
-          DrawSprite<kDrawBlendingModeSolidColor, kFilterNearest>(&to_sprite,
-              to_x_pivot, to_y_pivot, to_width, to_height,
-              *this, from_x, from_y, from_width, from_height,
-              in_color);
-          break;
-      }
-      break;
-      case kFilterBilinear:
-      switch (blending_mode) {
-        default:
-        case kDrawBlendingModeCopyRgba:
-          DrawSprite<kDrawBlendingModeCopyRgba, kFilterBilinear>(&to_sprite,
-              to_x_pivot, to_y_pivot, to_width, to_height,
-              *this, from_x, from_y, from_width, from_height,
-              in_color);
-          break;
-        case kDrawBlendingModeAlphaBlend:
-          DrawSprite<kDrawBlendingModeAlphaBlend, kFilterBilinear>(&to_sprite,
-              to_x_pivot, to_y_pivot, to_width, to_height,
-              *this, from_x, from_y, from_width, from_height,
-              in_color);
-          break;
-        case kDrawBlendingModePremultipliedAlphaBlend:
-          DrawSprite<kDrawBlendingModePremultipliedAlphaBlend, kFilterBilinear>(&to_sprite,
-              to_x_pivot, to_y_pivot, to_width, to_height,
-              *this, from_x, from_y, from_width, from_height,
-              in_color);
-          break;
-        case kDrawBlendingModeColorize:
-          DrawSprite<kDrawBlendingModeColorize, kFilterBilinear>(&to_sprite,
-              to_x_pivot, to_y_pivot, to_width, to_height,
-              *this, from_x, from_y, from_width, from_height,
-              in_color);
-          break;
-        case kDrawBlendingModeSolidColor:
-          DrawSprite<kDrawBlendingModeSolidColor, kFilterBilinear>(&to_sprite,
-              to_x_pivot, to_y_pivot, to_width, to_height,
-              *this, from_x, from_y, from_width, from_height,
-              in_color);
-          break;
-      }
-      break;
+  const bool is_unscaled = (to_width == from_width &&
+    to_height == from_height);
+  const Si32 to_x = (is_unscaled ? to_x_pivot - pivot_.x :
+    to_x_pivot - pivot_.x * to_width / from_width);
+  const Si32 to_y = (is_unscaled ? to_y_pivot - pivot_.y :
+    to_y_pivot - pivot_.y * to_height / from_height);
+  MarkSpriteDirty(to_sprite, to_x, to_y, to_x + to_width, to_y + to_height);
+  if (IsDeferredDrawingTarget(to_sprite)) {
+    DeferredDrawCommand command;
+    command.draw = DrawSpriteDeferred;
+    command.to_sprite = to_sprite;
+    command.from_sprite = *this;
+    command.point[0] = Vec2Si32(to_x_pivot, to_y_pivot);
+    command.point[1] = Vec2Si32(to_width, to_height);
+    command.point[2] = Vec2Si32(from_x, from_y);
+    command.point[3] = Vec2Si32(from_width, from_height);
+    command.color[0] = in_color;
+    command.blending_mode = blending_mode;
+    command.filter_mode = filter_mode;
+    DeferDrawing(command, to_y, to_y + to_height);
+    return;
   }
-  return;
+  FlushDeferredDrawingBeforeRead(*this);
+  FlushDeferredDrawingBeforeWrite(to_sprite);
+  DrawSpriteClipped(&to_sprite, to_x_pivot, to_y_pivot, to_width, to_height,
+    *this, from_x, from_y, from_width, from_height,
+    blending_mode, filter_mode, in_color, 0, to_sprite.Height());
 }
 
 Vec2Si32 Sprite::RefPos() const {
@@ -253,12 +253,15 @@ class Sprite {
   const Rgba* RgbaData() const;
   const std::shared_ptr<SpriteInstance> &SpriteInstance() const;
   const std::vector<SpanSi32> &Opaque() const;
-  /// @brief Update the opaque span parameters of the sprite
+  /// @brief Update the pixel runs of the sprite
   /// @details
-  /// Sets up the span parameters so that currently transparent pixels will not be drawn.
+  /// Splits each row into transparent, opaque and translucent runs so that currently transparent
+  /// pixels will not be drawn and opaque pixels will be copied without blending.
+  /// The runs are shared by all the sprites referencing the same pixels.
+  /// Opaque() returns the span from the first to the last run of each row.
   /// Changing pixel transparency may require calling either UpdateOpaqueSpans or ClearOpaqueSpans.
   void UpdateOpaqueSpans();
-  /// @brief Clear the opaque span parameters of the sprite so that each pixel of the sprite is drawn
+  /// @brief Clear the pixel runs of the sprite so that each pixel of the sprite is drawn
   void ClearOpaqueSpans();
 };
 
@@ -0,0 +1,755 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "engine/easy_sprite_blend.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ARCTIC_BLEND_X86
+#include <emmintrin.h>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif  // _MSC_VER
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define ARCTIC_BLEND_NEON
+#include <arm_neon.h>
+#endif
+
+namespace arctic {
+
+namespace {
+
+// Scalar reference. Every vector kernel must produce exactly the same bits.
+
+void CopyRowScalar(Rgba *to, const Rgba *from, Si32 count, Rgba) {
+  if (count > 0) {
+    memcpy(static_cast<void*>(to), from,
+      static_cast<size_t>(count) * sizeof(Rgba));
+  }
+}
+
+void AlphaBlendRowScalar(Rgba *to, const Rgba *from, Si32 count,
+    Rgba) {
+  for (Si32 i = 0; i < count; ++i) {
+    Rgba *to_rgba = to + i;
+    const Rgba color = from[i];
+    if (color.a == 255) {
+      to_rgba->rgba = color.rgba;
+    } else if (color.a) {
+      Ui32 m = 255 - color.a;
+      Ui32 rb = (to_rgba->rgba & 0x00ff00fful) * m;
+      Ui32 g = ((to_rgba->rgba & 0x0000ff00ul) >> 8u) * m;
+      Ui32 m2 = color.a;
+      Ui32 rb2 = (color.rgba & 0x00ff00fful) * m2;
+      Ui32 g2 = ((color.rgba & 0x0000ff00ul) >> 8u) * m2;
+      to_rgba->rgba = (((rb + rb2) >> 8u) & 0x00ff00fful) |
+        ((g + g2) & 0x0000ff00ul);
+    }
+  }
+}
+
+void PremultipliedAlphaBlendRowScalar(Rgba *to, const Rgba *from, Si32 count,
+    Rgba) {
+  for (Si32 i = 0; i < count; ++i) {
+    Rgba *to_rgba = to + i;
+    const Rgba color = from[i];
+    if (color.a == 255) {
+      to_rgba->rgba = color.rgba;
+    } else if (color.a) {
+      Ui32 m = 255 - color.a;
+      Ui32 rb = ((to_rgba->rgba & 0x00ff00fful) * m) >> 8u;
+      Ui32 g = ((to_rgba->rgba & 0x0000ff00ul) >> 8u) * m;
+      Ui32 rb2 = (color.rgba & 0x00ff00fful);
+      Ui32 g2 = (color.rgba & 0x0000ff00ul);
+      to_rgba->rgba = ((rb + rb2) & 0x00ff00fful) | ((g + g2) & 0x0000ff00ul);
+    }
+  }
+}
+
+void ColorizeRowScalar(Rgba *to, const Rgba *from, Si32 count,
+    Rgba in_color) {
+  for (Si32 i = 0; i < count; ++i) {
+    Rgba *to_rgba = to + i;
+    const Rgba color = from[i];
+    Ui32 ca = (Ui32(color.a) * (Ui32(in_color.a) + 1u)) >> 8u;
+    if (ca == 255) {
+      Ui32 r2 = (Ui32(color.r) * (Ui32(in_color.r) + 1)) >> 8u;
+      Ui32 g2 = (Ui32(color.g) * (Ui32(in_color.g) + 1)) >> 8u;
+      Ui32 b2 = (Ui32(color.b) * (Ui32(in_color.b) + 1)) >> 8u;
+      to_rgba->rgba = Rgba((Ui8)r2, (Ui8)g2, (Ui8)b2).rgba;
+    } else if (ca) {
+      Ui32 m = 255 - ca;
+      Ui32 rb = (to_rgba->rgba & 0x00ff00fful) * m;
+      Ui32 g = ((to_rgba->rgba & 0x0000ff00ul) >> 8u) * m;
+
+      Ui32 m2 = ca;
+      Ui32 rb2_ = (((color.rgba & 0x00ff00fful) * m2) & 0xff00ff00u) >> 8u;
+      Ui32 rb2 = ((rb2_ & 0x00ff0000u) * ((in_color.rgba & 0x00ff0000u) >> 16u))
+        | ((rb2_ & 0x000000ffu) * (in_color.rgba & 0x000000ffu));
+      Ui32 g2 = (Ui32(color.g) * m2 * (Ui32(in_color.g) + 1)) >> 8u;
+
+      to_rgba->rgba = (((rb + rb2) >> 8u) & 0x00ff00fful) |
+        ((g + g2) & 0x0000ff00ul);
+    }
+  }
+}
+
+void SolidColorRowScalar(Rgba *to, const Rgba *from, Si32 count,
+    Rgba in_color) {
+  for (Si32 i = 0; i < count; ++i) {
+    Rgba *to_rgba = to + i;
+    const Rgba color = from[i];
+    Ui32 ca = (Ui32(color.a) * (Ui32(in_color.a) + 1u)) >> 8u;
+    if (ca == 255) {
+      to_rgba->rgba = in_color.rgba;
+    } else if (ca) {
+      Ui32 m = 255 - ca;
+      Ui32 rb = (to_rgba->rgba & 0x00ff00fful) * m;
+      Ui32 g = ((to_rgba->rgba & 0x0000ff00ul) >> 8u) * m;
+
+      Ui32 rb2 = (in_color.rgba & 0x00ff00fful) * ca;
+      Ui32 g2 = ((in_color.rgba & 0x0000ff00ul) >> 8u) * ca;
+
+      to_rgba->rgba = (((rb + rb2) >> 8u) & 0x00ff00fful) |
+        ((g + g2) & 0x0000ff00ul);
+    }
+  }
+}
+
+void AddRowScalar(Rgba *to, const Rgba *from, Si32 count, Rgba) {
+  for (Si32 i = 0; i < count; ++i) {
+    Rgba *to_rgba = to + i;
+    const Rgba color = from[i];
+    Ui32 r2 = Ui32(color.r) + Ui32(to_rgba->r);
+    Ui32 g2 = Ui32(color.g) + Ui32(to_rgba->g);
+    Ui32 b2 = Ui32(color.b) + Ui32(to_rgba->b);
+    r2 = r2 > 255 ? 255 : r2;
+    g2 = g2 > 255 ? 255 : g2;
+    b2 = b2 > 255 ? 255 : b2;
+    to_rgba->rgba = Rgba((Ui8)r2, (Ui8)g2, (Ui8)b2).rgba;
+  }
+}
+
+void BilinearRowScalar(Rgba *to, const Rgba *color00, const Rgba *color01,
+    const Rgba *color10, const Rgba *color11,
+    const Ui32 *from_x_8, const Ui32 *from_y_8, Si32 count) {
+  for (Si32 i = 0; i < count; ++i) {
+    const Ui32 w00 = (255 - from_x_8[i]) * (255 - from_y_8[i]);
+    const Ui32 w01 = from_x_8[i] * (255 - from_y_8[i]);
+    const Ui32 w10 = (255 - from_x_8[i]) * from_y_8[i];
+    const Ui32 w11 = from_x_8[i] * from_y_8[i];
+    const Rgba c00 = color00[i];
+    const Rgba c01 = color01[i];
+    const Rgba c10 = color10[i];
+    const Rgba c11 = color11[i];
+    to[i] = Rgba(
+      (Ui8)((Ui32(c00.r) * w00 + Ui32(c01.r) * w01 +
+        Ui32(c10.r) * w10 + Ui32(c11.r) * w11) >> 16u),
+      (Ui8)((Ui32(c00.g) * w00 + Ui32(c01.g) * w01 +
+        Ui32(c10.g) * w10 + Ui32(c11.g) * w11) >> 16u),
+      (Ui8)((Ui32(c00.b) * w00 + Ui32(c01.b) * w01 +
+        Ui32(c10.b) * w10 + Ui32(c11.b) * w11) >> 16u),
+      (Ui8)((Ui32(c00.a) * w00 + Ui32(c01.a) * w01 +
+        Ui32(c10.a) * w10 + Ui32(c11.a) * w11) >> 16u));
+  }
+}
+
+void FillRowScalar(Rgba *to, Si32 count, Rgba color) {
+  if (color.rgba == 0) {
+    if (count > 0) {
+      memset(static_cast<void*>(to), 0,
+        static_cast<size_t>(count) * sizeof(Rgba));
+    }
+    return;
+  }
+  for (Si32 i = 0; i < count; ++i) {
+    to[i].rgba = color.rgba;
+  }
+}
+
+// The scalar fill has no streaming stores, the table entry drops the hint.
+void FillRowScalarEntry(Rgba *to, Si32 count, Rgba color, bool) {
+  FillRowScalar(to, count, color);
+}
+
+void ReverseRowScalar(Rgba *to, const Rgba *from, Si32 count) {
+  for (Si32 i = 0; i < count; ++i) {
+    to[count - 1 - i] = from[i];
+  }
+}
+
+// Side of the square tiles the rotations walk the pixels in. The source and
+// the destination rows of a tile stay in the L1 cache while it is copied,
+// instead of every destination write missing it.
+const Si32 kTransformTile = 32;
+
+// Writes the source pixels [x_begin, x_end) x [y_begin, y_end) of a width by
+// height block to their places rotated by 90 degrees.
+void RotatePixelsScalar(Rgba *to, Si32 to_stride,
+    const Rgba *from, Si32 from_stride, Si32 width, Si32 height,
+    CloneTransform transform,
+    Si32 x_begin, Si32 x_end, Si32 y_begin, Si32 y_end) {
+  for (Si32 y = y_begin; y < y_end; ++y) {
+    const Rgba *src = from + y * from_stride;
+    if (transform == kCloneRotateCw90) {
+      Rgba *dst = to + static_cast<Si64>(width - 1) * to_stride + y;
+      for (Si32 x = x_begin; x < x_end; ++x) {
+        dst[-static_cast<Si64>(x) * to_stride] = src[x];
+      }
+    } else {
+      Rgba *dst = to + (height - 1 - y);
+      for (Si32 x = x_begin; x < x_end; ++x) {
+        dst[static_cast<Si64>(x) * to_stride] = src[x];
+      }
+    }
+  }
+}
+
+// Rotation by 180 degrees and the mirroring move whole rows.
+void FlipRows(Rgba *to, Si32 to_stride, const Rgba *from, Si32 from_stride,
+    Si32 width, Si32 height, CloneTransform transform,
+    void (*reverse_row)(Rgba *to, const Rgba *from, Si32 count)) {
+  const bool is_upside_down =
+    (transform == kCloneRotate180 || transform == kCloneMirrorUd);
+  const bool is_reversed =
+    (transform == kCloneRotate180 || transform == kCloneMirrorLr);
+  for (Si32 y = 0; y < height; ++y) {
+    Rgba *dst = to +
+      static_cast<Si64>(is_upside_down ? height - 1 - y : y) * to_stride;
+    const Rgba *src = from + static_cast<Si64>(y) * from_stride;
+    if (is_reversed) {
+      reverse_row(dst, src, width);
+    } else if (width > 0) {
+      memcpy(static_cast<void*>(dst), src,
+        static_cast<size_t>(width) * sizeof(Rgba));
+    }
+  }
+}
+
+void TransformPixelsScalar(Rgba *to, Si32 to_stride,
+    const Rgba *from, Si32 from_stride, Si32 width, Si32 height,
+    CloneTransform transform) {
+  if (transform != kCloneRotateCw90 && transform != kCloneRotateCcw90) {
+    FlipRows(to, to_stride, from, from_stride, width, height, transform,
+      ReverseRowScalar);
+    return;
+  }
+  for (Si32 tile_y = 0; tile_y < height; tile_y += kTransformTile) {
+    const Si32 y_end = std::min(tile_y + kTransformTile, height);
+    for (Si32 tile_x = 0; tile_x < width; tile_x += kTransformTile) {
+      const Si32 x_end = std::min(tile_x + kTransformTile, width);
+      RotatePixelsScalar(to, to_stride, from, from_stride, width, height,
+        transform, tile_x, x_end, tile_y, y_end);
+    }
+  }
+}
+
+// The vector kernels keep one pixel per 32-bit lane and mirror the scalar
+// Ui32 arithmetic. Mul16 multiplies the 16-bit halves of each lane, which
+// equals the 32-bit product of the scalar code as long as neither half
+// overflows, and Mul32 multiplies lanes whose upper halves are zero.
+
+#if defined(ARCTIC_BLEND_X86)
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+namespace sse2 {
+
+typedef __m128i V;
+const Si32 kLanes = 4;
+
+inline V Load(const Rgba *p) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+inline void Store(Rgba *p, V v) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v);
+}
+inline V Set1(Ui32 x) {
+  return _mm_set1_epi32(static_cast<int>(x));
+}
+inline V And(V a, V b) {
+  return _mm_and_si128(a, b);
+}
+inline V Or(V a, V b) {
+  return _mm_or_si128(a, b);
+}
+inline V Add32(V a, V b) {
+  return _mm_add_epi32(a, b);
+}
+inline V Sub32(V a, V b) {
+  return _mm_sub_epi32(a, b);
+}
+inline V Srl8(V a) {
+  return _mm_srli_epi32(a, 8);
+}
+inline V Srl24(V a) {
+  return _mm_srli_epi32(a, 24);
+}
+inline V Sll16(V a) {
+  return _mm_slli_epi32(a, 16);
+}
+inline V Mul16(V a, V b) {
+  return _mm_mullo_epi16(a, b);
+}
+inline V Mul32(V a, V b) {
+  return _mm_or_si128(_mm_mullo_epi16(a, b),
+      _mm_slli_epi32(_mm_mulhi_epu16(a, b), 16));
+}
+inline V Eq32(V a, V b) {
+  return _mm_cmpeq_epi32(a, b);
+}
+inline V Select(V mask, V a, V b) {
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+inline V AddSatU8(V a, V b) {
+  return _mm_adds_epu8(a, b);
+}
+inline void StoreStream(Rgba *p, V v) {
+  _mm_stream_si128(reinterpret_cast<__m128i*>(p), v);
+}
+inline void StreamFence() {
+  _mm_sfence();
+}
+inline V Reverse(V a) {
+  return _mm_shuffle_epi32(a, _MM_SHUFFLE(0, 1, 2, 3));
+}
+inline void Transpose(V *rows) {
+  const V t0 = _mm_unpacklo_epi32(rows[0], rows[1]);
+  const V t1 = _mm_unpacklo_epi32(rows[2], rows[3]);
+  const V t2 = _mm_unpackhi_epi32(rows[0], rows[1]);
+  const V t3 = _mm_unpackhi_epi32(rows[2], rows[3]);
+  rows[0] = _mm_unpacklo_epi64(t0, t1);
+  rows[1] = _mm_unpackhi_epi64(t0, t1);
+  rows[2] = _mm_unpacklo_epi64(t2, t3);
+  rows[3] = _mm_unpackhi_epi64(t2, t3);
+}
+
+#include "engine/easy_sprite_blend_kernels.inc"
+
+}  // namespace sse2
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace avx2 {
+
+typedef __m256i V;
+const Si32 kLanes = 8;
+
+inline V Load(const Rgba *p) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+}
+inline void Store(Rgba *p, V v) {
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v);
+}
+inline V Set1(Ui32 x) {
+  return _mm256_set1_epi32(static_cast<int>(x));
+}
+inline V And(V a, V b) {
+  return _mm256_and_si256(a, b);
+}
+inline V Or(V a, V b) {
+  return _mm256_or_si256(a, b);
+}
+inline V Add32(V a, V b) {
+  return _mm256_add_epi32(a, b);
+}
+inline V Sub32(V a, V b) {
+  return _mm256_sub_epi32(a, b);
+}
+inline V Srl8(V a) {
+  return _mm256_srli_epi32(a, 8);
+}
+inline V Srl24(V a) {
+  return _mm256_srli_epi32(a, 24);
+}
+inline V Sll16(V a) {
+  return _mm256_slli_epi32(a, 16);
+}
+inline V Mul16(V a, V b) {
+  return _mm256_mullo_epi16(a, b);
+}
+inline V Mul32(V a, V b) {
+  return _mm256_or_si256(_mm256_mullo_epi16(a, b),
+      _mm256_slli_epi32(_mm256_mulhi_epu16(a, b), 16));
+}
+inline V Eq32(V a, V b) {
+  return _mm256_cmpeq_epi32(a, b);
+}
+inline V Select(V mask, V a, V b) {
+  return _mm256_blendv_epi8(b, a, mask);
+}
+inline V AddSatU8(V a, V b) {
+  return _mm256_adds_epu8(a, b);
+}
+inline void StoreStream(Rgba *p, V v) {
+  _mm256_stream_si256(reinterpret_cast<__m256i*>(p), v);
+}
+inline void StreamFence() {
+  _mm_sfence();
+}
+inline V Reverse(V a) {
+  return _mm256_permutevar8x32_epi32(a,
+      _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));
+}
+inline void Transpose(V *rows) {
+  // Transposes the 4x4 quarters within the 128-bit lanes, then swaps
+  // the upper right and the lower left quarters.
+  const V t0 = _mm256_unpacklo_epi32(rows[0], rows[1]);
+  const V t1 = _mm256_unpackhi_epi32(rows[0], rows[1]);
+  const V t2 = _mm256_unpacklo_epi32(rows[2], rows[3]);
+  const V t3 = _mm256_unpackhi_epi32(rows[2], rows[3]);
+  const V t4 = _mm256_unpacklo_epi32(rows[4], rows[5]);
+  const V t5 = _mm256_unpackhi_epi32(rows[4], rows[5]);
+  const V t6 = _mm256_unpacklo_epi32(rows[6], rows[7]);
+  const V t7 = _mm256_unpackhi_epi32(rows[6], rows[7]);
+  const V u0 = _mm256_unpacklo_epi64(t0, t2);
+  const V u1 = _mm256_unpackhi_epi64(t0, t2);
+  const V u2 = _mm256_unpacklo_epi64(t1, t3);
+  const V u3 = _mm256_unpackhi_epi64(t1, t3);
+  const V u4 = _mm256_unpacklo_epi64(t4, t6);
+  const V u5 = _mm256_unpackhi_epi64(t4, t6);
+  const V u6 = _mm256_unpacklo_epi64(t5, t7);
+  const V u7 = _mm256_unpackhi_epi64(t5, t7);
+  rows[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+  rows[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+  rows[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+  rows[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+  rows[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+  rows[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+  rows[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+  rows[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+#include "engine/easy_sprite_blend_kernels.inc"
+
+}  // namespace avx2
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif  // ARCTIC_BLEND_X86
+
+#if defined(ARCTIC_BLEND_NEON)
+
+namespace neon {
+
+typedef uint32x4_t V;
+const Si32 kLanes = 4;
+
+inline V Load(const Rgba *p) {
+  return vld1q_u32(reinterpret_cast<const Ui32*>(p));
+}
+inline void Store(Rgba *p, V v) {
+  vst1q_u32(reinterpret_cast<Ui32*>(p), v);
+}
+inline V Set1(Ui32 x) {
+  return vdupq_n_u32(x);
+}
+inline V And(V a, V b) {
+  return vandq_u32(a, b);
+}
+inline V Or(V a, V b) {
+  return vorrq_u32(a, b);
+}
+inline V Add32(V a, V b) {
+  return vaddq_u32(a, b);
+}
+inline V Sub32(V a, V b) {
+  return vsubq_u32(a, b);
+}
+inline V Srl8(V a) {
+  return vshrq_n_u32(a, 8);
+}
+inline V Srl24(V a) {
+  return vshrq_n_u32(a, 24);
+}
+inline V Sll16(V a) {
+  return vshlq_n_u32(a, 16);
+}
+inline V Mul16(V a, V b) {
+  return vreinterpretq_u32_u16(
+      vmulq_u16(vreinterpretq_u16_u32(a), vreinterpretq_u16_u32(b)));
+}
+inline V Mul32(V a, V b) {
+  return vmulq_u32(a, b);
+}
+inline V Eq32(V a, V b) {
+  return vceqq_u32(a, b);
+}
+inline V Select(V mask, V a, V b) {
+  return vbslq_u32(mask, a, b);
+}
+inline V AddSatU8(V a, V b) {
+  return vreinterpretq_u32_u8(
+      vqaddq_u8(vreinterpretq_u8_u32(a), vreinterpretq_u8_u32(b)));
+}
+inline void StoreStream(Rgba *p, V v) {
+  // NEON has no non-temporal vector store intrinsic.
+  vst1q_u32(reinterpret_cast<Ui32*>(p), v);
+}
+inline void StreamFence() {
+}
+inline V Reverse(V a) {
+  const V r = vrev64q_u32(a);
+  return vcombine_u32(vget_high_u32(r), vget_low_u32(r));
+}
+inline void Transpose(V *rows) {
+  const uint32x4x2_t t01 = vtrnq_u32(rows[0], rows[1]);
+  const uint32x4x2_t t23 = vtrnq_u32(rows[2], rows[3]);
+  rows[0] = vcombine_u32(vget_low_u32(t01.val[0]), vget_low_u32(t23.val[0]));
+  rows[1] = vcombine_u32(vget_low_u32(t01.val[1]), vget_low_u32(t23.val[1]));
+  rows[2] = vcombine_u32(vget_high_u32(t01.val[0]),
+      vget_high_u32(t23.val[0]));
+  rows[3] = vcombine_u32(vget_high_u32(t01.val[1]),
+      vget_high_u32(t23.val[1]));
+}
+
+#include "engine/easy_sprite_blend_kernels.inc"
+
+}  // namespace neon
+
+#endif  // ARCTIC_BLEND_NEON
+
+// Indexed by BlendSimdLevel, then by DrawBlendingMode.
+const BlendRowFunction g_blend_row_functions[kBlendSimdLevelCount][6] = {
+  {CopyRowScalar, AlphaBlendRowScalar, ColorizeRowScalar,
+    AddRowScalar, SolidColorRowScalar, PremultipliedAlphaBlendRowScalar},
+#if defined(ARCTIC_BLEND_X86)
+  {CopyRowScalar, sse2::AlphaBlendRow, sse2::ColorizeRow,
+    sse2::AddRow, sse2::SolidColorRow, sse2::PremultipliedAlphaBlendRow},
+  {CopyRowScalar, avx2::AlphaBlendRow, avx2::ColorizeRow,
+    avx2::AddRow, avx2::SolidColorRow, avx2::PremultipliedAlphaBlendRow},
+#else
+  {CopyRowScalar, AlphaBlendRowScalar, ColorizeRowScalar,
+    AddRowScalar, SolidColorRowScalar, PremultipliedAlphaBlendRowScalar},
+  {CopyRowScalar, AlphaBlendRowScalar, ColorizeRowScalar,
+    AddRowScalar, SolidColorRowScalar, PremultipliedAlphaBlendRowScalar},
+#endif  // ARCTIC_BLEND_X86
+#if defined(ARCTIC_BLEND_NEON)
+  {CopyRowScalar, neon::AlphaBlendRow, neon::ColorizeRow,
+    neon::AddRow, neon::SolidColorRow, neon::PremultipliedAlphaBlendRow},
+#else
+  {CopyRowScalar, AlphaBlendRowScalar, ColorizeRowScalar,
+    AddRowScalar, SolidColorRowScalar, PremultipliedAlphaBlendRowScalar},
+#endif  // ARCTIC_BLEND_NEON
+};
+
+// Indexed by BlendSimdLevel.
+const BilinearRowFunction g_bilinear_row_functions[kBlendSimdLevelCount] = {
+  BilinearRowScalar,
+#if defined(ARCTIC_BLEND_X86)
+  sse2::BilinearRow,
+  avx2::BilinearRow,
+#else
+  BilinearRowScalar,
+  BilinearRowScalar,
+#endif  // ARCTIC_BLEND_X86
+#if defined(ARCTIC_BLEND_NEON)
+  neon::BilinearRow,
+#else
+  BilinearRowScalar,
+#endif  // ARCTIC_BLEND_NEON
+};
+
+// Indexed by BlendSimdLevel.
+const FillRowFunction g_fill_row_functions[kBlendSimdLevelCount] = {
+  FillRowScalarEntry,
+#if defined(ARCTIC_BLEND_X86)
+  sse2::FillRow,
+  avx2::FillRow,
+#else
+  FillRowScalarEntry,
+  FillRowScalarEntry,
+#endif  // ARCTIC_BLEND_X86
+#if defined(ARCTIC_BLEND_NEON)
+  neon::FillRow,
+#else
+  FillRowScalarEntry,
+#endif  // ARCTIC_BLEND_NEON
+};
+
+// Indexed by BlendSimdLevel.
+const TransformPixelsFunction
+    g_transform_pixels_functions[kBlendSimdLevelCount] = {
+  TransformPixelsScalar,
+#if defined(ARCTIC_BLEND_X86)
+  sse2::TransformPixels,
+  avx2::TransformPixels,
+#else
+  TransformPixelsScalar,
+  TransformPixelsScalar,
+#endif  // ARCTIC_BLEND_X86
+#if defined(ARCTIC_BLEND_NEON)
+  neon::TransformPixels,
+#else
+  TransformPixelsScalar,
+#endif  // ARCTIC_BLEND_NEON
+};
+
+BlendSimdLevel DetectCpuBlendSimdLevel() {
+#if defined(ARCTIC_BLEND_X86)
+#if defined(_MSC_VER)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] >= 7) {
+    __cpuid(info, 1);
+    const bool is_os_saving_ymm = (info[2] & (1 << 27)) != 0
+      && (_xgetbv(0) & 6) == 6;
+    const bool has_avx = (info[2] & (1 << 28)) != 0;
+    __cpuidex(info, 7, 0);
+    const bool has_avx2 = (info[1] & (1 << 5)) != 0;
+    if (is_os_saving_ymm && has_avx && has_avx2) {
+      return kBlendSimdAvx2;
+    }
+  }
+#else
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return kBlendSimdAvx2;
+  }
+#endif  // _MSC_VER
+  return kBlendSimdSse2;
+#elif defined(ARCTIC_BLEND_NEON)
+  return kBlendSimdNeon;
+#else
+  return kBlendSimdScalar;
+#endif
+}
+
+const BlendSimdLevel g_detected_blend_simd_level = DetectCpuBlendSimdLevel();
+BlendSimdLevel g_blend_simd_level = g_detected_blend_simd_level;
+Si64 g_sprite_job_pixel_threshold = 0;
+
+bool IsBlendSimdLevelSupported(BlendSimdLevel level) {
+  switch (level) {
+    case kBlendSimdScalar:
+      return true;
+    case kBlendSimdSse2:
+      return g_detected_blend_simd_level == kBlendSimdSse2
+        || g_detected_blend_simd_level == kBlendSimdAvx2;
+    case kBlendSimdAvx2:
+    case kBlendSimdNeon:
+      return g_detected_blend_simd_level == level;
+    default:
+      return false;
+  }
+}
+
+}  // namespace
+
+BlendSimdLevel DetectBlendSimdLevel() {
+  return g_detected_blend_simd_level;
+}
+
+BlendSimdLevel GetBlendSimdLevel() {
+  return g_blend_simd_level;
+}
+
+void SetBlendSimdLevel(BlendSimdLevel level) {
+  g_blend_simd_level = IsBlendSimdLevelSupported(level) ?
+    level : g_detected_blend_simd_level;
+}
+
+BlendRowFunction GetBlendRowFunction(DrawBlendingMode blending_mode) {
+  return GetBlendRowFunction(blending_mode, g_blend_simd_level);
+}
+
+BlendRowFunction GetBlendRowFunction(DrawBlendingMode blending_mode,
+    BlendSimdLevel level) {
+  if (!IsBlendSimdLevelSupported(level)) {
+    level = g_detected_blend_simd_level;
+  }
+  const Si32 mode = static_cast<Si32>(blending_mode);
+  if (mode < 0 || mode >= 6) {
+    // Unknown blending mode, copy just like the DrawSprite does.
+    return CopyRowScalar;
+  }
+  return g_blend_row_functions[level][mode];
+}
+
+BilinearRowFunction GetBilinearRowFunction() {
+  return GetBilinearRowFunction(g_blend_simd_level);
+}
+
+BilinearRowFunction GetBilinearRowFunction(BlendSimdLevel level) {
+  if (!IsBlendSimdLevelSupported(level)) {
+    level = g_detected_blend_simd_level;
+  }
+  return g_bilinear_row_functions[level];
+}
+
+FillRowFunction GetFillRowFunction() {
+  return GetFillRowFunction(g_blend_simd_level);
+}
+
+FillRowFunction GetFillRowFunction(BlendSimdLevel level) {
+  if (!IsBlendSimdLevelSupported(level)) {
+    level = g_detected_blend_simd_level;
+  }
+  return g_fill_row_functions[level];
+}
+
+TransformPixelsFunction GetTransformPixelsFunction() {
+  return GetTransformPixelsFunction(g_blend_simd_level);
+}
+
+TransformPixelsFunction GetTransformPixelsFunction(BlendSimdLevel level) {
+  if (!IsBlendSimdLevelSupported(level)) {
+    level = g_detected_blend_simd_level;
+  }
+  return g_transform_pixels_functions[level];
+}
+
+Si64 GetSpriteJobPixelThreshold() {
+  return g_sprite_job_pixel_threshold;
+}
+
+void SetSpriteJobPixelThreshold(Si64 pixel_count) {
+  g_sprite_job_pixel_threshold = std::max(pixel_count, Si64(0));
+}
+
+}  // namespace arctic
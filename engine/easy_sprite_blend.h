@@ -0,0 +1,131 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef ENGINE_EASY_SPRITE_BLEND_H_
+#define ENGINE_EASY_SPRITE_BLEND_H_
+
+#include "engine/arctic_types.h"
+#include "engine/easy_sprite.h"
+#include "engine/rgba.h"
+
+namespace arctic {
+
+/// @addtogroup global_advanced
+/// @{
+
+/// @brief Instruction sets the software blitter can use for blending
+enum BlendSimdLevel {
+  kBlendSimdScalar = 0,  ///< Portable bit-exact reference implementation.
+  kBlendSimdSse2 = 1,  ///< 4 pixels per iteration, x86 and x86-64.
+  kBlendSimdAvx2 = 2,  ///< 8 pixels per iteration, x86 and x86-64.
+  kBlendSimdNeon = 3,  ///< 4 pixels per iteration, ARM.
+  kBlendSimdLevelCount
+};
+
+/// @brief Blends count pixels of the from row over the to row.
+/// @param [in,out] to Destination pixels.
+/// @param [in] from Source pixels, may not overlap the destination.
+/// @param [in] count Number of pixels to blend.
+/// @param [in] in_color Color used by the colorize and solid color modes.
+typedef void (*BlendRowFunction)(Rgba *to, const Rgba *from, Si32 count,
+    Rgba in_color);
+
+/// @brief Filters count pixels, each from its four nearest source pixels.
+/// @param [out] to Filtered pixels.
+/// @param [in] color00 Source pixels at (x, y).
+/// @param [in] color01 Source pixels at (x + 1, y).
+/// @param [in] color10 Source pixels at (x, y + 1).
+/// @param [in] color11 Source pixels at (x + 1, y + 1).
+/// @param [in] from_x_8 Weights of the x + 1 pixels, 0 to 255.
+/// @param [in] from_y_8 Weights of the y + 1 pixels, 0 to 255.
+/// @param [in] count Number of pixels to filter.
+typedef void (*BilinearRowFunction)(Rgba *to,
+    const Rgba *color00, const Rgba *color01,
+    const Rgba *color10, const Rgba *color11,
+    const Ui32 *from_x_8, const Ui32 *from_y_8, Si32 count);
+
+/// @brief Fills count pixels with the color.
+/// @param [out] to Destination pixels.
+/// @param [in] count Number of pixels to fill.
+/// @param [in] color Color to fill with.
+/// @param [in] is_streaming If true, the pixels are written around the cache.
+///  Use it for the fills much larger than the cache that are not read back
+///  right away.
+typedef void (*FillRowFunction)(Rgba *to, Si32 count, Rgba color,
+    bool is_streaming);
+
+/// @brief Copies a block of pixels rotating or mirroring it.
+/// @param [out] to Destination pixels, height by width of them for
+///  the 90 degree rotations and width by height otherwise.
+/// @param [in] to_stride Destination row stride in pixels.
+/// @param [in] from Source pixels, may not overlap the destination.
+/// @param [in] from_stride Source row stride in pixels.
+/// @param [in] width Source block width in pixels.
+/// @param [in] height Source block height in pixels.
+/// @param [in] transform Transformation to perform, the same way
+///  the Sprite::Clone does it.
+typedef void (*TransformPixelsFunction)(Rgba *to, Si32 to_stride,
+    const Rgba *from, Si32 from_stride, Si32 width, Si32 height,
+    CloneTransform transform);
+
+/// @brief Returns the best blending instruction set the cpu supports
+BlendSimdLevel DetectBlendSimdLevel();
+/// @brief Returns the blending instruction set the blitter is using
+BlendSimdLevel GetBlendSimdLevel();
+/// @brief Selects the blending instruction set for the software blitter
+/// @details The level is clamped to what the cpu supports.
+///  Pass kBlendSimdScalar to force the scalar reference implementation.
+///  The output is bit-exact with the scalar reference at every level.
+void SetBlendSimdLevel(BlendSimdLevel level);
+/// @brief Returns the row blending function for the current level
+BlendRowFunction GetBlendRowFunction(DrawBlendingMode blending_mode);
+/// @brief Returns the row blending function for the specified level
+BlendRowFunction GetBlendRowFunction(DrawBlendingMode blending_mode,
+    BlendSimdLevel level);
+/// @brief Returns the bilinear filtering function for the current level
+BilinearRowFunction GetBilinearRowFunction();
+/// @brief Returns the bilinear filtering function for the specified level
+BilinearRowFunction GetBilinearRowFunction(BlendSimdLevel level);
+/// @brief Returns the row filling function for the current level
+FillRowFunction GetFillRowFunction();
+/// @brief Returns the row filling function for the specified level
+FillRowFunction GetFillRowFunction(BlendSimdLevel level);
+/// @brief Returns the pixel block transforming function for the current level
+TransformPixelsFunction GetTransformPixelsFunction();
+/// @brief Returns the pixel block transforming function for the specified level
+TransformPixelsFunction GetTransformPixelsFunction(BlendSimdLevel level);
+
+/// @brief Returns the smallest Sprite::Clear and Sprite::Clone size
+///  that is split between the job system workers, in pixels
+Si64 GetSpriteJobPixelThreshold();
+/// @brief Lets the Sprite::Clear and Sprite::Clone of the large sprites
+///  run on the job system workers
+/// @details The sprites of at least pixel_count pixels are split into
+///  bands of rows and processed in parallel. Pass 0 to process every sprite
+///  on the calling thread, which is the default.
+void SetSpriteJobPixelThreshold(Si64 pixel_count);
+
+/// @}
+
+}  // namespace arctic
+
+#endif  // ENGINE_EASY_SPRITE_BLEND_H_
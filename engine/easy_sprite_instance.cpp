@@ -29,6 +29,7 @@
 #include <cstring>
 #include <memory>
 #include <sstream>
+#include <utility>
 
 #include "engine/arctic_platform.h"
 #include "engine/log.h"
@@ -45,39 +46,101 @@ namespace arctic {
           static_cast<size_t>(height) * sizeof(Rgba)) {
       }
 
+  SpriteInstance::SpriteInstance(Si32 width, Si32 height, Ui8 *data,
+      std::shared_ptr<void> owner)
+    : width_(width)
+      , height_(height)
+      , external_data_(data)
+      , external_owner_(std::move(owner)) {
+      }
+
+  // Splits the pixels [begin, end) into opaque and translucent runs.
+  static void AddPixelRuns(const Rgba *line, Si32 begin, Si32 end,
+      std::vector<PixelRun> *runs) {
+    Si32 run_begin = begin;
+    Si32 x = begin;
+    while (x < end) {
+      if (line[x].a != 255) {
+        ++x;
+        continue;
+      }
+      Si32 opaque_end = x + 1;
+      while (opaque_end < end && line[opaque_end].a == 255) {
+        ++opaque_end;
+      }
+      if (opaque_end - x >= kPixelRunMinOpaque) {
+        if (run_begin < x) {
+          runs->push_back(PixelRun{run_begin, x, false});
+        }
+        runs->push_back(PixelRun{x, opaque_end, true});
+        run_begin = opaque_end;
+      }
+      x = opaque_end;
+    }
+    if (run_begin < end) {
+      runs->push_back(PixelRun{run_begin, end, false});
+    }
+  }
+
   void SpriteInstance::UpdateOpaqueSpans() {
+    opaque_.clear();
+    runs_.clear();
+    row_runs_.clear();
     if (!height_) {
-      opaque_.clear();
       return;
     }
     opaque_.resize(static_cast<size_t>(height_));
+    row_runs_.reserve(static_cast<size_t>(height_) + 1);
     for (Si32 y = 0; y < height_; ++y) {
       const Rgba *line = reinterpret_cast<Rgba*>(
-          reinterpret_cast<void*>(data_.data())) +
+          reinterpret_cast<void*>(RawData())) +
         width_ * y;
-      SpanSi32 &span = opaque_[static_cast<size_t>(y)];
-      span.begin = 0;
-      span.end = 0;
+      row_runs_.push_back(static_cast<Si32>(runs_.size()));
       Si32 x = 0;
-      for (; x < width_; ++x) {
-        if (line[x].a != 0) {
-          span.begin = x;
+      while (x < width_) {
+        while (x < width_ && line[x].a == 0) {
+          ++x;
+        }
+        if (x == width_) {
           break;
         }
-      }
-      if (x < width_) {
-        for (; x < width_; ++x) {
+        const Si32 begin = x;
+        Si32 end = x;
+        while (x < width_) {
           if (line[x].a != 0) {
-            span.end = x;
+            ++x;
+            end = x;
+            continue;
           }
+          Si32 gap_end = x + 1;
+          while (gap_end < width_ && line[gap_end].a == 0) {
+            ++gap_end;
+          }
+          if (gap_end == width_ || gap_end - x >= kPixelRunMinGap) {
+            x = gap_end;
+            break;
+          }
+          // Blending a short gap costs less than starting a new run.
+          x = gap_end;
         }
-        span.end++;
+        AddPixelRuns(line, begin, end, &runs_);
+      }
+      // The span covers the runs of the row, from the first to the last.
+      SpanSi32 &span = opaque_[static_cast<size_t>(y)];
+      span.begin = 0;
+      span.end = 0;
+      if (static_cast<Si32>(runs_.size()) != row_runs_.back()) {
+        span.begin = runs_[static_cast<size_t>(row_runs_.back())].begin;
+        span.end = runs_.back().end;
       }
     }
+    row_runs_.push_back(static_cast<Si32>(runs_.size()));
   }
 
   void SpriteInstance::ClearOpaqueSpans() {
     opaque_.clear();
+    runs_.clear();
+    row_runs_.clear();
   }
 
 #pragma pack(1)
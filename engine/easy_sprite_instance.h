@@ -33,20 +33,45 @@ namespace arctic {
 /// @addtogroup global_advanced
 /// @{
 
+/// @brief Transparent gaps shorter than this are included in the runs
+const Si32 kPixelRunMinGap = 4;
+/// @brief Opaque pixels are split into a separate run from this length on
+const Si32 kPixelRunMinOpaque = 8;
+
 struct SpanSi32 {
   Si32 begin;
   Si32 end;
 };
 
+/// @brief A run of pixels of a sprite row that are not all transparent
+/// @details The pixels between the runs of a row are fully transparent.
+struct PixelRun {
+  Si32 begin;
+  Si32 end;
+  bool is_opaque;  ///< true if all the pixels of the run are fully opaque
+};
+
 class SpriteInstance {
  private:
   Si32 width_;
   Si32 height_;
   std::vector<Ui8> data_;
   std::vector<SpanSi32> opaque_;
+  // Pixels stored outside of data_, like in a mapped asset pack.
+  Ui8 *external_data_ = nullptr;
+  std::shared_ptr<void> external_owner_;
+  std::vector<PixelRun> runs_;
+  // Index of the first run of each row followed by the total run count.
+  std::vector<Si32> row_runs_;
 
  public:
   SpriteInstance(Si32 width, Si32 height);
+  /// @brief Creates a sprite instance that uses the pixels specified
+  /// without copying them
+  /// @param [in] data Rgba pixels, at least width * height of them
+  /// @param [in] owner Keeps the pixels alive while the instance exists
+  SpriteInstance(Si32 width, Si32 height, Ui8 *data,
+    std::shared_ptr<void> owner);
 
   Si32 width() const {
     return width_;
@@ -57,13 +82,25 @@ class SpriteInstance {
   }
 
   Ui8 *RawData() {
-    return data_.data();
+    return external_data_ ? external_data_ : data_.data();
   }
 
   const std::vector<SpanSi32> &Opaque() {
     return opaque_;
   }
 
+  bool HasPixelRuns() const {
+    return !row_runs_.empty();
+  }
+
+  const PixelRun *RowRunsBegin(Si32 y) const {
+    return runs_.data() + row_runs_[static_cast<size_t>(y)];
+  }
+
+  const PixelRun *RowRunsEnd(Si32 y) const {
+    return runs_.data() + row_runs_[static_cast<size_t>(y) + 1];
+  }
+
   void UpdateOpaqueSpans();
   void ClearOpaqueSpans();
 };
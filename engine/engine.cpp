@@ -24,11 +24,16 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <algorithm>
 #include <cstring>
 #include <sstream>
 
 #include "engine/opengl.h"
 #include "engine/engine.h"
+#include "engine/arctic_job_system.h"
+#include "engine/easy_deferred_drawing.h"
+#include "engine/easy_dirty_rects.h"
+#include "engine/easy_hw_sprite_batch.h"
 #include "engine/log.h"
 #include "engine/arctic_platform.h"
 #include "engine/arctic_math.h"
@@ -87,6 +92,9 @@ void Engine::Init(Si32 width, Si32 height) {
   width_ = width;
   height_ = height;
 
+  // The jobs pushed with RunMainThreadJob run in ShowFrame on this thread.
+  SetJobSystemMainThread();
+
   SetVSync(true);
 
   ResizeBackbuffer(width, height);
@@ -170,6 +178,48 @@ void main() {
 
   default_sprite_program_ = std::make_shared<GlProgram>();
   default_sprite_program_->Create(default_sprite_vShaderStr, default_sprite_fShaderStr);
+
+  const char batched_sprite_vShaderStr[] = R"SHADER(
+#ifdef GL_ES
+precision mediump float;
+#endif
+attribute vec2 vPosition;
+attribute vec2 vTex;
+attribute vec4 vColor;
+varying vec2 v_texCoord;
+varying vec4 v_color;
+uniform vec2 to_sprite_size;
+void main() {
+  vec2 position = vPosition;
+  position *= vec2(2.0 / to_sprite_size.x, 2.0 / to_sprite_size.y);
+  position -= vec2(1.0, 1.0);
+  gl_Position = vec4(position, 0.0, 1.0);
+
+  v_texCoord = vTex;
+  v_color = vColor;
+}
+)SHADER";
+
+  const char batched_sprite_fShaderStr[] = R"SHADER(
+#ifdef GL_ES
+precision lowp float;
+#endif
+varying vec2 v_texCoord;
+varying vec4 v_color;
+uniform sampler2D s_texture;
+uniform int is_solid_color;
+void main() {
+  if (is_solid_color == 1) {
+    gl_FragColor.rgb = v_color.rgb;
+    gl_FragColor.a = texture2D(s_texture, v_texCoord).a*v_color.a;
+  } else {
+    gl_FragColor = texture2D(s_texture, v_texCoord)*v_color;
+  }
+}
+)SHADER";
+
+  batched_sprite_program_ = std::make_shared<GlProgram>();
+  batched_sprite_program_->Create(batched_sprite_vShaderStr, batched_sprite_fShaderStr);
 }
 
 struct Vertex {
@@ -186,7 +236,29 @@ struct Vertex {
 };
 
 void Engine::Draw2d() {
-  gl_backbuffer_texture_.UpdateData(backbuffer_texture_.RawData());
+  FlushDeferredDrawing();
+  FinishHwSpriteBatchFrame();
+  if (IsBackbufferDirtyTracking()) {
+    if (IsSkipUnchangedFrames() && !IsFrameChanged()) {
+      SkipSwap();
+      return;
+    }
+    const DirtyRects &dirty_rects = GetBackbufferDirtyRects();
+    for (Si32 idx = 0; idx < dirty_rects.Count(); ++idx) {
+      const DirtyRects::Rect &rect = dirty_rects[idx];
+      const Si32 x1 = std::max(rect.x_begin, 0);
+      const Si32 y1 = std::max(rect.y_begin, 0);
+      const Si32 x2 = std::min(rect.x_end, gl_backbuffer_texture_.width());
+      const Si32 y2 = std::min(rect.y_end, gl_backbuffer_texture_.height());
+      if (x1 < x2 && y1 < y2) {
+        gl_backbuffer_texture_.UpdateData(backbuffer_texture_.RawData(),
+          x1, y1, x2 - x1, y2 - y1);
+      }
+    }
+    ClearBackbufferDirtyState();
+  } else {
+    gl_backbuffer_texture_.UpdateData(backbuffer_texture_.RawData());
+  }
 
   // render
 
@@ -281,10 +353,12 @@ void Engine::Draw2d() {
 }
 
 void Engine::ResizeBackbuffer(const Si32 width, const Si32 height) {
+  FlushDeferredDrawing();
   hw_backbuffer_texture_.Create(width, height);
   backbuffer_texture_.Create(width, height);
 
   gl_backbuffer_texture_.Create(width, height);
+  MarkBackbufferDirty(0, 0, width, height);
 }
 
 double Engine::GetTime() {
@@ -379,6 +453,9 @@ Vec2Si32 Engine::MouseToBackbuffer(Vec2F pos) const {
 }
 
 void Engine::OnWindowResize(Si32 width, Si32 height) {
+  if (width_ != width || height_ != height) {
+    MarkFrameChanged();
+  }
   width_ = width;
   height_ = height;
 }
@@ -80,6 +80,7 @@ class Engine {
 
   std::shared_ptr<GlProgram> copy_backbuffers_program_;
   std::shared_ptr<GlProgram> default_sprite_program_;
+  std::shared_ptr<GlProgram> batched_sprite_program_;
 
   std::vector<const char*> cmd_line_argv_;
   std::vector<std::string> cmd_line_arguments_;
@@ -125,6 +126,10 @@ class Engine {
   const std::shared_ptr<GlProgram> &GetDefaultSpriteProgram() const {
     return default_sprite_program_;
   }
+
+  const std::shared_ptr<GlProgram> &GetBatchedSpriteProgram() const {
+    return batched_sprite_program_;
+  }
 };
 /// @}
 
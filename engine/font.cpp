@@ -212,6 +212,21 @@ void Font::AddGlyph(Ui32 codepoint, Si32 xadvance, Sprite sprite) {
   codepoint_[codepoint] = &glyph_.back();
 }
 
+// Unlike Sprite::Clone it doesn't go through the drawing code,
+// so fonts can be loaded on the worker threads.
+static Sprite CopySpritePixels(const Sprite &from) {
+  Sprite sprite;
+  sprite.Create(from.Size());
+  if (from.Width() > 0) {
+    for (Si32 y = 0; y < from.Height(); ++y) {
+      memcpy(sprite.RgbaData() + y * sprite.StridePixels(),
+        from.RgbaData() + y * from.StridePixels(),
+        static_cast<size_t>(from.Width()) * sizeof(Rgba));
+    }
+  }
+  return sprite;
+}
+
 void Font::Load(const char *file_name) {
   codepoint_.clear();
   glyph_.clear();
@@ -313,8 +328,7 @@ void Font::Load(const char *file_name) {
     sprite0.Reference(page_images[chars->page],
       chars->x, page_images[chars->page].Height() - chars->y - chars->height,
       chars->width, chars->height);
-    Sprite sprite;
-    sprite.Clone(sprite0);
+    Sprite sprite = CopySpritePixels(sprite0);
     sprite.UpdateOpaqueSpans();
     sprite.SetPivot(arctic::Vec2Si32(
       -chars->xoffset, chars->height + chars->yoffset - common->base));
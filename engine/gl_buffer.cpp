@@ -55,9 +55,9 @@ void GlBuffer::Bind() const {
     }
 }
 
-void GlBuffer::SetData(const void *data, size_t size) {
+void GlBuffer::SetData(const void *data, size_t size, GLenum usage) {
     Bind();
-    ARCTIC_GL_CHECK_ERROR(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
+    ARCTIC_GL_CHECK_ERROR(glBufferData(GL_ARRAY_BUFFER, size, data, usage));
     size_ = size;
 }
 
@@ -50,7 +50,7 @@ class GlBuffer {
 
   void Create(const void *data, size_t size);
   void Bind() const;
-  void SetData(const void *data, size_t size);
+  void SetData(const void *data, size_t size, GLenum usage = GL_STATIC_DRAW);
   void UpdateData(const void *data);
 
   bool IsValid() const {
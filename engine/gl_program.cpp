@@ -25,6 +25,7 @@
 
 #include "engine/gl_program.h"
 
+#include <algorithm>
 #include <sstream>
 #include "engine/arctic_platform.h"
 #include "engine/log.h"
@@ -33,7 +34,18 @@
 
 namespace arctic {
 
+#ifdef NDEBUG
+bool g_is_gl_validation = false;
+#else
+bool g_is_gl_validation = true;
+#endif
+
+void SetGlValidation(bool is_enabled) {
+    g_is_gl_validation = is_enabled;
+}
+
 GLuint GlProgram::current_program_id_ = 0;
+Ui64 GlProgram::next_serial_ = 1;
 
 GLuint LoadShader(const char *shaderSrc, GLenum type) {
     // Create the shader object
@@ -70,7 +82,8 @@ GLuint LoadShader(const char *shaderSrc, GLenum type) {
 
 
 GlProgram::GlProgram()
-    : program_id_(0) {
+    : program_id_(0)
+    , serial_(0) {
 }
 
 GlProgram::~GlProgram() {
@@ -95,6 +108,7 @@ void GlProgram::Create(const char *vs_src, const char *fs_src) {
     // Bind vPosition to attribute 0
     ARCTIC_GL_CHECK_ERROR(glBindAttribLocation(program_id_, 0, "vPosition"));
     ARCTIC_GL_CHECK_ERROR(glBindAttribLocation(program_id_, 1, "vTex"));
+    ARCTIC_GL_CHECK_ERROR(glBindAttribLocation(program_id_, 2, "vColor"));
     // Link the program
     ARCTIC_GL_CHECK_ERROR(glLinkProgram(program_id_));
     // Check the link status
@@ -112,6 +126,43 @@ void GlProgram::Create(const char *vs_src, const char *fs_src) {
         ARCTIC_GL_CHECK_ERROR(glDeleteProgram(program_id_));
         Fatal("Unknown error linking program");
     }
+    serial_ = next_serial_++;
+    ReflectUniforms();
+}
+
+void GlProgram::ReflectUniforms() {
+    uniforms_.clear();
+    GLint count = 0;
+    ARCTIC_GL_CHECK_ERROR(glGetProgramiv(program_id_, GL_ACTIVE_UNIFORMS, &count));
+    GLint max_length = 0;
+    ARCTIC_GL_CHECK_ERROR(glGetProgramiv(program_id_, GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length));
+    std::string name;
+    name.resize(static_cast<size_t>(std::max(max_length, 1)) + 1);
+    for (GLint idx = 0; idx < count; ++idx) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        ARCTIC_GL_CHECK_ERROR(glGetActiveUniform(program_id_, static_cast<GLuint>(idx),
+            static_cast<GLsizei>(name.size()), &length, &size, &type, &name.front()));
+        UniformInfo info;
+        info.name.assign(name.data(), static_cast<size_t>(length));
+        // Arrays are reported as "name[0]", they are set by the plain name.
+        const size_t bracket = info.name.find('[');
+        if (bracket != std::string::npos) {
+            info.name.resize(bracket);
+        }
+        ARCTIC_GL_CHECK_ERROR(info.location = glGetUniformLocation(program_id_, info.name.c_str()));
+        uniforms_.push_back(info);
+    }
+}
+
+Si32 GlProgram::FindUniformByLocation(int location) const {
+    for (size_t idx = 0; idx < uniforms_.size(); ++idx) {
+        if (uniforms_[idx].location == location) {
+            return static_cast<Si32>(idx);
+        }
+    }
+    return -1;
 }
 
 void GlProgram::Bind() {
@@ -121,186 +172,315 @@ void GlProgram::Bind() {
     }
 }
 
+GlUniformHandle GlProgram::GetUniformHandle(const char *name) const {
+    GlUniformHandle handle;
+    for (size_t idx = 0; idx < uniforms_.size(); ++idx) {
+        if (strcmp(uniforms_[idx].name.c_str(), name) == 0) {
+            handle.idx = static_cast<Si32>(idx);
+            break;
+        }
+    }
+    return handle;
+}
+
+void GlProgram::SetUniform(GlUniformHandle handle, const GlUniformValue &value) {
+    if (!handle.IsValid() || handle.idx >= static_cast<Si32>(uniforms_.size())) {
+        return;
+    }
+    if (IsGlValidation()) {
+        Check(current_program_id_ == program_id_,
+            "SetUniform called for a program that is not bound");
+    }
+    UniformInfo &info = uniforms_[static_cast<size_t>(handle.idx)];
+    if (info.has_value && info.value == value) {
+        return;
+    }
+    info.has_value = true;
+    info.value = value;
+    const GLint location = info.location;
+    switch (value.type) {
+        case GlUniformType::Int:
+            ARCTIC_GL_CHECK_ERROR(glUniform1i(location, value.i[0]));
+            break;
+        case GlUniformType::Int2:
+            ARCTIC_GL_CHECK_ERROR(glUniform2i(location, value.i[0], value.i[1]));
+            break;
+        case GlUniformType::Int3:
+            ARCTIC_GL_CHECK_ERROR(glUniform3i(location, value.i[0], value.i[1],
+                value.i[2]));
+            break;
+        case GlUniformType::Int4:
+            ARCTIC_GL_CHECK_ERROR(glUniform4i(location, value.i[0], value.i[1],
+                value.i[2], value.i[3]));
+            break;
+        case GlUniformType::Float:
+            ARCTIC_GL_CHECK_ERROR(glUniform1f(location, value.f[0]));
+            break;
+        case GlUniformType::Float2:
+            ARCTIC_GL_CHECK_ERROR(glUniform2f(location, value.f[0], value.f[1]));
+            break;
+        case GlUniformType::Float3:
+            ARCTIC_GL_CHECK_ERROR(glUniform3f(location, value.f[0], value.f[1],
+                value.f[2]));
+            break;
+        case GlUniformType::Float4:
+            ARCTIC_GL_CHECK_ERROR(glUniform4f(location, value.f[0], value.f[1],
+                value.f[2], value.f[3]));
+            break;
+    }
+}
+
+void GlProgram::SetUniform(GlUniformHandle handle, int value) {
+    SetUniform(handle, GlUniformValue(value));
+}
+
+void GlProgram::SetUniform(GlUniformHandle handle, const Vec2Si32 &value) {
+    SetUniform(handle, GlUniformValue(value));
+}
+
+void GlProgram::SetUniform(GlUniformHandle handle, const Vec3Si32 &value) {
+    SetUniform(handle, GlUniformValue(value));
+}
+
+void GlProgram::SetUniform(GlUniformHandle handle, const Vec4Si32 &value) {
+    SetUniform(handle, GlUniformValue(value));
+}
+
+void GlProgram::SetUniform(GlUniformHandle handle, float value) {
+    SetUniform(handle, GlUniformValue(value));
+}
+
+void GlProgram::SetUniform(GlUniformHandle handle, const Vec2F &value) {
+    SetUniform(handle, GlUniformValue(value));
+}
+
+void GlProgram::SetUniform(GlUniformHandle handle, const Vec3F &value) {
+    SetUniform(handle, GlUniformValue(value));
+}
+
+void GlProgram::SetUniform(GlUniformHandle handle, const Vec4F &value) {
+    SetUniform(handle, GlUniformValue(value));
+}
+
 void GlProgram::SetUniform(int id, int value) {
-    ARCTIC_GL_CHECK_ERROR(glUniform1i(id, value));
+    GlUniformHandle handle;
+    handle.idx = FindUniformByLocation(id);
+    SetUniform(handle, GlUniformValue(value));
 }
 
 void GlProgram::SetUniform(int id, const Vec2Si32 &value) {
-    ARCTIC_GL_CHECK_ERROR(glUniform2i(id, value.x, value.y));
+    GlUniformHandle handle;
+    handle.idx = FindUniformByLocation(id);
+    SetUniform(handle, GlUniformValue(value));
 }
 
 void GlProgram::SetUniform(int id, const Vec3Si32 &value) {
-    ARCTIC_GL_CHECK_ERROR(glUniform3i(id, value.x, value.y, value.z));
+    GlUniformHandle handle;
+    handle.idx = FindUniformByLocation(id);
+    SetUniform(handle, GlUniformValue(value));
 }
 
 void GlProgram::SetUniform(int id, const Vec4Si32 &value) {
-    ARCTIC_GL_CHECK_ERROR(glUniform4i(id, value.x, value.y, value.z, value.w));
+    GlUniformHandle handle;
+    handle.idx = FindUniformByLocation(id);
+    SetUniform(handle, GlUniformValue(value));
 }
 
 void GlProgram::SetUniform(int id, float value) {
-    ARCTIC_GL_CHECK_ERROR(glUniform1f(id, value));
+    GlUniformHandle handle;
+    handle.idx = FindUniformByLocation(id);
+    SetUniform(handle, GlUniformValue(value));
 }
 
 void GlProgram::SetUniform(int id, const Vec2F &value) {
-    ARCTIC_GL_CHECK_ERROR(glUniform2f(id, value.x, value.y));
+    GlUniformHandle handle;
+    handle.idx = FindUniformByLocation(id);
+    SetUniform(handle, GlUniformValue(value));
 }
 
 void GlProgram::SetUniform(int id, const Vec3F &value) {
-    ARCTIC_GL_CHECK_ERROR(glUniform3f(id, value.x, value.y, value.z));
+    GlUniformHandle handle;
+    handle.idx = FindUniformByLocation(id);
+    SetUniform(handle, GlUniformValue(value));
 }
 
 void GlProgram::SetUniform(int id, const Vec4F &value) {
-    ARCTIC_GL_CHECK_ERROR(glUniform4f(id, value.x, value.y, value.z, value.w));
+    GlUniformHandle handle;
+    handle.idx = FindUniformByLocation(id);
+    SetUniform(handle, GlUniformValue(value));
 }
 
 void GlProgram::SetUniform(const char *name, int value) {
-    ARCTIC_GL_CHECK_ERROR(glUniform1i(GetUniformLocation(name), value));
+    GlUniformHandle handle = GetUniformHandle(name);
+    Check(handle.IsValid(), name, " not found");
+    SetUniform(handle, GlUniformValue(value));
 }
 
 void GlProgram::SetUniform(const char *name, const Vec2Si32 &value) {
-    ARCTIC_GL_CHECK_ERROR(glUniform2i(GetUniformLocation(name), value.x, value.y));
+    GlUniformHandle handle = GetUniformHandle(name);
+    Check(handle.IsValid(), name, " not found");
+    SetUniform(handle, GlUniformValue(value));
 }
 
 void GlProgram::SetUniform(const char *name, const Vec3Si32 &value) {
-    ARCTIC_GL_CHECK_ERROR(glUniform3i(GetUniformLocation(name), value.x, value.y, value.z));
+    GlUniformHandle handle = GetUniformHandle(name);
+    Check(handle.IsValid(), name, " not found");
+    SetUniform(handle, GlUniformValue(value));
 }
 
 void GlProgram::SetUniform(const char *name, const Vec4Si32 &value) {
-    ARCTIC_GL_CHECK_ERROR(glUniform4i(GetUniformLocation(name), value.x, value.y, value.z, value.w));
+    GlUniformHandle handle = GetUniformHandle(name);
+    Check(handle.IsValid(), name, " not found");
+    SetUniform(handle, GlUniformValue(value));
 }
 
 void GlProgram::SetUniform(const char *name, float value) {
-    ARCTIC_GL_CHECK_ERROR(glUniform1f(GetUniformLocation(name), value));
+    GlUniformHandle handle = GetUniformHandle(name);
+    Check(handle.IsValid(), name, " not found");
+    SetUniform(handle, GlUniformValue(value));
 }
 
 void GlProgram::SetUniform(const char *name, const Vec2F &value) {
-    ARCTIC_GL_CHECK_ERROR(glUniform2f(GetUniformLocation(name), value.x, value.y));
+    GlUniformHandle handle = GetUniformHandle(name);
+    Check(handle.IsValid(), name, " not found");
+    SetUniform(handle, GlUniformValue(value));
 }
 
 void GlProgram::SetUniform(const char *name, const Vec3F &value) {
-    ARCTIC_GL_CHECK_ERROR(glUniform3f(GetUniformLocation(name), value.x, value.y, value.z));
+    GlUniformHandle handle = GetUniformHandle(name);
+    Check(handle.IsValid(), name, " not found");
+    SetUniform(handle, GlUniformValue(value));
 }
 
 void GlProgram::SetUniform(const char *name, const Vec4F &value) {
-    ARCTIC_GL_CHECK_ERROR(glUniform4f(GetUniformLocation(name), value.x, value.y, value.z, value.w));
+    GlUniformHandle handle = GetUniformHandle(name);
+    Check(handle.IsValid(), name, " not found");
+    SetUniform(handle, GlUniformValue(value));
 }
 
 void GlProgram::CheckActiveUniforms(int required_count) {
+    if (!IsGlValidation()) {
+        return;
+    }
     GLint ufs;
     ARCTIC_GL_CHECK_ERROR(glGetProgramiv(program_id_, GL_ACTIVE_UNIFORMS, &ufs));
     Check(ufs == required_count, "Number of active uniforms does not match the required_count");
 }
 
 int GlProgram::GetUniformLocation(const char *name) const {
-    GLint loc;
-    ARCTIC_GL_CHECK_ERROR(loc = glGetUniformLocation(program_id_, name));
-    Check(loc >= 0, name, " not found");
-    return loc;
+    GlUniformHandle handle = GetUniformHandle(name);
+    Check(handle.IsValid(), name, " not found");
+    return uniforms_[static_cast<size_t>(handle.idx)].location;
 }
 
 
 
-UniformsTable::UniformData::UniformData() : type(UniformDataType::Int), value({ 0 }) {
+GlUniformValue::GlUniformValue()
+    : type(GlUniformType::Int), i{{0, 0, 0, 0}}, f{{0.f, 0.f, 0.f, 0.f}} {
+}
+
+GlUniformValue::GlUniformValue(int in_value)
+    : type(GlUniformType::Int), i{{in_value, 0, 0, 0}}, f{{0.f, 0.f, 0.f, 0.f}} {
+}
+
+GlUniformValue::GlUniformValue(const Vec2Si32 &in_value)
+    : type(GlUniformType::Int2), i{{in_value.x, in_value.y, 0, 0}},
+    f{{0.f, 0.f, 0.f, 0.f}} {
+}
+
+GlUniformValue::GlUniformValue(const Vec3Si32 &in_value)
+    : type(GlUniformType::Int3), i{{in_value.x, in_value.y, in_value.z, 0}},
+    f{{0.f, 0.f, 0.f, 0.f}} {
 }
 
-UniformsTable::UniformData &UniformsTable::UniformData::operator=(const UniformData &other) {
-    type = other.type;
-    memcpy(&value, &other.value, sizeof(value));
-    return *this;
+GlUniformValue::GlUniformValue(const Vec4Si32 &in_value)
+    : type(GlUniformType::Int4),
+    i{{in_value.x, in_value.y, in_value.z, in_value.w}},
+    f{{0.f, 0.f, 0.f, 0.f}} {
+}
+
+GlUniformValue::GlUniformValue(float in_value)
+    : type(GlUniformType::Float), i{{0, 0, 0, 0}}, f{{in_value, 0.f, 0.f, 0.f}} {
+}
+
+GlUniformValue::GlUniformValue(const Vec2F &in_value)
+    : type(GlUniformType::Float2), i{{0, 0, 0, 0}},
+    f{{in_value.x, in_value.y, 0.f, 0.f}} {
+}
+
+GlUniformValue::GlUniformValue(const Vec3F &in_value)
+    : type(GlUniformType::Float3), i{{0, 0, 0, 0}},
+    f{{in_value.x, in_value.y, in_value.z, 0.f}} {
+}
+
+GlUniformValue::GlUniformValue(const Vec4F &in_value)
+    : type(GlUniformType::Float4), i{{0, 0, 0, 0}},
+    f{{in_value.x, in_value.y, in_value.z, in_value.w}} {
 }
 
 void UniformsTable::Apply(GlProgram &program) const {
-    for (auto &uniform : table_) {
-        auto &name = uniform.first;
-        auto &data = uniform.second;
-
-        switch (data.type) {
-            case UniformDataType::Int:
-                program.SetUniform(name.data(), data.value.i);
-                break;
-            case UniformDataType::Int2:
-                program.SetUniform(name.data(), data.value.i2);
-                break;
-            case UniformDataType::Int3:
-                program.SetUniform(name.data(), data.value.i3);
-                break;
-            case UniformDataType::Int4:
-                program.SetUniform(name.data(), data.value.i4);
-                break;
-            case UniformDataType::Float:
-                program.SetUniform(name.data(), data.value.f);
-                break;
-            case UniformDataType::Float2:
-                program.SetUniform(name.data(), data.value.f2);
-                break;
-            case UniformDataType::Float3:
-                program.SetUniform(name.data(), data.value.f3);
-                break;
-            case UniformDataType::Float4:
-                program.SetUniform(name.data(), data.value.f4);
-                break;
+    if (handles_serial_ != program.Serial() || handles_.size() != table_.size()) {
+        handles_.clear();
+        for (const Entry &entry : table_) {
+            GlUniformHandle handle = program.GetUniformHandle(entry.name.c_str());
+            Check(handle.IsValid(), entry.name.c_str(), " not found");
+            handles_.push_back(handle);
         }
+        handles_serial_ = program.Serial();
+    }
+    for (size_t idx = 0; idx < table_.size(); ++idx) {
+        program.SetUniform(handles_[idx], table_[idx].value);
     }
 }
 
 void UniformsTable::Clear() {
     table_.clear();
+    handles_.clear();
+}
+
+void UniformsTable::Set(const std::string &name, const GlUniformValue &value) {
+    for (Entry &entry : table_) {
+        if (entry.name == name) {
+            entry.value = value;
+            return;
+        }
+    }
+    Entry entry;
+    entry.name = name;
+    entry.value = value;
+    table_.push_back(entry);
 }
 
 void UniformsTable::SetUniform(const std::string &name, int value) {
-    UniformData data;
-    data.type = UniformDataType::Int;
-    data.value.i = value;
-    table_.insert(std::make_pair(name, data));
+    Set(name, GlUniformValue(value));
 }
 
 void UniformsTable::SetUniform(const std::string &name, const Vec2Si32 &value) {
-    UniformData data;
-    data.type = UniformDataType::Int2;
-    data.value.i2 = value;
-    table_.insert(std::make_pair(name, data));
+    Set(name, GlUniformValue(value));
 }
 
 void UniformsTable::SetUniform(const std::string &name, const Vec3Si32 &value) {
-    UniformData data;
-    data.type = UniformDataType::Int3;
-    data.value.i3 = value;
-    table_.insert(std::make_pair(name, data));
+    Set(name, GlUniformValue(value));
 }
 
 void UniformsTable::SetUniform(const std::string &name, const Vec4Si32 &value) {
-    UniformData data;
-    data.type = UniformDataType::Int4;
-    data.value.i4 = value;
-    table_.insert(std::make_pair(name, data));
+    Set(name, GlUniformValue(value));
 }
 
 void UniformsTable::SetUniform(const std::string &name, float value) {
-    UniformData data;
-    data.type = UniformDataType::Float;
-    data.value.f = value;
-    table_.insert(std::make_pair(name, data));
+    Set(name, GlUniformValue(value));
 }
 
 void UniformsTable::SetUniform(const std::string &name, const Vec2F &value) {
-    UniformData data;
-    data.type = UniformDataType::Float2;
-    data.value.f2 = value;
-    table_.insert(std::make_pair(name, data));
+    Set(name, GlUniformValue(value));
 }
 
 void UniformsTable::SetUniform(const std::string &name, const Vec3F &value) {
-    UniformData data;
-    data.type = UniformDataType::Float3;
-    data.value.f3 = value;
-    table_.insert(std::make_pair(name, data));
+    Set(name, GlUniformValue(value));
 }
 
 void UniformsTable::SetUniform(const std::string &name, const Vec4F &value) {
-    UniformData data;
-    data.type = UniformDataType::Float4;
-    data.value.f4 = value;
-    table_.insert(std::make_pair(name, data));
+    Set(name, GlUniformValue(value));
 }
 
 size_t UniformsTable::Size() const {
@@ -23,8 +23,9 @@
 #ifndef ENGINE_GL_PROGRAM_H_
 #define ENGINE_GL_PROGRAM_H_
 
+#include <array>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 #include "engine/arctic_types.h"
 #include "engine/arctic_math.h"
@@ -35,6 +36,53 @@ namespace arctic {
 /// @addtogroup global_advanced
 /// @{
 
+/// @brief Type of the value stored in a GlUniformValue
+enum class GlUniformType {
+  Int,
+  Int2,
+  Int3,
+  Int4,
+  Float,
+  Float2,
+  Float3,
+  Float4,
+};
+
+/// @brief Typed value of a shader uniform
+struct GlUniformValue {
+  GlUniformValue();
+  explicit GlUniformValue(int value);
+  explicit GlUniformValue(const Vec2Si32 &value);
+  explicit GlUniformValue(const Vec3Si32 &value);
+  explicit GlUniformValue(const Vec4Si32 &value);
+  explicit GlUniformValue(float value);
+  explicit GlUniformValue(const Vec2F &value);
+  explicit GlUniformValue(const Vec3F &value);
+  explicit GlUniformValue(const Vec4F &value);
+
+  bool operator==(const GlUniformValue &other) const {
+    return type == other.type && i == other.i && f == other.f;
+  }
+  bool operator!=(const GlUniformValue &other) const {
+    return !(*this == other);
+  }
+
+  GlUniformType type;
+  /// @brief Components of an Int value, the unused ones are zero
+  std::array<int, 4> i;
+  /// @brief Components of a Float value, the unused ones are zero
+  std::array<float, 4> f;
+};
+
+/// @brief Index of an active uniform in the program uniform cache
+struct GlUniformHandle {
+  Si32 idx = -1;
+
+  bool IsValid() const {
+    return idx >= 0;
+  }
+};
+
 class GlProgram {
 private:
   GlProgram(GlProgram &other) = delete;
@@ -42,9 +90,23 @@ private:
   GlProgram &operator=(GlProgram &other) = delete;
   GlProgram &operator=(GlProgram &&other) = delete;
 
+  struct UniformInfo {
+    std::string name;
+    GLint location = -1;
+    // The value last sent to OpenGL, unchanged values are not sent again
+    bool has_value = false;
+    GlUniformValue value;
+  };
+
   GLuint program_id_;
+  Ui64 serial_;
+  std::vector<UniformInfo> uniforms_;
 
   static GLuint current_program_id_;
+  static Ui64 next_serial_;
+
+  void ReflectUniforms();
+  Si32 FindUniformByLocation(int location) const;
 
  public:
   GlProgram();
@@ -52,6 +114,22 @@ private:
 
   void Create(const char *vs_src, const char *fs_src);
   void Bind();
+  /// @brief Returns the number that changes each time the program is created
+  Ui64 Serial() const {
+    return serial_;
+  }
+  /// @brief Returns the handle of the active uniform or an invalid handle
+  GlUniformHandle GetUniformHandle(const char *name) const;
+  /// @brief Sets the uniform of the bound program unless it already has the value
+  void SetUniform(GlUniformHandle handle, const GlUniformValue &value);
+  void SetUniform(GlUniformHandle handle, int value);
+  void SetUniform(GlUniformHandle handle, const Vec2Si32 &value);
+  void SetUniform(GlUniformHandle handle, const Vec3Si32 &value);
+  void SetUniform(GlUniformHandle handle, const Vec4Si32 &value);
+  void SetUniform(GlUniformHandle handle, float value);
+  void SetUniform(GlUniformHandle handle, const Vec2F &value);
+  void SetUniform(GlUniformHandle handle, const Vec3F &value);
+  void SetUniform(GlUniformHandle handle, const Vec4F &value);
   void SetUniform(int id, int value);
   void SetUniform(int id, const Vec2Si32 &value);
   void SetUniform(int id, const Vec3Si32 &value);
@@ -68,41 +146,26 @@ private:
   void SetUniform(const char *name, const Vec2F &value);
   void SetUniform(const char *name, const Vec3F &value);
   void SetUniform(const char *name, const Vec4F &value);
+  /// @brief Checks the number of active uniforms while the validation is enabled
   void CheckActiveUniforms(int required_count);
+  /// @brief Returns the location of the active uniform from the uniform cache
   int GetUniformLocation(const char *name) const;
 };
 
+/// @brief Named uniform values applied to a program before drawing
+/// @details The names are resolved to the program uniform handles once per
+///  program, so Apply only walks a flat array.
 class UniformsTable {
-    enum class UniformDataType {
-        Int,
-        Int2,
-        Int3,
-        Int4,
-        Float,
-        Float2,
-        Float3,
-        Float4,
+    struct Entry {
+        std::string name;
+        GlUniformValue value;
     };
 
-    struct UniformData {
-        UniformData();
-
-        UniformData &operator=(const UniformData &other);
-
-        UniformDataType type;
-        union {
-            int i;
-            Vec2Si32 i2;
-            Vec3Si32 i3;
-            Vec4Si32 i4;
-            float f;
-            Vec2F f2;
-            Vec3F f3;
-            Vec4F f4;
-        } value;
-    };
+    std::vector<Entry> table_;
+    mutable std::vector<GlUniformHandle> handles_;
+    mutable Ui64 handles_serial_ = 0;
 
-    std::unordered_map<std::string, UniformData> table_;
+    void Set(const std::string &name, const GlUniformValue &value);
 
 public:
     void Apply(GlProgram &program) const;
@@ -92,6 +92,21 @@ void GlTexture2D::UpdateData(const void *data) {
     ARCTIC_GL_CHECK_ERROR(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, data));
 }
 
+void GlTexture2D::UpdateData(const void *data, Si32 x, Si32 y, Si32 w, Si32 h) {
+    Bind(0);
+    const Rgba *rows = static_cast<const Rgba*>(data) + static_cast<size_t>(y) * static_cast<size_t>(width_);
+#ifdef GL_UNPACK_ROW_LENGTH
+    ARCTIC_GL_CHECK_ERROR(glPixelStorei(GL_UNPACK_ROW_LENGTH, width_));
+    ARCTIC_GL_CHECK_ERROR(glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, w, h, GL_RGBA, GL_UNSIGNED_BYTE, rows + x));
+    ARCTIC_GL_CHECK_ERROR(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+#else
+    // OpenGL ES 2 can't skip the pixels between the rows, upload full rows.
+    (void)x;
+    (void)w;
+    ARCTIC_GL_CHECK_ERROR(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, width_, h, GL_RGBA, GL_UNSIGNED_BYTE, rows));
+#endif
+}
+
 /*void GlTexture2D::ReadData(void *dst) const {
     Bind(0);
     ARCTIC_GL_CHECK_ERROR(glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_UNSIGNED_BYTE, dst));
@@ -56,6 +56,7 @@ class GlTexture2D {
   void Bind(Ui32 slot) const;
   void SetData(const void *data, Si32 w, Si32 h);
   void UpdateData(const void *data);
+  void UpdateData(const void *data, Si32 x, Si32 y, Si32 w, Si32 h);
 //  void ReadData(void *dst) const;
   void SetFilterMode(DrawFilterMode filter_mode);
 
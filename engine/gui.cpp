@@ -29,6 +29,8 @@
 #include <memory>
 #include <utility>
 #include "engine/easy_advanced.h"
+#include "engine/easy_deferred_drawing.h"
+#include "engine/easy_dirty_rects.h"
 #include "engine/easy_drawing.h"
 #include "engine/easy_util.h"
 #include "engine/unicode.h"
@@ -517,6 +519,8 @@ void Text::SetText(std::string text) {
 void DrawSelection(Si32 x1, Si32 y1, Si32 x2, Si32 y2,
     TextSelectionMode selection_mode,
     Rgba c1, Rgba c2, Sprite backbuffer) {
+  FlushDeferredDrawingBeforeWrite(backbuffer);
+  MarkSpriteDirty(backbuffer, x1, y1, x2, y2);
   switch (selection_mode) {
     case kTextSelectionModeInvert:
       for (Si32 y = y1; y < y2; ++y) {
@@ -25,165 +25,604 @@
 
 #include "engine/log.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <condition_variable>  // NOLINT
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <mutex>  // NOLINT
 #include <sstream>
 #include <string>
 #include <thread>  // NOLINT
+#include <vector>
 
-#include "engine/mtq_mpsc_vinfarr.h"
 #include "engine/arctic_platform.h"
 
 namespace arctic {
 
-template <class TQueue, class TItem>
-class SyncQueue{
-  std::atomic<bool> is_going_to_sleep = ATOMIC_VAR_INIT(false);
-  std::mutex sleep_mutex;
-  std::condition_variable sleep_condvar;
-  TQueue queue;
+// A log message in the buffer of the thread that logged it. The header is
+// followed by the arguments, each is a type byte and the value bytes.
+struct LogRecordHeader {
+  Ui32 size;  // Size of the whole record, a multiple of kLogRecordAlignment.
+  Ui8 level;
+  Ui8 arg_count;
+  Ui16 reserved;
+  // nullptr for the Log functions, their arguments are just concatenated.
+  const char *format;
+};
+
+static const Ui32 kLogRecordAlignment = 8;
+// Level of the record that skips the rest of the ring to its start.
+static const Ui8 kLogRecordPadding = 255;
+static const Si32 kLogMaxArgCount = 64;
+static const Ui32 kLogMinThreadBufferSize = 4096;
+static const std::chrono::milliseconds kLoggerPollInterval(10);
 
+// Single producer single consumer ring of log records. The thread that owns
+// it writes the records and the logger thread reads them, so neither of
+// them ever waits for a lock.
+class LogRing {
  public:
-  void Enqueue(TItem *item) {
-    queue.enqueue(item);
-    if (is_going_to_sleep.load()) {
-      sleep_condvar.notify_one();
-    }
+  explicit LogRing(Ui32 capacity)
+    : data_(capacity)
+    , mask_(capacity - 1) {
   }
 
-  TItem* TryDequeue() {
-    return queue.dequeue();
+  Ui32 Capacity() const {
+    return static_cast<Ui32>(data_.size());
   }
 
-  TItem* SyncDequeue() {
-    TItem *item = queue.dequeue();
-    if (item) {
-      return item;
+  // Returns space for a record of size bytes, nullptr if the ring is full.
+  // Called by the owner thread only.
+  Ui8 *TryReserve(Ui32 size) {
+    const Ui64 offset = write_pos_ & mask_;
+    const Ui64 contiguous = Capacity() - offset;
+    // A record that does not fit the ring end starts over at the beginning.
+    const Ui64 needed = (size <= contiguous ? size : contiguous + size);
+    if (write_pos_ + needed - cached_read_pos_ > Capacity()) {
+      cached_read_pos_ = read_pos_.load(std::memory_order_acquire);
+      if (write_pos_ + needed - cached_read_pos_ > Capacity()) {
+        return nullptr;
+      }
     }
-    is_going_to_sleep.store(true);
-    {
-      while (true) {
-        item = queue.dequeue();
-        if (item) {
-          is_going_to_sleep.store(false);
-          return item;
-        }
-        {
-          std::unique_lock<std::mutex> lock(sleep_mutex);
-          sleep_condvar.wait(lock);
-        }
+    if (size > contiguous) {
+      LogRecordHeader padding;
+      memset(&padding, 0, sizeof(padding));
+      padding.size = static_cast<Ui32>(contiguous);
+      padding.level = kLogRecordPadding;
+      memcpy(&data_[offset], &padding, kLogRecordAlignment);
+      write_pos_ += contiguous;
+    }
+    return &data_[write_pos_ & mask_];
+  }
+
+  // Publishes the reserved record to the logger thread.
+  void Commit(Ui32 size) {
+    write_pos_ += size;
+    published_write_pos_.store(write_pos_, std::memory_order_release);
+  }
+
+  // Returns an upper estimate of the used space for the owner thread.
+  Ui64 UsedBytes() const {
+    return write_pos_ - cached_read_pos_;
+  }
+
+  // Calls process for each published record. Called by the logger only.
+  template<class TProcess>
+  void Drain(TProcess process) {
+    Ui64 read_pos = read_pos_.load(std::memory_order_relaxed);
+    const Ui64 write_pos =
+      published_write_pos_.load(std::memory_order_acquire);
+    while (read_pos < write_pos) {
+      const Ui8 *record = &data_[read_pos & mask_];
+      Ui32 size;
+      memcpy(&size, record, sizeof(size));
+      if (record[offsetof(LogRecordHeader, level)] != kLogRecordPadding) {
+        process(record);
       }
+      read_pos += size;
     }
+    read_pos_.store(read_pos, std::memory_order_release);
   }
+
+  bool IsEmpty() const {
+    return read_pos_.load(std::memory_order_acquire) ==
+      published_write_pos_.load(std::memory_order_acquire);
+  }
+
+  // Set when the owner thread exits, the logger deletes the ring once
+  // it is empty.
+  std::atomic<bool> is_orphaned = ATOMIC_VAR_INIT(false);
+
+ private:
+  std::vector<Ui8> data_;
+  Ui64 mask_;
+  // Owned by the writer thread.
+  Ui64 write_pos_ = 0;
+  Ui64 cached_read_pos_ = 0;
+  // Shared, the positions grow monotonically and never wrap.
+  std::atomic<Ui64> published_write_pos_ = ATOMIC_VAR_INIT(0);
+  std::atomic<Ui64> read_pos_ = ATOMIC_VAR_INIT(0);
 };
 
+struct ThreadLogState {
+  LogRing *ring = nullptr;
+  // Streams of the Log() calls kept for reuse.
+  std::vector<std::ostringstream*> streams;
+};
+
+struct ThreadLogStateOwner;
+
 static std::atomic<bool> g_is_log_enabled = ATOMIC_VAR_INIT(false);
-static SyncQueue<
-  MpscVirtInfArray<std::string*, TuneDeletePayloadFlag<true>>,
-  std::string> g_logger_queue;
+static std::atomic<bool> g_is_logger_quitting = ATOMIC_VAR_INIT(false);
+static std::atomic<bool> g_is_logger_wake_requested = ATOMIC_VAR_INIT(false);
+static std::atomic<Si32> g_log_level = ATOMIC_VAR_INIT(kLogLevelTrace);
+static std::atomic<Si32> g_log_overflow_policy =
+  ATOMIC_VAR_INIT(kLogOverflowBlock);
+static std::atomic<Si32> g_log_flush_policy =
+  ATOMIC_VAR_INIT(kLogFlushEveryBatch);
+static std::atomic<Si64> g_log_flush_interval_us = ATOMIC_VAR_INIT(1000000);
+static std::atomic<Ui32> g_log_thread_buffer_size = ATOMIC_VAR_INIT(65536);
+static std::atomic<Ui64> g_log_dropped_count = ATOMIC_VAR_INIT(0);
+static std::mutex g_log_rings_mutex;
+static std::vector<LogRing*> g_log_rings;
+static std::mutex g_logger_sleep_mutex;
+static std::condition_variable g_logger_condvar;
 static std::thread g_logger_thread;
-static std::string *g_quit_item = nullptr;
 static std::mutex g_quit_mutex;
+static thread_local ThreadLogState *g_thread_log_state = nullptr;
+static thread_local bool g_is_thread_log_state_destroyed = false;
 
-void LoggerThreadFunction() {
-    const char *file_name = "log.txt";
-    const char *newline = "\r\n";
-    std::ofstream out(file_name,
-      std::ios_base::binary | std::ios_base::out | std::ios_base::app);
-    Check(out.rdstate() != std::ios_base::failbit,
-      "Error in LoggerThreadFunction. Can't create/open the file, file_name: ",
-      file_name);
-    out.exceptions(std::ios_base::goodbit);
-    bool is_flush_needed = false;
-    while (true) {
-      std::string *message = g_logger_queue.TryDequeue();
-      if (!message) {
-        if (is_flush_needed) {
-          out.flush();
-          is_flush_needed = false;
-        }
-        message = g_logger_queue.SyncDequeue();
-      }
-      if (message == g_quit_item) {
-        if (is_flush_needed) {
-          out.flush();
-        }
-        out.close();
-        Check(!(out.rdstate() & std::ios_base::failbit),
-          "Error in LoggerThreadFunction. Can't close the file, file_name: ",
-          file_name);
-        delete message;
-        return;
-      }
-      is_flush_needed = true;
-      out.write(message->data(), static_cast<std::streamsize>(message->size()));
-      Check(!(out.rdstate() & std::ios_base::badbit),
-        "Error in LoggerThreadFunction. Can't write the file, file_name: ",
-        file_name);
-      out.write(newline, 2);
-      Check(!(out.rdstate() & std::ios_base::badbit),
-        "Error in LoggerThreadFunction. Can't write the file, file_name: ",
-        file_name);
+struct ThreadLogStateOwner {
+  ThreadLogState state;
+
+  ~ThreadLogStateOwner() {
+    for (std::ostringstream *stream : state.streams) {
+      delete stream;
+    }
+    if (state.ring) {
+      state.ring->is_orphaned.store(true, std::memory_order_release);
     }
+    g_thread_log_state = nullptr;
+    g_is_thread_log_state_destroyed = true;
   }
+};
 
-  void Log(const char *text) {
-    if (g_is_log_enabled.load()) {
-      std::string *str = new std::string(text);
-      g_logger_queue.Enqueue(str);
+// Returns nullptr if the thread is exiting and its state is destroyed.
+static ThreadLogState *GetThreadLogState() {
+  if (g_thread_log_state) {
+    return g_thread_log_state;
+  }
+  if (g_is_thread_log_state_destroyed) {
+    return nullptr;
+  }
+  static thread_local ThreadLogStateOwner owner;
+  g_thread_log_state = &owner.state;
+  return g_thread_log_state;
+}
+
+static void WakeLogger() {
+  if (!g_is_logger_wake_requested.load(std::memory_order_relaxed) &&
+      !g_is_logger_wake_requested.exchange(true)) {
+    g_logger_condvar.notify_one();
+  }
+}
+
+static void DropLogMessage() {
+  g_log_dropped_count.fetch_add(1, std::memory_order_relaxed);
+}
+
+LogArg::LogArg(const char *str)
+    : type(kString) {
+  if (!str) {
+    str = "(null)";
+  }
+  value.p = str;
+  length = static_cast<Ui32>(strlen(str));
+}
+
+LogArg::LogArg(const std::string &str)
+    : type(kString) {
+  value.p = str.data();
+  length = static_cast<Ui32>(str.size());
+}
+
+// Returns the string lengths that fit the record of at most max_size bytes.
+static Ui32 LogRecordSize(const LogArg *args, Si32 arg_count,
+    Ui32 max_size, Ui32 *string_lengths) {
+  Ui32 size = static_cast<Ui32>(sizeof(LogRecordHeader));
+  for (Si32 idx = 0; idx < arg_count; ++idx) {
+    size += 1 + static_cast<Ui32>(args[idx].type == LogArg::kString ?
+      sizeof(Ui32) : sizeof(args[idx].value));
+  }
+  // Long strings are cut so that the ring always fits the record.
+  Ui32 string_budget = (max_size > size ? max_size - size : 0);
+  for (Si32 idx = 0; idx < arg_count; ++idx) {
+    if (args[idx].type == LogArg::kString) {
+      string_lengths[idx] = std::min(args[idx].length, string_budget);
+      string_budget -= string_lengths[idx];
+      size += string_lengths[idx];
     }
   }
+  return (size + kLogRecordAlignment - 1) & ~(kLogRecordAlignment - 1);
+}
 
-  void Log(const char *text1, const char *text2) {
-    if (g_is_log_enabled.load()) {
-      std::string *str = new std::string(text1);
-      str->append(text2);
-      g_logger_queue.Enqueue(str);
+static void WriteLogRecord(LogLevel level, const char *format,
+    const LogArg *args, Si32 arg_count) {
+  if (!g_is_log_enabled.load(std::memory_order_relaxed)) {
+    return;
+  }
+  ThreadLogState *state = GetThreadLogState();
+  if (!state) {
+    DropLogMessage();
+    return;
+  }
+  if (!state->ring) {
+    Ui32 capacity = kLogMinThreadBufferSize;
+    while (capacity < g_log_thread_buffer_size.load()) {
+      capacity *= 2;
     }
+    state->ring = new LogRing(capacity);
+    std::lock_guard<std::mutex> lock(g_log_rings_mutex);
+    g_log_rings.push_back(state->ring);
   }
+  LogRing &ring = *state->ring;
+  arg_count = std::min(arg_count, kLogMaxArgCount);
+  Ui32 string_lengths[kLogMaxArgCount];
+  const Ui32 size = LogRecordSize(args, arg_count, ring.Capacity() / 2,
+    string_lengths);
 
-  void Log(const char *text1, const char *text2, const char *text3) {
-    if (g_is_log_enabled.load()) {
-      std::string *str = new std::string(text1);
-      str->append(text2);
-      str->append(text3);
-      g_logger_queue.Enqueue(str);
+  Ui8 *record = ring.TryReserve(size);
+  if (!record) {
+    WakeLogger();
+    if (g_log_overflow_policy.load(std::memory_order_relaxed) ==
+        kLogOverflowDrop) {
+      DropLogMessage();
+      return;
+    }
+    while (!(record = ring.TryReserve(size))) {
+      if (!g_is_log_enabled.load()) {
+        DropLogMessage();
+        return;
+      }
+      WakeLogger();
+      std::this_thread::yield();
     }
   }
 
-  void LogAndDelete(std::ostringstream *str) {
-    Check(str, "Unexpected nullptr in LogAndDelete call");
-    if (g_is_log_enabled.load()) {
-      std::string *p = new std::string(str->str());
-      g_logger_queue.Enqueue(p);
+  LogRecordHeader header;
+  memset(&header, 0, sizeof(header));
+  header.size = size;
+  header.level = static_cast<Ui8>(level);
+  header.arg_count = static_cast<Ui8>(arg_count);
+  header.format = format;
+  memcpy(record, &header, sizeof(header));
+  Ui8 *p = record + sizeof(header);
+  for (Si32 idx = 0; idx < arg_count; ++idx) {
+    const LogArg &arg = args[idx];
+    *p = static_cast<Ui8>(arg.type);
+    ++p;
+    if (arg.type == LogArg::kString) {
+      memcpy(p, &string_lengths[idx], sizeof(Ui32));
+      p += sizeof(Ui32);
+      memcpy(p, arg.value.p, string_lengths[idx]);
+      p += string_lengths[idx];
+    } else {
+      memcpy(p, &arg.value, sizeof(arg.value));
+      p += sizeof(arg.value);
     }
-    delete str;
   }
+  ring.Commit(size);
+  if (level >= kLogLevelError || ring.UsedBytes() > ring.Capacity() / 2) {
+    WakeLogger();
+  }
+}
+
+static void AppendLogArg(const LogArg &arg, std::string *out) {
+  char buffer[32];
+  buffer[0] = '\0';
+  switch (arg.type) {
+    case LogArg::kNone:
+      break;
+    case LogArg::kSigned:
+      snprintf(buffer, sizeof(buffer), "%lld",
+        static_cast<long long>(arg.value.i));  // NOLINT
+      break;
+    case LogArg::kUnsigned:
+      snprintf(buffer, sizeof(buffer), "%llu",
+        static_cast<unsigned long long>(arg.value.u));  // NOLINT
+      break;
+    case LogArg::kDouble:
+      snprintf(buffer, sizeof(buffer), "%g", arg.value.d);
+      break;
+    case LogArg::kBool:
+      out->append(arg.value.u ? "true" : "false");
+      break;
+    case LogArg::kChar:
+      out->push_back(static_cast<char>(arg.value.i));
+      break;
+    case LogArg::kString:
+      out->append(static_cast<const char*>(arg.value.p), arg.length);
+      break;
+    case LogArg::kPointer:
+      snprintf(buffer, sizeof(buffer), "%p", arg.value.p);
+      break;
+  }
+  out->append(buffer);
+}
+
+static void AppendLogMessage(const char *format,
+    const LogArg *args, Si32 arg_count, std::string *out) {
+  if (!format) {
+    for (Si32 idx = 0; idx < arg_count; ++idx) {
+      AppendLogArg(args[idx], out);
+    }
+    return;
+  }
+  Si32 next_arg = 0;
+  for (const char *c = format; *c; ++c) {
+    if (c[0] == '{' && c[1] == '}' && next_arg < arg_count) {
+      AppendLogArg(args[next_arg], out);
+      ++next_arg;
+      ++c;
+    } else {
+      out->push_back(*c);
+    }
+  }
+  // The arguments with no {} left go to the message end.
+  for (; next_arg < arg_count; ++next_arg) {
+    out->push_back(' ');
+    AppendLogArg(args[next_arg], out);
+  }
+}
 
-  std::unique_ptr<std::ostringstream, void(*)(std::ostringstream *str)> Log() {
-    return std::unique_ptr<std::ostringstream, void(*)(std::ostringstream *str)>
-      (new std::ostringstream, LogAndDelete);
+// Formats the record as a line of the log file. Returns its level.
+static Ui8 AppendLogRecord(const Ui8 *record, LogArg *args,
+    std::string *out) {
+  LogRecordHeader header;
+  memcpy(&header, record, sizeof(header));
+  const Ui8 *p = record + sizeof(header);
+  for (Si32 idx = 0; idx < header.arg_count; ++idx) {
+    LogArg &arg = args[idx];
+    arg.type = static_cast<LogArg::Type>(*p);
+    ++p;
+    if (arg.type == LogArg::kString) {
+      memcpy(&arg.length, p, sizeof(Ui32));
+      p += sizeof(Ui32);
+      arg.value.p = p;
+      p += arg.length;
+    } else {
+      memcpy(&arg.value, p, sizeof(arg.value));
+      p += sizeof(arg.value);
+    }
+  }
+  static const char *kLevelPrefixes[] = {
+    "[trace] ", "[debug] ", "", "[warning] ", "[error] "};
+  if (header.level < sizeof(kLevelPrefixes) / sizeof(kLevelPrefixes[0])) {
+    out->append(kLevelPrefixes[header.level]);
   }
+  AppendLogMessage(header.format, args, header.arg_count, out);
+  out->append("\r\n");
+  return header.level;
+}
 
-  void StartLogger() {
-    std::lock_guard<std::mutex> lock(g_quit_mutex);
-    Check(g_quit_item == nullptr,
-        "StartLogger called with g_quit_item already initialized");
-    g_is_log_enabled.store(true);
-    g_quit_item = new std::string("g_quit_item");
-    g_logger_thread = std::thread(arctic::LoggerThreadFunction);
+static void ReleaseOrphanedLogRings() {
+  std::lock_guard<std::mutex> lock(g_log_rings_mutex);
+  for (size_t idx = 0; idx < g_log_rings.size();) {
+    LogRing *ring = g_log_rings[idx];
+    if (ring->is_orphaned.load(std::memory_order_acquire) &&
+        ring->IsEmpty()) {
+      delete ring;
+      g_log_rings[idx] = g_log_rings.back();
+      g_log_rings.pop_back();
+    } else {
+      ++idx;
+    }
   }
+}
 
-  void StopLogger() {
-    std::lock_guard<std::mutex> lock(g_quit_mutex);
-    if (g_quit_item == nullptr) {
+void LoggerThreadFunction() {
+  const char *file_name = "log.txt";
+  std::ofstream out(file_name,
+    std::ios_base::binary | std::ios_base::out | std::ios_base::app);
+  Check(out.rdstate() != std::ios_base::failbit,
+    "Error in LoggerThreadFunction. Can't create/open the file, file_name: ",
+    file_name);
+  out.exceptions(std::ios_base::goodbit);
+  // Messages of all the threads are formatted into one batch
+  // that is written at once.
+  std::string batch;
+  std::vector<LogRing*> rings;
+  LogArg args[kLogMaxArgCount];
+  Ui64 reported_dropped_count = g_log_dropped_count.load();
+  bool is_flush_needed = false;
+  std::chrono::steady_clock::time_point flush_time =
+    std::chrono::steady_clock::now();
+  while (true) {
+    const bool is_quitting = g_is_logger_quitting.load();
+    {
+      std::lock_guard<std::mutex> lock(g_log_rings_mutex);
+      rings = g_log_rings;
+    }
+    bool has_error = false;
+    for (LogRing *ring : rings) {
+      ring->Drain([&](const Ui8 *record) {
+        if (AppendLogRecord(record, args, &batch) >= kLogLevelError) {
+          has_error = true;
+        }
+      });
+    }
+    const Ui64 dropped_count = g_log_dropped_count.load();
+    if (dropped_count != reported_dropped_count) {
+      batch.append("Log dropped ");
+      batch.append(std::to_string(dropped_count - reported_dropped_count));
+      batch.append(" messages\r\n");
+      reported_dropped_count = dropped_count;
+    }
+    if (!batch.empty()) {
+      out.write(batch.data(), static_cast<std::streamsize>(batch.size()));
+      Check(!(out.rdstate() & std::ios_base::badbit),
+        "Error in LoggerThreadFunction. Can't write the file, file_name: ",
+        file_name);
+      batch.clear();
+      is_flush_needed = true;
+    }
+    if (is_flush_needed) {
+      const std::chrono::steady_clock::time_point now =
+        std::chrono::steady_clock::now();
+      bool is_flush_due = has_error;
+      switch (g_log_flush_policy.load()) {
+        case kLogFlushEveryBatch:
+          is_flush_due = true;
+          break;
+        case kLogFlushPeriodically:
+          is_flush_due = is_flush_due || now - flush_time >=
+            std::chrono::microseconds(g_log_flush_interval_us.load());
+          break;
+        default:
+          break;
+      }
+      if (is_flush_due) {
+        out.flush();
+        is_flush_needed = false;
+        flush_time = now;
+      }
+    }
+    ReleaseOrphanedLogRings();
+    if (is_quitting) {
+      out.close();
+      Check(!(out.rdstate() & std::ios_base::failbit),
+        "Error in LoggerThreadFunction. Can't close the file, file_name: ",
+        file_name);
       return;
     }
-    g_is_log_enabled.store(false);
-    g_logger_queue.Enqueue(g_quit_item);
-    g_logger_thread.join();
-    g_quit_item = nullptr;
+    std::unique_lock<std::mutex> lock(g_logger_sleep_mutex);
+    g_logger_condvar.wait_for(lock, kLoggerPollInterval, [] {
+      return g_is_logger_wake_requested.load() ||
+        g_is_logger_quitting.load();
+    });
+    g_is_logger_wake_requested.store(false);
   }
+}
+
+void Log(const char *text) {
+  if (IsLogLevelEnabled(kLogLevelInfo)) {
+    const LogArg args[] = {LogArg(text)};
+    WriteLogRecord(kLogLevelInfo, nullptr, args, 1);
+  }
+}
+
+void Log(const char *text1, const char *text2) {
+  if (IsLogLevelEnabled(kLogLevelInfo)) {
+    const LogArg args[] = {LogArg(text1), LogArg(text2)};
+    WriteLogRecord(kLogLevelInfo, nullptr, args, 2);
+  }
+}
+
+void Log(const char *text1, const char *text2, const char *text3) {
+  if (IsLogLevelEnabled(kLogLevelInfo)) {
+    const LogArg args[] = {LogArg(text1), LogArg(text2), LogArg(text3)};
+    WriteLogRecord(kLogLevelInfo, nullptr, args, 3);
+  }
+}
+
+void LogFormatArgs(LogLevel level, const char *format,
+    const LogArg *args, Si32 arg_count) {
+  if (IsLogLevelEnabled(level)) {
+    WriteLogRecord(level, format, args, arg_count);
+  }
+}
+
+std::string FormatLogMessage(const char *format,
+    const LogArg *args, Si32 arg_count) {
+  std::string message;
+  AppendLogMessage(format, args, arg_count, &message);
+  return message;
+}
+
+void LogAndRecycle(std::ostringstream *str) {
+  Check(str, "Unexpected nullptr in LogAndRecycle call");
+  if (g_is_log_enabled.load(std::memory_order_relaxed) &&
+      IsLogLevelEnabled(kLogLevelInfo)) {
+    const std::string text = str->str();
+    const LogArg args[] = {LogArg(text)};
+    WriteLogRecord(kLogLevelInfo, nullptr, args, 1);
+  }
+  ThreadLogState *state = GetThreadLogState();
+  if (state && state->streams.size() < 4) {
+    str->str(std::string());
+    str->clear();
+    state->streams.push_back(str);
+  } else {
+    delete str;
+  }
+}
+
+std::unique_ptr<std::ostringstream, void(*)(std::ostringstream *str)> Log() {
+  std::ostringstream *str = nullptr;
+  ThreadLogState *state = GetThreadLogState();
+  if (state && !state->streams.empty()) {
+    str = state->streams.back();
+    state->streams.pop_back();
+  } else {
+    str = new std::ostringstream;
+  }
+  return std::unique_ptr<std::ostringstream, void(*)(std::ostringstream *str)>
+    (str, LogAndRecycle);
+}
+
+void SetLogLevel(LogLevel level) {
+  g_log_level.store(level);
+}
+
+bool IsLogLevelEnabled(LogLevel level) {
+  return level >= g_log_level.load(std::memory_order_relaxed) &&
+    level < kLogLevelOff;
+}
+
+void SetLogOverflowPolicy(LogOverflowPolicy policy) {
+  g_log_overflow_policy.store(policy);
+}
+
+void SetLogFlushPolicy(LogFlushPolicy policy, double interval_seconds) {
+  g_log_flush_interval_us.store(static_cast<Si64>(interval_seconds * 1e6));
+  g_log_flush_policy.store(policy);
+}
+
+void SetLogThreadBufferSize(Si32 size_bytes) {
+  g_log_thread_buffer_size.store(static_cast<Ui32>(
+    std::max(size_bytes, static_cast<Si32>(kLogMinThreadBufferSize))));
+}
+
+Ui64 GetLogDroppedMessageCount() {
+  return g_log_dropped_count.load();
+}
+
+void StartLogger() {
+  std::lock_guard<std::mutex> lock(g_quit_mutex);
+  Check(!g_logger_thread.joinable(),
+      "StartLogger called with the logger already started");
+  g_is_logger_quitting.store(false);
+  g_is_log_enabled.store(true);
+  g_logger_thread = std::thread(arctic::LoggerThreadFunction);
+}
+
+void StopLogger() {
+  std::lock_guard<std::mutex> lock(g_quit_mutex);
+  if (!g_logger_thread.joinable()) {
+    return;
+  }
+  g_is_log_enabled.store(false);
+  {
+    std::lock_guard<std::mutex> sleep_lock(g_logger_sleep_mutex);
+    g_is_logger_quitting.store(true);
+  }
+  g_logger_condvar.notify_one();
+  g_logger_thread.join();
+}
+
 }  // namespace arctic
@@ -26,33 +26,187 @@
 #include <memory>
 //#include <sstream>
 #include <iosfwd>
+#include <string>
+#include <type_traits>
 #include "engine/arctic_types.h"
 
+/// @brief Log messages below this level are compiled out of ARCTIC_LOG
+#ifndef ARCTIC_LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define ARCTIC_LOG_MIN_LEVEL 2
+#else
+#define ARCTIC_LOG_MIN_LEVEL 0
+#endif  // NDEBUG
+#endif  // ARCTIC_LOG_MIN_LEVEL
+
+/// @brief Writes a formatted message to log if the level is enabled
+/// @details The arguments are not evaluated for the disabled levels.
+///  Usage example:
+/// @code
+///   ARCTIC_LOG_DEBUG("Entity {} moved to {}, {}", id, pos.x, pos.y);
+/// @endcode
+#define ARCTIC_LOG(level, ...) \
+  do { \
+    if ((level) >= ARCTIC_LOG_MIN_LEVEL && \
+        ::arctic::IsLogLevelEnabled(level)) { \
+      ::arctic::LogFormat((level), __VA_ARGS__); \
+    } \
+  } while (false)
+#define ARCTIC_LOG_TRACE(...) ARCTIC_LOG(::arctic::kLogLevelTrace, __VA_ARGS__)
+#define ARCTIC_LOG_DEBUG(...) ARCTIC_LOG(::arctic::kLogLevelDebug, __VA_ARGS__)
+#define ARCTIC_LOG_INFO(...) ARCTIC_LOG(::arctic::kLogLevelInfo, __VA_ARGS__)
+#define ARCTIC_LOG_WARNING(...) \
+  ARCTIC_LOG(::arctic::kLogLevelWarning, __VA_ARGS__)
+#define ARCTIC_LOG_ERROR(...) ARCTIC_LOG(::arctic::kLogLevelError, __VA_ARGS__)
+
 namespace arctic {
 
 /// @addtogroup global_log
 /// @{
 
-/// @brief Writes message text to log
+/// @brief Severity of a log message
+enum LogLevel {
+  kLogLevelTrace = 0,
+  kLogLevelDebug = 1,
+  kLogLevelInfo = 2,  ///< Level of the messages of the Log functions.
+  kLogLevelWarning = 3,
+  kLogLevelError = 4,  ///< Error messages are flushed right away.
+  kLogLevelOff = 5
+};
+
+/// @brief What a thread does when its log buffer is full
+enum LogOverflowPolicy {
+  kLogOverflowBlock = 0,  ///< Wait for the logger thread, lose nothing.
+  kLogOverflowDrop = 1  ///< Drop the message and count it.
+};
+
+/// @brief When the logger thread flushes the log file
+enum LogFlushPolicy {
+  kLogFlushEveryBatch = 0,  ///< After each write of the pending messages.
+  kLogFlushPeriodically = 1,  ///< At most once per flush interval.
+  kLogFlushOnStop = 2  ///< Only when the logger stops.
+};
+
+/// @brief An argument of a formatted log message
+/// @details Strings are copied when the message is logged, the rest of
+///  the formatting is done by the logger thread.
+struct LogArg {
+  enum Type {
+    kNone = 0,
+    kSigned,
+    kUnsigned,
+    kDouble,
+    kBool,
+    kChar,
+    kString,
+    kPointer
+  };
+  Type type = kNone;
+  union {
+    Si64 i;
+    Ui64 u;
+    double d;
+    const void *p;
+  } value = {0};
+  Ui32 length = 0;  ///< Length of the kString argument.
+
+  LogArg() {
+  }
+  LogArg(bool b) : type(kBool) {  // NOLINT
+    value.u = b ? 1 : 0;
+  }
+  LogArg(char c) : type(kChar) {  // NOLINT
+    value.i = c;
+  }
+  template<typename T, typename std::enable_if<std::is_integral<T>::value &&
+    std::is_signed<T>::value, int>::type = 0>
+  LogArg(T i) : type(kSigned) {  // NOLINT
+    value.i = static_cast<Si64>(i);
+  }
+  template<typename T, typename std::enable_if<std::is_integral<T>::value &&
+    std::is_unsigned<T>::value, int>::type = 0>
+  LogArg(T u) : type(kUnsigned) {  // NOLINT
+    value.u = static_cast<Ui64>(u);
+  }
+  template<typename T, typename std::enable_if<std::is_enum<T>::value,
+    int>::type = 0>
+  LogArg(T e) : type(kSigned) {  // NOLINT
+    value.i = static_cast<Si64>(e);
+  }
+  LogArg(double d) : type(kDouble) {  // NOLINT
+    value.d = d;
+  }
+  LogArg(const char *str);  // NOLINT
+  LogArg(const std::string &str);  // NOLINT
+  LogArg(const void *p) : type(kPointer) {  // NOLINT
+    value.p = p;
+  }
+};
+
+/// @brief Writes message text to log at the info level
 void Log(const char *text);
 
-/// @brief Writes message text to log
+/// @brief Writes message text to log at the info level
 void Log(const char *text1, const char *text2);
 
-/// @brief Writes message text to log
+/// @brief Writes message text to log at the info level
 void Log(const char *text1, const char *text2, const char *text3);
 
-/// @brief Provides a streaming interface to write log
+/// @brief Writes a formatted message to log
+/// @param [in] level Severity of the message.
+/// @param [in] format Message text, each {} is replaced with the next
+///  argument. Must stay valid until the logger stops, use string literals.
+/// @param [in] args Arguments of the message.
+/// @param [in] arg_count Number of the arguments.
+void LogFormatArgs(LogLevel level, const char *format,
+  const LogArg *args, Si32 arg_count);
+
+/// @brief Writes a formatted message to log
+/// @details See LogFormatArgs, prefer the ARCTIC_LOG macros.
+template<typename... Args>
+void LogFormat(LogLevel level, const char *format, const Args &...args) {
+  const LogArg log_args[] = {LogArg(args)..., LogArg()};
+  LogFormatArgs(level, format, log_args, static_cast<Si32>(sizeof...(Args)));
+}
+
+/// @brief Formats a log message just like the logger thread does
+std::string FormatLogMessage(const char *format,
+  const LogArg *args, Si32 arg_count);
+
+/// @brief Provides a streaming interface to write log at the info level
 /// Usage example:
 /// @code
 ///   *Log() << "Hello World!";
 /// @endcode
 std::unique_ptr<std::ostringstream, void(*)(std::ostringstream *str)> Log();
 
+/// @brief Sets the lowest level of the messages to write
+void SetLogLevel(LogLevel level);
+
+/// @brief Returns true if the messages of the level are written
+bool IsLogLevelEnabled(LogLevel level);
+
+/// @brief Sets what a thread does when its log buffer is full
+void SetLogOverflowPolicy(LogOverflowPolicy policy);
+
+/// @brief Sets when the log file is flushed
+/// @param [in] policy Flush policy.
+/// @param [in] interval_seconds Flush interval of kLogFlushPeriodically.
+void SetLogFlushPolicy(LogFlushPolicy policy, double interval_seconds = 1.0);
+
+/// @brief Sets the size of the log buffers of the threads that log next
+/// @details Each thread that logs gets its own buffer. The size is
+///  rounded up to a power of two of at least 4 KiB.
+void SetLogThreadBufferSize(Si32 size_bytes);
+
+/// @brief Returns the number of messages dropped since the start
+Ui64 GetLogDroppedMessageCount();
+
 /// @brief Starts the logger
 void StartLogger();
 
 /// @brief Stops the logger
+/// @details Writes all the messages logged before the call.
 void StopLogger();
 
 /// @}
@@ -895,65 +895,71 @@ bool Mesh::Expand(int nv, int nf) {
    }*/
 
 int Mesh::Compact() {
+  // one remap shared by all the streams, they are indexed by the same faces
+  int numSrcVerts = 0;
   for (int j=0; j<mVertexData.mNumVertexArrays; j++) {
-    MeshVertexArray *va = mVertexData.mVertexArray + j;
-
-    const int numSrcVerts = va->mNum;
-
-    const int stride = va->mFormat.mStride;
+    const int num = mVertexData.mVertexArray[j].mNum;
+    numSrcVerts = (num > numSrcVerts) ? num : numSrcVerts;
+  }
+  if (numSrcVerts == 0) {
+    return 1;
+  }
 
-    std::vector<char> tmp;
-    tmp.reserve(numSrcVerts * stride);
+  int *remap = (int*)malloc(numSrcVerts * sizeof(int));
+  if (!remap) {
+    return 0;
+  }
+  memset(remap, 0, numSrcVerts * sizeof(int));
 
-    int *tmpHis = (int*)malloc(numSrcVerts * sizeof(int));
-    if (!tmpHis) {
-      return 0;
-    }
-    memset(tmpHis, 0, numSrcVerts * sizeof(int));
-
-    const int numf = mFaceData.mIndexArray[0].mNum;
-    for (int i=0; i<numf; i++) {
-      const MeshFace *fa = mFaceData.mIndexArray[0].mBuffer + i;
-      const int nv = 3;
-      for (int j=0; j<nv; j++) {
-        tmpHis[ fa->mIndex[j] ] += 1;
-      }
+  const int numf = mFaceData.mIndexArray[0].mNum;
+  for (int i=0; i<numf; i++) {
+    const MeshFace *fa = mFaceData.mIndexArray[0].mBuffer + i;
+    const int nv = 3;
+    for (int k=0; k<nv; k++) {
+      remap[ fa->mIndex[k] ] = 1;
     }
+  }
 
-    int num = 0;
-    for (int i=0; i<numSrcVerts; i++) {
-      if (tmpHis[i] > 0) {
-        for (Si32 idx = 0; idx < stride; ++idx) {
-          tmp.emplace_back(*((char*)va->mBuffer + stride*i + idx));
-        }
+  // keep the used vertices in their original order
+  int num = 0;
+  for (int i=0; i<numSrcVerts; i++) {
+    remap[i] = remap[i] ? num++ : -1;
+  }
 
-        // change all references
-        for (int j=0; j<numf; j++) {
-          MeshFace *fa = mFaceData.mIndexArray[0].mBuffer + j;
-          const int nv = 3;
-          for (int k=0; k<nv; k++) {
-            if (fa->mIndex[k] == i) {
-              fa->mIndex[k] = num;
-            }
-          }
+  for (int j=0; j<mVertexData.mNumVertexArrays; j++) {
+    MeshVertexArray *va = mVertexData.mVertexArray + j;
+    const int stride = va->mFormat.mStride;
+    int numDst = 0;
+    for (unsigned int i=0; i<va->mNum; i++) {
+      if (remap[i] != -1) {
+        if (remap[i] != (int)i) {
+          memcpy((char*)va->mBuffer + stride*remap[i],
+            (char*)va->mBuffer + stride*i, stride);
         }
-        num++;
+        numDst++;
       }
     }
-
-    free(va->mBuffer);
-    va->mBuffer = malloc(num*stride);
-    if (!va->mBuffer) {
-      free(tmpHis);
-      return 0;
+    if (numDst > 0) {
+      void *buffer = realloc(va->mBuffer, numDst*stride);
+      if (!buffer) {
+        free(remap);
+        return 0;
+      }
+      va->mBuffer = buffer;
     }
-    memcpy(va->mBuffer, &tmp[0], num*stride);
-    va->mNum = num;
-    va->mMax = num;
+    va->mNum = numDst;
+    va->mMax = numDst;
+  }
 
-    free(tmpHis);
+  for (int i=0; i<numf; i++) {
+    MeshFace *fa = mFaceData.mIndexArray[0].mBuffer + i;
+    const int nv = 3;
+    for (int k=0; k<nv; k++) {
+      fa->mIndex[k] = remap[ fa->mIndex[k] ];
+    }
   }
 
+  free(remap);
   return 1;
 }
 
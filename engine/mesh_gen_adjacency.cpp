@@ -47,34 +47,33 @@ bool MeshAdjacency_Init(MeshAdjacency *me, const Mesh *mesh) {
   me->nmax = numf*4;
   me->numaristas = 0;
   me->arisaux = (MeshEdge*)malloc(me->nmax*sizeof(MeshEdge));
+  me->mVertexValence = nullptr;
   if (!me->arisaux) {
-    return 0;
+    return false;
   }
   memset(me->arisaux, 0, me->nmax*sizeof(MeshEdge));
 
-  for (int i=0; i<numf; i++) {
-    MeshFace *face = mesh->mFaceData.mIndexArray[0].mBuffer + i;
-    const int fv = 3;
-    for (int j=0; j<fv; j++) {
-      const int v0 = face->mIndex[j];
-      const int v1 = face->mIndex[(j+1)%fv];
-      const int ed = MeshAdjacency_GetEdgeIDContainingVerts(me, v0, v1);
-
-      if (ed==-1) {
-        const int id = me->numaristas++;
-        me->arisaux[id].v0 = (v0>v1)?v0:v1;
-        me->arisaux[id].v1 = (v0<v1)?v0:v1;
-        me->arisaux[id].va = 1;
-      } else {
-        me->arisaux[ed].va = 2;
-      }
-    }
+  MeshHalfEdges he;
+  if (!MeshHalfEdges_Init(&he, mesh)) {
+    MeshAdjacency_DeInit(me);
+    return false;
+  }
+  for (int i=0; i<he.mNumEdges; i++) {
+    const int h = he.mEdgeHalf[i];
+    const int v0 = MeshHalfEdges_GetVertex(&he, h);
+    const int v1 = MeshHalfEdges_GetVertex(&he, MeshHalfEdges_GetNext(h));
+    me->arisaux[i].v0 = (v0>v1)?v0:v1;
+    me->arisaux[i].v1 = (v0<v1)?v0:v1;
+    me->arisaux[i].va = (he.mEdgeValence[i]>1) ? 2 : 1;
   }
+  me->numaristas = he.mNumEdges;
+  MeshHalfEdges_DeInit(&he);
 
   //----------------
   const int num = mesh->mVertexData.mVertexArray[0].mNum;
   me->mVertexValence = (char*)malloc(num);
   if (!me->mVertexValence) {
+    MeshAdjacency_DeInit(me);
     return false;
   }
   memset(me->mVertexValence, 0, num);
@@ -91,5 +90,187 @@ int MeshAdjacency_GetNumEdges(MeshAdjacency *me) {
   return me->numaristas;
 }
 
+//--------------------------------------------------------------------------
+
+static inline unsigned long long EdgeKey(int a, int b) {
+  const unsigned int ma = (unsigned int)((a>b)?a:b);
+  const unsigned int mi = (unsigned int)((a<b)?a:b);
+  return ((unsigned long long)mi << 32) | ma;
+}
+
+static inline unsigned int EdgeHash(unsigned long long key) {
+  key *= 0x9E3779B97F4A7C15ull;
+  return (unsigned int)(key >> 32);
+}
+
+static const unsigned long long kEmptyEdgeKey = ~0ull;
+
+int MeshHalfEdges_GetVertex(const MeshHalfEdges *me, int halfEdge) {
+  const MeshFace *face = me->mMesh->mFaceData.mIndexArray[0].mBuffer +
+    halfEdge/3;
+  return face->mIndex[halfEdge%3];
+}
+
+bool MeshHalfEdges_Init(MeshHalfEdges *me, const Mesh *mesh) {
+  *me = MeshHalfEdges();
+  me->mMesh = mesh;
+  const int numf = mesh->mFaceData.mIndexArray[0].mNum;
+  const int numv = mesh->mVertexData.mVertexArray[0].mNum;
+  const int numh = numf*3;
+  me->mNumFaces = numf;
+  me->mNumVerts = numv;
+
+  // at least half of the map stays empty
+  unsigned int cap = 16;
+  while (cap < (unsigned int)numh*2) {
+    cap <<= 1;
+  }
+  me->mMapMask = cap - 1;
+
+  const int numa = (numh > 0) ? numh : 1;
+
+  me->mTwin = (int*)malloc(numa*sizeof(int));
+  me->mEdge = (int*)malloc(numa*sizeof(int));
+  me->mEdgeHalf = (int*)malloc(numa*sizeof(int));
+  me->mEdgeValence = (int*)malloc(numa*sizeof(int));
+  me->mVertFaceStart = (int*)malloc((numv+1)*sizeof(int));
+  me->mVertFaces = (int*)malloc(numa*sizeof(int));
+  me->mMapKeys = (unsigned long long*)malloc(cap*sizeof(unsigned long long));
+  me->mMapEdges = (int*)malloc(cap*sizeof(int));
+  if (!me->mTwin || !me->mEdge || !me->mEdgeHalf || !me->mEdgeValence ||
+      !me->mVertFaceStart || !me->mVertFaces || !me->mMapKeys ||
+      !me->mMapEdges) {
+    MeshHalfEdges_DeInit(me);
+    return false;
+  }
+  memset(me->mMapKeys, 0xff, cap*sizeof(unsigned long long));
+
+  const MeshFace *faces = mesh->mFaceData.mIndexArray[0].mBuffer;
+
+  // edges and twins
+  int nume = 0;
+  for (int h=0; h<numh; h++) {
+    const int v0 = faces[h/3].mIndex[h%3];
+    const int v1 = faces[h/3].mIndex[(h%3 == 2) ? 0 : h%3 + 1];
+    const unsigned long long key = EdgeKey(v0, v1);
+    unsigned int slot = EdgeHash(key) & me->mMapMask;
+    while (me->mMapKeys[slot] != kEmptyEdgeKey && me->mMapKeys[slot] != key) {
+      slot = (slot + 1) & me->mMapMask;
+    }
+    me->mTwin[h] = -1;
+    if (me->mMapKeys[slot] == kEmptyEdgeKey) {
+      me->mMapKeys[slot] = key;
+      me->mMapEdges[slot] = nume;
+      me->mEdgeHalf[nume] = h;
+      me->mEdgeValence[nume] = 1;
+      me->mEdge[h] = nume;
+      nume++;
+    } else {
+      const int e = me->mMapEdges[slot];
+      const int first = me->mEdgeHalf[e];
+      me->mEdge[h] = e;
+      me->mEdgeValence[e]++;
+      // non-manifold edges only get their first two half-edges paired
+      if (me->mEdgeValence[e] == 2) {
+        me->mTwin[h] = first;
+        me->mTwin[first] = h;
+      }
+    }
+  }
+  me->mNumEdges = nume;
+
+  // vertex to faces, counting sort over the corners
+  memset(me->mVertFaceStart, 0, (numv+1)*sizeof(int));
+  for (int h=0; h<numh; h++) {
+    me->mVertFaceStart[faces[h/3].mIndex[h%3] + 1]++;
+  }
+  for (int i=0; i<numv; i++) {
+    me->mVertFaceStart[i+1] += me->mVertFaceStart[i];
+  }
+  for (int h=0; h<numh; h++) {
+    const int v = faces[h/3].mIndex[h%3];
+    me->mVertFaces[me->mVertFaceStart[v]++] = h/3;
+  }
+  for (int i=numv; i>0; i--) {
+    me->mVertFaceStart[i] = me->mVertFaceStart[i-1];
+  }
+  me->mVertFaceStart[0] = 0;
+
+  return true;
+}
+
+void MeshHalfEdges_DeInit(MeshHalfEdges *me) {
+  free(me->mTwin);
+  free(me->mEdge);
+  free(me->mEdgeHalf);
+  free(me->mEdgeValence);
+  free(me->mVertFaceStart);
+  free(me->mVertFaces);
+  free(me->mMapKeys);
+  free(me->mMapEdges);
+  *me = MeshHalfEdges();
+}
+
+int MeshHalfEdges_FindEdge(const MeshHalfEdges *me, int a, int b) {
+  const unsigned long long key = EdgeKey(a, b);
+  unsigned int slot = EdgeHash(key) & me->mMapMask;
+  while (me->mMapKeys[slot] != kEmptyEdgeKey) {
+    if (me->mMapKeys[slot] == key) {
+      return me->mMapEdges[slot];
+    }
+    slot = (slot + 1) & me->mMapMask;
+  }
+  return -1;
+}
+
+int MeshHalfEdges_GetEdgeFaces(const MeshHalfEdges *me, int edgeID,
+    int *faces) {
+  const int h = me->mEdgeHalf[edgeID];
+  faces[0] = h/3;
+  if (me->mTwin[h] == -1) {
+    return 1;
+  }
+  faces[1] = me->mTwin[h]/3;
+  return 2;
+}
+
+const int *MeshHalfEdges_GetVertexFaces(const MeshHalfEdges *me, int vertexID,
+    int *num) {
+  const int start = me->mVertFaceStart[vertexID];
+  *num = me->mVertFaceStart[vertexID+1] - start;
+  return me->mVertFaces + start;
+}
+
+int MeshHalfEdges_GetOneRing(const MeshHalfEdges *me, int vertexID,
+    int *ring, int maxNum) {
+  const MeshFace *faces = me->mMesh->mFaceData.mIndexArray[0].mBuffer;
+  int num = 0;
+  int numf = 0;
+  const int *vf = MeshHalfEdges_GetVertexFaces(me, vertexID, &numf);
+  for (int i=0; i<numf; i++) {
+    const MeshFace *face = faces + vf[i];
+    int k = 0;
+    while (k < 2 && face->mIndex[k] != vertexID) {
+      k++;
+    }
+    const int h = vf[i]*3 + k;
+    // every interior edge is the outgoing half-edge of exactly one face,
+    // the incoming ones only matter on the borders
+    const int next = face->mIndex[(k+1)%3];
+    if (num < maxNum) {
+      ring[num] = next;
+    }
+    num++;
+    const int hp = MeshHalfEdges_GetPrev(h);
+    if (me->mTwin[hp] == -1) {
+      if (num < maxNum) {
+        ring[num] = face->mIndex[(k+2)%3];
+      }
+      num++;
+    }
+  }
+  return num;
+}
+
 
 }
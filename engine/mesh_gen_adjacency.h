@@ -51,8 +51,57 @@ void MeshAdjacency_DeInit(MeshAdjacency *me);
 
 int MeshAdjacency_GetNumEdges(MeshAdjacency *am);
 // devuelve el index de la arista que contiene a "a" y "b"
+// linear search, use MeshHalfEdges_FindEdge in the loops
 int MeshAdjacency_GetEdgeIDContainingVerts(MeshAdjacency *am, int a, int b);
 
+// Half-edge adjacency of the index array 0 faces, built in O(F).
+// Half-edge h = 3*face + k goes from the face vertex k to the vertex k+1.
+// The edges are numbered in the order the faces first use them.
+struct MeshHalfEdges {
+  const Mesh *mMesh = nullptr;
+  int mNumVerts = 0;
+  int mNumFaces = 0;
+  int mNumEdges = 0;
+  int *mTwin = nullptr;          // [3*numf] opposite half-edge, -1 on borders
+  int *mEdge = nullptr;          // [3*numf] edge of each half-edge
+  int *mEdgeHalf = nullptr;      // [nume] first half-edge of each edge
+  int *mEdgeValence = nullptr;   // [nume] number of faces sharing each edge
+  int *mVertFaceStart = nullptr; // [numv+1] ranges of mVertFaces
+  int *mVertFaces = nullptr;     // [3*numf] faces around each vertex
+  // open addressing map from the (min, max) vertex pairs to the edges
+  unsigned long long *mMapKeys = nullptr;
+  int *mMapEdges = nullptr;
+  unsigned int mMapMask = 0;
+};
+
+bool MeshHalfEdges_Init(MeshHalfEdges *me, const Mesh *mesh);
+void MeshHalfEdges_DeInit(MeshHalfEdges *me);
+
+inline int MeshHalfEdges_GetFace(int halfEdge) {
+  return halfEdge/3;
+}
+inline int MeshHalfEdges_GetNext(int halfEdge) {
+  return (halfEdge%3 == 2) ? halfEdge - 2 : halfEdge + 1;
+}
+inline int MeshHalfEdges_GetPrev(int halfEdge) {
+  return (halfEdge%3 == 0) ? halfEdge + 2 : halfEdge - 1;
+}
+// vertex the half-edge starts at
+int MeshHalfEdges_GetVertex(const MeshHalfEdges *me, int halfEdge);
+
+// edge joining the vertices a and b, -1 if there is none
+int MeshHalfEdges_FindEdge(const MeshHalfEdges *me, int a, int b);
+// faces sharing the edge, writes up to 2 of them and returns their number
+int MeshHalfEdges_GetEdgeFaces(const MeshHalfEdges *me, int edgeID,
+  int *faces);
+// faces using the vertex
+const int *MeshHalfEdges_GetVertexFaces(const MeshHalfEdges *me, int vertexID,
+  int *num);
+// vertices sharing an edge with the vertex, writes up to maxNum of them
+// and returns their total number
+int MeshHalfEdges_GetOneRing(const MeshHalfEdges *me, int vertexID,
+  int *ring, int maxNum);
+
 
 
 } // namespace piLibs
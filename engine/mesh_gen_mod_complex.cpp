@@ -25,117 +25,39 @@
 // IN THE SOFTWARE.
 
 #define _USE_MATH_DEFINES
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <vector>
 
 #include "engine/mesh.h"
 #include "engine/mesh_gen.h"
-#include "engine/mesh_gen_adjacency.h"
 #include "engine/mesh_gen_mod_complex.h"
+#include "engine/mesh_subdiv.h"
 #include "engine/vec3f.h"
 
 
 namespace arctic {
 
 
-static void MeshVert_Scale(Mesh *dst, int dstID, float scale) {
-  float *dstdata = (float*)dst->GetVertexData(STREAMID, dstID, POSID);
-  for (int j=0; j<3; j++) {
-    dstdata[j] *= scale;
-  }
-}
-
-static void MeshVert_SInc(Mesh *dst, int dstID, float s, Mesh *src, int srcID) {
-  float *srcdata = (float*)src->GetVertexData(STREAMID, srcID, POSID);
-  float *dstdata = (float*)dst->GetVertexData(STREAMID, dstID, POSID);
-  for (int j=0; j<3; j++) {
-    dstdata[j] += s*srcdata[j];
-  }
-}
-
-const static float vpw_cc[4] = { 9.0f, 3.0f, 1.0f, 3.0f };
-const static float epw_cc[4] = { 3.0f, 3.0f, 1.0f, 1.0f };
-const static float vpw_te[4] = { 16.0f, 0.0f, 0.0f, 0.0f };
-const static float epw_te[4] = { 4.0f, 4.0f, 0.0f, 0.0f };
-
 bool Mesh_Subdivide(Mesh *mesh, int times, int mode) {
-  const float *vpw = (mode==1) ? vpw_te : vpw_cc;
-  const float *epw = (mode==1) ? epw_te : epw_cc;
-
-  while (times--) {
-    Mesh   aux;
-    MeshAdjacency adj;
-
-    if (!MeshAdjacency_Init(&adj, mesh)) {
-      return false;
-    }
-
-    const int numf = mesh->mFaceData.mIndexArray[0].mNum;
-    const int numv = mesh->mVertexData.mVertexArray[0].mNum;
-    const int nume = MeshAdjacency_GetNumEdges(&adj);
-
-    if (!aux.Init(1, numv+numf+nume, &mesh->mVertexData.mVertexArray[0].mFormat, kRMVEDT_Polys, 1, numf*4)) {
-      return false;
-    }
-
-    //////////////////////////////////////////////////////////////////////
-    const int foff = 0;
-    const int voff = numf;
-    const int eoff = numf + numv;
-
-    int numOutFaces = 0;
-
-    for (int i=0; i<numf; i++) {
-      MeshFace *fo = mesh->mFaceData.mIndexArray[0].mBuffer + i;
-      const int nv = 3;
-
-      int eid[4]; 
-      for (int j=0; j<nv; j++) {
-        int abcd[4]; for (int k=0; k<nv; k++) abcd[k] = fo->mIndex[ (j+k)%nv ];
-
-        adj.mVertexValence[ abcd[0] ] ++;
-
-        eid[j] = MeshAdjacency_GetEdgeIDContainingVerts(&adj, abcd[0], abcd[1]);
-
-        MeshVert_SInc(&aux, foff + i, 0.25f, mesh, abcd[0]);   // face vertex
-
-        for (int k=0; k<nv; k++) {
-          MeshVert_SInc(&aux, voff + abcd[0], vpw[k], mesh, abcd[k]);   // vertex vertex
-          MeshVert_SInc(&aux, eoff + eid[j],  epw[k], mesh, abcd[k]);   // edge vertex
-        }
-      }
-
-      for (int j=0; j<nv; j++) {                                           // make child faces
-        MeshFace *df = aux.mFaceData.mIndexArray[0].mBuffer + numOutFaces++;
-        df->mIndex[0] = foff + i;
-        df->mIndex[1] = eoff + eid[(j+nv-1)%nv]; 
-        df->mIndex[2] = voff + fo->mIndex[j];
-        df = aux.mFaceData.mIndexArray[0].mBuffer + numOutFaces++;
-        df->mIndex[0] = voff + fo->mIndex[j];
-        df->mIndex[1] = eoff + eid[ j       ];
-        df->mIndex[2] = foff + i;
-      }
-    }
-
-    for (int i=0; i<numv; i++) {
-      MeshVert_Scale(&aux, voff+i, 0.0625f/(float)adj.mVertexValence[i]);
-    }
-    for (int i=0; i<nume; i++) {
-      MeshVert_Scale(&aux, eoff+i, 0.1250f/(float)adj.arisaux[i].va);
-    }
-
-
-    //////////////////////////////////////////////////////////////////////
-
-    mesh->DeInit();
-    MeshAdjacency_DeInit(&adj);
-
-    aux.mFaceData.mIndexArray[0].mNum = numOutFaces;
-    *mesh = aux;
+  MeshSubdiv subdiv;
+  if (!MeshSubdiv_Init(&subdiv, mesh,
+      (mode==SUBD_TE) ? kMeshSubdivLinear : kMeshSubdivCatmullClark, times,
+      nullptr, false)) {
+    return false;
+  }
 
+  Mesh aux;
+  if (!MeshSubdiv_InitMesh(&subdiv, &aux)) {
+    MeshSubdiv_DeInit(&subdiv);
+    return false;
   }
+  MeshSubdiv_Evaluate(&subdiv, mesh, &aux);
+  MeshSubdiv_DeInit(&subdiv);
 
+  mesh->DeInit();
+  *mesh = aux;
   return true;
 }
 
@@ -551,6 +473,7 @@ bool Mesh_Clip(Mesh *mesh, float y) {
 
 bool Mesh_Split(Mesh *outMesh, Mesh *mesh, int nx, int ny, int nz, int *resNum) {
   const int numf = mesh->mFaceData.mIndexArray[0].mNum;
+  const int numv = mesh->mVertexData.mVertexArray[0].mNum;
 
   mesh->CalcBBox(STREAMID, POSID);
 
@@ -560,12 +483,12 @@ bool Mesh_Split(Mesh *outMesh, Mesh *mesh, int nx, int ny, int nz, int *resNum)
   if (numOutMeshs>256) {
     return false;
   }
-  std::vector<MeshFace> faces[256];
-  for (int i=0; i<numOutMeshs; i++) {
-    faces[i].reserve(numf); 
-  }
 
-  int nnumf = 0;
+  // bucket the faces by piece, counting sort
+  std::vector<int> faceMesh(numf);
+  std::vector<int> faceOrder(numf);
+  int start[257];
+  memset(start, 0, sizeof(start));
   for (int i=0; i<numf; i++) {
     const MeshFace *mf = mesh->mFaceData.mIndexArray[0].mBuffer + i;
     const float *vert = (float*)mesh->GetVertexData(STREAMID, mf->mIndex[0], POSID);
@@ -579,36 +502,75 @@ bool Mesh_Split(Mesh *outMesh, Mesh *mesh, int nx, int ny, int nz, int *resNum)
       return false;
     }
 
-    faces[id].push_back(*mf);
+    faceMesh[i] = id;
+    start[id+1]++;
   }
-
-  int remap[256];
-  int num = 0;
   for (int i=0; i<numOutMeshs; i++) {
-    const int numDstFaces = (int)faces[i].size();
-    if (numDstFaces!=0) {
-      remap[num++] = i;
+    start[i+1] += start[i];
+  }
+  {
+    int pos[256];
+    memcpy(pos, start, numOutMeshs*sizeof(int));
+    for (int i=0; i<numf; i++) {
+      faceOrder[pos[faceMesh[i]]++] = i;
     }
   }
 
-  *resNum = num;
+  // vertex remap of the current piece, -1 for the vertices it does not use
+  std::vector<int> remap(numv, -1);
+  std::vector<int> used;
+  used.reserve(numv);
 
-  for (int i=0; i<num; i++) {
-    Mesh *dst = outMesh + i;
-    std::vector<MeshFace> *src = faces + remap[i];
-    const int numDstFaces = (int)src->size();
-    const int numDstVerts = mesh->mVertexData.mVertexArray[0].mNum;
-    if (!dst->Init(1, numDstVerts, &mesh->mVertexData.mVertexArray[0].mFormat, mesh->mFaceData.mType, 1, numDstFaces)) {
-      return false;
+  const MeshVertexArray *sva = mesh->mVertexData.mVertexArray + 0;
+  const int stride = sva->mFormat.mStride;
+
+  int num = 0;
+  for (int p=0; p<numOutMeshs; p++) {
+    const int numDstFaces = start[p+1] - start[p];
+    if (numDstFaces==0) {
+      continue;
     }
-    memcpy(dst->mFaceData.mIndexArray[0].mBuffer, &src[0], numDstFaces*sizeof(MeshFace));
-    memcpy(dst->mVertexData.mVertexArray[0].mBuffer, mesh->mVertexData.mVertexArray[0].mBuffer, numDstVerts*mesh->mVertexData.mVertexArray[0].mFormat.mStride);
 
-    if (!dst->Compact()) {
+    used.clear();
+    for (int i=start[p]; i<start[p+1]; i++) {
+      const MeshFace *mf = mesh->mFaceData.mIndexArray[0].mBuffer + faceOrder[i];
+      for (int k=0; k<3; k++) {
+        const int vid = mf->mIndex[k];
+        if (remap[vid] == -1) {
+          remap[vid] = 0;
+          used.push_back(vid);
+        }
+      }
+    }
+    // same vertex order as Mesh::Compact
+    std::sort(used.begin(), used.end());
+    const int numDstVerts = (int)used.size();
+
+    Mesh *dst = outMesh + num++;
+    // Init wants 3 vertices at least, degenerate pieces may use less
+    if (!dst->Init(1, (numDstVerts<3) ? 3 : numDstVerts, &sva->mFormat, mesh->mFaceData.mType, 1, numDstFaces)) {
       return false;
     }
+    dst->mVertexData.mVertexArray[0].mNum = numDstVerts;
+    for (int i=0; i<numDstVerts; i++) {
+      remap[used[i]] = i;
+      memcpy((char*)dst->mVertexData.mVertexArray[0].mBuffer + i*stride,
+        (const char*)sva->mBuffer + used[i]*stride, stride);
+    }
+    for (int i=start[p]; i<start[p+1]; i++) {
+      const MeshFace *mf = mesh->mFaceData.mIndexArray[0].mBuffer + faceOrder[i];
+      MeshFace *df = dst->mFaceData.mIndexArray[0].mBuffer + (i - start[p]);
+      for (int k=0; k<3; k++) {
+        df->mIndex[k] = remap[mf->mIndex[k]];
+      }
+    }
+    for (int i=0; i<numDstVerts; i++) {
+      remap[used[i]] = -1;
+    }
   }
 
+  *resNum = num;
+
   return true;
 }
 
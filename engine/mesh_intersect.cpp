@@ -24,13 +24,550 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
-#include "engine/mesh.h"
-#include "engine/vec3f.h"
+#include "engine/mesh_intersect.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "engine/arctic_job_system.h"
 
 namespace arctic {
 
-bool Mesh_Intersect( const Mesh *me, const Vec3F &ro, Vec3F &rd, float tmin, float tmax, float *res ) {
-	return true;
+namespace {
+
+const int kBvhBinCount = 12;
+const int kBvhMaxLeafSize = 4;
+const int kBvhMaxDepth = 60;
+const int kBvhStackSize = 64;
+const int kBvhPacketSize = 8;
+// Widens the box exit distances by the rounding of the slab test, otherwise
+// a face ending on the box surface can hit just past it and get culled
+const float kBvhBoxSlack = 1.0f + 3.0f*FLT_EPSILON;
+// Subtrees with fewer faces are built on the thread that split their parent
+const int kBvhParallelBuildSize = 4096;
+
+inline Vec3F MinVec(const Vec3F &a, const Vec3F &b) {
+  return Vec3F(std::min(a.x, b.x), std::min(a.y, b.y), std::min(a.z, b.z));
+}
+
+inline Vec3F MaxVec(const Vec3F &a, const Vec3F &b) {
+  return Vec3F(std::max(a.x, b.x), std::max(a.y, b.y), std::max(a.z, b.z));
+}
+
+inline float HalfArea(const Vec3F &mi, const Vec3F &ma) {
+  const Vec3F d = ma - mi;
+  return d.x*d.y + d.y*d.z + d.z*d.x;
+}
+
+inline const Vec3F &GetPosition(const Mesh *mesh, int stream, int pPos,
+    int vertexID) {
+  return *(const Vec3F*)mesh->GetVertexData(stream, vertexID, pPos);
+}
+
+inline void MakeTriangle(const Mesh *mesh, int stream, int pPos, int faceID,
+    MeshBvhTriangle *tri) {
+  const MeshFace *face = mesh->mFaceData.mIndexArray[0].mBuffer + faceID;
+  const Vec3F v0 = GetPosition(mesh, stream, pPos, face->mIndex[0]);
+  tri->mV0 = v0;
+  tri->mE1 = GetPosition(mesh, stream, pPos, face->mIndex[1]) - v0;
+  tri->mE2 = GetPosition(mesh, stream, pPos, face->mIndex[2]) - v0;
+}
+
+// Moller-Trumbore, the barycentrics go to u and v
+inline bool IntersectTriangle(const MeshBvhTriangle &tri, const Vec3F &ro,
+    const Vec3F &rd, float tmin, float tmax, float *t, float *u, float *v) {
+  const Vec3F p = Cross(rd, tri.mE2);
+  const float det = Dot(tri.mE1, p);
+  if (det == 0.0f) {
+    return false;
+  }
+  const float invDet = 1.0f / det;
+  const Vec3F s = ro - tri.mV0;
+  const float uu = Dot(s, p)*invDet;
+  if (uu < 0.0f || uu > 1.0f) {
+    return false;
+  }
+  const Vec3F q = Cross(s, tri.mE1);
+  const float vv = Dot(rd, q)*invDet;
+  if (vv < 0.0f || uu + vv > 1.0f) {
+    return false;
+  }
+  const float tt = Dot(tri.mE2, q)*invDet;
+  if (!(tt >= tmin && tt <= tmax)) {
+    return false;
+  }
+  *t = tt;
+  *u = uu;
+  *v = vv;
+  return true;
 }
 
+// Returns the entry distance, or FLT_MAX if the ray misses the box
+inline float IntersectBox(const MeshBvhNode &node, const Vec3F &ro,
+    const Vec3F &invRd, float tmin, float tmax) {
+  const float tx0 = (node.mMin.x - ro.x)*invRd.x;
+  const float tx1 = (node.mMax.x - ro.x)*invRd.x;
+  const float ty0 = (node.mMin.y - ro.y)*invRd.y;
+  const float ty1 = (node.mMax.y - ro.y)*invRd.y;
+  const float tz0 = (node.mMin.z - ro.z)*invRd.z;
+  const float tz1 = (node.mMax.z - ro.z)*invRd.z;
+  const float t0 = std::max(std::max(std::min(tx0, tx1), std::min(ty0, ty1)),
+    std::max(std::min(tz0, tz1), tmin));
+  const float t1 = std::min(std::min(std::max(tx0, tx1), std::max(ty0, ty1)),
+    std::min(std::max(tz0, tz1), tmax));
+  return (t0 <= t1*kBvhBoxSlack) ? t0 : FLT_MAX;
 }
+
+// The zero direction components become tiny ones, otherwise the box test
+// gets 0 * inf for the rays starting on a box plane
+inline float SafeInverse(float d) {
+  return 1.0f/(std::fabs(d) > 1e-20f ? d : std::copysign(1e-20f, d));
+}
+
+inline Vec3F Inverse(const Vec3F &rd) {
+  return Vec3F(SafeInverse(rd.x), SafeInverse(rd.y), SafeInverse(rd.z));
+}
+
+struct BvhBuilder {
+  MeshBvh *mBvh;
+  std::vector<Vec3F> mFaceMin;
+  std::vector<Vec3F> mFaceMax;
+  std::vector<Vec3F> mCentroid;
+  std::atomic<int> mNumNodes;
+
+  void Build(int nodeID, int first, int count, int depth) {
+    MeshBvhNode &node = mBvh->mNodes[nodeID];
+    int *ids = mBvh->mFaceIDs + first;
+    Vec3F mi(FLT_MAX);
+    Vec3F ma(-FLT_MAX);
+    Vec3F cmi(FLT_MAX);
+    Vec3F cma(-FLT_MAX);
+    for (int i=0; i<count; i++) {
+      mi = MinVec(mi, mFaceMin[ids[i]]);
+      ma = MaxVec(ma, mFaceMax[ids[i]]);
+      cmi = MinVec(cmi, mCentroid[ids[i]]);
+      cma = MaxVec(cma, mCentroid[ids[i]]);
+    }
+    node.mMin = mi;
+    node.mMax = ma;
+    node.mFirst = first;
+    node.mCount = count;
+    if (count <= kBvhMaxLeafSize || depth >= kBvhMaxDepth) {
+      return;
+    }
+
+    // Binned surface area heuristic, in the units of one face test
+    int bestAxis = -1;
+    int bestBin = 0;
+    float bestCost = (float)count;
+    for (int axis=0; axis<3; axis++) {
+      const float extent = cma.element[axis] - cmi.element[axis];
+      if (!(extent > 0.0f)) {
+        continue;
+      }
+      const float scale = (float)kBvhBinCount/extent;
+      int binCount[kBvhBinCount] = {};
+      Vec3F binMin[kBvhBinCount];
+      Vec3F binMax[kBvhBinCount];
+      for (int b=0; b<kBvhBinCount; b++) {
+        binMin[b] = Vec3F(FLT_MAX);
+        binMax[b] = Vec3F(-FLT_MAX);
+      }
+      for (int i=0; i<count; i++) {
+        const int b = std::min(kBvhBinCount - 1,
+          (int)((mCentroid[ids[i]].element[axis] - cmi.element[axis])*scale));
+        binCount[b]++;
+        binMin[b] = MinVec(binMin[b], mFaceMin[ids[i]]);
+        binMax[b] = MaxVec(binMax[b], mFaceMax[ids[i]]);
+      }
+      float leftCost[kBvhBinCount];
+      Vec3F lmi(FLT_MAX);
+      Vec3F lma(-FLT_MAX);
+      int leftCount = 0;
+      for (int b=0; b<kBvhBinCount - 1; b++) {
+        leftCount += binCount[b];
+        lmi = MinVec(lmi, binMin[b]);
+        lma = MaxVec(lma, binMax[b]);
+        leftCost[b] = leftCount ? HalfArea(lmi, lma)*(float)leftCount : 0.0f;
+      }
+      Vec3F rmi(FLT_MAX);
+      Vec3F rma(-FLT_MAX);
+      int rightCount = 0;
+      const float invArea = 1.0f/std::max(HalfArea(mi, ma), FLT_MIN);
+      for (int b=kBvhBinCount - 1; b>0; b--) {
+        rightCount += binCount[b];
+        rmi = MinVec(rmi, binMin[b]);
+        rma = MaxVec(rma, binMax[b]);
+        if (rightCount == 0 || rightCount == count) {
+          continue;
+        }
+        const float cost = 1.0f +
+          (leftCost[b - 1] + HalfArea(rmi, rma)*(float)rightCount)*invArea;
+        if (cost < bestCost) {
+          bestCost = cost;
+          bestAxis = axis;
+          bestBin = b;
+        }
+      }
+    }
+
+    int leftCount = count/2;
+    if (bestAxis >= 0) {
+      const float origin = cmi.element[bestAxis];
+      const float scale = (float)kBvhBinCount/
+        (cma.element[bestAxis] - cmi.element[bestAxis]);
+      const int axis = bestAxis;
+      const int bin = bestBin;
+      const BvhBuilder *self = this;
+      leftCount = (int)(std::partition(ids, ids + count, [=](int id) {
+        return std::min(kBvhBinCount - 1,
+          (int)((self->mCentroid[id].element[axis] - origin)*scale)) < bin;
+      }) - ids);
+    } else if (count <= 4*kBvhMaxLeafSize) {
+      // Splitting does not pay off
+      return;
+    } else {
+      // Too many faces for a leaf, split them at the median centroid
+      const Vec3F extent = cma - cmi;
+      bestAxis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 :
+        ((extent.y >= extent.z) ? 1 : 2);
+      const int axis = bestAxis;
+      const BvhBuilder *self = this;
+      std::nth_element(ids, ids + leftCount, ids + count, [=](int a, int b) {
+        return self->mCentroid[a].element[axis] <
+          self->mCentroid[b].element[axis];
+      });
+    }
+
+    const int left = mNumNodes.fetch_add(2);
+    node.mFirst = left;
+    node.mCount = -1 - bestAxis;
+    if (mBvh->mIsParallel && count >= kBvhParallelBuildSize) {
+      JobCounter counter;
+      RunJob([=]() {
+        Build(left, first, leftCount, depth + 1);
+      }, &counter);
+      Build(left + 1, first + leftCount, count - leftCount, depth + 1);
+      WaitForJobs(counter);
+    } else {
+      Build(left, first, leftCount, depth + 1);
+      Build(left + 1, first + leftCount, count - leftCount, depth + 1);
+    }
+  }
+};
+
+void UpdateTriangles(MeshBvh *me, int first, int end) {
+  for (int i=first; i<end; i++) {
+    MakeTriangle(me->mMesh, me->mStream, me->mPos, me->mFaceIDs[i],
+      me->mTriangles + i);
+  }
+}
+
+}  // namespace
+
+bool Mesh_Intersect(const Mesh *me, const Vec3F &ro, const Vec3F &rd,
+    float tmin, float tmax, MeshRayHit *res) {
+  const int numf = me->mFaceData.mIndexArray[0].mNum;
+  bool isHit = false;
+  for (int i=0; i<numf; i++) {
+    MeshBvhTriangle tri;
+    MakeTriangle(me, 0, 0, i, &tri);
+    float t, u, v;
+    if (IntersectTriangle(tri, ro, rd, tmin, tmax, &t, &u, &v)) {
+      tmax = t;
+      res->mT = t;
+      res->mFaceID = i;
+      res->mU = u;
+      res->mV = v;
+      isHit = true;
+    }
+  }
+  return isHit;
+}
+
+bool MeshBvh_Init(MeshBvh *me, const Mesh *mesh, int stream, int pPos,
+    bool isParallel) {
+  if (mesh->mFaceData.mType != kRMVEDT_Polys) {
+    return false;
+  }
+  const int numf = mesh->mFaceData.mIndexArray[0].mNum;
+  me->mMesh = mesh;
+  me->mStream = stream;
+  me->mPos = pPos;
+  me->mIsParallel = isParallel;
+  me->mNumFaces = numf;
+  me->mNodes = (MeshBvhNode*)malloc(std::max(1, 2*numf)*sizeof(MeshBvhNode));
+  me->mFaceIDs = (int*)malloc(std::max(1, numf)*sizeof(int));
+  me->mTriangles = (MeshBvhTriangle*)malloc(
+    std::max(1, numf)*sizeof(MeshBvhTriangle));
+  if (!me->mNodes || !me->mFaceIDs || !me->mTriangles) {
+    MeshBvh_DeInit(me);
+    return false;
+  }
+
+  BvhBuilder builder;
+  builder.mBvh = me;
+  builder.mFaceMin.resize(numf);
+  builder.mFaceMax.resize(numf);
+  builder.mCentroid.resize(numf);
+  builder.mNumNodes = 1;
+  auto prepareFaces = [me, &builder](int first, int end) {
+    for (int i=first; i<end; i++) {
+      MeshBvhTriangle tri;
+      MakeTriangle(me->mMesh, me->mStream, me->mPos, i, &tri);
+      const Vec3F v1 = tri.mV0 + tri.mE1;
+      const Vec3F v2 = tri.mV0 + tri.mE2;
+      builder.mFaceMin[i] = MinVec(tri.mV0, MinVec(v1, v2));
+      builder.mFaceMax[i] = MaxVec(tri.mV0, MaxVec(v1, v2));
+      builder.mCentroid[i] = (builder.mFaceMin[i] + builder.mFaceMax[i])*0.5f;
+      me->mFaceIDs[i] = i;
+    }
+  };
+  if (isParallel) {
+    ParallelFor(0, numf, 0, prepareFaces);
+  } else {
+    prepareFaces(0, numf);
+  }
+  builder.Build(0, 0, numf, 0);
+  me->mNumNodes = builder.mNumNodes;
+
+  if (isParallel) {
+    ParallelFor(0, numf, 0, [me](int first, int end) {
+      UpdateTriangles(me, first, end);
+    });
+  } else {
+    UpdateTriangles(me, 0, numf);
+  }
+  return true;
+}
+
+void MeshBvh_DeInit(MeshBvh *me) {
+  free(me->mNodes);
+  free(me->mFaceIDs);
+  free(me->mTriangles);
+  me->mNodes = nullptr;
+  me->mFaceIDs = nullptr;
+  me->mTriangles = nullptr;
+  me->mNumNodes = 0;
+  me->mNumFaces = 0;
+}
+
+void MeshBvh_Refit(MeshBvh *me) {
+  if (me->mIsParallel) {
+    ParallelFor(0, me->mNumFaces, 0, [me](int first, int end) {
+      UpdateTriangles(me, first, end);
+    });
+  } else {
+    UpdateTriangles(me, 0, me->mNumFaces);
+  }
+  // The children always come after their parent
+  for (int i=me->mNumNodes - 1; i>=0; i--) {
+    MeshBvhNode &node = me->mNodes[i];
+    Vec3F mi(FLT_MAX);
+    Vec3F ma(-FLT_MAX);
+    if (node.mCount >= 0) {
+      for (int j=node.mFirst; j<node.mFirst + node.mCount; j++) {
+        const MeshBvhTriangle &tri = me->mTriangles[j];
+        const Vec3F v1 = tri.mV0 + tri.mE1;
+        const Vec3F v2 = tri.mV0 + tri.mE2;
+        mi = MinVec(mi, MinVec(tri.mV0, MinVec(v1, v2)));
+        ma = MaxVec(ma, MaxVec(tri.mV0, MaxVec(v1, v2)));
+      }
+    } else {
+      const MeshBvhNode &left = me->mNodes[node.mFirst];
+      const MeshBvhNode &right = me->mNodes[node.mFirst + 1];
+      mi = MinVec(left.mMin, right.mMin);
+      ma = MaxVec(left.mMax, right.mMax);
+    }
+    node.mMin = mi;
+    node.mMax = ma;
+  }
+}
+
+bool MeshBvh_Intersect(const MeshBvh *me, const Vec3F &ro, const Vec3F &rd,
+    float tmin, float tmax, MeshRayHit *res) {
+  const Vec3F invRd = Inverse(rd);
+  bool isHit = false;
+  int stack[kBvhStackSize];
+  int sp = 0;
+  if (IntersectBox(me->mNodes[0], ro, invRd, tmin, tmax) == FLT_MAX) {
+    return false;
+  }
+  int nodeID = 0;
+  while (true) {
+    const MeshBvhNode &node = me->mNodes[nodeID];
+    if (node.mCount >= 0) {
+      for (int i=node.mFirst; i<node.mFirst + node.mCount; i++) {
+        float t, u, v;
+        if (IntersectTriangle(me->mTriangles[i], ro, rd, tmin, tmax,
+            &t, &u, &v)) {
+          tmax = t;
+          res->mT = t;
+          res->mFaceID = me->mFaceIDs[i];
+          res->mU = u;
+          res->mV = v;
+          isHit = true;
+        }
+      }
+    } else {
+      int near = node.mFirst;
+      int far = node.mFirst + 1;
+      float tNear = IntersectBox(me->mNodes[near], ro, invRd, tmin, tmax);
+      float tFar = IntersectBox(me->mNodes[far], ro, invRd, tmin, tmax);
+      if (tFar < tNear) {
+        std::swap(near, far);
+        std::swap(tNear, tFar);
+      }
+      if (tNear != FLT_MAX) {
+        if (tFar != FLT_MAX) {
+          stack[sp++] = far;
+        }
+        nodeID = near;
+        continue;
+      }
+    }
+    // Pops the nodes the closer hits have made useless
+    do {
+      if (sp == 0) {
+        return isHit;
+      }
+      nodeID = stack[--sp];
+    } while (isHit &&
+      IntersectBox(me->mNodes[nodeID], ro, invRd, tmin, tmax) == FLT_MAX);
+  }
+}
+
+bool MeshBvh_IntersectAny(const MeshBvh *me, const Vec3F &ro, const Vec3F &rd,
+    float tmin, float tmax) {
+  const Vec3F invRd = Inverse(rd);
+  int stack[kBvhStackSize];
+  int sp = 0;
+  stack[sp++] = 0;
+  while (sp) {
+    const MeshBvhNode &node = me->mNodes[stack[--sp]];
+    if (IntersectBox(node, ro, invRd, tmin, tmax) == FLT_MAX) {
+      continue;
+    }
+    if (node.mCount >= 0) {
+      for (int i=node.mFirst; i<node.mFirst + node.mCount; i++) {
+        float t, u, v;
+        if (IntersectTriangle(me->mTriangles[i], ro, rd, tmin, tmax,
+            &t, &u, &v)) {
+          return true;
+        }
+      }
+    } else {
+      const bool isBackwards = rd.element[-1 - node.mCount] < 0.0f;
+      stack[sp++] = node.mFirst + (isBackwards ? 0 : 1);
+      stack[sp++] = node.mFirst + (isBackwards ? 1 : 0);
+    }
+  }
+  return false;
+}
+
+int MeshBvh_IntersectPacket(const MeshBvh *me, const Vec3F *ro,
+    const Vec3F *rd, int num, float tmin, float tmax, MeshRayHit *res) {
+  int numHits = 0;
+  for (int base=0; base<num; base+=kBvhPacketSize) {
+    const int n = std::min(kBvhPacketSize, num - base);
+    // The rays are kept as structures of arrays and the lanes are tested
+    // without branches, so that the loops over the packet vectorize.
+    // The unused lanes repeat the last ray and never hit.
+    float ox[kBvhPacketSize], oy[kBvhPacketSize], oz[kBvhPacketSize];
+    float dx[kBvhPacketSize], dy[kBvhPacketSize], dz[kBvhPacketSize];
+    float ix[kBvhPacketSize], iy[kBvhPacketSize], iz[kBvhPacketSize];
+    float tFar[kBvhPacketSize], hitU[kBvhPacketSize], hitV[kBvhPacketSize];
+    int hitID[kBvhPacketSize];
+    for (int r=0; r<kBvhPacketSize; r++) {
+      const int k = base + std::min(r, n - 1);
+      ox[r] = ro[k].x;
+      oy[r] = ro[k].y;
+      oz[r] = ro[k].z;
+      dx[r] = rd[k].x;
+      dy[r] = rd[k].y;
+      dz[r] = rd[k].z;
+      ix[r] = SafeInverse(rd[k].x);
+      iy[r] = SafeInverse(rd[k].y);
+      iz[r] = SafeInverse(rd[k].z);
+      tFar[r] = (r < n) ? tmax : -FLT_MAX;
+      hitU[r] = 0.0f;
+      hitV[r] = 0.0f;
+      hitID[r] = -1;
+    }
+    int stack[kBvhStackSize];
+    int sp = 0;
+    stack[sp++] = 0;
+    while (sp) {
+      const MeshBvhNode &node = me->mNodes[stack[--sp]];
+      int isAnyHit = 0;
+      for (int r=0; r<kBvhPacketSize; r++) {
+        const float tx0 = (node.mMin.x - ox[r])*ix[r];
+        const float tx1 = (node.mMax.x - ox[r])*ix[r];
+        const float ty0 = (node.mMin.y - oy[r])*iy[r];
+        const float ty1 = (node.mMax.y - oy[r])*iy[r];
+        const float tz0 = (node.mMin.z - oz[r])*iz[r];
+        const float tz1 = (node.mMax.z - oz[r])*iz[r];
+        const float t0 = std::max(std::max(std::min(tx0, tx1),
+          std::min(ty0, ty1)), std::max(std::min(tz0, tz1), tmin));
+        const float t1 = std::min(std::min(std::max(tx0, tx1),
+          std::max(ty0, ty1)), std::min(std::max(tz0, tz1), tFar[r]));
+        isAnyHit |= (t0 <= t1*kBvhBoxSlack) ? 1 : 0;
+      }
+      if (!isAnyHit) {
+        continue;
+      }
+      if (node.mCount >= 0) {
+        for (int i=node.mFirst; i<node.mFirst + node.mCount; i++) {
+          const MeshBvhTriangle &tri = me->mTriangles[i];
+          const int faceID = me->mFaceIDs[i];
+          for (int r=0; r<kBvhPacketSize; r++) {
+            // Moller-Trumbore, the same arithmetic as IntersectTriangle
+            const float px = dy[r]*tri.mE2.z - dz[r]*tri.mE2.y;
+            const float py = dz[r]*tri.mE2.x - dx[r]*tri.mE2.z;
+            const float pz = dx[r]*tri.mE2.y - dy[r]*tri.mE2.x;
+            const float det = tri.mE1.x*px + tri.mE1.y*py + tri.mE1.z*pz;
+            const float invDet = 1.0f/det;
+            const float sx = ox[r] - tri.mV0.x;
+            const float sy = oy[r] - tri.mV0.y;
+            const float sz = oz[r] - tri.mV0.z;
+            const float uu = (sx*px + sy*py + sz*pz)*invDet;
+            const float qx = sy*tri.mE1.z - sz*tri.mE1.y;
+            const float qy = sz*tri.mE1.x - sx*tri.mE1.z;
+            const float qz = sx*tri.mE1.y - sy*tri.mE1.x;
+            const float vv = (dx[r]*qx + dy[r]*qy + dz[r]*qz)*invDet;
+            const float tt = (tri.mE2.x*qx + tri.mE2.y*qy + tri.mE2.z*qz)*invDet;
+            const bool isHit = (det != 0.0f) & (uu >= 0.0f) & (uu <= 1.0f) &
+              (vv >= 0.0f) & (uu + vv <= 1.0f) & (tt >= tmin) & (tt <= tFar[r]);
+            tFar[r] = isHit ? tt : tFar[r];
+            hitU[r] = isHit ? uu : hitU[r];
+            hitV[r] = isHit ? vv : hitV[r];
+            hitID[r] = isHit ? faceID : hitID[r];
+          }
+        }
+      } else {
+        // Visits the child on the side the packet comes from first
+        const int axis = -1 - node.mCount;
+        const bool isBackwards = rd[base].element[axis] < 0.0f;
+        stack[sp++] = node.mFirst + (isBackwards ? 0 : 1);
+        stack[sp++] = node.mFirst + (isBackwards ? 1 : 0);
+      }
+    }
+    for (int r=0; r<n; r++) {
+      MeshRayHit &hit = res[base + r];
+      hit.mFaceID = hitID[r];
+      if (hitID[r] >= 0) {
+        hit.mT = tFar[r];
+        hit.mU = hitU[r];
+        hit.mV = hitV[r];
+        numHits++;
+      }
+    }
+  }
+  return numHits;
+}
+
+}  // namespace arctic
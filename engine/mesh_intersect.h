@@ -31,6 +31,63 @@
 
 namespace arctic {
 
-bool Mesh_Intersect(const Mesh *me, const Vec3F & ro, vec3 &rd, float tmin, float tmax, float *res);
+struct MeshRayHit {
+  float mT = 0.0f;    // distance along the ray direction
+  int mFaceID = -1;   // face of the index array 0
+  float mU = 0.0f;    // barycentric weight of the face vertex 1
+  float mV = 0.0f;    // barycentric weight of the face vertex 2
+};
+
+// 32 bytes, the children of an inner node are next to each other
+struct MeshBvhNode {
+  Vec3F mMin;
+  int mFirst;   // leaf: first face in mFaceIDs, inner: left child node
+  Vec3F mMax;
+  int mCount;   // leaf: number of faces, inner: -1 - split axis
+};
+
+struct MeshBvhTriangle {
+  Vec3F mV0;
+  Vec3F mE1;  // v1 - v0
+  Vec3F mE2;  // v2 - v0
+};
+
+struct MeshBvh {
+  const Mesh *mMesh = nullptr;
+  int mStream = 0;
+  int mPos = 0;
+  bool mIsParallel = false;
+  int mNumNodes = 0;
+  int mNumFaces = 0;
+  MeshBvhNode *mNodes = nullptr;
+  int *mFaceIDs = nullptr;               // mesh face of each leaf face
+  MeshBvhTriangle *mTriangles = nullptr; // leaf faces, in the leaf order
+};
+
+// Brute force closest hit against every face of the index array 0,
+// the positions are the element 0 of the vertex stream 0.
+// Fine for the small meshes, build a MeshBvh for the large ones.
+bool Mesh_Intersect(const Mesh *me, const Vec3F &ro, const Vec3F &rd,
+  float tmin, float tmax, MeshRayHit *res);
+
+// Builds the bounding volume hierarchy of the index array 0 faces,
+// the positions are the element pPos of the vertex stream.
+// With isParallel the build and the refits run on the job system.
+bool MeshBvh_Init(MeshBvh *me, const Mesh *mesh, int stream, int pPos,
+  bool isParallel);
+void MeshBvh_DeInit(MeshBvh *me);
+// Updates the bounds after the vertices moved, the faces must stay the same
+void MeshBvh_Refit(MeshBvh *me);
+
+// Closest hit in [tmin, tmax]
+bool MeshBvh_Intersect(const MeshBvh *me, const Vec3F &ro, const Vec3F &rd,
+  float tmin, float tmax, MeshRayHit *res);
+// Any hit in [tmin, tmax], for the line of sight queries
+bool MeshBvh_IntersectAny(const MeshBvh *me, const Vec3F &ro, const Vec3F &rd,
+  float tmin, float tmax);
+// Closest hits of num rays, traversed in packets of coherent rays.
+// The rays that miss get mFaceID -1. Returns the number of hits.
+int MeshBvh_IntersectPacket(const MeshBvh *me, const Vec3F *ro,
+  const Vec3F *rd, int num, float tmin, float tmax, MeshRayHit *res);
 
 } // namespace arctic
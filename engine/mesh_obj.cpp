@@ -24,155 +24,329 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 //#define USETRICAT
-
 #include <cstring>
-#include <deque>
-#include <fstream>
-#include <string>
 #include <vector>
+#include "engine/arctic_job_system.h"
 #include "engine/mesh.h"
-#include "engine/vec3f.h"
+#include "engine/mesh_obj.h"
+#include "engine/mesh_parse.h"
 
 namespace arctic {
 
-static int splitInWords(char *str, char **ptrs, const char *sep, int num) {
-  int i;
-  for (i=0; i<num; i++) {
-    ptrs[i] = strtok(i==0?str:0, sep);
-    if (ptrs[i]==0) {
-      break;
-    }
-  }
-  return i;
+static const Ui64 kObjChunkSize = 256*1024;
+static const int kObjNoIndex = -1;
+// The negative (relative) indices are resolved once the number of the
+// elements before the chunk is known, until then they are stored as
+// -2 - (index in the chunk + kObjRelativeBias).
+static const int kObjRelativeBias = 1 << 30;
+
+struct ObjChunk {
+  std::vector<float> mPositions;  // 3 per v
+  std::vector<float> mNormals;    // 3 per vn
+  std::vector<float> mUVs;        // 2 per vt
+  std::vector<int> mCorners;      // v, vt, vn per triangle corner
+  bool mIsValid = true;
+  bool mHasNormals = false;
+  bool mHasUVs = false;
+};
+
+static inline bool IsObjSpace(const char *p, const char *end) {
+  return p >= end || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n';
 }
 
-int MeshObj_Read(Mesh *me, const char *name, bool calcNormals) {
-  char str[512];
-  char *ptrs[128];
-  std::vector<Vec3F> vertices;
-  std::vector<MeshFace> faces;
+static const char *ParseObjIndex(const char *p, const char *end, int numLocal,
+    int *res) {
+  int index;
+  p = MeshParse_Int(p, end, &index);
+  if (!p || index == 0) {
+    return nullptr;
+  }
+  *res = (index > 0) ? index - 1 : -2 - (numLocal + index + kObjRelativeBias);
+  return p;
+}
 
-  std::ifstream ifile(name);
-  if (!ifile.is_open()) {
-    return 0;
+// v, v/vt, v//vn or v/vt/vn
+static const char *ParseObjCorner(const char *p, const char *end,
+    const ObjChunk &chunk, int *corner) {
+  corner[1] = kObjNoIndex;
+  corner[2] = kObjNoIndex;
+  p = ParseObjIndex(p, end, (int)(chunk.mPositions.size()/3), &corner[0]);
+  if (p && p < end && *p == '/') {
+    p++;
+    if (p < end && *p != '/') {
+      p = ParseObjIndex(p, end, (int)(chunk.mUVs.size()/2), &corner[1]);
+    }
+    if (p && p < end && *p == '/') {
+      p = ParseObjIndex(p + 1, end, (int)(chunk.mNormals.size()/3), &corner[2]);
+    }
   }
-  std::deque<std::string> original_file;
-  std::string line;
-  while (ifile.good()) {
-    std::getline(ifile, line);
-    if (!line.empty()) {
-      original_file.push_back(line);
+  return p;
+}
+
+static bool ParseObjFloats(const char **pp, const char *end, int num,
+    int numRequired, std::vector<float> *dst) {
+  const char *p = *pp;
+  for (int i=0; i<num; i++) {
+    float value = 0.0f;
+    const char *q = MeshParse_Float(p, end, &value);
+    if (!q && i < numRequired) {
+      return false;
+    }
+    if (q) {
+      p = q;
     }
+    dst->push_back(value);
   }
-  ifile.close();
-
-  vertices.reserve(1024 * 1024);
-  faces.reserve(1024 * 1024);
-
-  // get all the vertices
-  for (size_t i = 0; i < original_file.size(); ++i) {
-    memcpy(str, original_file[i].c_str(), std::min((size_t)512, original_file[i].size() + 1));
-    str[511] = 0;
-    int n = splitInWords(str, ptrs, ", \t", 128);
-    if (n>0) {
-      if (ptrs[0][0]=='v' && ptrs[0][1]=='\0') {
-        Vec3F vert;
-        vert.x = (float)atof(ptrs[1]);
-        vert.y = (float)atof(ptrs[2]);
-        vert.z = (float)atof(ptrs[3]);
-        vertices.push_back(vert);
-      }            
+  *pp = p;
+  return true;
+}
+
+static void ParseObjChunk(const char *p, const char *end, ObjChunk *chunk) {
+  while (p < end) {
+    p = MeshParse_SkipSpaces(p, end);
+    if (p >= end) {
+      break;
+    }
+    if (p[0] == 'v' && IsObjSpace(p+1, end)) {
+      p++;
+      chunk->mIsValid &= ParseObjFloats(&p, end, 3, 3, &chunk->mPositions);
+    } else if (p[0] == 'v' && p+1 < end && p[1] == 'n' && IsObjSpace(p+2, end)) {
+      p += 2;
+      chunk->mIsValid &= ParseObjFloats(&p, end, 3, 3, &chunk->mNormals);
+    } else if (p[0] == 'v' && p+1 < end && p[1] == 't' && IsObjSpace(p+2, end)) {
+      p += 2;
+      chunk->mIsValid &= ParseObjFloats(&p, end, 2, 1, &chunk->mUVs);
+    } else if (p[0] == 'f' && IsObjSpace(p+1, end)) {
+      // polygons become triangle fans
+      p++;
+      int first[3];
+      int prev[3];
+      int corner[3];
+      int num = 0;
+      while (true) {
+        p = MeshParse_SkipSpaces(p, end);
+        if (p >= end || *p == '\r' || *p == '\n' || *p == '#') {
+          break;
+        }
+        p = ParseObjCorner(p, end, *chunk, corner);
+        if (!p) {
+          chunk->mIsValid = false;
+          return;
+        }
+        chunk->mHasUVs |= (corner[1] != kObjNoIndex);
+        chunk->mHasNormals |= (corner[2] != kObjNoIndex);
+        if (num == 0) {
+          memcpy(first, corner, sizeof(first));
+        } else if (num >= 2) {
+          chunk->mCorners.insert(chunk->mCorners.end(), first, first + 3);
+          chunk->mCorners.insert(chunk->mCorners.end(), prev, prev + 3);
+          chunk->mCorners.insert(chunk->mCorners.end(), corner, corner + 3);
+        }
+        memcpy(prev, corner, sizeof(prev));
+        num++;
+      }
     }
+    if (!chunk->mIsValid) {
+      return;
+    }
+    p = MeshParse_SkipLine(p, end);
+  }
+}
+
+static inline bool ResolveObjIndex(int *index, int base, int num) {
+  if (*index == kObjNoIndex) {
+    return true;
+  }
+  if (*index < kObjNoIndex) {
+    *index = base + (-2 - *index) - kObjRelativeBias;
   }
+  return *index >= 0 && *index < num;
+}
 
-  // get all the faces
-
-  //int group    = -1;
-  //int newgrouprequest = 0;
-  //int matid = -1;
-  for (size_t i = 0; i < original_file.size(); ++i) {
-    MeshFace face;
-    memcpy(str, original_file[i].c_str(), std::min((size_t)512, original_file[i].size() + 1));
-    str[511] = 0;
-    int n = splitInWords(str, ptrs, ", \t", 128);
-    if (n>0) {
-      if (ptrs[0][0]=='v' && ptrs[0][1]=='\0') {
-      // } else if (ptrs[0][0]=='g' && ptrs[0][1]=='\0')
-      // {
-      //    newgrouprequest=1;
-      //}
-      //else if (strcmp(ptrs[0],"usemtl")==0)
-      // {
-      //     newgrouprequest=1;
-      // }
-      } else if (ptrs[0][0]=='f' && ptrs[0][1]=='\0' && n>=(3+1)) {
-        if (n==(1+3)) {
-          face.mIndex[0] = atoi(ptrs[1])-1;
-          face.mIndex[1] = atoi(ptrs[2])-1;
-          face.mIndex[2] = atoi(ptrs[3])-1;
-          //face.mat = matid;
-          faces.push_back(face);
-        } else if (n==(1+4)) {
-          face.mIndex[0] = atoi(ptrs[1])-1;
-          face.mIndex[1] = atoi(ptrs[2])-1;
-          face.mIndex[2] = atoi(ptrs[3])-1;
-
-
-          faces.push_back(face);
-          face.mIndex[0] = atoi(ptrs[3])-1;
-          face.mIndex[1] = atoi(ptrs[4])-1;
-          face.mIndex[2] = atoi(ptrs[1])-1;
-          //face.mat = matid;
-          faces.push_back(face);
-
-        } else {
-          // TODO: tesselate N-polygons into triangle!
-          const int num = n-1;
-          if (num<32) {	
-            unsigned int indices[32];
-            for (int i=0; i<num; i++) {
-              indices[i] = atoi(ptrs[1+i])-1;
-            }
-
-            for (int i=0; i<num-2; i++) {
-              face.mIndex[0] = indices[0];
-              face.mIndex[1] = indices[i+1];
-              face.mIndex[2] = indices[i+2];
-              //face.mat = matid;
-              faces.push_back(face);
-            }
+// unique v/vt/vn triplets, open addressing
+static void MakeObjVertices(const std::vector<int> &corners,
+    std::vector<int> *vertices, std::vector<int> *indices) {
+  const size_t numCorners = corners.size()/3;
+  size_t cap = 1024;
+  while (cap < numCorners/2) {
+    cap <<= 1;
+  }
+  std::vector<int> table(cap, -1);
+  indices->resize(numCorners);
+  vertices->clear();
+  for (size_t i=0; i<numCorners; i++) {
+    const int *key = &corners[i*3];
+    size_t mask = cap - 1;
+    size_t slot = ((unsigned)key[0]*0x9E3779B1u ^ (unsigned)key[1]*0x85EBCA77u ^
+      (unsigned)key[2]*0xC2B2AE3Du) & mask;
+    int id;
+    while ((id = table[slot]) != -1 &&
+        memcmp(&(*vertices)[id*3], key, 3*sizeof(int))) {
+      slot = (slot + 1) & mask;
+    }
+    if (id == -1) {
+      id = (int)(vertices->size()/3);
+      vertices->insert(vertices->end(), key, key + 3);
+      table[slot] = id;
+      // keep the table at most half full
+      if ((size_t)id*2 >= cap) {
+        cap <<= 1;
+        mask = cap - 1;
+        table.assign(cap, -1);
+        for (int j=0; j<=id; j++) {
+          const int *k = &(*vertices)[j*3];
+          size_t s = ((unsigned)k[0]*0x9E3779B1u ^ (unsigned)k[1]*0x85EBCA77u ^
+            (unsigned)k[2]*0xC2B2AE3Du) & mask;
+          while (table[s] != -1) {
+            s = (s + 1) & mask;
           }
+          table[s] = j;
         }
-      }     
+      }
     }
+    (*indices)[i] = id;
   }
+}
 
+int MeshObj_Read(Mesh *me, const char *name, bool calcNormals) {
+  MeshFileMap file;
+  if (!MeshFileMap_Init(&file, name)) {
+    return 0;
+  }
 
-  if (calcNormals) {
-    const MeshVertexFormat vf = { 6*sizeof(float), 2, 0, {{3, kRMVEDT_Float, false},
-      {3, kRMVEDT_Float, false} } };
-    if (!me->Init(1, (int)vertices.size(), &vf, kRMVEDT_Polys, 1, (int)faces.size())) {
+  // parse the chunks in parallel, then put them together in the file order
+  std::vector<Ui64> starts;
+  MeshParse_SplitLines(file.mData, file.mSize, kObjChunkSize, &starts);
+  const int numChunks = (int)starts.size() - 1;
+  std::vector<ObjChunk> chunks(numChunks);
+  ParallelFor(0, numChunks, 1, [&](Si32 from, Si32 to) {
+    for (Si32 i=from; i<to; i++) {
+      ParseObjChunk(file.mData + starts[i], file.mData + starts[i+1],
+        &chunks[i]);
+    }
+  });
+  MeshFileMap_DeInit(&file);
+
+  std::vector<int> posBase(numChunks + 1, 0);
+  std::vector<int> norBase(numChunks + 1, 0);
+  std::vector<int> uvBase(numChunks + 1, 0);
+  std::vector<size_t> cornerBase(numChunks + 1, 0);
+  bool hasNormals = false;
+  bool hasUVs = false;
+  for (int i=0; i<numChunks; i++) {
+    if (!chunks[i].mIsValid) {
       return 0;
     }
-  } else {
-    const MeshVertexFormat vf = { 3*sizeof(float), 1, 0, { {3, kRMVEDT_Float, false} } };
-    if (!me->Init(1, (int)vertices.size(), &vf, kRMVEDT_Polys, 1, (int)faces.size())) {
+    posBase[i+1] = posBase[i] + (int)(chunks[i].mPositions.size()/3);
+    norBase[i+1] = norBase[i] + (int)(chunks[i].mNormals.size()/3);
+    uvBase[i+1] = uvBase[i] + (int)(chunks[i].mUVs.size()/2);
+    cornerBase[i+1] = cornerBase[i] + chunks[i].mCorners.size();
+    hasNormals |= chunks[i].mHasNormals;
+    hasUVs |= chunks[i].mHasUVs;
+  }
+  const int numPositions = posBase[numChunks];
+  const int numNormals = norBase[numChunks];
+  const int numUVs = uvBase[numChunks];
+
+  std::vector<float> positions(numPositions*3);
+  std::vector<float> normals(numNormals*3);
+  std::vector<float> uvs(numUVs*2);
+  std::vector<int> corners(cornerBase[numChunks]);
+  std::vector<char> isChunkValid(numChunks, 1);
+  std::vector<char> isUVMatching(numChunks, 1);
+  std::vector<char> isNormalMatching(numChunks, 1);
+  ParallelFor(0, numChunks, 1, [&](Si32 from, Si32 to) {
+    for (Si32 i=from; i<to; i++) {
+      ObjChunk *chunk = &chunks[i];
+      int *dst = corners.data() + cornerBase[i];
+      for (size_t j=0; j<chunk->mCorners.size(); j+=3) {
+        dst[j+0] = chunk->mCorners[j+0];
+        dst[j+1] = chunk->mCorners[j+1];
+        dst[j+2] = chunk->mCorners[j+2];
+        if (!ResolveObjIndex(&dst[j+0], posBase[i], numPositions) ||
+            !ResolveObjIndex(&dst[j+1], uvBase[i], numUVs) ||
+            !ResolveObjIndex(&dst[j+2], norBase[i], numNormals) ||
+            dst[j+0] == kObjNoIndex) {
+          isChunkValid[i] = 0;
+        }
+        isUVMatching[i] &= (dst[j+1] == dst[j+0]);
+        isNormalMatching[i] &= (dst[j+2] == dst[j+0]);
+      }
+      std::copy(chunk->mPositions.begin(), chunk->mPositions.end(),
+        positions.begin() + posBase[i]*3);
+      std::copy(chunk->mNormals.begin(), chunk->mNormals.end(),
+        normals.begin() + norBase[i]*3);
+      std::copy(chunk->mUVs.begin(), chunk->mUVs.end(),
+        uvs.begin() + uvBase[i]*2);
+      *chunk = ObjChunk();
+    }
+  });
+  bool isMatching = true;
+  for (int i=0; i<numChunks; i++) {
+    if (!isChunkValid[i]) {
       return 0;
     }
+    isMatching &= (!hasUVs || isUVMatching[i]) &&
+      (!hasNormals || isNormalMatching[i]);
   }
+  chunks.clear();
 
-  // copy vertices
-  //memcpy(me->mVertexData.mBuffer, vertices.mBuffer, vertices.mNum*sizeof(Vec3F));
-  float *vptr = (float*)&vertices[0];
-  for (unsigned int i = 0; i<vertices.size(); i++) {
-    float *v = (float*)me->GetVertexData(0, i, 0);
-    v[0] = vptr[0];
-    v[1] = vptr[1];
-    v[2] = vptr[2];
-    vptr += 3;
+  // The positions are the vertices when the faces use no vt and vn or use
+  // the same index for all of them, as the scanners write them. Otherwise
+  // every v/vt/vn triplet used becomes one.
+  std::vector<int> vertices;
+  std::vector<int> indices;
+  int numVerts = numPositions;
+  if (!isMatching) {
+    MakeObjVertices(corners, &vertices, &indices);
+    numVerts = (int)(vertices.size()/3);
+  }
+  const int numFaces = (int)(corners.size()/9);
+
+  const bool withNormals = hasNormals || calcNormals;
+  MeshVertexFormat vf;
+  vf.mNumElems = 0;
+  vf.mElems[vf.mNumElems].mNumComponents = 3;
+  vf.mElems[vf.mNumElems++].mType = kRMVEDT_Float;
+  if (withNormals) {
+    vf.mElems[vf.mNumElems].mNumComponents = 3;
+    vf.mElems[vf.mNumElems++].mType = kRMVEDT_Float;
+  }
+  if (hasUVs) {
+    vf.mElems[vf.mNumElems].mNumComponents = 2;
+    vf.mElems[vf.mNumElems++].mType = kRMVEDT_Float;
   }
-  // copy faces
-  memcpy(me->mFaceData.mIndexArray[0].mBuffer, &faces[0], faces.size()*sizeof(MeshFace));
+  vf.mStride = (3 + (withNormals ? 3 : 0) + (hasUVs ? 2 : 0))*sizeof(float);
+  if (!me->Init(1, numVerts, &vf, kRMVEDT_Polys, 1, numFaces)) {
+    return 0;
+  }
+
+  // straight into the vertex stream and the index array
+  const int uvElem = withNormals ? 2 : 1;
+  ParallelFor(0, numVerts, 0, [&](Si32 from, Si32 to) {
+    for (Si32 i=from; i<to; i++) {
+      const int *src = vertices.empty() ? nullptr : &vertices[i*3];
+      const int pos = src ? src[0] : i;
+      const int uv = src ? src[1] : ((i < numUVs) ? i : kObjNoIndex);
+      const int nor = src ? src[2] : ((i < numNormals) ? i : kObjNoIndex);
+      memcpy(me->GetVertexData(0, i, 0), &positions[pos*3], 3*sizeof(float));
+      if (hasNormals && nor != kObjNoIndex) {
+        memcpy(me->GetVertexData(0, i, 1), &normals[nor*3], 3*sizeof(float));
+      }
+      if (hasUVs && uv != kObjNoIndex) {
+        memcpy(me->GetVertexData(0, i, uvElem), &uvs[uv*2], 2*sizeof(float));
+      }
+    }
+  });
+  ParallelFor(0, numFaces, 0, [&](Si32 from, Si32 to) {
+    for (Si32 i=from; i<to; i++) {
+      MeshFace *face = me->mFaceData.mIndexArray[0].mBuffer + i;
+      for (int k=0; k<3; k++) {
+        face->mIndex[k] = indices.empty() ? corners[i*9 + k*3] :
+          indices[i*3 + k];
+      }
+    }
+  });
 
   if (calcNormals) {
     me->Normalize(0, 0, 1);
@@ -181,4 +355,3 @@ int MeshObj_Read(Mesh *me, const char *name, bool calcNormals) {
 }
 
 }
-
@@ -30,6 +30,10 @@
 
 namespace arctic {
 
-int MeshObj_Read(Mesh *mesh, const wchar_t *name, bool calcNormals);
+// Reads v, vt, vn and f, the polygons become triangle fans. The vertices
+// hold the position, the normal if the file has normals or calcNormals is
+// set, and then the uv if the file has uvs. calcNormals computes the
+// normals from the faces.
+int MeshObj_Read(Mesh *mesh, const char *name, bool calcNormals);
 
 } // namespace arctic
@@ -0,0 +1,471 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Huldra
+// Copyright (c) 2015 - 2016 Inigo Quilez
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "engine/mesh_optimize.h"
+#include "engine/vec3f.h"
+
+namespace arctic {
+
+namespace {
+
+// Forsyth, "Linear-Speed Vertex Cache Optimisation"
+const float kCacheDecayPower = 1.5f;
+const float kLastFaceScore = 0.75f;
+const float kValenceBoostScale = 2.0f;
+const float kValenceBoostPower = 0.5f;
+const int kMaxValence = 64;
+
+// A vertex stays in the FIFO cache until cacheSize other vertices got
+// transformed after it
+struct FifoCache {
+  std::vector<unsigned int> mStamp;
+  unsigned int mTime;
+  unsigned int mSize;
+
+  FifoCache(int numVerts, int cacheSize)
+    : mStamp(numVerts, 0), mTime(cacheSize + 1), mSize(cacheSize) {}
+  int Miss(int v) {
+    if (mTime - mStamp[v] > mSize) {
+      mStamp[v] = mTime++;
+      return 1;
+    }
+    return 0;
+  }
+  int Misses(const MeshFace &face) {
+    return Miss(face.mIndex[0]) + Miss(face.mIndex[1]) + Miss(face.mIndex[2]);
+  }
+  void Flush() {
+    mTime += mSize + 1;
+  }
+};
+
+int ClampCacheSize(int cacheSize) {
+  if (cacheSize < 4) {
+    return 4;
+  }
+  return (cacheSize > MeshOptimize_MAXCACHESIZE) ?
+    MeshOptimize_MAXCACHESIZE : cacheSize;
+}
+
+// the streams with one element per vertex, instance streams are skipped
+int GetNumVerts(const Mesh *me) {
+  int num = 0;
+  for (int j=0; j<me->mVertexData.mNumVertexArrays; j++) {
+    const MeshVertexArray *va = me->mVertexData.mVertexArray + j;
+    if (va->mFormat.mDivisor == 0 && (int)va->mNum > num) {
+      num = va->mNum;
+    }
+  }
+  return num;
+}
+
+struct ForsythScores {
+  float mCache[MeshOptimize_MAXCACHESIZE + 3];
+  float mValence[kMaxValence + 1];
+
+  explicit ForsythScores(int cacheSize) {
+    const float scaler = 1.0f / (float)(cacheSize - 3);
+    for (int i=0; i<cacheSize + 3; i++) {
+      if (i < 3) {
+        mCache[i] = kLastFaceScore;
+      } else if (i < cacheSize) {
+        mCache[i] = powf(1.0f - (float)(i - 3)*scaler, kCacheDecayPower);
+      } else {
+        mCache[i] = 0.0f;
+      }
+    }
+    mValence[0] = 0.0f;
+    for (int i=1; i<=kMaxValence; i++) {
+      mValence[i] = kValenceBoostScale*powf((float)i, -kValenceBoostPower);
+    }
+  }
+  float Get(int cachePos, int numLive) const {
+    if (numLive == 0) {
+      return -1.0f;
+    }
+    const float score = (cachePos < 0) ? 0.0f : mCache[cachePos];
+    return score + mValence[(numLive < kMaxValence) ? numLive : kMaxValence];
+  }
+};
+
+void OptimizeVertexCache(MeshFace *faces, int numf, int numVerts,
+    int cacheSize) {
+  const ForsythScores scores(cacheSize);
+
+  // the live faces of a vertex are the first live ones of its range
+  std::vector<int> start(numVerts + 1, 0);
+  std::vector<int> live(numVerts, 0);
+  for (int i=0; i<numf; i++) {
+    for (int k=0; k<3; k++) {
+      live[faces[i].mIndex[k]]++;
+    }
+  }
+  for (int v=0; v<numVerts; v++) {
+    start[v + 1] = start[v] + live[v];
+    live[v] = 0;
+  }
+  std::vector<int> vertFaces(start[numVerts]);
+  for (int i=0; i<numf; i++) {
+    for (int k=0; k<3; k++) {
+      const int v = faces[i].mIndex[k];
+      vertFaces[start[v] + live[v]++] = i;
+    }
+  }
+
+  std::vector<int> cachePos(numVerts, -1);
+  std::vector<float> vertScore(numVerts);
+  for (int v=0; v<numVerts; v++) {
+    vertScore[v] = scores.Get(-1, live[v]);
+  }
+  std::vector<float> faceScore(numf);
+  std::vector<char> isEmitted(numf, 0);
+  int best = -1;
+  float bestScore = -1.0f;
+  for (int i=0; i<numf; i++) {
+    const MeshFace &fa = faces[i];
+    faceScore[i] = vertScore[fa.mIndex[0]] + vertScore[fa.mIndex[1]] +
+      vertScore[fa.mIndex[2]];
+    if (faceScore[i] > bestScore) {
+      bestScore = faceScore[i];
+      best = i;
+    }
+  }
+
+  std::vector<MeshFace> dst(numf);
+  int cache[MeshOptimize_MAXCACHESIZE + 3];
+  int newCache[MeshOptimize_MAXCACHESIZE + 6];
+  int numCache = 0;
+  int cursor = 0;
+  for (int n=0; n<numf; n++) {
+    if (best < 0) {
+      // nothing left around the cache, take the next face in input order
+      while (isEmitted[cursor]) {
+        cursor++;
+      }
+      best = cursor;
+    }
+    const MeshFace fa = faces[best];
+    dst[n] = fa;
+    isEmitted[best] = 1;
+
+    int numNew = 0;
+    for (int k=0; k<3; k++) {
+      const int v = fa.mIndex[k];
+      int *list = vertFaces.data() + start[v];
+      const int last = --live[v];
+      for (int j=0; j<=last; j++) {
+        if (list[j] == best) {
+          list[j] = list[last];
+          list[last] = best;
+          break;
+        }
+      }
+      if (std::find(newCache, newCache + numNew, v) == newCache + numNew) {
+        newCache[numNew++] = v;
+      }
+    }
+    for (int j=0; j<numCache; j++) {
+      const int v = cache[j];
+      if (v != fa.mIndex[0] && v != fa.mIndex[1] && v != fa.mIndex[2]) {
+        newCache[numNew++] = v;
+      }
+    }
+
+    // rescore the vertices of the cache, the evicted ones included
+    for (int j=0; j<numNew; j++) {
+      const int v = newCache[j];
+      cachePos[v] = (j < cacheSize) ? j : -1;
+      vertScore[v] = scores.Get(cachePos[v], live[v]);
+    }
+    best = -1;
+    bestScore = -1.0f;
+    for (int j=0; j<numNew; j++) {
+      const int v = newCache[j];
+      const int *list = vertFaces.data() + start[v];
+      for (int l=0; l<live[v]; l++) {
+        const int f = list[l];
+        const MeshFace &ff = faces[f];
+        faceScore[f] = vertScore[ff.mIndex[0]] + vertScore[ff.mIndex[1]] +
+          vertScore[ff.mIndex[2]];
+        if (faceScore[f] > bestScore) {
+          bestScore = faceScore[f];
+          best = f;
+        }
+      }
+    }
+    numCache = (numNew < cacheSize) ? numNew : cacheSize;
+    memcpy(cache, newCache, numCache*sizeof(int));
+  }
+  memcpy(faces, dst.data(), numf*sizeof(MeshFace));
+}
+
+struct Cluster {
+  int mStart = 0;
+  int mEnd = 0;
+  float mSortKey = 0.0f;
+};
+
+// Sander et al., "Fast Triangle Reordering for Vertex Locality and
+// Reduced Overdraw"
+void OptimizeOverdraw(MeshFace *faces, int numf, int numVerts,
+    const Mesh *me, int cacheSize, float threshold) {
+  FifoCache cache(numVerts, cacheSize);
+
+  // a face with three misses starts a new patch of the mesh
+  std::vector<int> hard;
+  for (int i=0; i<numf; i++) {
+    if (cache.Misses(faces[i]) == 3 || i == 0) {
+      hard.push_back(i);
+    }
+  }
+  hard.push_back(numf);
+
+  // the patches are split where their running ACMR gets close to the one
+  // of the whole patch
+  std::vector<Cluster> clusters;
+  for (size_t h=0; h+1<hard.size(); h++) {
+    const int first = hard[h];
+    const int end = hard[h + 1];
+    cache.Flush();
+    int misses = 0;
+    for (int i=first; i<end; i++) {
+      misses += cache.Misses(faces[i]);
+    }
+    const float target = threshold*(float)misses/(float)(end - first);
+
+    cache.Flush();
+    Cluster cl;
+    cl.mStart = first;
+    int runMisses = 0;
+    int runFaces = 0;
+    for (int i=first; i<end; i++) {
+      runMisses += cache.Misses(faces[i]);
+      runFaces++;
+      if ((float)runMisses <= target*(float)runFaces && i + 1 < end) {
+        cl.mEnd = i + 1;
+        clusters.push_back(cl);
+        cl.mStart = i + 1;
+        cache.Flush();
+        runMisses = 0;
+        runFaces = 0;
+      }
+    }
+    cl.mEnd = end;
+    clusters.push_back(cl);
+  }
+
+  // the clusters facing away from the center are drawn first, they are
+  // the likely occluders
+  std::vector<Vec3F> centroid(clusters.size());
+  std::vector<Vec3F> normal(clusters.size());
+  Vec3F center(0.0f, 0.0f, 0.0f);
+  float area = 0.0f;
+  for (size_t c=0; c<clusters.size(); c++) {
+    Vec3F sum(0.0f, 0.0f, 0.0f);
+    Vec3F nor(0.0f, 0.0f, 0.0f);
+    float clusterArea = 0.0f;
+    for (int i=clusters[c].mStart; i<clusters[c].mEnd; i++) {
+      const MeshFace &fa = faces[i];
+      const Vec3F a = *(const Vec3F*)me->GetVertexData(0, fa.mIndex[0], 0);
+      const Vec3F b = *(const Vec3F*)me->GetVertexData(0, fa.mIndex[1], 0);
+      const Vec3F d = *(const Vec3F*)me->GetVertexData(0, fa.mIndex[2], 0);
+      const Vec3F n = Cross(b - a, d - a);
+      const float faceArea = Length(n);
+      sum = sum + (a + b + d)*faceArea;
+      nor = nor + n;
+      clusterArea += faceArea;
+    }
+    center = center + sum;
+    area += clusterArea;
+    centroid[c] = (clusterArea > 0.0f) ? sum*(1.0f/(3.0f*clusterArea)) : sum;
+    normal[c] = NormalizeSafe(nor);
+  }
+  if (area > 0.0f) {
+    center = center*(1.0f/(3.0f*area));
+  }
+  for (size_t c=0; c<clusters.size(); c++) {
+    clusters[c].mSortKey = Dot(centroid[c] - center, normal[c]);
+  }
+  std::stable_sort(clusters.begin(), clusters.end(),
+    [](const Cluster &a, const Cluster &b) {
+      return a.mSortKey > b.mSortKey;
+    });
+
+  std::vector<MeshFace> dst(numf);
+  int n = 0;
+  for (size_t c=0; c<clusters.size(); c++) {
+    const int num = clusters[c].mEnd - clusters[c].mStart;
+    memcpy(dst.data() + n, faces + clusters[c].mStart, num*sizeof(MeshFace));
+    n += num;
+  }
+  memcpy(faces, dst.data(), numf*sizeof(MeshFace));
+}
+
+} // namespace
+
+void MeshOptimize_GetStats(const Mesh *me, int cacheSize,
+    MeshOptimizeStats *stats) {
+  *stats = MeshOptimizeStats();
+  const int numVerts = GetNumVerts(me);
+  if (me->mFaceData.mType != kRMVEDT_Polys || numVerts == 0) {
+    return;
+  }
+  // the index arrays are drawn apart, the cache starts empty for each
+  FifoCache cache(numVerts, ClampCacheSize(cacheSize));
+  std::vector<char> isUsed(numVerts, 0);
+  for (int j=0; j<me->mFaceData.mNumIndexArrays; j++) {
+    const MeshIndexArray *ia = me->mFaceData.mIndexArray + j;
+    cache.Flush();
+    for (unsigned int i=0; i<ia->mNum; i++) {
+      const MeshFace &fa = ia->mBuffer[i];
+      stats->mNumTransformed += cache.Misses(fa);
+      for (int k=0; k<3; k++) {
+        stats->mNumVerts += isUsed[fa.mIndex[k]] ? 0 : 1;
+        isUsed[fa.mIndex[k]] = 1;
+      }
+    }
+    stats->mNumFaces += ia->mNum;
+  }
+  if (stats->mNumFaces > 0) {
+    stats->mAcmr = (float)stats->mNumTransformed/(float)stats->mNumFaces;
+    stats->mAtvr = (float)stats->mNumTransformed/(float)stats->mNumVerts;
+  }
+}
+
+bool MeshOptimize_VertexCache(Mesh *me, int cacheSize) {
+  const int numVerts = GetNumVerts(me);
+  if (me->mFaceData.mType != kRMVEDT_Polys || numVerts == 0) {
+    return true;
+  }
+  for (int j=0; j<me->mFaceData.mNumIndexArrays; j++) {
+    MeshIndexArray *ia = me->mFaceData.mIndexArray + j;
+    OptimizeVertexCache(ia->mBuffer, ia->mNum, numVerts,
+      ClampCacheSize(cacheSize));
+  }
+  return true;
+}
+
+bool MeshOptimize_Overdraw(Mesh *me, int cacheSize, float threshold) {
+  const int numVerts = GetNumVerts(me);
+  if (me->mFaceData.mType != kRMVEDT_Polys || numVerts == 0) {
+    return true;
+  }
+  if (me->mVertexData.mNumVertexArrays == 0) {
+    return false;
+  }
+  const MeshVertexFormat &format = me->mVertexData.mVertexArray[0].mFormat;
+  if (format.mNumElems == 0 || format.mElems[0].mType != kRMVEDT_Float ||
+      format.mElems[0].mNumComponents < 3) {
+    return false;
+  }
+  for (int j=0; j<me->mFaceData.mNumIndexArrays; j++) {
+    MeshIndexArray *ia = me->mFaceData.mIndexArray + j;
+    if (ia->mNum > 0) {
+      OptimizeOverdraw(ia->mBuffer, ia->mNum, numVerts, me,
+        ClampCacheSize(cacheSize), threshold);
+    }
+  }
+  return true;
+}
+
+bool MeshOptimize_VertexFetch(Mesh *me) {
+  const int numVerts = GetNumVerts(me);
+  if (me->mFaceData.mType != kRMVEDT_Polys || numVerts == 0) {
+    return true;
+  }
+
+  std::vector<int> remap(numVerts, -1);
+  int num = 0;
+  for (int j=0; j<me->mFaceData.mNumIndexArrays; j++) {
+    const MeshIndexArray *ia = me->mFaceData.mIndexArray + j;
+    for (unsigned int i=0; i<ia->mNum; i++) {
+      for (int k=0; k<3; k++) {
+        const int v = ia->mBuffer[i].mIndex[k];
+        if (remap[v] == -1) {
+          remap[v] = num++;
+        }
+      }
+    }
+  }
+  for (int v=0; v<numVerts; v++) {
+    if (remap[v] == -1) {
+      remap[v] = num++;
+    }
+  }
+
+  for (int j=0; j<me->mVertexData.mNumVertexArrays; j++) {
+    MeshVertexArray *va = me->mVertexData.mVertexArray + j;
+    if (va->mFormat.mDivisor != 0 || (int)va->mNum != numVerts) {
+      continue;
+    }
+    const int stride = va->mFormat.mStride;
+    char *buffer = (char*)malloc(numVerts*stride);
+    if (!buffer) {
+      return false;
+    }
+    for (int i=0; i<numVerts; i++) {
+      memcpy(buffer + remap[i]*stride, (char*)va->mBuffer + i*stride, stride);
+    }
+    free(va->mBuffer);
+    va->mBuffer = buffer;
+    va->mMax = numVerts;
+  }
+
+  for (int j=0; j<me->mFaceData.mNumIndexArrays; j++) {
+    MeshIndexArray *ia = me->mFaceData.mIndexArray + j;
+    for (unsigned int i=0; i<ia->mNum; i++) {
+      for (int k=0; k<3; k++) {
+        ia->mBuffer[i].mIndex[k] = remap[ia->mBuffer[i].mIndex[k]];
+      }
+    }
+  }
+  return true;
+}
+
+bool MeshOptimize_Process(Mesh *me, int cacheSize, float threshold,
+    MeshOptimizeStats *before, MeshOptimizeStats *after) {
+  if (before) {
+    MeshOptimize_GetStats(me, cacheSize, before);
+  }
+  if (!MeshOptimize_VertexCache(me, cacheSize) ||
+      !MeshOptimize_Overdraw(me, cacheSize, threshold) ||
+      !MeshOptimize_VertexFetch(me)) {
+    return false;
+  }
+  if (after) {
+    MeshOptimize_GetStats(me, cacheSize, after);
+  }
+  return true;
+}
+
+} // namespace arctic
@@ -0,0 +1,66 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Huldra
+// Copyright (c) 2015 - 2016 Inigo Quilez
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+#pragma once
+
+#include "engine/mesh.h"
+
+namespace arctic {
+
+#define MeshOptimize_MAXCACHESIZE 32
+
+// Post-transform cache efficiency of the index arrays, simulated with a
+// FIFO cache. A transformed vertex is a cache miss.
+struct MeshOptimizeStats {
+  int mNumFaces = 0;
+  int mNumVerts = 0;          // referenced by the faces
+  int mNumTransformed = 0;
+  float mAcmr = 0.0f;         // transformed vertices per face, 0.5 to 3
+  float mAtvr = 0.0f;         // transformed vertices per vertex, 1 or more
+};
+
+void MeshOptimize_GetStats(const Mesh *me, int cacheSize,
+  MeshOptimizeStats *stats);
+
+// Reorders the faces of every index array for the vertex cache, with
+// Forsyth's scoring
+bool MeshOptimize_VertexCache(Mesh *me, int cacheSize);
+// Splits the cache ordered faces of every index array in clusters and
+// draws the outward facing clusters first. The clusters end where the
+// running ACMR reaches threshold times the one of the whole patch, 1.05
+// keeps most of the cache efficiency. Needs the positions in the element
+// 0 of the vertex stream 0.
+bool MeshOptimize_Overdraw(Mesh *me, int cacheSize, float threshold);
+// Moves the vertices of all the per vertex streams to the order the faces
+// first use them, the unused ones go last
+bool MeshOptimize_VertexFetch(Mesh *me);
+
+// The three passes in order, before and after can be null
+bool MeshOptimize_Process(Mesh *me, int cacheSize, float threshold,
+  MeshOptimizeStats *before, MeshOptimizeStats *after);
+
+} // namespace arctic
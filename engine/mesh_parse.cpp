@@ -0,0 +1,188 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Huldra
+// Copyright (c) 2015 - 2016 Inigo Quilez
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#include "engine/mesh_parse.h"
+
+namespace arctic {
+
+bool MeshFileMap_Init(MeshFileMap *me, const char *name) {
+  *me = MeshFileMap();
+  if (!OpenMappedFile(name, &me->mFile, &me->mSize)) {
+    return false;
+  }
+  if (me->mSize == 0 || !MapFileView(me->mFile, 0, me->mSize, &me->mView)) {
+    MeshFileMap_DeInit(me);
+    return false;
+  }
+  me->mData = (const char*)me->mView.data;
+  return true;
+}
+
+void MeshFileMap_DeInit(MeshFileMap *me) {
+  UnmapFileView(&me->mView);
+  CloseMappedFile(&me->mFile);
+  me->mData = nullptr;
+  me->mSize = 0;
+}
+
+void MeshParse_SplitLines(const char *data, Ui64 size, Ui64 minChunkSize,
+    std::vector<Ui64> *starts) {
+  const unsigned numThreads = std::thread::hardware_concurrency();
+  const Ui64 maxNum = (Ui64)(numThreads ? numThreads : 1) * 4;
+  Ui64 num = size / (minChunkSize ? minChunkSize : 1);
+  num = (num < 1) ? 1 : ((num > maxNum) ? maxNum : num);
+
+  starts->clear();
+  starts->push_back(0);
+  for (Ui64 i=1; i<num; i++) {
+    Ui64 pos = size / num * i;
+    if (pos <= starts->back()) {
+      continue;
+    }
+    const void *eol = memchr(data + pos, '\n', (size_t)(size - pos));
+    if (!eol) {
+      break;
+    }
+    pos = (Ui64)((const char*)eol - data) + 1;
+    if (pos < size) {
+      starts->push_back(pos);
+    }
+  }
+  starts->push_back(size);
+}
+
+static const double kPowersOf10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+const char *MeshParse_Double(const char *p, const char *end, double *res) {
+  p = MeshParse_SkipSpaces(p, end);
+  bool isNegative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    isNegative = (*p == '-');
+    p++;
+  }
+
+  // up to 19 significant digits fit the mantissa
+  Ui64 mantissa = 0;
+  int numDigits = 0;
+  int exponent = 0;
+  bool hasDigits = false;
+  while (p < end && (unsigned)(*p - '0') < 10u) {
+    if (numDigits < 19) {
+      mantissa = mantissa*10 + (unsigned)(*p - '0');
+      numDigits += (mantissa != 0);
+    } else {
+      exponent++;
+    }
+    hasDigits = true;
+    p++;
+  }
+  if (p < end && *p == '.') {
+    p++;
+    while (p < end && (unsigned)(*p - '0') < 10u) {
+      if (numDigits < 19) {
+        mantissa = mantissa*10 + (unsigned)(*p - '0');
+        numDigits += (mantissa != 0);
+        exponent--;
+      }
+      hasDigits = true;
+      p++;
+    }
+  }
+  if (!hasDigits) {
+    return nullptr;
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    const char *q = p + 1;
+    bool isExponentNegative = false;
+    if (q < end && (*q == '-' || *q == '+')) {
+      isExponentNegative = (*q == '-');
+      q++;
+    }
+    if (q < end && (unsigned)(*q - '0') < 10u) {
+      int e = 0;
+      while (q < end && (unsigned)(*q - '0') < 10u) {
+        e = (e < 10000) ? e*10 + (*q - '0') : e;
+        q++;
+      }
+      exponent += isExponentNegative ? -e : e;
+      p = q;
+    }
+  }
+
+  // exact powers of 10 leave a single rounding for the common cases
+  double value = (double)mantissa;
+  if (mantissa == 0) {
+    value = 0.0;
+  } else if (exponent < 0) {
+    value = (exponent >= -22) ? value / kPowersOf10[-exponent] :
+      value * std::pow(10.0, (double)exponent);
+  } else if (exponent > 0) {
+    value = (exponent <= 22) ? value * kPowersOf10[exponent] :
+      value * std::pow(10.0, (double)exponent);
+  }
+  *res = isNegative ? -value : value;
+  return p;
+}
+
+const char *MeshParse_Float(const char *p, const char *end, float *res) {
+  double value;
+  p = MeshParse_Double(p, end, &value);
+  if (p) {
+    *res = (float)value;
+  }
+  return p;
+}
+
+const char *MeshParse_Int(const char *p, const char *end, int *res) {
+  p = MeshParse_SkipSpaces(p, end);
+  bool isNegative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    isNegative = (*p == '-');
+    p++;
+  }
+  if (p >= end || (unsigned)(*p - '0') >= 10u) {
+    return nullptr;
+  }
+  Si64 value = 0;
+  while (p < end && (unsigned)(*p - '0') < 10u) {
+    value = (value < 0x80000000ll) ? value*10 + (*p - '0') : value;
+    p++;
+  }
+  if (value > 0x7fffffffll) {
+    return nullptr;
+  }
+  *res = isNegative ? -(int)value : (int)value;
+  return p;
+}
+
+}  // namespace arctic
@@ -0,0 +1,76 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Huldra
+// Copyright (c) 2015 - 2016 Inigo Quilez
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#pragma once
+
+#include <vector>
+
+#include "engine/arctic_platform.h"
+#include "engine/arctic_types.h"
+
+namespace arctic {
+
+// A whole file mapped into memory, read only by the importers.
+struct MeshFileMap {
+  MappedFileHandle mFile;
+  MappedFileView mView;
+  const char *mData = nullptr;
+  Ui64 mSize = 0;
+};
+
+bool MeshFileMap_Init(MeshFileMap *me, const char *name);
+void MeshFileMap_DeInit(MeshFileMap *me);
+
+// Splits [0, size) into chunks for the parallel parsing, every chunk but
+// the first one starts right after a '\n'. Fills the chunk starts and
+// the end, about one chunk per minChunkSize bytes, 4 chunks per thread
+// at most.
+void MeshParse_SplitLines(const char *data, Ui64 size, Ui64 minChunkSize,
+  std::vector<Ui64> *starts);
+
+inline const char *MeshParse_SkipSpaces(const char *p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t')) {
+    p++;
+  }
+  return p;
+}
+
+inline const char *MeshParse_SkipLine(const char *p, const char *end) {
+  while (p < end && *p != '\n') {
+    p++;
+  }
+  return (p < end) ? p + 1 : p;
+}
+
+// The number parsers skip the leading spaces and return the address
+// after the number, or nullptr if there is no number there.
+// The floats are within one ulp of strtof, without the locale and the
+// hex, inf and nan forms.
+const char *MeshParse_Float(const char *p, const char *end, float *res);
+const char *MeshParse_Double(const char *p, const char *end, double *res);
+const char *MeshParse_Int(const char *p, const char *end, int *res);
+
+}  // namespace arctic
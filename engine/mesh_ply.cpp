@@ -24,13 +24,53 @@
 // FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
 // IN THE SOFTWARE.
 
+#include <atomic>
 #include <cstring>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string>
+#include <vector>
+#include "engine/arctic_job_system.h"
+#include "engine/mesh_parse.h"
 #include "engine/mesh_ply.h"
 
 namespace arctic {
 
+static const Ui64 kPlyChunkSize = 256*1024;
+
+enum PlyFormat {
+  kPlyAscii = 0,
+  kPlyBinaryLittleEndian = 1,
+  kPlyBinaryBigEndian = 2
+};
+
+enum PlyType {
+  kPlyNone = 0,
+  kPlyInt8, kPlyUInt8, kPlyInt16, kPlyUInt16,
+  kPlyInt32, kPlyUInt32, kPlyFloat32, kPlyFloat64
+};
+
+static const int kPlyTypeSize[] = { 0, 1, 1, 2, 2, 4, 4, 4, 8 };
+
+// where the property goes: a float of the mesh vertex, the face indices
+// or nowhere
+static const int kPlySkip = -1;
+static const int kPlyFaceIndices = -2;
+
+struct PlyProperty {
+  PlyType mType = kPlyNone;
+  PlyType mCountType = kPlyNone;  // kPlyNone for the scalars
+  std::string mName;
+  int mTarget = kPlySkip;
+};
+
+struct PlyElement {
+  std::string mName;
+  Si64 mNum = 0;
+  std::vector<PlyProperty> mProperties;
+  int mRowSize = 0;  // binary, -1 for the elements with lists
+};
+
 static int separa_palabras(char *str, char *ptrs[], const char *del, int maxpalabras) {
   if (str[0]==';') return 0;
   if (str[0]==0) return 0;
@@ -46,107 +86,523 @@ static int separa_palabras(char *str, char *ptrs[], const char *del, int maxpala
   return i;
 }
 
-static int readline(char *str, int max, FILE *fp) {
-  size_t l;
+static PlyType GetPlyType(const char *str) {
+  static const char *names[] = { "", "char", "uchar", "short", "ushort",
+    "int", "uint", "float", "double" };
+  static const char *sizedNames[] = { "", "int8", "uint8", "int16", "uint16",
+    "int32", "uint32", "float32", "float64" };
+  for (int i=1; i<9; i++) {
+    if (!strcmp(str, names[i]) || !strcmp(str, sizedNames[i])) {
+      return (PlyType)i;
+    }
+  }
+  return kPlyNone;
+}
 
-  if (!fgets(str,max,fp)) {
-    return 0;
+static bool ReadPlyHeader(const char *data, Ui64 size, PlyFormat *format,
+    std::vector<PlyElement> *elements, Ui64 *bodyOffset) {
+  char str[256];
+  char *ptrs[16];
+  Ui64 pos = 0;
+  bool isFirst = true;
+  while (pos < size) {
+    const char *line = data + pos;
+    const void *eol = memchr(line, '\n', (size_t)(size - pos));
+    const Ui64 len = eol ? (Ui64)((const char*)eol - line) : size - pos;
+    pos += len + (eol ? 1 : 0);
+    if (len >= sizeof(str)) {
+      return false;
+    }
+    memcpy(str, line, (size_t)len);
+    str[len] = 0;
+
+    const int n = separa_palabras(str, ptrs, " \t\r", 16);
+    if (isFirst) {
+      if (n!=1 || strcmp(ptrs[0], "ply")) {
+        return false;
+      }
+      isFirst = false;
+    } else if (n==0 || !strcmp(ptrs[0], "comment") || !strcmp(ptrs[0], "obj_info")) {
+    } else if (!strcmp(ptrs[0], "format") && n>=2) {
+      if (!strcmp(ptrs[1], "ascii")) {
+        *format = kPlyAscii;
+      } else if (!strcmp(ptrs[1], "binary_little_endian")) {
+        *format = kPlyBinaryLittleEndian;
+      } else if (!strcmp(ptrs[1], "binary_big_endian")) {
+        *format = kPlyBinaryBigEndian;
+      } else {
+        return false;
+      }
+    } else if (!strcmp(ptrs[0], "element") && n>=3) {
+      PlyElement el;
+      el.mName = ptrs[1];
+      el.mNum = atoll(ptrs[2]);
+      if (el.mNum < 0) {
+        return false;
+      }
+      elements->push_back(el);
+    } else if (!strcmp(ptrs[0], "property") && n>=3 && !elements->empty()) {
+      PlyElement *el = &elements->back();
+      PlyProperty prop;
+      if (!strcmp(ptrs[1], "list") && n>=5) {
+        prop.mCountType = GetPlyType(ptrs[2]);
+        prop.mType = GetPlyType(ptrs[3]);
+        prop.mName = ptrs[4];
+        if (prop.mCountType==kPlyNone || prop.mCountType==kPlyFloat32 ||
+            prop.mCountType==kPlyFloat64) {
+          return false;
+        }
+        el->mRowSize = -1;
+      } else {
+        prop.mType = GetPlyType(ptrs[1]);
+        prop.mName = ptrs[2];
+        if (el->mRowSize >= 0) {
+          el->mRowSize += kPlyTypeSize[prop.mType];
+        }
+      }
+      if (prop.mType == kPlyNone) {
+        return false;
+      }
+      el->mProperties.push_back(prop);
+    } else if (!strcmp(ptrs[0], "end_header")) {
+      *bodyOffset = pos;
+      return true;
+    } else {
+      return false;
+    }
   }
+  return false;
+}
 
-  l = strlen(str)-1;
-  while (str[l]==10 || str[l]==13) {
-    str[l] = 0;
+static inline double ReadPlyValue(const Ui8 *p, PlyType type, bool isSwapped) {
+  Ui8 b[8];
+  const int size = kPlyTypeSize[type];
+  if (isSwapped) {
+    for (int i=0; i<size; i++) {
+      b[i] = p[size-1-i];
+    }
+  } else {
+    memcpy(b, p, size);
   }
+  switch (type) {
+    case kPlyInt8:   { Si8 v;  memcpy(&v, b, 1); return v; }
+    case kPlyUInt8:  { Ui8 v;  memcpy(&v, b, 1); return v; }
+    case kPlyInt16:  { Si16 v; memcpy(&v, b, 2); return v; }
+    case kPlyUInt16: { Ui16 v; memcpy(&v, b, 2); return v; }
+    case kPlyInt32:  { Si32 v; memcpy(&v, b, 4); return v; }
+    case kPlyUInt32: { Ui32 v; memcpy(&v, b, 4); return v; }
+    case kPlyFloat32: { float v; memcpy(&v, b, 4); return v; }
+    case kPlyFloat64: { double v; memcpy(&v, b, 8); return v; }
+    default: return 0.0;
+  }
+}
 
-  return 1;
+// One row of any element, the vertex floats go to vertex and the face
+// indices to poly. Returns the address after the row, nullptr on errors.
+static const Ui8 *ReadPlyBinaryRow(const Ui8 *p, const Ui8 *end,
+    const PlyElement &el, bool isSwapped, float *vertex,
+    std::vector<int> *poly) {
+  for (const PlyProperty &prop : el.mProperties) {
+    if (prop.mCountType == kPlyNone) {
+      if (end - p < kPlyTypeSize[prop.mType]) {
+        return nullptr;
+      }
+      if (prop.mTarget >= 0 && vertex) {
+        vertex[prop.mTarget] = (float)ReadPlyValue(p, prop.mType, isSwapped);
+      }
+      p += kPlyTypeSize[prop.mType];
+    } else {
+      if (end - p < kPlyTypeSize[prop.mCountType]) {
+        return nullptr;
+      }
+      const double num = ReadPlyValue(p, prop.mCountType, isSwapped);
+      p += kPlyTypeSize[prop.mCountType];
+      const int itemSize = kPlyTypeSize[prop.mType];
+      if (num < 0.0 || (double)(end - p) < num*itemSize) {
+        return nullptr;
+      }
+      if (prop.mTarget == kPlyFaceIndices && poly) {
+        for (int i=0; i<(int)num; i++) {
+          poly->push_back((int)ReadPlyValue(p + i*itemSize, prop.mType, isSwapped));
+        }
+      }
+      p += (int)num*itemSize;
+    }
+  }
+  return p;
 }
 
+static const char *ReadPlyAsciiRow(const char *p, const char *end,
+    const PlyElement &el, float *vertex, std::vector<int> *poly) {
+  for (const PlyProperty &prop : el.mProperties) {
+    if (prop.mCountType == kPlyNone) {
+      double value;
+      p = MeshParse_Double(p, end, &value);
+      if (!p) {
+        return nullptr;
+      }
+      if (prop.mTarget >= 0 && vertex) {
+        vertex[prop.mTarget] = (float)value;
+      }
+    } else {
+      int num;
+      p = MeshParse_Int(p, end, &num);
+      if (!p || num < 0) {
+        return nullptr;
+      }
+      for (int i=0; i<num; i++) {
+        double value;
+        p = MeshParse_Double(p, end, &value);
+        if (!p) {
+          return nullptr;
+        }
+        if (prop.mTarget == kPlyFaceIndices && poly) {
+          poly->push_back((int)value);
+        }
+      }
+    }
+  }
+  return p;
+}
 
-int piRenderMeshPly_Read(Mesh *me, const char *name, bool calcNormals) {
-  int n, nv, nf;
-  char str[256];
-  char *ptrs[16];
+// triangle fan of the polygon, false if it uses a missing vertex
+static bool AddPlyPolygon(const std::vector<int> &poly, int numVerts,
+    std::vector<MeshFace> *faces) {
+  for (int v : poly) {
+    if (v < 0 || v >= numVerts) {
+      return false;
+    }
+  }
+  for (size_t i=2; i<poly.size(); i++) {
+    MeshFace face;
+    face.mIndex[0] = poly[0];
+    face.mIndex[1] = poly[i-1];
+    face.mIndex[2] = poly[i];
+    faces->push_back(face);
+  }
+  return true;
+}
 
-  FILE *fp = fopen(name, "rt");
-  if (!fp) {
-    return 0;
+static bool SetPlyFaces(Mesh *me, const std::vector<MeshFace> *faces,
+    int numChunks) {
+  size_t num = 0;
+  for (int i=0; i<numChunks; i++) {
+    num += faces[i].size();
+  }
+  MeshIndexArray *ia = me->mFaceData.mIndexArray + 0;
+  if (num > ia->mMax) {
+    MeshFace *buffer = (MeshFace*)realloc(ia->mBuffer, num*sizeof(MeshFace));
+    if (!buffer) {
+      return false;
+    }
+    ia->mBuffer = buffer;
+    ia->mMax = (unsigned int)num;
+  }
+  ia->mNum = (unsigned int)num;
+  std::vector<size_t> bases(numChunks + 1, 0);
+  for (int i=0; i<numChunks; i++) {
+    bases[i+1] = bases[i] + faces[i].size();
   }
+  ParallelFor(0, numChunks, 1, [&](Si32 from, Si32 to) {
+    for (Si32 i=from; i<to; i++) {
+      if (!faces[i].empty()) {
+        memcpy(ia->mBuffer + bases[i], faces[i].data(),
+          faces[i].size()*sizeof(MeshFace));
+      }
+    }
+  });
+  return true;
+}
 
-  readline(str, 255, fp); if (strcmp(str,"ply")) { fclose(fp); return 0; }
-  fgets(str,255,fp);
-  fgets(str,255,fp);
+static bool ReadPlyAscii(Mesh *me, const char *data, Ui64 size,
+    const std::vector<PlyElement> &elements, int vertexElement,
+    int faceElement) {
+  const int numVerts = me->mVertexData.mVertexArray[0].mNum;
+  const int stride = me->mVertexData.mVertexArray[0].mFormat.mStride;
+  float *vertices = (float*)me->mVertexData.mVertexArray[0].mBuffer;
+
+  // one row per line, the chunks find their first row from the line counts
+  std::vector<Ui64> starts;
+  MeshParse_SplitLines(data, size, kPlyChunkSize, &starts);
+  const int numChunks = (int)starts.size() - 1;
+  std::vector<Si64> firstRows(numChunks + 1, 0);
+  ParallelFor(0, numChunks, 1, [&](Si32 from, Si32 to) {
+    for (Si32 i=from; i<to; i++) {
+      Si64 num = 0;
+      const char *p = data + starts[i];
+      const char *end = data + starts[i+1];
+      while ((p = (const char*)memchr(p, '\n', (size_t)(end - p))) != nullptr) {
+        num++;
+        p++;
+      }
+      firstRows[i+1] = num + ((end > data + starts[i] && end[-1] != '\n') ? 1 : 0);
+    }
+  });
+  for (int i=0; i<numChunks; i++) {
+    firstRows[i+1] += firstRows[i];
+  }
+  std::vector<Si64> elementStarts(elements.size() + 1, 0);
+  for (size_t i=0; i<elements.size(); i++) {
+    elementStarts[i+1] = elementStarts[i] + elements[i].mNum;
+  }
+  if (firstRows[numChunks] < elementStarts[elements.size()]) {
+    return false;
+  }
 
-  readline(str,255,fp); 
-  n = separa_palabras(str, ptrs, " \t", 16);
-  if (strcmp(ptrs[0], "element")) { fclose(fp); return 0; }
-  if (strcmp(ptrs[1], "vertex")) { fclose(fp); return 0; }
-  nv = atoi(ptrs[2]);
+  std::vector<std::vector<MeshFace>> faces(numChunks);
+  std::vector<char> isChunkValid(numChunks, 1);
+  ParallelFor(0, numChunks, 1, [&](Si32 from, Si32 to) {
+    std::vector<int> poly;
+    for (Si32 i=from; i<to; i++) {
+      const char *p = data + starts[i];
+      const char *end = data + starts[i+1];
+      size_t el = 0;
+      for (Si64 row=firstRows[i]; p<end; row++) {
+        while (el < elements.size() && row >= elementStarts[el+1]) {
+          el++;
+        }
+        if (el == elements.size()) {
+          break;
+        }
+        const char *q = p;
+        if ((int)el == vertexElement) {
+          float *vertex = (float*)((char*)vertices +
+            (row - elementStarts[el])*stride);
+          q = ReadPlyAsciiRow(p, end, elements[el], vertex, nullptr);
+        } else if ((int)el == faceElement) {
+          poly.clear();
+          q = ReadPlyAsciiRow(p, end, elements[el], nullptr, &poly);
+          if (q && !AddPlyPolygon(poly, numVerts, &faces[i])) {
+            q = nullptr;
+          }
+        }
+        if (!q) {
+          isChunkValid[i] = 0;
+          break;
+        }
+        p = MeshParse_SkipLine(q, end);
+      }
+    }
+  });
+  for (int i=0; i<numChunks; i++) {
+    if (!isChunkValid[i]) {
+      return false;
+    }
+  }
+  return SetPlyFaces(me, faces.data(), numChunks);
+}
 
-  do {
-    readline(str,255,fp); 
-    n = separa_palabras(str, ptrs, " \t", 16);
-  } while (strcmp(ptrs[0],"property")==0);
+static bool ReadPlyBinaryFaces(Mesh *me, const Ui8 *p, const Ui8 *end,
+    const PlyElement &el, bool isSwapped, const Ui8 **next) {
+  const int numVerts = me->mVertexData.mVertexArray[0].mNum;
+  const int numRows = (int)el.mNum;
+
+  // the scans are triangles, then every row has the same size and the rows
+  // go in parallel straight into the index array
+  int listOffset = -1;
+  int triangleRowSize = 0;
+  const PlyProperty *list = nullptr;
+  for (const PlyProperty &prop : el.mProperties) {
+    if (prop.mCountType == kPlyNone) {
+      triangleRowSize += kPlyTypeSize[prop.mType];
+    } else if (!list && prop.mTarget == kPlyFaceIndices) {
+      list = &prop;
+      listOffset = triangleRowSize;
+      triangleRowSize += kPlyTypeSize[prop.mCountType] + 3*kPlyTypeSize[prop.mType];
+    } else {
+      listOffset = -1;
+      break;
+    }
+  }
+  if (listOffset >= 0 && (Ui64)(end - p) >= (Ui64)numRows*triangleRowSize) {
+    MeshIndexArray *ia = me->mFaceData.mIndexArray + 0;
+    std::atomic<bool> isValid(true);
+    ParallelFor(0, numRows, 0, [&](Si32 from, Si32 to) {
+      for (Si32 i=from; i<to; i++) {
+        const Ui8 *row = p + (Ui64)i*triangleRowSize + listOffset;
+        bool isRowValid = (ReadPlyValue(row, list->mCountType, isSwapped) == 3.0);
+        row += kPlyTypeSize[list->mCountType];
+        for (int k=0; k<3 && isRowValid; k++) {
+          const int v = (int)ReadPlyValue(row + k*kPlyTypeSize[list->mType],
+            list->mType, isSwapped);
+          isRowValid = (v >= 0 && v < numVerts);
+          ia->mBuffer[i].mIndex[k] = v;
+        }
+        if (!isRowValid) {
+          isValid = false;
+          break;
+        }
+      }
+    });
+    if (isValid) {
+      ia->mNum = numRows;
+      *next = p + (Ui64)numRows*triangleRowSize;
+      return true;
+    }
+  }
 
-  n = separa_palabras(str, ptrs, " \t", 16);
-  if (strcmp(ptrs[0], "element")) { fclose(fp); return 0; }
-  if (strcmp(ptrs[1], "face")) { fclose(fp); return 0; }
-  nf = atoi(ptrs[2]);
+  // polygons, one row after another
+  std::vector<MeshFace> faces;
+  faces.reserve(numRows);
+  std::vector<int> poly;
+  for (int i=0; i<numRows; i++) {
+    poly.clear();
+    p = ReadPlyBinaryRow(p, end, el, isSwapped, nullptr, &poly);
+    if (!p || !AddPlyPolygon(poly, numVerts, &faces)) {
+      return false;
+    }
+  }
+  *next = p;
+  return SetPlyFaces(me, &faces, 1);
+}
 
-  do {
-    readline(str,255,fp); 
-    n = separa_palabras(str, ptrs, " \t", 16);
-  } while (strcmp(ptrs[0],"property")==0);
+static bool ReadPlyBinary(Mesh *me, const Ui8 *p, const Ui8 *end,
+    const std::vector<PlyElement> &elements, int vertexElement,
+    int faceElement, bool isSwapped) {
+  const int stride = me->mVertexData.mVertexArray[0].mFormat.mStride;
+  char *vertices = (char*)me->mVertexData.mVertexArray[0].mBuffer;
+  for (int el=0; el<(int)elements.size(); el++) {
+    const PlyElement &element = elements[el];
+    const int rowSize = element.mRowSize;
+    if (el == faceElement) {
+      if (!ReadPlyBinaryFaces(me, p, end, element, isSwapped, &p)) {
+        return false;
+      }
+    } else if (rowSize >= 0) {
+      // fixed size rows, the vertices go in parallel
+      if ((Ui64)(end - p) < (Ui64)element.mNum*rowSize) {
+        return false;
+      }
+      if (el == vertexElement) {
+        const Ui8 *rows = p;
+        ParallelFor(0, (Si32)element.mNum, 0, [&](Si32 from, Si32 to) {
+          for (Si32 i=from; i<to; i++) {
+            ReadPlyBinaryRow(rows + (Ui64)i*rowSize, end, element, isSwapped,
+              (float*)(vertices + (Ui64)i*stride), nullptr);
+          }
+        });
+      }
+      p += (Ui64)element.mNum*rowSize;
+    } else {
+      for (Si64 i=0; i<element.mNum && p; i++) {
+        float *vertex = (el == vertexElement) ?
+          (float*)(vertices + (Ui64)i*stride) : nullptr;
+        p = ReadPlyBinaryRow(p, end, element, isSwapped, vertex, nullptr);
+      }
+      if (!p) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
 
-  if (strcmp(str,"end_header")) {
-    fclose(fp);
+int MeshPly_Read(Mesh *me, const char *name, bool calcNormals) {
+  MeshFileMap file;
+  if (!MeshFileMap_Init(&file, name)) {
     return 0;
   }
 
-  const MeshVertexFormat vf = {5*sizeof(float), 2, 0,
-    {{3, kRMVEDT_Float, false}, {2, kRMVEDT_Float, false}}};
-  if (!me->Init(1, nv, &vf, kRMVEDT_Polys, 1, nf)) {
-    fclose(fp);
+  PlyFormat format = kPlyAscii;
+  std::vector<PlyElement> elements;
+  Ui64 bodyOffset = 0;
+  if (!ReadPlyHeader(file.mData, file.mSize, &format, &elements, &bodyOffset)) {
+    MeshFileMap_DeInit(&file);
     return 0;
   }
 
-  for (int i=0; i<nv; i++) {
-    readline(str,255,fp);
-
-    float *v  = (float*)me->GetVertexData(0, i, 0);
-    float *nt = (float*)me->GetVertexData(0, i, 1);
-
-    n = separa_palabras(str, ptrs, " \t", 16);
-
-    v[0] = (float)atof(ptrs[0]);
-    v[1] = (float)atof(ptrs[1]);
-    v[2] = (float)atof(ptrs[2]);
-
-    nt[0] = (float)atof(ptrs[3]);
-    nt[1] = (float)atof(ptrs[4]);
-    nt[2] = (float)atof(ptrs[5]);
+  // the vertex floats are the position, the normal and the uv
+  int vertexElement = -1;
+  int faceElement = -1;
+  bool hasNormals = false;
+  bool hasUVs = false;
+  for (int i=0; i<(int)elements.size(); i++) {
+    if (elements[i].mName == "vertex" && vertexElement == -1) {
+      vertexElement = i;
+      for (const PlyProperty &prop : elements[i].mProperties) {
+        hasNormals |= (prop.mName == "nx" || prop.mName == "ny" || prop.mName == "nz");
+        hasUVs |= (prop.mName == "u" || prop.mName == "s" ||
+          prop.mName == "texture_u" || prop.mName == "texture_s");
+      }
+    } else if (elements[i].mName == "face" && faceElement == -1) {
+      faceElement = i;
+    }
   }
-
-  //-------------------
-
-  for (int i=0; i<nf; i++) {
-    readline(str,255,fp);
-
-    n = separa_palabras(str, ptrs, " \t", 16);
-
-    me->mFaceData.mIndexArray[0].mBuffer[i].mIndex[0] = atoi(ptrs[1]);
-    me->mFaceData.mIndexArray[0].mBuffer[i].mIndex[1] = atoi(ptrs[2]);
-    me->mFaceData.mIndexArray[0].mBuffer[i].mIndex[2] = atoi(ptrs[3]);
+  if (vertexElement == -1 || elements[vertexElement].mNum > 0x7fffffff ||
+      (faceElement != -1 && elements[faceElement].mNum > 0x7fffffff)) {
+    MeshFileMap_DeInit(&file);
+    return 0;
+  }
+  const bool withNormals = hasNormals || calcNormals;
+  const int uvTarget = withNormals ? 6 : 3;
+  for (PlyProperty &prop : elements[vertexElement].mProperties) {
+    if (prop.mCountType != kPlyNone) {
+      continue;
+    }
+    static const char *names[] = { "x", "y", "z", "nx", "ny", "nz" };
+    for (int k=0; k<6; k++) {
+      if (prop.mName == names[k] && (k < 3 || hasNormals)) {
+        prop.mTarget = k;
+      }
+    }
+    if (prop.mName == "u" || prop.mName == "s" ||
+        prop.mName == "texture_u" || prop.mName == "texture_s") {
+      prop.mTarget = uvTarget;
+    } else if (hasUVs && (prop.mName == "v" || prop.mName == "t" ||
+        prop.mName == "texture_v" || prop.mName == "texture_t")) {
+      prop.mTarget = uvTarget + 1;
+    }
+  }
+  if (faceElement != -1) {
+    for (PlyProperty &prop : elements[faceElement].mProperties) {
+      if (prop.mCountType != kPlyNone &&
+          (prop.mName == "vertex_indices" || prop.mName == "vertex_index")) {
+        prop.mTarget = kPlyFaceIndices;
+      }
+    }
   }
 
-  fclose(fp);
+  MeshVertexFormat vf;
+  vf.mNumElems = 0;
+  vf.mElems[vf.mNumElems].mNumComponents = 3;
+  vf.mElems[vf.mNumElems++].mType = kRMVEDT_Float;
+  if (withNormals) {
+    vf.mElems[vf.mNumElems].mNumComponents = 3;
+    vf.mElems[vf.mNumElems++].mType = kRMVEDT_Float;
+  }
+  if (hasUVs) {
+    vf.mElems[vf.mNumElems].mNumComponents = 2;
+    vf.mElems[vf.mNumElems++].mType = kRMVEDT_Float;
+  }
+  vf.mStride = (3 + (withNormals ? 3 : 0) + (hasUVs ? 2 : 0))*sizeof(float);
+  const int nv = (int)elements[vertexElement].mNum;
+  const int nf = (faceElement == -1) ? 0 : (int)elements[faceElement].mNum;
+  if (!me->Init(1, nv, &vf, kRMVEDT_Polys, 1, nf)) {
+    MeshFileMap_DeInit(&file);
+    return 0;
+  }
 
+  bool isRead;
+  if (format == kPlyAscii) {
+    isRead = ReadPlyAscii(me, file.mData + bodyOffset, file.mSize - bodyOffset,
+      elements, vertexElement, faceElement);
+  } else {
+    const Ui16 probe = 1;
+    const bool isHostBigEndian = (*(const Ui8*)&probe == 0);
+    const Ui8 *body = (const Ui8*)file.mData + bodyOffset;
+    isRead = ReadPlyBinary(me, body, (const Ui8*)file.mData + file.mSize,
+      elements, vertexElement, faceElement,
+      isHostBigEndian != (format == kPlyBinaryBigEndian));
+  }
+  MeshFileMap_DeInit(&file);
+  if (!isRead) {
+    me->DeInit();
+    return 0;
+  }
 
-  //-------------------
-  /*
-     DMESH_CalcNormals(me, 0, 3*sizeof(float), 0,
-     1, 5*sizeof(float), 0, 
-     20.0f);
-     */
+  if (calcNormals) {
+    me->Normalize(0, 0, 1);
+  }
   return 1;
 }
 
@@ -30,6 +30,10 @@
 
 namespace arctic {
 
+// Reads the ascii and the binary files, the vertex and the face elements.
+// The vertices hold the position, the normal if the file has normals or
+// calcNormals is set, and then the uv if the file has uvs. The polygons
+// become triangle fans. calcNormals computes the normals from the faces.
 int MeshPly_Read(Mesh *mesh, const char *name, bool calcNormals);
 
 } // namespace arctic
@@ -0,0 +1,495 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Huldra
+// Copyright (c) 2015 - 2016 Inigo Quilez
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include <cstring>
+#include <vector>
+
+#include "engine/arctic_job_system.h"
+#include "engine/mesh_gen_adjacency.h"
+#include "engine/mesh_subdiv.h"
+
+namespace arctic {
+
+namespace {
+
+// Collects the stencils of a level, merging the repeated sources.
+struct StencilBuilder {
+  std::vector<int> mStart;
+  std::vector<int> mSrc;
+  std::vector<float> mWeight;
+  std::vector<int> mSlot;   // [numSrcVerts] entry of the source, or -1
+  int mFirst = 0;
+
+  explicit StencilBuilder(int numSrcVerts) : mSlot(numSrcVerts, -1) {
+    mStart.push_back(0);
+  }
+  void Add(int v, float w) {
+    if (mSlot[v] < mFirst) {
+      mSlot[v] = (int)mSrc.size();
+      mSrc.push_back(v);
+      mWeight.push_back(w);
+    } else {
+      mWeight[mSlot[v]] += w;
+    }
+  }
+  void End() {
+    mFirst = (int)mSrc.size();
+    mStart.push_back(mFirst);
+  }
+};
+
+struct LevelTopology {
+  std::vector<MeshFace> mFaces;
+  std::vector<int> mTargets;   // level each face is refined to
+  int mNumVerts = 0;
+};
+
+inline int GetCorner(const MeshFace &face, int v) {
+  return (face.mIndex[0] == v) ? 0 : ((face.mIndex[1] == v) ? 1 : 2);
+}
+
+void AddVertexStencil(const MeshHalfEdges &he, const MeshFace *faces, int v,
+    int scheme, StencilBuilder *sb, std::vector<int> *ring) {
+  int numf = 0;
+  const int *vf = MeshHalfEdges_GetVertexFaces(&he, v, &numf);
+  if (scheme == kMeshSubdivLinear || numf == 0) {
+    sb->Add(v, 1.0f);
+    return;
+  }
+
+  // the edges shared by 2 faces are interior, the rest are borders
+  ring->clear();
+  int border[2];
+  int numBorder = 0;
+  for (int i=0; i<numf; i++) {
+    const MeshFace &face = faces[vf[i]];
+    const int k = GetCorner(face, v);
+    const int h = vf[i]*3 + k;
+    const int next = face.mIndex[(k+1)%3];
+    const int prev = face.mIndex[(k+2)%3];
+    ring->push_back(next);
+    if (he.mEdgeValence[he.mEdge[h]] != 2) {
+      if (numBorder < 2) {
+        border[numBorder] = next;
+      }
+      numBorder++;
+    }
+    if (he.mEdgeValence[he.mEdge[MeshHalfEdges_GetPrev(h)]] != 2) {
+      ring->push_back(prev);
+      if (numBorder < 2) {
+        border[numBorder] = prev;
+      }
+      numBorder++;
+    }
+  }
+
+  if (numBorder == 2) {
+    sb->Add(v, 0.75f);
+    sb->Add(border[0], 0.125f);
+    sb->Add(border[1], 0.125f);
+    return;
+  }
+  if (numBorder != 0) {
+    // corners and non-manifold vertices stay put
+    sb->Add(v, 1.0f);
+    return;
+  }
+
+  const int n = (int)ring->size();
+  if (scheme == kMeshSubdivLoop) {
+    const float beta = (n == 3) ? 3.0f/16.0f : 3.0f/(8.0f*(float)n);
+    sb->Add(v, 1.0f - (float)n*beta);
+    for (int i=0; i<n; i++) {
+      sb->Add((*ring)[i], beta);
+    }
+  } else {
+    // (F + 2R + (n-3)P)/n with F the average of the face centroids and
+    // R the average of the edge midpoints
+    const float fn = (float)n;
+    const float faceWeight = 1.0f/(3.0f*(float)numf*fn);
+    for (int i=0; i<numf; i++) {
+      const MeshFace &face = faces[vf[i]];
+      for (int k=0; k<3; k++) {
+        sb->Add(face.mIndex[k], faceWeight);
+      }
+    }
+    sb->Add(v, 1.0f/fn + (fn - 3.0f)/fn);
+    for (int i=0; i<n; i++) {
+      sb->Add((*ring)[i], 1.0f/(fn*fn));
+    }
+  }
+}
+
+void AddEdgeStencil(const MeshHalfEdges &he, const MeshFace *faces, int e,
+    int scheme, StencilBuilder *sb) {
+  const int h = he.mEdgeHalf[e];
+  const MeshFace &face = faces[h/3];
+  const int a = face.mIndex[h%3];
+  const int b = face.mIndex[(h%3 + 1)%3];
+  const int twin = he.mTwin[h];
+  if (scheme == kMeshSubdivLinear || he.mEdgeValence[e] != 2 || twin == -1) {
+    sb->Add(a, 0.5f);
+    sb->Add(b, 0.5f);
+    return;
+  }
+  const int c = face.mIndex[(h%3 + 2)%3];
+  const int d = faces[twin/3].mIndex[(twin%3 + 2)%3];
+  // Loop: 3/8 and 1/8, Catmull-Clark: the midpoint and the two centroids
+  const float near = (scheme == kMeshSubdivLoop) ? 0.375f : 5.0f/12.0f;
+  const float far = (scheme == kMeshSubdivLoop) ? 0.125f : 1.0f/12.0f;
+  sb->Add(a, near);
+  sb->Add(b, near);
+  sb->Add(c, far);
+  sb->Add(d, far);
+}
+
+bool BuildLevel(const LevelTopology &src, int depth, int scheme,
+    MeshSubdivLevel *level, LevelTopology *dst) {
+  // MeshHalfEdges only reads the face array and the vertex count
+  Mesh topo;
+  topo.mVertexData.mNumVertexArrays = 1;
+  topo.mVertexData.mVertexArray[0].mNum = src.mNumVerts;
+  topo.mFaceData.mNumIndexArrays = 1;
+  topo.mFaceData.mIndexArray[0].mNum = (unsigned)src.mFaces.size();
+  topo.mFaceData.mIndexArray[0].mBuffer = const_cast<MeshFace*>(src.mFaces.data());
+  MeshHalfEdges he;
+  if (!MeshHalfEdges_Init(&he, &topo)) {
+    return false;
+  }
+
+  const int numf = (int)src.mFaces.size();
+  const MeshFace *faces = src.mFaces.data();
+  const bool hasFacePoints = (scheme != kMeshSubdivLoop);
+
+  // the edges of the refined faces get split and their vertices moved,
+  // the new vertices come in order
+  std::vector<int> facePoint(numf, -1);
+  std::vector<int> edgePoint(he.mNumEdges, -1);
+  std::vector<char> isMoved(src.mNumVerts, 0);
+  int numVerts = src.mNumVerts;
+  for (int i=0; i<numf; i++) {
+    if (src.mTargets[i] > depth && hasFacePoints) {
+      facePoint[i] = numVerts++;
+    }
+  }
+  for (int i=0; i<numf; i++) {
+    if (src.mTargets[i] > depth) {
+      for (int k=0; k<3; k++) {
+        const int e = he.mEdge[i*3 + k];
+        if (edgePoint[e] == -1) {
+          edgePoint[e] = -2;
+        }
+        isMoved[faces[i].mIndex[k]] = 1;
+      }
+    }
+  }
+  for (int e=0; e<he.mNumEdges; e++) {
+    if (edgePoint[e] == -2) {
+      edgePoint[e] = numVerts++;
+    }
+  }
+
+  StencilBuilder sb(src.mNumVerts);
+  std::vector<int> ring;
+  for (int v=0; v<src.mNumVerts; v++) {
+    if (isMoved[v]) {
+      AddVertexStencil(he, faces, v, scheme, &sb, &ring);
+    } else {
+      sb.Add(v, 1.0f);
+    }
+    sb.End();
+  }
+  for (int i=0; i<numf; i++) {
+    if (facePoint[i] != -1) {
+      for (int k=0; k<3; k++) {
+        sb.Add(faces[i].mIndex[k], 1.0f/3.0f);
+      }
+      sb.End();
+    }
+  }
+  for (int e=0; e<he.mNumEdges; e++) {
+    if (edgePoint[e] != -1) {
+      AddEdgeStencil(he, faces, e, scheme, &sb);
+      sb.End();
+    }
+  }
+
+  dst->mNumVerts = numVerts;
+  dst->mFaces.clear();
+  dst->mTargets.clear();
+  for (int i=0; i<numf; i++) {
+    const int *v = faces[i].mIndex;
+    const int ep[3] = { edgePoint[he.mEdge[i*3 + 0]],
+      edgePoint[he.mEdge[i*3 + 1]], edgePoint[he.mEdge[i*3 + 2]] };
+    if (src.mTargets[i] > depth && scheme == kMeshSubdivLoop) {
+      const MeshFace children[4] = { {{v[0], ep[0], ep[2]}},
+        {{ep[0], v[1], ep[1]}}, {{ep[2], ep[1], v[2]}},
+        {{ep[0], ep[1], ep[2]}} };
+      dst->mFaces.insert(dst->mFaces.end(), children, children + 4);
+    } else if (src.mTargets[i] > depth) {
+      const int f = facePoint[i];
+      for (int j=0; j<3; j++) {
+        const MeshFace children[2] = { {{f, ep[(j+2)%3], v[j]}},
+          {{v[j], ep[j], f}} };
+        dst->mFaces.insert(dst->mFaces.end(), children, children + 2);
+      }
+    } else {
+      // the split edges of a face kept whole, fan from the first one
+      int poly[6];
+      int num = 0;
+      int first = -1;
+      for (int k=0; k<3; k++) {
+        poly[num++] = v[k];
+        if (ep[k] >= 0) {
+          first = (first == -1) ? num : first;
+          poly[num++] = ep[k];
+        }
+      }
+      first = (first == -1) ? 0 : first;
+      for (int k=1; k+1<num; k++) {
+        const MeshFace child = {{poly[first], poly[(first+k)%num],
+          poly[(first+k+1)%num]}};
+        dst->mFaces.push_back(child);
+      }
+    }
+    dst->mTargets.resize(dst->mFaces.size(), src.mTargets[i]);
+  }
+  MeshHalfEdges_DeInit(&he);
+
+  level->mNumSrcVerts = src.mNumVerts;
+  level->mNumVerts = numVerts;
+  level->mStencilStart = (int*)malloc(sb.mStart.size()*sizeof(int));
+  level->mStencilSrc = (int*)malloc((sb.mSrc.size() + 1)*sizeof(int));
+  level->mStencilWeight = (float*)malloc((sb.mWeight.size() + 1)*sizeof(float));
+  if (!level->mStencilStart || !level->mStencilSrc || !level->mStencilWeight) {
+    return false;
+  }
+  memcpy(level->mStencilStart, sb.mStart.data(), sb.mStart.size()*sizeof(int));
+  memcpy(level->mStencilSrc, sb.mSrc.data(), sb.mSrc.size()*sizeof(int));
+  memcpy(level->mStencilWeight, sb.mWeight.data(),
+    sb.mWeight.size()*sizeof(float));
+  return true;
+}
+
+// The stencils of the vertices [from, to), kNumFloats is the number of
+// float components when it is known at compile time, 0 otherwise.
+// The result goes packed to dst, or to the vertex buffer when dstOffsets
+// is given.
+template <int kNumFloats>
+void EvaluateStencils(const MeshSubdivLevel &level, int numFloatsRuntime,
+    const float *src, float *dst, const int *dstOffsets, int dstStride,
+    int from, int to) {
+  const int numFloats = kNumFloats ? kNumFloats : numFloatsRuntime;
+  for (int i=from; i<to; i++) {
+    float acc[Mesh_MAXELEMS*4];
+    for (int c=0; c<numFloats; c++) {
+      acc[c] = 0.0f;
+    }
+    for (int s=level.mStencilStart[i]; s<level.mStencilStart[i+1]; s++) {
+      const float w = level.mStencilWeight[s];
+      const float *v = src + (size_t)level.mStencilSrc[s]*numFloats;
+      for (int c=0; c<numFloats; c++) {
+        acc[c] += w*v[c];
+      }
+    }
+    if (dstOffsets) {
+      char *vertex = (char*)dst + (size_t)i*dstStride;
+      for (int c=0; c<numFloats; c++) {
+        memcpy(vertex + dstOffsets[c], &acc[c], sizeof(float));
+      }
+    } else {
+      memcpy(dst + (size_t)i*numFloats, acc, numFloats*sizeof(float));
+    }
+  }
+}
+
+void EvaluateLevel(const MeshSubdivLevel &level, int numFloats,
+    const float *src, float *dst, const int *dstOffsets, int dstStride,
+    int from, int to) {
+  switch (numFloats) {
+    case 3:
+      EvaluateStencils<3>(level, 3, src, dst, dstOffsets, dstStride, from, to);
+      break;
+    case 5:
+      EvaluateStencils<5>(level, 5, src, dst, dstOffsets, dstStride, from, to);
+      break;
+    case 6:
+      EvaluateStencils<6>(level, 6, src, dst, dstOffsets, dstStride, from, to);
+      break;
+    case 8:
+      EvaluateStencils<8>(level, 8, src, dst, dstOffsets, dstStride, from, to);
+      break;
+    default:
+      EvaluateStencils<0>(level, numFloats, src, dst, dstOffsets, dstStride,
+        from, to);
+      break;
+  }
+}
+
+}  // namespace
+
+bool MeshSubdiv_Init(MeshSubdiv *me, const Mesh *cage, int scheme, int levels,
+    const int *faceLevels, bool isParallel) {
+  *me = MeshSubdiv();
+  if (levels < 0 || cage->mVertexData.mNumVertexArrays < 1) {
+    return false;
+  }
+  me->mScheme = scheme;
+  me->mIsParallel = isParallel;
+  me->mNumLevels = levels;
+  me->mNumCageVerts = cage->mVertexData.mVertexArray[0].mNum;
+  me->mFormat = cage->mVertexData.mVertexArray[0].mFormat;
+
+  int numFloats = 0;
+  for (int i=0; i<me->mFormat.mNumElems; i++) {
+    if (me->mFormat.mElems[i].mType == kRMVEDT_Float) {
+      numFloats += me->mFormat.mElems[i].mNumComponents;
+    }
+  }
+  me->mNumFloats = numFloats;
+  me->mFloatOffsets = (int*)malloc((numFloats + 1)*sizeof(int));
+  me->mLevels = (MeshSubdivLevel*)malloc((levels + 1)*sizeof(MeshSubdivLevel));
+  if (!me->mFloatOffsets || !me->mLevels) {
+    MeshSubdiv_DeInit(me);
+    return false;
+  }
+  for (int i=0; i<=levels; i++) {
+    me->mLevels[i] = MeshSubdivLevel();
+  }
+  numFloats = 0;
+  for (int i=0; i<me->mFormat.mNumElems; i++) {
+    const MeshVertexElemInfo &elem = me->mFormat.mElems[i];
+    if (elem.mType == kRMVEDT_Float) {
+      for (int c=0; c<(int)elem.mNumComponents; c++) {
+        me->mFloatOffsets[numFloats++] = elem.mOffset + c*(int)sizeof(float);
+      }
+    }
+  }
+
+  const int numf = cage->mFaceData.mIndexArray[0].mNum;
+  LevelTopology topology[2];
+  topology[0].mNumVerts = me->mNumCageVerts;
+  topology[0].mFaces.assign(cage->mFaceData.mIndexArray[0].mBuffer,
+    cage->mFaceData.mIndexArray[0].mBuffer + numf);
+  topology[0].mTargets.resize(numf, levels);
+  if (faceLevels) {
+    for (int i=0; i<numf; i++) {
+      topology[0].mTargets[i] = (faceLevels[i] < levels) ? faceLevels[i] : levels;
+    }
+  }
+
+  int maxVerts = me->mNumCageVerts;
+  for (int l=0; l<levels; l++) {
+    if (!BuildLevel(topology[l&1], l, scheme, me->mLevels + l,
+        &topology[(l+1)&1])) {
+      MeshSubdiv_DeInit(me);
+      return false;
+    }
+    maxVerts = (me->mLevels[l].mNumVerts > maxVerts) ? me->mLevels[l].mNumVerts : maxVerts;
+  }
+
+  const LevelTopology &result = topology[levels&1];
+  me->mNumVerts = result.mNumVerts;
+  me->mNumFaces = (int)result.mFaces.size();
+  me->mFaces = (MeshFace*)malloc((me->mNumFaces + 1)*sizeof(MeshFace));
+  me->mScratch[0] = (float*)malloc(((size_t)maxVerts*numFloats + 1)*sizeof(float));
+  me->mScratch[1] = (float*)malloc(((size_t)maxVerts*numFloats + 1)*sizeof(float));
+  if (!me->mFaces || !me->mScratch[0] || !me->mScratch[1]) {
+    MeshSubdiv_DeInit(me);
+    return false;
+  }
+  memcpy(me->mFaces, result.mFaces.data(), me->mNumFaces*sizeof(MeshFace));
+  return true;
+}
+
+void MeshSubdiv_DeInit(MeshSubdiv *me) {
+  if (me->mLevels) {
+    for (int i=0; i<me->mNumLevels; i++) {
+      free(me->mLevels[i].mStencilStart);
+      free(me->mLevels[i].mStencilSrc);
+      free(me->mLevels[i].mStencilWeight);
+    }
+  }
+  free(me->mLevels);
+  free(me->mFaces);
+  free(me->mFloatOffsets);
+  free(me->mScratch[0]);
+  free(me->mScratch[1]);
+  *me = MeshSubdiv();
+}
+
+bool MeshSubdiv_InitMesh(const MeshSubdiv *me, Mesh *dst) {
+  if (!dst->Init(1, me->mNumVerts, &me->mFormat, kRMVEDT_Polys, 1,
+      me->mNumFaces)) {
+    return false;
+  }
+  memcpy(dst->mFaceData.mIndexArray[0].mBuffer, me->mFaces,
+    me->mNumFaces*sizeof(MeshFace));
+  return true;
+}
+
+void MeshSubdiv_Evaluate(MeshSubdiv *me, const Mesh *cage, Mesh *dst) {
+  const int numFloats = me->mNumFloats;
+  const int stride = me->mFormat.mStride;
+  const char *cageData = (const char*)cage->mVertexData.mVertexArray[0].mBuffer;
+  char *dstData = (char*)dst->mVertexData.mVertexArray[0].mBuffer;
+
+  if (me->mNumLevels == 0) {
+    for (int i=0; i<me->mNumVerts; i++) {
+      for (int c=0; c<numFloats; c++) {
+        memcpy(dstData + (size_t)i*stride + me->mFloatOffsets[c],
+          cageData + (size_t)i*stride + me->mFloatOffsets[c], sizeof(float));
+      }
+    }
+    return;
+  }
+
+  // the cage goes packed, every level reads the previous one
+  float *src = me->mScratch[0];
+  for (int i=0; i<me->mNumCageVerts; i++) {
+    for (int c=0; c<numFloats; c++) {
+      memcpy(src + (size_t)i*numFloats + c,
+        cageData + (size_t)i*stride + me->mFloatOffsets[c], sizeof(float));
+    }
+  }
+  for (int l=0; l<me->mNumLevels; l++) {
+    const MeshSubdivLevel &level = me->mLevels[l];
+    const bool isLast = (l == me->mNumLevels - 1);
+    float *out = isLast ? (float*)dstData : me->mScratch[(l+1)&1];
+    const int *offsets = isLast ? me->mFloatOffsets : nullptr;
+    if (me->mIsParallel) {
+      ParallelFor(0, level.mNumVerts, 0, [&](Si32 from, Si32 to) {
+        EvaluateLevel(level, numFloats, src, out, offsets, stride, from, to);
+      });
+    } else {
+      EvaluateLevel(level, numFloats, src, out, offsets, stride, 0,
+        level.mNumVerts);
+    }
+    src = out;
+  }
+}
+
+}  // namespace arctic
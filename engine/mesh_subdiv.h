@@ -0,0 +1,82 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// The MIT License (MIT)
+//
+// Copyright (c) 2022 Huldra
+// Copyright (c) 2015 - 2016 Inigo Quilez
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#pragma once
+
+#include "engine/mesh.h"
+
+namespace arctic {
+
+enum MeshSubdivScheme {
+  kMeshSubdivLoop = 0,          // 4 triangles per face, smooth
+  kMeshSubdivCatmullClark = 1,  // 6 triangles per face around the centroid
+  kMeshSubdivLinear = 2         // same topology, the vertices stay put
+};
+
+// One refinement step. The vertices of the step are the ones of the
+// previous step, then the face points, then the edge points, every one
+// a weighted sum of the previous step vertices.
+struct MeshSubdivLevel {
+  int mNumSrcVerts = 0;
+  int mNumVerts = 0;
+  int *mStencilStart = nullptr;   // [numVerts+1] ranges of the two below
+  int *mStencilSrc = nullptr;
+  float *mStencilWeight = nullptr;
+};
+
+// The refined topology and the stencil tables of a control cage, built
+// once. Evaluating them moves the refined mesh along with the cage, as
+// long as the cage faces stay the same.
+struct MeshSubdiv {
+  int mScheme = kMeshSubdivLoop;
+  bool mIsParallel = false;
+  int mNumLevels = 0;
+  int mNumCageVerts = 0;
+  int mNumVerts = 0;
+  int mNumFaces = 0;
+  MeshSubdivLevel *mLevels = nullptr;
+  MeshFace *mFaces = nullptr;     // [numFaces] the refined faces
+  MeshVertexFormat mFormat;       // vertex stream 0 of the cage
+  int mNumFloats = 0;             // float components of a vertex
+  int *mFloatOffsets = nullptr;   // [numFloats] their offsets, in bytes
+  float *mScratch[2] = {nullptr, nullptr};
+};
+
+// Refines the index array 0 faces of the cage levels times. With
+// faceLevels, the cage face i is refined faceLevels[i] times, up to
+// levels, and the faces around it are split to close the cracks.
+// With isParallel the evaluation runs on the job system.
+bool MeshSubdiv_Init(MeshSubdiv *me, const Mesh *cage, int scheme, int levels,
+  const int *faceLevels, bool isParallel);
+void MeshSubdiv_DeInit(MeshSubdiv *me);
+
+// Inits dst with the refined faces and the vertex format of the cage
+bool MeshSubdiv_InitMesh(const MeshSubdiv *me, Mesh *dst);
+// Computes the refined vertices from the cage vertices, the float
+// elements are subdivided and the rest is left untouched
+void MeshSubdiv_Evaluate(MeshSubdiv *me, const Mesh *cage, Mesh *dst);
+
+} // namespace arctic
@@ -60,27 +60,25 @@ void *FixedBlockQueue_Gears::get_front(I_FixedSizeAllocator *pool,
 
 void FixedBlockQueue_Gears::front_cleanup(I_FixedSizeAllocator *pool,
     size_t item_size) {
-  if (front->next == nullptr) {
-    // there is only one block in the queue
-    if (front_offset == back_offset) {
-      // the queue is empty, let's free everything
-      pool->free(front);
-      front = nullptr;
+  if (front->next != nullptr) {
+    const size_t item_count = getItemCount(pool, item_size);
+    if (front_offset < item_count) {
+      return;
     }
-    return;
-  }
-  const size_t item_count = getItemCount(pool, item_size);
-  if (front_offset < item_count) {
-    return;
-  }
 
-  // let's transfer the state to the next block
-  front_offset -= item_count;
-  back_offset -= item_count;
+    // let's transfer the state to the next block,
+    // back_offset is relative to the back block, so it stays
+    front_offset -= item_count;
 
-  BlockItems *next_block = front->next;
-  pool->free(front);
-  front = next_block;
+    BlockItems *next_block = front->next;
+    pool->free(front);
+    front = next_block;
+  }
+  if (front == back && front_offset == back_offset) {
+    // the queue is empty, let's free everything
+    pool->free(front);
+    front = nullptr;
+  }
 }
 
 size_t inline FixedBlockQueue_Gears::getItemCount(I_FixedSizeAllocator *pool,
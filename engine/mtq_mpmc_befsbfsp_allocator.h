@@ -39,6 +39,7 @@
 #include "engine/mtq_mempool_allocator.h"
 #include <array>
 #include <atomic>
+#include <cstdlib>
 
 namespace arctic {
 
@@ -56,7 +57,7 @@ class alignas(64) MpmcBestEffortFixedSizeBufferFixedSizePool : public I_FixedSiz
     for (size_t i = 0; i < items.size(); ++i) {
       void *p = std::atomic_exchange(&items[i], (void*)nullptr);
       if (p) {
-        free(p);
+        ::free(p);
       }
     }
   }
@@ -78,7 +79,7 @@ class alignas(64) MpmcBestEffortFixedSizeBufferFixedSizePool : public I_FixedSiz
         return;
       }
     }
-    free(ptr);
+    ::free(ptr);
     return;
   }
 
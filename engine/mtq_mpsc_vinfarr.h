@@ -56,6 +56,7 @@
 
 #include <memory.h>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <deque>
 #include <new>
@@ -270,12 +271,17 @@ struct InfArrayChunk<false> final {
 
   static constexpr size_t
   getNumberOfSlotsForSize(size_t size, size_t payload_size) {
+    // the size is of the whole chunk, the header included
+    if (size < sizeof(SelfType)) {
+      return 0;
+    }
+    size -= sizeof(SelfType);
     const size_t pack_size =
       getPackPayloadSize(payload_size) + sizeof(SlotPack);
     const size_t total_packs = size / pack_size;
     const size_t pack_tail = size % pack_size;
     if (pack_tail < sizeof(SlotPack) + payload_size) {
-      return 0;
+      return total_packs * NUMBER_OF_SLOTS_IN_PACK;
     }
     size_t tail_number_of_slots =
       (pack_tail - sizeof(SlotPack)) / payload_size;
@@ -313,7 +319,8 @@ struct InfArrayChunk<false> final {
   getTotalPackSize(size_t number_of_slots, size_t payload_size) {
     size_t total_payload_size = payload_size * number_of_slots;
     size_t number_of_packs =
-      align_up(number_of_slots, NUMBER_OF_SLOTS_IN_PACK);
+      align_up(number_of_slots, NUMBER_OF_SLOTS_IN_PACK) /
+      NUMBER_OF_SLOTS_IN_PACK;
     return total_payload_size
       + number_of_packs * sizeof(SlotPack::ReadyFlags);
   }
@@ -362,7 +369,9 @@ class AuxiliaryChunkSize<false, true> {
   }
 
   inline void freeChunk(ChunkType *chunk) {
-    delete chunk;
+    // allocated by ::operator new with room for the slots
+    chunk->~ChunkType();
+    ::operator delete(chunk);
   }
 
   void setSlot(ChunkType *chunk, Ui64 slot, void *item) {
@@ -459,7 +468,9 @@ class AuxiliaryChunkSize<false, false> {
   }
 
   inline void freeChunk(InfArrayChunk<false> *chunk) {
-    delete chunk;
+    // allocated by ::operator new with room for the slots
+    chunk->~ChunkType();
+    ::operator delete(chunk);
   }
 
   void setSlot(ChunkType *chunk, size_t slot, void *item) {
@@ -888,7 +899,7 @@ class MPSC_VirtInfArray_ConstructorSelector<Params, true, ForwardParams...> {
  public:
   MPSC_VirtInfArray_ConstructorSelector(
     ForwardParams...params, I_FixedSizeAllocator *pool)
-    : impl(pool, params...) {}
+    : impl(params..., pool) {}
 
  protected:
   MPSC_VirtInfArray_Impl<
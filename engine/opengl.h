@@ -26,12 +26,31 @@
 
 #include "engine/arctic_platform_def.h"
 
+namespace arctic {
+
+extern bool g_is_gl_validation;
+
+/// @brief Enables or disables the OpenGL validation
+/// @details While enabled, every OpenGL call is followed by a glGetError
+///  check and the programs check their active uniforms. The checks stall
+///  the pipeline, so they are enabled by default only in the builds
+///  without NDEBUG.
+void SetGlValidation(bool is_enabled);
+/// @brief Returns true if the OpenGL validation is enabled
+inline bool IsGlValidation() {
+  return g_is_gl_validation;
+}
+
+}  // namespace arctic
+
 #define ARCTIC_GL_CHECK_ERROR(opengl_call) do { \
     opengl_call; int call_line = __LINE__; \
-    GLenum error_code = glGetError(); \
-    if (error_code != GL_NO_ERROR) { \
-        *Log() << "OpenGL Error: " << #opengl_call << " -> " << GlErrorToString(error_code) << " (" << error_code << ")" \
-               << "\nFile: " << __FILE__ << "\nLine: " << call_line; \
+    if (arctic::IsGlValidation()) { \
+        GLenum error_code = glGetError(); \
+        if (error_code != GL_NO_ERROR) { \
+            *Log() << "OpenGL Error: " << #opengl_call << " -> " << GlErrorToString(error_code) << " (" << error_code << ")" \
+                   << "\nFile: " << __FILE__ << "\nLine: " << call_line; \
+        } \
     } \
 } while(false)
 
@@ -52,11 +71,13 @@ extern PFNGLCREATESHADERPROC glCreateShader;
 extern PFNGLDELETEPROGRAMPROC glDeleteProgram;
 extern PFNGLDELETESHADERPROC glDeleteShader;
 extern PFNGLENABLEVERTEXATTRIBARRAYPROC glEnableVertexAttribArray;
+extern PFNGLDISABLEVERTEXATTRIBARRAYPROC glDisableVertexAttribArray;
 extern PFNGLGETPROGRAMIVPROC glGetProgramiv;
 extern PFNGLGETPROGRAMINFOLOGPROC glGetProgramInfoLog;
 extern PFNGLGETSHADERIVPROC glGetShaderiv;
 extern PFNGLGETSHADERINFOLOGPROC glGetShaderInfoLog;
 extern PFNGLGETUNIFORMLOCATIONPROC glGetUniformLocation;
+extern PFNGLGETACTIVEUNIFORMPROC glGetActiveUniform;
 extern PFNGLLINKPROGRAMPROC glLinkProgram;
 extern PFNGLSHADERSOURCEPROC glShaderSource;
 extern PFNGLUSEPROGRAMPROC glUseProgram;
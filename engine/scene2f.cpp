@@ -0,0 +1,393 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "engine/scene2f.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#include "engine/easy_advanced.h"
+#include "engine/engine.h"
+
+namespace arctic {
+
+constexpr Si32 Scene2F::kNoNode;
+constexpr Ui32 Scene2F::kFlagVisible;
+constexpr Ui32 Scene2F::kFlagRelativeZOrder;
+constexpr Ui32 Scene2F::kFlagAlive;
+constexpr Ui32 Scene2F::kFlagDirty;
+constexpr Ui32 Scene2F::kFlagZOrderChanged;
+constexpr Ui32 Scene2F::kFlagWorldVisible;
+
+Si32 Scene2F::AddNode(Si32 parent_idx) {
+  Check(parent_idx == kNoNode || IsAlive(parent_idx),
+    "Scene2F::AddNode: the parent node is not alive");
+  Si32 idx;
+  if (free_nodes_.empty()) {
+    idx = static_cast<Si32>(flags_.size());
+    parent_.push_back(kNoNode);
+    first_child_.push_back(kNoNode);
+    next_sibling_.push_back(kNoNode);
+    prev_sibling_.push_back(kNoNode);
+    flags_.push_back(0);
+    sequence_.push_back(0);
+    local_.emplace_back();
+    world_.emplace_back();
+    z_order_.push_back(0.f);
+    world_z_order_.push_back(0.f);
+    world_radius_.push_back(0.f);
+    sprite_.emplace_back();
+    blending_mode_.push_back(kDrawBlendingModeCopyRgba);
+    filter_mode_.push_back(kFilterNearest);
+    color_.push_back(Rgba(0xffffffff));
+  } else {
+    idx = free_nodes_.back();
+    free_nodes_.pop_back();
+    first_child_[idx] = kNoNode;
+    local_[idx] = Transform2F();
+    world_[idx] = Transform2F();
+    z_order_[idx] = 0.f;
+    world_z_order_[idx] = 0.f;
+    world_radius_[idx] = 0.f;
+    blending_mode_[idx] = kDrawBlendingModeCopyRgba;
+    filter_mode_[idx] = kFilterNearest;
+    color_[idx] = Rgba(0xffffffff);
+  }
+  flags_[idx] = kFlagAlive | kFlagVisible;
+  sequence_[idx] = next_sequence_;
+  ++next_sequence_;
+  ++node_count_;
+  Link(idx, parent_idx);
+  MarkDirty(idx);
+  MarkZOrderChanged(idx);
+  return idx;
+}
+
+Si32 Scene2F::AddSpriteNode(Sprite sprite, Si32 parent_idx) {
+  Si32 idx = AddNode(parent_idx);
+  sprite_[idx] = sprite;
+  return idx;
+}
+
+void Scene2F::RemoveNode(Si32 idx) {
+  Check(IsAlive(idx), "Scene2F::RemoveNode: the node is not alive");
+  Unlink(idx);
+  stack_.clear();
+  stack_.push_back(idx);
+  while (!stack_.empty()) {
+    Si32 node = stack_.back();
+    stack_.pop_back();
+    for (Si32 child = first_child_[node]; child != kNoNode;
+        child = next_sibling_[child]) {
+      stack_.push_back(child);
+    }
+    flags_[node] = 0;
+    sprite_[node] = Sprite();
+    parent_[node] = kNoNode;
+    free_nodes_.push_back(node);
+    --node_count_;
+  }
+  has_removed_nodes_ = true;
+}
+
+void Scene2F::SetParent(Si32 idx, Si32 parent_idx) {
+  Check(IsAlive(idx), "Scene2F::SetParent: the node is not alive");
+  Check(parent_idx == kNoNode || IsAlive(parent_idx),
+    "Scene2F::SetParent: the parent node is not alive");
+  for (Si32 node = parent_idx; node != kNoNode; node = parent_[node]) {
+    Check(node != idx,
+      "Scene2F::SetParent: the node can't be a child of its own subtree");
+  }
+  Unlink(idx);
+  Link(idx, parent_idx);
+  MarkDirty(idx);
+}
+
+Si32 Scene2F::GetParent(Si32 idx) const {
+  return parent_[idx];
+}
+
+bool Scene2F::IsAlive(Si32 idx) const {
+  return idx >= 0 && idx < static_cast<Si32>(flags_.size()) &&
+    (flags_[idx] & kFlagAlive);
+}
+
+Si32 Scene2F::NodeCount() const {
+  return node_count_;
+}
+
+void Scene2F::SetTransform(Si32 idx, const Transform2F &transform) {
+  local_[idx] = transform;
+  MarkDirty(idx);
+}
+
+const Transform2F &Scene2F::GetTransform(Si32 idx) const {
+  return local_[idx];
+}
+
+void Scene2F::SetPosition(Si32 idx, Vec2F position) {
+  local_[idx].SetPosition(position);
+  MarkDirty(idx);
+}
+
+const Transform2F &Scene2F::GetWorldTransform(Si32 idx) const {
+  return world_[idx];
+}
+
+void Scene2F::SetZOrder(Si32 idx, float z_order) {
+  z_order_[idx] = z_order;
+  MarkDirty(idx);
+}
+
+float Scene2F::GetZOrder(Si32 idx) const {
+  return z_order_[idx];
+}
+
+void Scene2F::SetRelativeZOrder(Si32 idx, bool is_relative) {
+  if (is_relative) {
+    flags_[idx] |= kFlagRelativeZOrder;
+  } else {
+    flags_[idx] &= ~kFlagRelativeZOrder;
+  }
+  MarkDirty(idx);
+}
+
+bool Scene2F::IsRelativeZOrder(Si32 idx) const {
+  return (flags_[idx] & kFlagRelativeZOrder) != 0;
+}
+
+void Scene2F::SetVisible(Si32 idx, bool is_visible) {
+  if (is_visible) {
+    flags_[idx] |= kFlagVisible;
+  } else {
+    flags_[idx] &= ~kFlagVisible;
+  }
+  MarkDirty(idx);
+}
+
+bool Scene2F::IsVisible(Si32 idx) const {
+  return (flags_[idx] & kFlagVisible) != 0;
+}
+
+void Scene2F::SetSprite(Si32 idx, Sprite sprite) {
+  sprite_[idx] = sprite;
+  MarkDirty(idx);
+}
+
+void Scene2F::SetDrawBlendingMode(Si32 idx, DrawBlendingMode blending_mode) {
+  blending_mode_[idx] = blending_mode;
+}
+
+void Scene2F::SetDrawFilterMode(Si32 idx, DrawFilterMode filter_mode) {
+  filter_mode_[idx] = filter_mode;
+}
+
+void Scene2F::SetColor(Si32 idx, Rgba color) {
+  color_[idx] = color;
+}
+
+void Scene2F::MarkDirty(Si32 idx) {
+  if (!(flags_[idx] & kFlagDirty)) {
+    flags_[idx] |= kFlagDirty;
+    dirty_nodes_.push_back(idx);
+  }
+}
+
+void Scene2F::MarkZOrderChanged(Si32 idx) {
+  if (!(flags_[idx] & kFlagZOrderChanged)) {
+    flags_[idx] |= kFlagZOrderChanged;
+    z_order_changed_nodes_.push_back(idx);
+  }
+}
+
+void Scene2F::Link(Si32 idx, Si32 parent_idx) {
+  parent_[idx] = parent_idx;
+  prev_sibling_[idx] = kNoNode;
+  next_sibling_[idx] = kNoNode;
+  if (parent_idx != kNoNode) {
+    Si32 first = first_child_[parent_idx];
+    next_sibling_[idx] = first;
+    if (first != kNoNode) {
+      prev_sibling_[first] = idx;
+    }
+    first_child_[parent_idx] = idx;
+  }
+}
+
+void Scene2F::Unlink(Si32 idx) {
+  Si32 prev = prev_sibling_[idx];
+  Si32 next = next_sibling_[idx];
+  if (prev != kNoNode) {
+    next_sibling_[prev] = next;
+  } else if (parent_[idx] != kNoNode) {
+    first_child_[parent_[idx]] = next;
+  }
+  if (next != kNoNode) {
+    prev_sibling_[next] = prev;
+  }
+  parent_[idx] = kNoNode;
+  prev_sibling_[idx] = kNoNode;
+  next_sibling_[idx] = kNoNode;
+}
+
+bool Scene2F::HasDirtyAncestor(Si32 idx) const {
+  for (Si32 node = parent_[idx]; node != kNoNode; node = parent_[node]) {
+    if (flags_[node] & kFlagDirty) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void Scene2F::UpdateSubtree(Si32 root_idx) {
+  stack_.clear();
+  stack_.push_back(root_idx);
+  while (!stack_.empty()) {
+    Si32 idx = stack_.back();
+    stack_.pop_back();
+    Ui32 flags = flags_[idx] & ~(kFlagDirty | kFlagWorldVisible);
+    Si32 parent_idx = parent_[idx];
+    float world_z_order = z_order_[idx];
+    if (parent_idx == kNoNode) {
+      world_[idx] = local_[idx];
+      if (flags & kFlagVisible) {
+        flags |= kFlagWorldVisible;
+      }
+    } else {
+      const Transform2F &parent = world_[parent_idx];
+      world_[idx].dc = parent.dc * local_[idx].dc.TranslationScaled(
+        parent.scale);
+      world_[idx].scale = parent.scale * local_[idx].scale;
+      if ((flags & kFlagVisible) && (flags_[parent_idx] & kFlagWorldVisible)) {
+        flags |= kFlagWorldVisible;
+      }
+      if (flags & kFlagRelativeZOrder) {
+        world_z_order += world_z_order_[parent_idx];
+      }
+    }
+    flags_[idx] = flags;
+    if (world_z_order != world_z_order_[idx]) {
+      world_z_order_[idx] = world_z_order;
+      MarkZOrderChanged(idx);
+    }
+
+    const Sprite &sprite = sprite_[idx];
+    if (sprite.Width() > 0) {
+      Vec2Si32 pivot = sprite.Pivot();
+      float dx = static_cast<float>(
+        std::max(pivot.x, sprite.Width() - pivot.x));
+      float dy = static_cast<float>(
+        std::max(pivot.y, sprite.Height() - pivot.y));
+      world_radius_[idx] = std::sqrt(dx * dx + dy * dy) *
+        std::abs(world_[idx].scale);
+    } else {
+      world_radius_[idx] = 0.f;
+    }
+    ++updated_node_count_;
+
+    for (Si32 child = first_child_[idx]; child != kNoNode;
+        child = next_sibling_[child]) {
+      stack_.push_back(child);
+    }
+  }
+}
+
+bool Scene2F::IsDrawnBefore(Si32 a, Si32 b) const {
+  if (world_z_order_[a] != world_z_order_[b]) {
+    return world_z_order_[a] < world_z_order_[b];
+  }
+  return sequence_[a] < sequence_[b];
+}
+
+void Scene2F::UpdateDrawOrder() {
+  if (z_order_changed_nodes_.empty() && !has_removed_nodes_) {
+    return;
+  }
+  // Drop the removed and the moved nodes, the rest stays sorted
+  draw_order_.erase(std::remove_if(draw_order_.begin(), draw_order_.end(),
+      [this](Si32 idx) {
+        return (flags_[idx] & (kFlagAlive | kFlagZOrderChanged)) != kFlagAlive;
+      }), draw_order_.end());
+  size_t sorted_size = draw_order_.size();
+  for (Si32 idx : z_order_changed_nodes_) {
+    // The slot may be removed or even reused since it was marked
+    if (flags_[idx] & kFlagZOrderChanged) {
+      flags_[idx] &= ~kFlagZOrderChanged;
+      if (flags_[idx] & kFlagAlive) {
+        draw_order_.push_back(idx);
+      }
+    }
+  }
+  z_order_changed_nodes_.clear();
+  has_removed_nodes_ = false;
+  auto less = [this](Si32 a, Si32 b) {
+    return IsDrawnBefore(a, b);
+  };
+  auto middle = draw_order_.begin() + static_cast<std::ptrdiff_t>(sorted_size);
+  std::sort(middle, draw_order_.end(), less);
+  std::inplace_merge(draw_order_.begin(), middle, draw_order_.end(), less);
+}
+
+void Scene2F::Update() {
+  updated_node_count_ = 0;
+  for (Si32 idx : dirty_nodes_) {
+    // A dirty ancestor will update the whole subtree
+    if ((flags_[idx] & (kFlagAlive | kFlagDirty)) ==
+        (kFlagAlive | kFlagDirty) && !HasDirtyAncestor(idx)) {
+      UpdateSubtree(idx);
+    }
+  }
+  dirty_nodes_.clear();
+  UpdateDrawOrder();
+}
+
+void Scene2F::Draw() {
+  Draw(GetEngine()->GetBackbuffer());
+}
+
+void Scene2F::Draw(Sprite to_sprite) {
+  Update();
+  drawn_node_count_ = 0;
+  const float width = static_cast<float>(to_sprite.Width());
+  const float height = static_cast<float>(to_sprite.Height());
+  for (Si32 idx : draw_order_) {
+    if (!(flags_[idx] & kFlagWorldVisible) || sprite_[idx].Width() == 0) {
+      continue;
+    }
+    const Transform2F &world = world_[idx];
+    Vec2F pos = world.dc.Transform(Vec2F(0.f, 0.f));
+    float radius = world_radius_[idx];
+    if (pos.x + radius < 0.f || pos.y + radius < 0.f ||
+        pos.x - radius > width || pos.y - radius > height) {
+      continue;
+    }
+    sprite_[idx].Draw(pos.x, pos.y, world.dc.GetAngle(), world.scale,
+      to_sprite, blending_mode_[idx], filter_mode_[idx], color_[idx]);
+    ++drawn_node_count_;
+  }
+}
+
+}  // namespace arctic
@@ -0,0 +1,156 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef ENGINE_SCENE2F_H_
+#define ENGINE_SCENE2F_H_
+
+#include <vector>
+
+#include "engine/arctic_types.h"
+#include "engine/easy_sprite.h"
+#include "engine/rgba.h"
+#include "engine/transform2f.h"
+#include "engine/vec2f.h"
+
+namespace arctic {
+
+/// @addtogroup global_drawing
+/// @{
+
+/// @brief A flat 2D scene graph for large trees of sprites
+/// @details The nodes are addressed by index and their data is kept in
+///  parallel arrays. Changing a node marks it dirty, and Update recomputes
+///  the world transforms of the dirty subtrees only. The draw order is
+///  sorted by the world z order, ties are drawn in the node creation order.
+///  It is kept sorted incrementally: only the nodes whose world z order
+///  changed are re-sorted and merged back. Draw skips the invisible nodes
+///  and the sprites that lie outside of the target sprite.
+class Scene2F {
+ public:
+  static constexpr Si32 kNoNode = -1;
+  static constexpr Ui32 kFlagVisible = 1;
+  static constexpr Ui32 kFlagRelativeZOrder = 2;
+
+  /// @brief Adds a node without a sprite
+  /// @param [in] parent_idx Index of the parent node or kNoNode for a root.
+  /// @return Index of the new node.
+  Si32 AddNode(Si32 parent_idx = kNoNode);
+  /// @brief Adds a node that draws the sprite with its pivot at the node origin
+  Si32 AddSpriteNode(Sprite sprite, Si32 parent_idx = kNoNode);
+  /// @brief Removes the node with its whole subtree
+  void RemoveNode(Si32 idx);
+  /// @brief Moves the node with its subtree under another parent
+  void SetParent(Si32 idx, Si32 parent_idx);
+  Si32 GetParent(Si32 idx) const;
+  /// @brief Returns true if the index refers to a node that is not removed
+  bool IsAlive(Si32 idx) const;
+  /// @brief Returns the number of nodes that are not removed
+  Si32 NodeCount() const;
+
+  void SetTransform(Si32 idx, const Transform2F &transform);
+  const Transform2F &GetTransform(Si32 idx) const;
+  void SetPosition(Si32 idx, Vec2F position);
+  /// @brief Returns the world transform computed by the last Update
+  const Transform2F &GetWorldTransform(Si32 idx) const;
+
+  void SetZOrder(Si32 idx, float z_order);
+  float GetZOrder(Si32 idx) const;
+  /// @brief Makes the node z order relative to the parent world z order
+  void SetRelativeZOrder(Si32 idx, bool is_relative);
+  bool IsRelativeZOrder(Si32 idx) const;
+  /// @brief Shows or hides the node with its whole subtree
+  void SetVisible(Si32 idx, bool is_visible);
+  bool IsVisible(Si32 idx) const;
+
+  void SetSprite(Si32 idx, Sprite sprite);
+  void SetDrawBlendingMode(Si32 idx, DrawBlendingMode blending_mode);
+  void SetDrawFilterMode(Si32 idx, DrawFilterMode filter_mode);
+  void SetColor(Si32 idx, Rgba color);
+
+  /// @brief Recomputes the dirty world transforms and the draw order
+  void Update();
+  /// @brief Returns the node indices in the draw order of the last Update
+  const std::vector<Si32> &DrawOrder() const {
+    return draw_order_;
+  }
+  /// @brief Returns the number of world transforms the last Update computed
+  Si32 UpdatedNodeCount() const {
+    return updated_node_count_;
+  }
+  /// @brief Updates the scene and draws it to the backbuffer
+  void Draw();
+  /// @brief Updates the scene and draws it to the target sprite
+  void Draw(Sprite to_sprite);
+  /// @brief Returns the number of sprites the last Draw did not cull
+  Si32 DrawnNodeCount() const {
+    return drawn_node_count_;
+  }
+
+ private:
+  static constexpr Ui32 kFlagAlive = 1u << 8;
+  static constexpr Ui32 kFlagDirty = 1u << 9;
+  static constexpr Ui32 kFlagZOrderChanged = 1u << 10;
+  static constexpr Ui32 kFlagWorldVisible = 1u << 11;
+
+  std::vector<Si32> parent_;
+  std::vector<Si32> first_child_;
+  std::vector<Si32> next_sibling_;
+  std::vector<Si32> prev_sibling_;
+  std::vector<Ui32> flags_;
+  std::vector<Ui64> sequence_;
+  std::vector<Transform2F> local_;
+  std::vector<Transform2F> world_;
+  std::vector<float> z_order_;
+  std::vector<float> world_z_order_;
+  // Distance from the sprite pivot to its farthest corner in the world
+  std::vector<float> world_radius_;
+  std::vector<Sprite> sprite_;
+  std::vector<DrawBlendingMode> blending_mode_;
+  std::vector<DrawFilterMode> filter_mode_;
+  std::vector<Rgba> color_;
+
+  std::vector<Si32> free_nodes_;
+  std::vector<Si32> dirty_nodes_;
+  std::vector<Si32> z_order_changed_nodes_;
+  std::vector<Si32> draw_order_;
+  std::vector<Si32> stack_;
+  Ui64 next_sequence_ = 0;
+  Si32 node_count_ = 0;
+  bool has_removed_nodes_ = false;
+  Si32 updated_node_count_ = 0;
+  Si32 drawn_node_count_ = 0;
+
+  void MarkDirty(Si32 idx);
+  void MarkZOrderChanged(Si32 idx);
+  void Link(Si32 idx, Si32 parent_idx);
+  void Unlink(Si32 idx);
+  bool HasDirtyAncestor(Si32 idx) const;
+  void UpdateSubtree(Si32 root_idx);
+  void UpdateDrawOrder();
+  bool IsDrawnBefore(Si32 a, Si32 b) const;
+};
+
+/// @}
+
+}  // namespace arctic
+
+#endif  // ENGINE_SCENE2F_H_
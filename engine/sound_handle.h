@@ -49,6 +49,10 @@ class SoundHandle {
     return uid_;
   }
 
+  SoundTask *GetSoundTask() const {
+    return sound_task_;
+  }
+
   inline static SoundHandle Invalid() {
     return SoundHandle(nullptr);
   }
@@ -0,0 +1,288 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "engine/sound_mix_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ARCTIC_SOUND_MIX_X86
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define ARCTIC_SOUND_MIX_NEON
+#include <arm_neon.h>
+#endif
+
+namespace arctic {
+
+namespace {
+
+constexpr float kSoftClipKnee = 0.97f;
+constexpr float kCompressorAttack = 1.f / (44100.f * 0.005f);
+constexpr float kCompressorRelease = 1.f / (44100.f * 0.2f);
+
+// Scalar reference. The vector kernels must produce the same samples.
+
+inline float SoftClipSample(float d) {
+  constexpr float a = kSoftClipKnee;
+  constexpr float b = 1.f - a;
+  if (d > a) {
+    d -= a;
+    return (b * d) / (b + d) + a;
+  } else if (d < -a) {
+    d += a;
+    return (b * d) / (b - d) - a;
+  } else {
+    return d;
+  }
+}
+
+// Advances the envelope follower by one frame and returns the frame gain.
+inline float NextCompressorGain(float peak, float *level) {
+  if (peak > *level) {
+    *level = *level * (1.f - kCompressorAttack) + peak * kCompressorAttack;
+  } else {
+    *level = *level * (1.f - kCompressorRelease) + peak * kCompressorRelease;
+  }
+  return (*level > 1.f ? 1.f / *level : 1.f);
+}
+
+// The envelope depends on the previous frame, so it stays scalar.
+void PeaksToGains(float *peak_to_gain, Si32 count, float *level) {
+  for (Si32 i = 0; i < count; ++i) {
+    peak_to_gain[i] = NextCompressorGain(peak_to_gain[i], level);
+  }
+}
+
+void AccumulateStereoScalar(float *to_l, float *to_r, const Si16 *from,
+    Si32 count, float volume) {
+  for (Si32 i = 0; i < count; ++i) {
+    to_l[i] += static_cast<float>(from[i * 2]) * volume;
+    to_r[i] += static_cast<float>(from[i * 2 + 1]) * volume;
+  }
+}
+
+void CompressAndClipScalar(float *l, float *r, Si32 count,
+    float *compressor_level) {
+  for (Si32 i = 0; i < count; ++i) {
+    const float peak = std::max(std::abs(l[i]), std::abs(r[i]));
+    const float gain = NextCompressorGain(peak, compressor_level);
+    l[i] = SoftClipSample(l[i] * gain);
+    r[i] = SoftClipSample(r[i] * gain);
+  }
+}
+
+inline Si16 SampleToSi16(float sample) {
+  const float scaled = sample * 32767.f;
+  return static_cast<Si16>(scaled < -32767.f ? -32767.f :
+    (scaled > 32767.f ? 32767.f : scaled));
+}
+
+void InterleaveToSi16Scalar(Si16 *to, const float *l, const float *r,
+    Si32 count) {
+  for (Si32 i = 0; i < count; ++i) {
+    to[i * 2] = SampleToSi16(l[i]);
+    to[i * 2 + 1] = SampleToSi16(r[i]);
+  }
+}
+
+#if defined(ARCTIC_SOUND_MIX_X86)
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+namespace sse2 {
+
+typedef __m128 F;
+typedef __m128 M;
+const Si32 kLanes = 4;
+
+inline F LoadF(const float *p) {
+  return _mm_loadu_ps(p);
+}
+inline void StoreF(float *p, F v) {
+  _mm_storeu_ps(p, v);
+}
+inline F Set1F(float x) {
+  return _mm_set1_ps(x);
+}
+inline F AddF(F a, F b) {
+  return _mm_add_ps(a, b);
+}
+inline F SubF(F a, F b) {
+  return _mm_sub_ps(a, b);
+}
+inline F MulF(F a, F b) {
+  return _mm_mul_ps(a, b);
+}
+inline F DivF(F a, F b) {
+  return _mm_div_ps(a, b);
+}
+inline F AbsF(F a) {
+  return _mm_andnot_ps(_mm_set1_ps(-0.f), a);
+}
+inline F MaxF(F a, F b) {
+  return _mm_max_ps(a, b);
+}
+inline F MinF(F a, F b) {
+  return _mm_min_ps(a, b);
+}
+inline M GreaterF(F a, F b) {
+  return _mm_cmpgt_ps(a, b);
+}
+inline F SelectF(M mask, F a, F b) {
+  return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+inline F CopySignF(F magnitude, F sign) {
+  const F sign_mask = _mm_set1_ps(-0.f);
+  return _mm_or_ps(_mm_andnot_ps(sign_mask, magnitude),
+    _mm_and_ps(sign_mask, sign));
+}
+inline void LoadStereoSi16(const Si16 *p, F *l, F *r) {
+  const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  *l = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_slli_epi32(v, 16), 16));
+  *r = _mm_cvtepi32_ps(_mm_srai_epi32(v, 16));
+}
+inline void StoreStereoSi16(Si16 *p, F l, F r) {
+  const __m128i li = _mm_cvttps_epi32(l);
+  const __m128i ri = _mm_cvttps_epi32(r);
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_packs_epi32(
+    _mm_unpacklo_epi32(li, ri), _mm_unpackhi_epi32(li, ri)));
+}
+
+#include "engine/sound_mix_kernels.inc"
+
+}  // namespace sse2
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#endif  // ARCTIC_SOUND_MIX_X86
+
+#if defined(ARCTIC_SOUND_MIX_NEON)
+
+namespace neon {
+
+typedef float32x4_t F;
+typedef uint32x4_t M;
+const Si32 kLanes = 4;
+
+inline F LoadF(const float *p) {
+  return vld1q_f32(p);
+}
+inline void StoreF(float *p, F v) {
+  vst1q_f32(p, v);
+}
+inline F Set1F(float x) {
+  return vdupq_n_f32(x);
+}
+inline F AddF(F a, F b) {
+  return vaddq_f32(a, b);
+}
+inline F SubF(F a, F b) {
+  return vsubq_f32(a, b);
+}
+inline F MulF(F a, F b) {
+  return vmulq_f32(a, b);
+}
+inline F DivF(F a, F b) {
+#if defined(__aarch64__) || defined(_M_ARM64)
+  return vdivq_f32(a, b);
+#else
+  // ARMv7 has no vector division, refine the reciprocal estimate instead.
+  F inv = vrecpeq_f32(b);
+  inv = vmulq_f32(inv, vrecpsq_f32(b, inv));
+  inv = vmulq_f32(inv, vrecpsq_f32(b, inv));
+  return vmulq_f32(a, inv);
+#endif
+}
+inline F AbsF(F a) {
+  return vabsq_f32(a);
+}
+inline F MaxF(F a, F b) {
+  return vmaxq_f32(a, b);
+}
+inline F MinF(F a, F b) {
+  return vminq_f32(a, b);
+}
+inline M GreaterF(F a, F b) {
+  return vcgtq_f32(a, b);
+}
+inline F SelectF(M mask, F a, F b) {
+  return vbslq_f32(mask, a, b);
+}
+inline F CopySignF(F magnitude, F sign) {
+  return vbslq_f32(vdupq_n_u32(0x80000000u), sign, magnitude);
+}
+inline void LoadStereoSi16(const Si16 *p, F *l, F *r) {
+  const int16x4x2_t v = vld2_s16(p);
+  *l = vcvtq_f32_s32(vmovl_s16(v.val[0]));
+  *r = vcvtq_f32_s32(vmovl_s16(v.val[1]));
+}
+inline void StoreStereoSi16(Si16 *p, F l, F r) {
+  int16x4x2_t v;
+  v.val[0] = vmovn_s32(vcvtq_s32_f32(l));
+  v.val[1] = vmovn_s32(vcvtq_s32_f32(r));
+  vst2_s16(p, v);
+}
+
+#include "engine/sound_mix_kernels.inc"
+
+}  // namespace neon
+
+#endif  // ARCTIC_SOUND_MIX_NEON
+
+const SoundMixKernels g_scalar_sound_mix_kernels = {
+  AccumulateStereoScalar, CompressAndClipScalar, InterleaveToSi16Scalar};
+
+#if defined(ARCTIC_SOUND_MIX_X86)
+const SoundMixKernels g_sound_mix_kernels = {
+  sse2::AccumulateStereo, sse2::CompressAndClip, sse2::InterleaveToSi16};
+#elif defined(ARCTIC_SOUND_MIX_NEON)
+const SoundMixKernels g_sound_mix_kernels = {
+  neon::AccumulateStereo, neon::CompressAndClip, neon::InterleaveToSi16};
+#else
+const SoundMixKernels g_sound_mix_kernels = g_scalar_sound_mix_kernels;
+#endif
+
+}  // namespace
+
+const SoundMixKernels &GetSoundMixKernels() {
+  return g_sound_mix_kernels;
+}
+
+const SoundMixKernels &GetScalarSoundMixKernels() {
+  return g_scalar_sound_mix_kernels;
+}
+
+}  // namespace arctic
@@ -0,0 +1,64 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef ENGINE_SOUND_MIX_KERNELS_H_
+#define ENGINE_SOUND_MIX_KERNELS_H_
+
+#include "engine/arctic_types.h"
+
+namespace arctic {
+
+/// @addtogroup global_sound
+/// @{
+
+/// @brief Number of frames the compressor processes at once
+const Si32 kSoundMixBlockFrames = 256;
+
+/// @brief Functions doing the per-sample work of the sound mixer
+/// @details The channels are planar float buffers, the samples are
+///  in the [-1, 1] range after the clipping.
+struct SoundMixKernels {
+  /// @brief Adds count interleaved stereo Si16 frames scaled by volume
+  ///  to the to_l and to_r channels
+  void (*accumulate_stereo)(float *to_l, float *to_r, const Si16 *from,
+    Si32 count, float volume);
+  /// @brief Applies the compressor and the soft clipping to the channels
+  /// @param [in,out] compressor_level The envelope follower state.
+  void (*compress_and_clip)(float *l, float *r, Si32 count,
+    float *compressor_level);
+  /// @brief Writes the channels to count interleaved stereo Si16 frames
+  void (*interleave_to_si16)(Si16 *to, const float *l, const float *r,
+    Si32 count);
+};
+
+/// @brief Returns the fastest mixing kernels the cpu supports
+/// @details On x86 the results are bit-exact with the scalar reference.
+///  Other instruction sets may differ in the last bits of the float samples.
+const SoundMixKernels &GetSoundMixKernels();
+/// @brief Returns the portable scalar reference mixing kernels
+const SoundMixKernels &GetScalarSoundMixKernels();
+
+/// @}
+
+}  // namespace arctic
+
+#endif  // ENGINE_SOUND_MIX_KERNELS_H_
@@ -0,0 +1,108 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "engine/sound_offline_mixer.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "engine/arctic_mixer.h"
+#include "engine/easy_files.h"
+
+namespace arctic {
+
+extern SoundMixerState g_sound_mixer_state;
+
+namespace {
+
+void AppendUi16(std::vector<Ui8> *out, Ui16 value) {
+  out->push_back(static_cast<Ui8>(value & 0xff));
+  out->push_back(static_cast<Ui8>(value >> 8));
+}
+
+void AppendUi32(std::vector<Ui8> *out, Ui32 value) {
+  AppendUi16(out, static_cast<Ui16>(value & 0xffff));
+  AppendUi16(out, static_cast<Ui16>(value >> 16));
+}
+
+void AppendTag(std::vector<Ui8> *out, const char *tag) {
+  out->insert(out->end(), tag, tag + 4);
+}
+
+}  // namespace
+
+OfflineSoundMixer::OfflineSoundMixer(Si32 period_frames)
+    : period_frames_(std::max(period_frames, 1))
+    , period_(static_cast<size_t>(period_frames_) * 2)
+    , tmp_(static_cast<size_t>(period_frames_) * 2) {
+}
+
+void OfflineSoundMixer::RenderPeriod(Si16 *out) {
+  g_sound_mixer_state.MixSoundToSi16(out, period_frames_, tmp_.data());
+}
+
+void OfflineSoundMixer::Render(Si32 frames, std::vector<Si16> *out) {
+  out->reserve(out->size() + static_cast<size_t>(frames) * 2);
+  while (frames > 0) {
+    RenderPeriod(period_.data());
+    const Si32 size = std::min(frames, period_frames_);
+    out->insert(out->end(), period_.begin(), period_.begin() + size * 2);
+    frames -= size;
+  }
+}
+
+void OfflineSoundMixer::RenderToWav(double duration_seconds,
+    const char *file_name) {
+  std::vector<Si16> samples;
+  Render(static_cast<Si32>(duration_seconds * kSampleRate + 0.5), &samples);
+  std::vector<Ui8> wav = MakeWav(samples.data(),
+    static_cast<Si32>(samples.size() / 2));
+  WriteFile(file_name, wav.data(), wav.size());
+}
+
+std::vector<Ui8> MakeWav(const Si16 *samples, Si32 frames) {
+  const Ui32 data_size = static_cast<Ui32>(frames) * 4;
+  std::vector<Ui8> wav;
+  wav.reserve(44 + data_size);
+  AppendTag(&wav, "RIFF");
+  AppendUi32(&wav, 36 + data_size);
+  AppendTag(&wav, "WAVE");
+  AppendTag(&wav, "fmt ");
+  AppendUi32(&wav, 16);
+  AppendUi16(&wav, 1);  // PCM
+  AppendUi16(&wav, 2);
+  AppendUi32(&wav, OfflineSoundMixer::kSampleRate);
+  AppendUi32(&wav, OfflineSoundMixer::kSampleRate * 4);
+  AppendUi16(&wav, 4);
+  AppendUi16(&wav, 16);
+  AppendTag(&wav, "data");
+  AppendUi32(&wav, data_size);
+  for (Si32 i = 0; i < frames * 2; ++i) {
+    AppendUi16(&wav, static_cast<Ui16>(samples[i]));
+  }
+  return wav;
+}
+
+}  // namespace arctic
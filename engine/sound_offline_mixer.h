@@ -0,0 +1,79 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef ENGINE_SOUND_OFFLINE_MIXER_H_
+#define ENGINE_SOUND_OFFLINE_MIXER_H_
+
+#include <vector>
+
+#include "engine/arctic_types.h"
+
+namespace arctic {
+
+/// @addtogroup global_sound
+/// @{
+
+/// @brief Runs the sound mixer into memory instead of a sound device.
+/// Renders as fast as the cpu allows, so it is meant for headless runs,
+/// tests and benchmarks where no SoundPlayer is initialized.
+class OfflineSoundMixer {
+ public:
+  static constexpr Si32 kSampleRate = 44100;
+
+  /// @param period_frames Number of frames the mixer renders per call,
+  /// like the period of a sound device.
+  explicit OfflineSoundMixer(Si32 period_frames = 512);
+
+  Si32 PeriodFrames() const {
+    return period_frames_;
+  }
+
+  /// @brief Mixes one period of the playing sounds
+  /// @param [out] out Buffer of 2 * PeriodFrames() interleaved stereo samples
+  void RenderPeriod(Si16 *out);
+
+  /// @brief Mixes the playing sounds and appends them to out
+  /// @param frames Number of stereo frames to render
+  /// @param [out] out Vector interleaved stereo samples are appended to
+  void Render(Si32 frames, std::vector<Si16> *out);
+
+  /// @brief Mixes the playing sounds and saves them as a 16-bit stereo wav file
+  /// @param duration_seconds Duration of the sound to render
+  /// @param file_name Path of the wav file to write
+  void RenderToWav(double duration_seconds, const char *file_name);
+
+ private:
+  Si32 period_frames_;
+  std::vector<Si16> period_;
+  std::vector<Si16> tmp_;
+};
+
+/// @brief Makes a 16-bit stereo 44100 Hz wav file image
+/// @param samples Interleaved stereo samples
+/// @param frames Number of stereo frames
+std::vector<Ui8> MakeWav(const Si16 *samples, Si32 frames);
+
+/// @}
+
+}  // namespace arctic
+
+#endif  // ENGINE_SOUND_OFFLINE_MIXER_H_
@@ -0,0 +1,143 @@
+// This is an open source non-commercial project. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#include "engine/sound_stream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+#include "engine/log.h"
+
+#define STB_VORBIS_HEADER_ONLY
+#define STB_VORBIS_NO_PUSHDATA_API
+#define STB_VORBIS_NO_STDIO
+#define STB_VORBIS_MAX_CHANNELS    2
+#include "engine/stb_vorbis.inc"
+
+namespace arctic {
+
+void SoundFrameRing::Reset(Si32 capacity_frames) {
+  if (capacity_frames_ != capacity_frames) {
+    data_.resize(static_cast<size_t>(capacity_frames) * 2);
+    capacity_frames_ = capacity_frames;
+  }
+  write_frames_.store(0);
+  read_frames_.store(0);
+}
+
+Si32 SoundFrameRing::BufferedFrames() const {
+  const Ui64 read = read_frames_.load(std::memory_order_acquire);
+  const Ui64 write = write_frames_.load(std::memory_order_acquire);
+  return static_cast<Si32>(write - read);
+}
+
+Si16 *SoundFrameRing::WriteSpan(Si32 *out_frames) {
+  const Ui64 write = write_frames_.load(std::memory_order_relaxed);
+  const Ui64 read = read_frames_.load(std::memory_order_acquire);
+  const Si32 offset = static_cast<Si32>(write % static_cast<Ui64>(capacity_frames_));
+  const Si32 free_frames = capacity_frames_ - static_cast<Si32>(write - read);
+  *out_frames = std::min(free_frames, capacity_frames_ - offset);
+  return data_.data() + offset * 2;
+}
+
+void SoundFrameRing::CommitWrite(Si32 frames) {
+  write_frames_.store(write_frames_.load(std::memory_order_relaxed) +
+    static_cast<Ui64>(frames), std::memory_order_release);
+}
+
+Si32 SoundFrameRing::Read(Si16 *out, Si32 frames) {
+  const Ui64 read = read_frames_.load(std::memory_order_relaxed);
+  const Ui64 write = write_frames_.load(std::memory_order_acquire);
+  const Si32 to_read = std::min(frames, static_cast<Si32>(write - read));
+  const Si32 offset = static_cast<Si32>(read % static_cast<Ui64>(capacity_frames_));
+  const Si32 first = std::min(to_read, capacity_frames_ - offset);
+  memcpy(out, data_.data() + offset * 2, static_cast<size_t>(first) * 4);
+  memcpy(out + first * 2, data_.data(),
+    static_cast<size_t>(to_read - first) * 4);
+  read_frames_.store(read + static_cast<Ui64>(to_read),
+    std::memory_order_release);
+  return to_read;
+}
+
+SoundStream::~SoundStream() {
+  Close();
+}
+
+void SoundStream::Open(const SoundInstance &instance) {
+  Close();
+  ring_.Reset(kRingFrames);
+  vorbis_data_ = instance.GetVorbisData();
+  vorbis_size_ = instance.GetVorbisSize();
+  is_decoder_ended_.store(false);
+  int error = 0;
+  vorbis_codec_ = stb_vorbis_open_memory(vorbis_data_, vorbis_size_,
+    &error, nullptr);
+  if (!vorbis_codec_) {
+    *Log() << "SoundStream encountered error: " << error
+      << " while opening vorbis data of size " << vorbis_size_;
+    is_decoder_ended_.store(true);
+  }
+}
+
+void SoundStream::Close() {
+  if (vorbis_codec_) {
+    stb_vorbis_close(vorbis_codec_);
+    vorbis_codec_ = nullptr;
+  }
+  vorbis_data_ = nullptr;
+  vorbis_size_ = 0;
+}
+
+Si32 SoundStream::Decode(Si32 max_frames) {
+  if (!vorbis_codec_ || is_decoder_ended_.load(std::memory_order_relaxed)) {
+    return 0;
+  }
+  Si32 decoded = 0;
+  while (decoded < max_frames) {
+    Si32 span_frames = 0;
+    Si16 *span = ring_.WriteSpan(&span_frames);
+    span_frames = std::min(span_frames, max_frames - decoded);
+    if (span_frames == 0) {
+      break;
+    }
+    int res = stb_vorbis_get_samples_short_interleaved(
+      vorbis_codec_, 2, span, span_frames * 2);
+    if (res <= 0) {
+      is_decoder_ended_.store(true, std::memory_order_release);
+      break;
+    }
+    ring_.CommitWrite(res);
+    decoded += res;
+  }
+  return decoded;
+}
+
+bool SoundStream::IsEnded() const {
+  return is_decoder_ended_.load(std::memory_order_acquire) &&
+    ring_.BufferedFrames() == 0;
+}
+
+}  // namespace arctic
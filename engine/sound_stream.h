@@ -0,0 +1,112 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+#ifndef ENGINE_SOUND_STREAM_H_
+#define ENGINE_SOUND_STREAM_H_
+
+#include <atomic>
+#include <vector>
+
+#include "engine/arctic_types.h"
+#include "engine/easy_sound_instance.h"
+
+struct stb_vorbis;
+
+namespace arctic {
+
+/// @addtogroup global_sound
+/// @{
+
+/// @brief Single producer single consumer ring of interleaved stereo frames
+class SoundFrameRing {
+ public:
+  /// @brief Empties the ring, allocates the storage on the first call
+  void Reset(Si32 capacity_frames);
+  Si32 CapacityFrames() const {
+    return capacity_frames_;
+  }
+  /// @brief Number of frames the consumer can read
+  Si32 BufferedFrames() const;
+  /// @brief Returns the contiguous free space the producer can write to
+  /// @param [out] out_frames Number of frames available at the returned pointer
+  Si16 *WriteSpan(Si32 *out_frames);
+  /// @brief Publishes frames written to the span returned by WriteSpan
+  void CommitWrite(Si32 frames);
+  /// @brief Copies up to frames frames out of the ring
+  /// @return Number of frames copied
+  Si32 Read(Si16 *out, Si32 frames);
+
+ private:
+  std::vector<Si16> data_;
+  Si32 capacity_frames_ = 0;
+  std::atomic<Ui64> write_frames_ = ATOMIC_VAR_INIT(0);
+  std::atomic<Ui64> read_frames_ = ATOMIC_VAR_INIT(0);
+};
+
+/// @brief Sequential Vorbis decoder of one playing voice.
+/// Decode is called by one thread (the mixer or the decode thread),
+/// Read by the mixer, so the stream never has to seek.
+class SoundStream {
+ public:
+  static constexpr Si32 kRingFrames = 4096;
+
+  SoundStream() = default;
+  SoundStream(const SoundStream &) = delete;
+  SoundStream &operator=(const SoundStream &) = delete;
+  ~SoundStream();
+
+  /// @brief Opens the decoder to decode the instance from the beginning.
+  /// Called by the thread starting the voice, so the mixer never allocates
+  /// a decoder. The instance must outlive the stream or the next Open/Close call.
+  void Open(const SoundInstance &instance);
+  /// @brief Frees the decoder, keeps the ring storage for the next voice
+  void Close();
+  bool IsOpen() const {
+    return vorbis_data_ != nullptr;
+  }
+  /// @brief Decodes up to max_frames frames into the free ring space
+  /// @return Number of frames decoded
+  Si32 Decode(Si32 max_frames);
+  Si32 BufferedFrames() const {
+    return ring_.BufferedFrames();
+  }
+  /// @brief Copies up to frames decoded frames out of the ring
+  /// @return Number of frames copied
+  Si32 Read(Si16 *out, Si32 frames) {
+    return ring_.Read(out, frames);
+  }
+  /// @brief Returns true once the whole sound was decoded and read
+  bool IsEnded() const;
+
+ private:
+  SoundFrameRing ring_;
+  stb_vorbis *vorbis_codec_ = nullptr;
+  const Ui8 *vorbis_data_ = nullptr;
+  Si32 vorbis_size_ = 0;
+  std::atomic<bool> is_decoder_ended_ = ATOMIC_VAR_INIT(false);
+};
+
+/// @}
+
+}  // namespace arctic
+
+#endif  // ENGINE_SOUND_STREAM_H_
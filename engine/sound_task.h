@@ -24,10 +24,12 @@
 #define ENGINE_SOUND_TASK_H_
 
 #include <atomic>
+#include <vector>
 
 #include "engine/arctic_types.h"
 #include "engine/transform3f.h"
 #include "engine/easy_sound.h"
+#include "engine/sound_stream.h"
 
 namespace arctic {
 
@@ -39,21 +41,35 @@ enum class SoundTaskAction {
   kStop = 1,
   kSetHeadLocation = 2,
   kSetLocation = 3,
-  kStart3d = 4
+  kStart3d = 4,
+  kSetLocations = 5
 };
 
 struct ChannelPlaybackState {
   double play_position = 0.0;
   double delay = 0.0;
   float acc = 0.f;
+  // Gain of the last rendered sample, the next period ramps from it
+  float volume = 0.f;
+  bool has_volume = false;
 
   void Clear() {
     play_position = 0.0;
     delay = 0.0;
     acc = 0.f;
+    volume = 0.f;
+    has_volume = false;
   }
 };
 
+struct SoundTask;
+
+struct SoundLocationUpdate {
+  SoundTask *target_task = nullptr;
+  Ui64 target_uid = 0;
+  Vec3F position;
+};
+
 struct SoundTask {
   static constexpr Ui64 kInvalidSoundTaskUid = 0;
   std::atomic<Ui64> uid = ATOMIC_VAR_INIT(kInvalidSoundTaskUid);
@@ -66,16 +82,34 @@ struct SoundTask {
   SoundTaskAction action = SoundTaskAction::kStart;
   bool is_3d = false;
   std::atomic<bool> is_playing = ATOMIC_VAR_INIT(false);
+  // Voice the command is addressed to, checked against target_uid
+  SoundTask *target_task = nullptr;
+  // Payload of kSetLocations, keeps its capacity while the task is pooled
+  std::vector<SoundLocationUpdate> location_updates;
+  // Mixer-only state: index in SoundMixerState::buffers or -1,
+  // and the list of voices playing the same SoundInstance
+  Si32 buffer_idx = -1;
+  bool is_culled = false;
+  SoundTask *prev_instance_voice = nullptr;
+  SoundTask *next_instance_voice = nullptr;
+  // Decoder of a sound loaded with do_unpack == false, owned by this voice
+  SoundStream stream;
+  // Index in SoundMixerState::decoded_streams or -1 if the mixer decodes
+  Si32 stream_slot = -1;
 
   void Clear(Ui64 in_uid) {
     uid = in_uid;
     target_uid = kInvalidSoundTaskUid;
+    target_task = nullptr;
+    location_updates.clear();
     sound.Clear();
     volume = 1.0f;
     next_position = 0;
     action = SoundTaskAction::kStart;
     is_3d = false;
     is_playing = false;
+    stream.Close();
+    stream_slot = -1;
   }
 };
 
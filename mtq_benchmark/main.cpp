@@ -0,0 +1,729 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2026 Huldra
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+// Measures the throughput and the latency of the mtq queues and allocators
+// under several producer and consumer counts, payload sizes and
+// TuneMemoryPoolFlag settings, next to a mutex and std::deque baseline.
+// Writes the results as CSV and JSON for regression tracking.
+// usage: mtq_benchmark [max_threads] [items_per_run] [out.csv] [out.json]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <type_traits>
+#include <vector>
+
+#include "engine/arctic_types.h"
+#include "engine/mtq_fixed_block_queue.h"
+#include "engine/mtq_mpmc_befsbfsp_allocator.h"
+#include "engine/mtq_mpsc_tail_swap.h"
+#include "engine/mtq_mpsc_vinfarr.h"
+#include "engine/mtq_spmc_array.h"
+
+using namespace arctic;  // NOLINT
+
+namespace {
+
+// Every kLatencyStride-th item carries the time it was enqueued at.
+const Ui64 kLatencyStride = 16;
+const size_t kSpmcArraySize = 1024;
+
+Ui64 NowNs() {
+  return static_cast<Ui64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+template <size_t kSize>
+struct Payload {
+  // words[0] is the enqueue time, 0 if the item is not sampled.
+  Ui64 words[kSize / sizeof(Ui64)];
+};
+
+struct Result {
+  std::string scenario;
+  std::string queue;
+  Si32 producers = 0;
+  Si32 consumers = 0;
+  size_t payload_bytes = 0;
+  bool is_memory_pool = false;
+  Ui64 items = 0;
+  double seconds = 0.0;
+  double p50_ns = 0.0;
+  double p99_ns = 0.0;
+  double p999_ns = 0.0;
+  double max_ns = 0.0;
+
+  double ItemsPerSecond() const {
+    return seconds > 0.0 ? static_cast<double>(items) / seconds : 0.0;
+  }
+};
+
+void SetLatencies(std::vector<Ui64> *latencies, Result *result) {
+  if (latencies->empty()) {
+    return;
+  }
+  std::sort(latencies->begin(), latencies->end());
+  auto at = [latencies](double fraction) {
+    const size_t idx = std::min(latencies->size() - 1,
+      static_cast<size_t>(fraction * static_cast<double>(latencies->size())));
+    return static_cast<double>((*latencies)[idx]);
+  };
+  result->p50_ns = at(0.5);
+  result->p99_ns = at(0.99);
+  result->p999_ns = at(0.999);
+  result->max_ns = static_cast<double>(latencies->back());
+}
+
+double Seconds(Ui64 begin_ns, Ui64 end_ns) {
+  return static_cast<double>(end_ns - begin_ns) * 1e-9;
+}
+
+// Starts the threads together once they are all up.
+class StartLine {
+ public:
+  explicit StartLine(Si32 thread_count)
+    : thread_count_(thread_count) {
+  }
+
+  void Arrive() {
+    ready_.fetch_add(1);
+    while (!is_go_.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+  }
+
+  Ui64 Go() {
+    while (ready_.load() != thread_count_) {
+      std::this_thread::yield();
+    }
+    const Ui64 now = NowNs();
+    is_go_.store(true, std::memory_order_release);
+    return now;
+  }
+
+ private:
+  const Si32 thread_count_;
+  std::atomic<Si32> ready_{0};
+  std::atomic<bool> is_go_{false};
+};
+
+// The baseline: any number of producers and consumers.
+template <typename Item>
+class MutexDequeQueue {
+ public:
+  bool Push(const Item &item) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    items_.push_back(item);
+    return true;
+  }
+
+  bool Pop(Item *item) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (items_.empty()) {
+      return false;
+    }
+    *item = items_.front();
+    items_.pop_front();
+    return true;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::deque<Item> items_;
+};
+
+// The chunks come from a pool of 4080 byte pages, like the input queue has.
+template <typename Item, bool kIsMemoryPool>
+class VirtInfArrayQueue;
+
+template <typename Item>
+class VirtInfArrayQueue<Item, true> {
+ public:
+  VirtInfArrayQueue()
+    : queue_(&pool_) {
+  }
+
+  bool Push(const Item &item) {
+    queue_.enqueue(item);
+    return true;
+  }
+
+  bool Pop(Item *item) {
+    return queue_.dequeue(item);
+  }
+
+ private:
+  MpmcBestEffortFixedSizeBufferFixedSizePool<8, 4080> pool_;
+  MpscVirtInfArray<Item, TuneDeletePayloadFlag<false>,
+    TuneMemoryPoolFlag<true>> queue_;
+};
+
+template <typename Item>
+class VirtInfArrayQueue<Item, false> {
+ public:
+  VirtInfArrayQueue()
+    : queue_(64) {
+  }
+
+  bool Push(const Item &item) {
+    queue_.enqueue(item);
+    return true;
+  }
+
+  bool Pop(Item *item) {
+    return queue_.dequeue(item);
+  }
+
+ private:
+  MpscVirtInfArray<Item, TuneDeletePayloadFlag<false>,
+    TuneMemoryPoolFlag<false>> queue_;
+};
+
+// The pointer payloads use the other dequeue signature.
+template <typename Item, bool kIsMemoryPool>
+class VirtInfArrayPtrQueue {
+ public:
+  VirtInfArrayPtrQueue()
+    : queue_(MakeQueue(&pool_,
+        std::integral_constant<bool, kIsMemoryPool>())) {
+  }
+
+  bool Push(Item *item) {
+    queue_->enqueue(item);
+    return true;
+  }
+
+  bool Pop(Item **item) {
+    *item = queue_->dequeue();
+    return *item != nullptr;
+  }
+
+ private:
+  typedef MpscVirtInfArray<Item *, TuneDeletePayloadFlag<false>,
+    TuneMemoryPoolFlag<kIsMemoryPool>> QueueType;
+
+  static QueueType *MakeQueue(I_FixedSizeAllocator *pool, std::true_type) {
+    return new QueueType(pool);
+  }
+
+  static QueueType *MakeQueue(I_FixedSizeAllocator *, std::false_type) {
+    return new QueueType(64);
+  }
+
+  MpmcBestEffortFixedSizeBufferFixedSizePool<8, 4080> pool_;
+  std::unique_ptr<QueueType> queue_;
+};
+
+template <typename Item>
+class TailSwapQueue {
+ public:
+  bool Push(Item item) {
+    queue_.enqueue(std::move(item));
+    return true;
+  }
+
+  bool Pop(Item *item) {
+    return queue_.dequeue(item);
+  }
+
+ private:
+  MPSC_TailSwap<Item> queue_;
+};
+
+template <typename Item>
+class SpmcArrayQueue {
+ public:
+  SpmcArrayQueue()
+    : queue_(kSpmcArraySize) {
+  }
+
+  bool Push(Item *item) {
+    return queue_.enqueue(item);
+  }
+
+  bool Pop(Item **item) {
+    *item = queue_.dequeue();
+    return *item != nullptr;
+  }
+
+ private:
+  SpmcArray<Item, false> queue_;
+};
+
+// Items are either payloads or pointers to the payloads allocated by the
+// producers and deleted by the consumers, the way the input queue does it.
+template <typename Item>
+struct ItemTraits;
+
+template <size_t kSize>
+struct ItemTraits<Payload<kSize>> {
+  static Payload<kSize> Make(Ui64 stamp) {
+    Payload<kSize> item;
+    std::fill(std::begin(item.words), std::end(item.words), stamp);
+    return item;
+  }
+
+  static Ui64 Consume(const Payload<kSize> &item) {
+    return item.words[0];
+  }
+};
+
+template <size_t kSize>
+struct ItemTraits<Payload<kSize> *> {
+  static Payload<kSize> *Make(Ui64 stamp) {
+    return new Payload<kSize>(ItemTraits<Payload<kSize>>::Make(stamp));
+  }
+
+  static Ui64 Consume(Payload<kSize> *item) {
+    const Ui64 stamp = item->words[0];
+    delete item;
+    return stamp;
+  }
+};
+
+template <typename Queue, typename Item, size_t kSize>
+Result RunMpsc(const char *scenario, const char *name, bool is_memory_pool,
+    Si32 producers, Ui64 items) {
+  Queue queue;
+  const Ui64 items_per_producer = std::max<Ui64>(1, items / producers);
+  StartLine start_line(producers);
+  std::vector<std::thread> threads;
+  for (Si32 idx = 0; idx < producers; ++idx) {
+    threads.emplace_back([&queue, &start_line, items_per_producer]() {
+      start_line.Arrive();
+      for (Ui64 i = 0; i < items_per_producer; ++i) {
+        Item item = ItemTraits<Item>::Make(
+          i % kLatencyStride == 0 ? NowNs() : 0);
+        queue.Push(item);
+      }
+    });
+  }
+  std::vector<Ui64> latencies;
+  const Ui64 total = items_per_producer * static_cast<Ui64>(producers);
+  latencies.reserve(static_cast<size_t>(total / kLatencyStride + producers));
+  const Ui64 begin = start_line.Go();
+  for (Ui64 received = 0; received < total;) {
+    Item item;
+    if (queue.Pop(&item)) {
+      ++received;
+      const Ui64 stamp = ItemTraits<Item>::Consume(item);
+      if (stamp) {
+        latencies.push_back(NowNs() - stamp);
+      }
+    } else {
+      std::this_thread::yield();
+    }
+  }
+  const Ui64 end = NowNs();
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  Result result;
+  result.scenario = scenario;
+  result.queue = name;
+  result.producers = producers;
+  result.consumers = 1;
+  result.payload_bytes = kSize;
+  result.is_memory_pool = is_memory_pool;
+  result.items = total;
+  result.seconds = Seconds(begin, end);
+  SetLatencies(&latencies, &result);
+  return result;
+}
+
+template <typename Queue, size_t kSize>
+Result RunSpmc(const char *name, Si32 consumers, Ui64 items) {
+  typedef Payload<kSize> Item;
+  Queue queue;
+  // Each consumer quits on the stop item.
+  Item stop_item;
+  StartLine start_line(consumers);
+  std::vector<std::vector<Ui64>> latencies(static_cast<size_t>(consumers));
+  std::vector<std::thread> threads;
+  for (Si32 idx = 0; idx < consumers; ++idx) {
+    std::vector<Ui64> *thread_latencies = &latencies[static_cast<size_t>(idx)];
+    threads.emplace_back([&queue, &start_line, &stop_item, thread_latencies]() {
+      start_line.Arrive();
+      while (true) {
+        Item *item = nullptr;
+        if (!queue.Pop(&item)) {
+          std::this_thread::yield();
+          continue;
+        }
+        if (item == &stop_item) {
+          return;
+        }
+        const Ui64 stamp = ItemTraits<Item *>::Consume(item);
+        if (stamp) {
+          thread_latencies->push_back(NowNs() - stamp);
+        }
+      }
+    });
+  }
+  const Ui64 begin = start_line.Go();
+  for (Ui64 idx = 0; idx < items; ++idx) {
+    Item *item = ItemTraits<Item *>::Make(
+      idx % kLatencyStride == 0 ? NowNs() : 0);
+    while (!queue.Push(item)) {
+      std::this_thread::yield();
+    }
+  }
+  for (Si32 idx = 0; idx < consumers; ++idx) {
+    while (!queue.Push(&stop_item)) {
+      std::this_thread::yield();
+    }
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  const Ui64 end = NowNs();
+  std::vector<Ui64> all_latencies;
+  for (const std::vector<Ui64> &thread_latencies : latencies) {
+    all_latencies.insert(all_latencies.end(), thread_latencies.begin(),
+      thread_latencies.end());
+  }
+  Result result;
+  result.scenario = "spmc_ptr";
+  result.queue = name;
+  result.producers = 1;
+  result.consumers = consumers;
+  result.payload_bytes = kSize;
+  result.items = items;
+  result.seconds = Seconds(begin, end);
+  SetLatencies(&all_latencies, &result);
+  return result;
+}
+
+class MallocAllocator : public I_FixedSizeAllocator {
+ public:
+  explicit MallocAllocator(size_t block_size)
+    : block_size_(block_size) {
+  }
+  void *alloc() override {
+    return malloc(block_size_);
+  }
+  void free(void *ptr) override {
+    ::free(ptr);
+  }
+  size_t getBlockSize() override {
+    return block_size_;
+  }
+
+ private:
+  size_t block_size_;
+};
+
+class MutexFreeListAllocator : public I_FixedSizeAllocator {
+ public:
+  explicit MutexFreeListAllocator(size_t block_size)
+    : block_size_(block_size) {
+  }
+  ~MutexFreeListAllocator() {
+    for (void *ptr : blocks_) {
+      ::free(ptr);
+    }
+  }
+  void *alloc() override {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (!blocks_.empty()) {
+        void *ptr = blocks_.back();
+        blocks_.pop_back();
+        return ptr;
+      }
+    }
+    return malloc(block_size_);
+  }
+  void free(void *ptr) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    blocks_.push_back(ptr);
+  }
+  size_t getBlockSize() override {
+    return block_size_;
+  }
+
+ private:
+  size_t block_size_;
+  std::mutex mutex_;
+  std::vector<void *> blocks_;
+};
+
+// Each thread allocates a burst of blocks, touches and frees them.
+Result RunAllocator(const char *name, bool is_memory_pool,
+    I_FixedSizeAllocator *allocator, Si32 threads_count, Ui64 items) {
+  const size_t kBurst = 8;
+  const Ui64 bursts_per_thread = std::max<Ui64>(1,
+    items / kBurst / static_cast<Ui64>(threads_count));
+  StartLine start_line(threads_count);
+  std::vector<std::vector<Ui64>> latencies(
+    static_cast<size_t>(threads_count));
+  std::vector<std::thread> threads;
+  for (Si32 idx = 0; idx < threads_count; ++idx) {
+    std::vector<Ui64> *thread_latencies = &latencies[static_cast<size_t>(idx)];
+    threads.emplace_back([allocator, &start_line, bursts_per_thread,
+        thread_latencies]() {
+      void *blocks[kBurst];
+      start_line.Arrive();
+      for (Ui64 burst = 0; burst < bursts_per_thread; ++burst) {
+        const bool is_sampled = burst % kLatencyStride == 0;
+        const Ui64 begin = is_sampled ? NowNs() : 0;
+        for (size_t i = 0; i < kBurst; ++i) {
+          blocks[i] = allocator->alloc();
+          *static_cast<Ui64 *>(blocks[i]) = burst;
+        }
+        for (size_t i = 0; i < kBurst; ++i) {
+          allocator->free(blocks[i]);
+        }
+        if (is_sampled) {
+          // One alloc and free pair.
+          thread_latencies->push_back((NowNs() - begin) / kBurst);
+        }
+      }
+    });
+  }
+  const Ui64 begin = start_line.Go();
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  const Ui64 end = NowNs();
+  std::vector<Ui64> all_latencies;
+  for (const std::vector<Ui64> &thread_latencies : latencies) {
+    all_latencies.insert(all_latencies.end(), thread_latencies.begin(),
+      thread_latencies.end());
+  }
+  Result result;
+  result.scenario = "alloc_free";
+  result.queue = name;
+  result.producers = threads_count;
+  result.payload_bytes = allocator->getBlockSize();
+  result.is_memory_pool = is_memory_pool;
+  result.items = bursts_per_thread * kBurst *
+    static_cast<Ui64>(threads_count);
+  result.seconds = Seconds(begin, end);
+  SetLatencies(&all_latencies, &result);
+  return result;
+}
+
+// FixedBlockQueue is the single threaded container inside the queues.
+template <size_t kSize>
+Result RunFixedBlockQueue(bool is_baseline, Ui64 items) {
+  typedef Payload<kSize> Item;
+  const Ui64 kBurst = 256;
+  MpmcBestEffortFixedSizeBufferFixedSizePool<8, 4080> pool;
+  FixedBlockQueue<Item> queue;
+  std::deque<Item> baseline;
+  std::vector<Ui64> latencies;
+  Ui64 checksum = 0;
+  const Ui64 bursts = std::max<Ui64>(1, items / kBurst);
+  const Ui64 begin = NowNs();
+  for (Ui64 burst = 0; burst < bursts; ++burst) {
+    const Ui64 burst_begin = NowNs();
+    for (Ui64 idx = 0; idx < kBurst; ++idx) {
+      Item item = ItemTraits<Item>::Make(idx);
+      if (is_baseline) {
+        baseline.push_back(item);
+      } else {
+        queue.push_back(item, &pool);
+      }
+    }
+    for (Ui64 idx = 0; idx < kBurst; ++idx) {
+      if (is_baseline) {
+        checksum += baseline.front().words[0];
+        baseline.pop_front();
+      } else {
+        checksum += queue.front(&pool).words[0];
+        queue.pop_front(&pool);
+      }
+    }
+    latencies.push_back((NowNs() - burst_begin) / kBurst);
+  }
+  const Ui64 end = NowNs();
+  Result result;
+  result.scenario = "fifo_single_thread";
+  result.queue = is_baseline ? "std_deque" : "FixedBlockQueue";
+  result.producers = 1;
+  result.consumers = 1;
+  result.payload_bytes = kSize;
+  result.is_memory_pool = !is_baseline;
+  result.items = checksum == bursts * kBurst * (kBurst - 1) / 2 ?
+    bursts * kBurst : 0;
+  result.seconds = Seconds(begin, end);
+  SetLatencies(&latencies, &result);
+  return result;
+}
+
+void PrintResult(const Result &result) {
+  std::printf("%-18s %-42s %3d:%-3d %4d B %-6s %12.0f items/s"
+    " p50 %8.0f p99 %8.0f p99.9 %9.0f max %10.0f ns\n",
+    result.scenario.c_str(), result.queue.c_str(),
+    static_cast<int>(result.producers), static_cast<int>(result.consumers),
+    static_cast<int>(result.payload_bytes),
+    result.is_memory_pool ? "pool" : "malloc", result.ItemsPerSecond(),
+    result.p50_ns, result.p99_ns, result.p999_ns, result.max_ns);
+  std::fflush(stdout);
+}
+
+void AddResult(std::vector<Result> *results, const Result &result) {
+  PrintResult(result);
+  results->push_back(result);
+}
+
+bool WriteCsv(const char *file_name, const std::vector<Result> &results) {
+  FILE *file = std::fopen(file_name, "w");
+  if (!file) {
+    return false;
+  }
+  std::fprintf(file, "scenario,queue,producers,consumers,payload_bytes,"
+    "memory_pool,items,seconds,items_per_second,p50_ns,p99_ns,p999_ns,"
+    "max_ns\n");
+  for (const Result &r : results) {
+    std::fprintf(file, "%s,%s,%d,%d,%d,%d,%llu,%.6f,%.1f,%.0f,%.0f,%.0f,"
+      "%.0f\n", r.scenario.c_str(), r.queue.c_str(),
+      static_cast<int>(r.producers), static_cast<int>(r.consumers),
+      static_cast<int>(r.payload_bytes), r.is_memory_pool ? 1 : 0,
+      static_cast<unsigned long long>(r.items), r.seconds,  // NOLINT
+      r.ItemsPerSecond(), r.p50_ns, r.p99_ns, r.p999_ns, r.max_ns);
+  }
+  std::fclose(file);
+  return true;
+}
+
+bool WriteJson(const char *file_name, const std::vector<Result> &results) {
+  FILE *file = std::fopen(file_name, "w");
+  if (!file) {
+    return false;
+  }
+  std::fprintf(file, "{\n  \"hardware_threads\": %u,\n  \"results\": [\n",
+    std::thread::hardware_concurrency());
+  for (size_t idx = 0; idx < results.size(); ++idx) {
+    const Result &r = results[idx];
+    std::fprintf(file, "    {\"scenario\": \"%s\", \"queue\": \"%s\", "
+      "\"producers\": %d, \"consumers\": %d, \"payload_bytes\": %d, "
+      "\"memory_pool\": %s, \"items\": %llu, \"seconds\": %.6f, "
+      "\"items_per_second\": %.1f, \"p50_ns\": %.0f, \"p99_ns\": %.0f, "
+      "\"p999_ns\": %.0f, \"max_ns\": %.0f}%s\n",
+      r.scenario.c_str(), r.queue.c_str(),
+      static_cast<int>(r.producers), static_cast<int>(r.consumers),
+      static_cast<int>(r.payload_bytes),
+      r.is_memory_pool ? "true" : "false",
+      static_cast<unsigned long long>(r.items), r.seconds,  // NOLINT
+      r.ItemsPerSecond(), r.p50_ns, r.p99_ns, r.p999_ns, r.max_ns,
+      idx + 1 < results.size() ? "," : "");
+  }
+  std::fprintf(file, "  ]\n}\n");
+  std::fclose(file);
+  return true;
+}
+
+template <size_t kSize>
+void RunPayloadSize(const std::vector<Si32> &thread_counts, Ui64 items,
+    std::vector<Result> *results) {
+  typedef Payload<kSize> Item;
+  for (Si32 producers : thread_counts) {
+    AddResult(results, RunMpsc<MutexDequeQueue<Item>, Item, kSize>(
+      "mpsc", "mutex_deque", false, producers, items));
+    AddResult(results, RunMpsc<VirtInfArrayQueue<Item, true>, Item, kSize>(
+      "mpsc", "MpscVirtInfArray", true, producers, items));
+    AddResult(results, RunMpsc<VirtInfArrayQueue<Item, false>, Item, kSize>(
+      "mpsc", "MpscVirtInfArray", false, producers, items));
+    AddResult(results, RunMpsc<TailSwapQueue<Item>, Item, kSize>(
+      "mpsc", "MPSC_TailSwap", false, producers, items));
+    AddResult(results, RunMpsc<MutexDequeQueue<Item *>, Item *, kSize>(
+      "mpsc_ptr", "mutex_deque", false, producers, items));
+    AddResult(results, RunMpsc<VirtInfArrayPtrQueue<Item, true>, Item *,
+      kSize>("mpsc_ptr", "MpscVirtInfArray", true, producers, items));
+    AddResult(results, RunMpsc<VirtInfArrayPtrQueue<Item, false>, Item *,
+      kSize>("mpsc_ptr", "MpscVirtInfArray", false, producers, items));
+  }
+  for (Si32 consumers : thread_counts) {
+    AddResult(results, RunSpmc<MutexDequeQueue<Item *>, kSize>(
+      "mutex_deque", consumers, items));
+    AddResult(results, RunSpmc<SpmcArrayQueue<Item>, kSize>(
+      "SpmcArray", consumers, items));
+  }
+  AddResult(results, RunFixedBlockQueue<kSize>(true, items));
+  AddResult(results, RunFixedBlockQueue<kSize>(false, items));
+}
+
+template <size_t kBlockSize>
+void RunBlockSize(const std::vector<Si32> &thread_counts, Ui64 items,
+    std::vector<Result> *results) {
+  for (Si32 threads_count : thread_counts) {
+    MallocAllocator malloc_allocator(kBlockSize);
+    AddResult(results, RunAllocator("malloc", false, &malloc_allocator,
+      threads_count, items));
+    MutexFreeListAllocator mutex_allocator(kBlockSize);
+    AddResult(results, RunAllocator("mutex_free_list", true, &mutex_allocator,
+      threads_count, items));
+    MpmcBestEffortFixedSizeBufferFixedSizePool<64, kBlockSize> pool;
+    AddResult(results, RunAllocator(
+      "MpmcBestEffortFixedSizeBufferFixedSizePool", true, &pool,
+      threads_count, items));
+  }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+  const Si32 hardware_threads = std::max(2,
+    static_cast<Si32>(std::thread::hardware_concurrency()));
+  const Si32 max_threads = std::max(1,
+    argc > 1 ? std::atoi(argv[1]) : hardware_threads);
+  const Ui64 items = static_cast<Ui64>(std::max(1000LL,
+    argc > 2 ? std::atoll(argv[2]) : 1000000LL));
+  const char *csv_file_name = argc > 3 ? argv[3] : "mtq_benchmark.csv";
+  const char *json_file_name = argc > 4 ? argv[4] : "mtq_benchmark.json";
+
+  std::vector<Si32> thread_counts;
+  for (Si32 count = 1; count < max_threads; count *= 2) {
+    thread_counts.push_back(count);
+  }
+  thread_counts.push_back(max_threads);
+  std::printf("%llu items per run, up to %d threads, %d hardware threads\n",
+    static_cast<unsigned long long>(items),  // NOLINT
+    static_cast<int>(max_threads),
+    static_cast<int>(std::thread::hardware_concurrency()));
+
+  std::vector<Result> results;
+  RunPayloadSize<8>(thread_counts, items, &results);
+  RunPayloadSize<64>(thread_counts, items, &results);
+  RunPayloadSize<256>(thread_counts, items, &results);
+  RunBlockSize<64>(thread_counts, items, &results);
+  RunBlockSize<4080>(thread_counts, items, &results);
+
+  bool is_ok = WriteCsv(csv_file_name, results);
+  is_ok = WriteJson(json_file_name, results) && is_ok;
+  if (!is_ok) {
+    std::fprintf(stderr, "Can't write %s or %s\n", csv_file_name,
+      json_file_name);
+    return 1;
+  }
+  std::printf("Written %s and %s\n", csv_file_name, json_file_name);
+  return 0;
+}
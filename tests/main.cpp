@@ -2,15 +2,40 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
 #include <deque>
 #include <string>
 #include <iostream>
+#include <numeric>
 #include <sstream>
+#include <thread>
 
 #include "engine/arctic_types.h"
 #include "engine/arctic_platform.h"
+#include "engine/arctic_mixer.h"
+#include "engine/asset_pack.h"
 #include "engine/easy.h"
+#include "engine/easy_sprite_blend.h"
+#include "engine/log.h"
+#include "engine/mesh.h"
+#include "engine/mesh_gen_adjacency.h"
+#include "engine/mesh_gen_mod_complex.h"
+#include "engine/mesh_intersect.h"
+#include "engine/mesh_obj.h"
+#include "engine/mesh_optimize.h"
+#include "engine/mesh_parse.h"
+#include "engine/mesh_ply.h"
+#include "engine/mesh_subdiv.h"
+#include "engine/mtq_fixed_block_queue.h"
+#include "engine/mtq_mpmc_befsbfsp_allocator.h"
+#include "engine/mtq_mpsc_vinfarr.h"
 #include "engine/rgb.h"
+#include "engine/scene2f.h"
+#include "engine/sound_mix_kernels.h"
+#include "engine/sound_offline_mixer.h"
+#include "engine/sound_stream.h"
 #include <ctime>
 
 
@@ -437,10 +462,2044 @@ void test_rgba() {
   }
 }
 
+void test_blend_simd() {
+  std::independent_bits_engine<std::mt19937_64, 32, Ui32> rnd;
+  Sprite from;
+  from.Create(37, 29);
+  for (Si32 y = 0; y < from.Height(); ++y) {
+    for (Si32 x = 0; x < from.Width(); ++x) {
+      Rgba color(rnd());
+      Ui32 kind = rnd() % 4;
+      if (kind == 0 || x < 3) {
+        color.a = 0;
+      } else if (kind == 1) {
+        color.a = 255;
+      }
+      from.RgbaData()[y * from.StridePixels() + x] = color;
+    }
+  }
+  from.UpdateOpaqueSpans();
+
+  const BlendSimdLevel level = GetBlendSimdLevel();
+  const Vec2Si32 sizes[] = {from.Size(), Vec2Si32(80, 61), Vec2Si32(20, 13)};
+  for (Si32 simd = kBlendSimdSse2; simd < kBlendSimdLevelCount; ++simd) {
+    // Every level the cpu supports, the others fall back to the detected one.
+    const BlendSimdLevel simd_level = static_cast<BlendSimdLevel>(simd);
+    SetBlendSimdLevel(simd_level);
+    if (GetBlendSimdLevel() != simd_level) {
+      continue;
+    }
+    for (Si32 mode = 0; mode < 6; ++mode) {
+      for (Si32 filter = 0; filter < 2; ++filter) {
+        for (const Vec2Si32 &size : sizes) {
+          Sprite to_scalar;
+          to_scalar.Create(64, 48);
+          for (Si32 i = 0; i < to_scalar.Width() * to_scalar.Height(); ++i) {
+            to_scalar.RgbaData()[i].rgba = rnd();
+          }
+          Sprite to_simd;
+          to_simd.Clone(to_scalar);
+          const Rgba in_color(rnd());
+          const Vec2Si32 pos(Si32(rnd() % 80) - 20, Si32(rnd() % 60) - 15);
+
+          SetBlendSimdLevel(kBlendSimdScalar);
+          from.Draw(to_scalar, pos, size, static_cast<DrawBlendingMode>(mode),
+            static_cast<DrawFilterMode>(filter), in_color);
+          SetBlendSimdLevel(simd_level);
+          from.Draw(to_simd, pos, size, static_cast<DrawBlendingMode>(mode),
+            static_cast<DrawFilterMode>(filter), in_color);
+
+          for (Si32 i = 0; i < to_scalar.Width() * to_scalar.Height(); ++i) {
+            if (to_scalar.RgbaData()[i] != to_simd.RgbaData()[i]) {
+              TEST_CHECK_(false,
+                "mode=%d filter=%d level=%d pixel=%d %08x != %08x",
+                int(mode), int(filter), int(simd), int(i),
+                to_scalar.RgbaData()[i].rgba, to_simd.RgbaData()[i].rgba);
+              break;
+            }
+          }
+        }
+      }
+    }
+  }
+  SetBlendSimdLevel(level);
+}
+
+void test_clone_transforms() {
+  std::independent_bits_engine<std::mt19937_64, 32, Ui32> rnd;
+  Sprite whole;
+  whole.Create(83, 45);
+  for (Si32 i = 0; i < whole.Width() * whole.Height(); ++i) {
+    whole.RgbaData()[i].rgba = rnd();
+  }
+  Sprite part;
+  part.Reference(whole, 3, 5, 70, 37);
+  part.SetPivot(Vec2Si32(11, 7));
+
+  const BlendSimdLevel level = GetBlendSimdLevel();
+  const CloneTransform transforms[] = {kCloneRotateCw90, kCloneRotateCcw90,
+    kCloneRotate180, kCloneMirrorLr, kCloneMirrorUd};
+  for (Si32 pass = 0; pass < kBlendSimdLevelCount + 1; ++pass) {
+    // The last pass runs on the job system.
+    SetBlendSimdLevel(pass < kBlendSimdLevelCount ?
+      static_cast<BlendSimdLevel>(pass) : level);
+    SetSpriteJobPixelThreshold(pass < kBlendSimdLevelCount ? 0 : 1);
+    for (const Sprite &from : {whole, part}) {
+      const Si32 w = from.Width();
+      const Si32 h = from.Height();
+      for (CloneTransform transform : transforms) {
+        Sprite to;
+        to.Clone(from, transform);
+        const bool is_rotated =
+          (transform == kCloneRotateCw90 || transform == kCloneRotateCcw90);
+        TEST_CHECK(to.Size() == (is_rotated ? Vec2Si32(h, w) : from.Size()));
+        bool is_ok = true;
+        for (Si32 y = 0; y < h && is_ok; ++y) {
+          for (Si32 x = 0; x < w && is_ok; ++x) {
+            Vec2Si32 dst(x, y);
+            switch (transform) {
+              case kCloneRotateCw90: dst = Vec2Si32(y, w - 1 - x); break;
+              case kCloneRotateCcw90: dst = Vec2Si32(h - 1 - y, x); break;
+              case kCloneRotate180: dst = Vec2Si32(w - 1 - x, h - 1 - y); break;
+              case kCloneMirrorLr: dst = Vec2Si32(w - 1 - x, y); break;
+              default: dst = Vec2Si32(x, h - 1 - y); break;
+            }
+            is_ok = (to.RgbaData()[dst.y * to.StridePixels() + dst.x] ==
+              from.RgbaData()[y * from.StridePixels() + x]);
+            TEST_CHECK_(is_ok, "pass=%d transform=%d x=%d y=%d",
+              int(pass), int(transform), int(x), int(y));
+          }
+        }
+      }
+    }
+  }
+
+  for (Si32 fill_level = 0; fill_level < kBlendSimdLevelCount; ++fill_level) {
+    const FillRowFunction fill_row =
+      GetFillRowFunction(static_cast<BlendSimdLevel>(fill_level));
+    Rgba row[64];
+    for (Si32 offset = 0; offset < 8; ++offset) {
+      for (Si32 count = 0; count < 40; ++count) {
+        const Rgba color(rnd());
+        memset(static_cast<void*>(row), 0, sizeof(row));
+        fill_row(row + offset, count, color, (count & 1) != 0);
+        bool is_ok = true;
+        for (Si32 i = 0; i < 64; ++i) {
+          const bool is_filled = i >= offset && i < offset + count;
+          is_ok = is_ok && row[i] == (is_filled ? color : Rgba(0, 0, 0, 0));
+        }
+        TEST_CHECK_(is_ok, "level=%d offset=%d count=%d",
+          int(fill_level), int(offset), int(count));
+      }
+    }
+  }
+
+  // Clears of more than 16 MiB stream the pixels around the cache.
+  Sprite big;
+  big.Create(2053, 2049);
+  for (Si32 pass = 0; pass < 2; ++pass) {
+    SetSpriteJobPixelThreshold(pass ? 1 : 0);
+    const Rgba color(rnd());
+    big.Clear(color);
+    Si32 mismatch_count = 0;
+    for (Si32 y = 0; y < big.Height(); ++y) {
+      for (Si32 x = 0; x < big.Width(); ++x) {
+        mismatch_count +=
+          (big.RgbaData()[y * big.StridePixels() + x] != color) ? 1 : 0;
+      }
+    }
+    TEST_CHECK_(mismatch_count == 0, "pass=%d mismatch_count=%d",
+      int(pass), int(mismatch_count));
+  }
+  SetSpriteJobPixelThreshold(0);
+  SetBlendSimdLevel(level);
+}
+
+void test_pixel_runs() {
+  std::independent_bits_engine<std::mt19937_64, 32, Ui32> rnd;
+  Sprite runs;
+  runs.Create(75, 41);
+  for (Si32 y = 0; y < runs.Height(); ++y) {
+    Si32 x = 0;
+    while (x < runs.Width()) {
+      const Si32 length = Si32(rnd() % 12) + 1;
+      const Ui32 kind = rnd() % 3;
+      for (Si32 end = std::min(x + length, runs.Width()); x < end; ++x) {
+        Rgba color(rnd());
+        color.a = (kind == 0 ? 0 : kind == 1 ? 255 : color.a);
+        runs.RgbaData()[y * runs.StridePixels() + x] = color;
+      }
+    }
+  }
+  runs.UpdateOpaqueSpans();
+  Sprite plain;
+  plain.Clone(runs);
+  plain.ClearOpaqueSpans();
+  Sprite runs_ref;
+  runs_ref.Reference(runs, 9, 5, 50, 31);
+  Sprite plain_ref;
+  plain_ref.Reference(plain, 9, 5, 50, 31);
+
+  // The spans cover the pixels from the first to the last non-transparent.
+  TEST_CHECK(plain.Opaque().empty());
+  TEST_CHECK(runs.Opaque().size() == size_t(runs.Height()));
+  for (Si32 y = 0; y < runs.Height(); ++y) {
+    const Rgba *line = runs.RgbaData() + y * runs.StridePixels();
+    Si32 begin = 0;
+    while (begin < runs.Width() && line[begin].a == 0) {
+      ++begin;
+    }
+    Si32 end = runs.Width();
+    while (end > begin && line[end - 1].a == 0) {
+      --end;
+    }
+    const SpanSi32 &span = runs.Opaque()[size_t(y)];
+    TEST_CHECK(span.end == end);
+    TEST_CHECK(span.begin == (begin < end ? begin : 0));
+  }
+
+  // Drawing with the runs must not change a bit in any mode.
+  const DrawBlendingMode modes[] = {kDrawBlendingModeCopyRgba,
+    kDrawBlendingModeAlphaBlend, kDrawBlendingModeColorize,
+    kDrawBlendingModeAdd, kDrawBlendingModeSolidColor,
+    kDrawBlendingModePremultipliedAlphaBlend};
+  for (Si32 idx = 0; idx < 600; ++idx) {
+    const bool is_ref = (idx % 2 == 1);
+    Sprite from_runs = (is_ref ? runs_ref : runs);
+    Sprite from_plain = (is_ref ? plain_ref : plain);
+    const DrawBlendingMode mode = modes[rnd() % 6];
+    const Rgba in_color(rnd());
+    const Vec2Si32 from_pos(Si32(rnd() % 8), Si32(rnd() % 8));
+    const Vec2Si32 from_size = from_runs.Size() - from_pos -
+      Vec2Si32(Si32(rnd() % 8), Si32(rnd() % 8));
+    const Vec2Si32 to_size = (rnd() % 2 ? from_size :
+      Vec2Si32(Si32(rnd() % 150) + 1, Si32(rnd() % 90) + 1));
+    const Vec2Si32 pos(Si32(rnd() % 100) - 30, Si32(rnd() % 70) - 20);
+
+    Sprite to_runs;
+    to_runs.Create(64, 48);
+    for (Si32 i = 0; i < to_runs.Width() * to_runs.Height(); ++i) {
+      to_runs.RgbaData()[i].rgba = rnd();
+    }
+    Sprite to_plain;
+    to_plain.Clone(to_runs);
+    from_runs.Draw(to_runs, pos.x, pos.y, to_size.x, to_size.y,
+      from_pos.x, from_pos.y, from_size.x, from_size.y, mode,
+      kFilterNearest, in_color);
+    from_plain.Draw(to_plain, pos.x, pos.y, to_size.x, to_size.y,
+      from_pos.x, from_pos.y, from_size.x, from_size.y, mode,
+      kFilterNearest, in_color);
+    for (Si32 i = 0; i < to_runs.Width() * to_runs.Height(); ++i) {
+      if (to_runs.RgbaData()[i] != to_plain.RgbaData()[i]) {
+        TEST_CHECK_(false, "idx=%d mode=%d pixel=%d %08x != %08x",
+          int(idx), int(mode), int(i),
+          to_runs.RgbaData()[i].rgba, to_plain.RgbaData()[i].rgba);
+        break;
+      }
+    }
+  }
+}
+
+Ui32 DrawDeferredTestScene(Sprite to, Sprite from) {
+  std::independent_bits_engine<std::mt19937_64, 32, Ui32> rnd;
+  Ui32 checksum = 0;
+  Sprite ref;
+  ref.Reference(to, 10, 37, 120, 90);
+  to.Clear(Rgba(rnd()));
+  for (Si32 idx = 0; idx < 200; ++idx) {
+    Sprite dst = (rnd() % 4 == 0 ? ref : to);
+    const DrawBlendingMode mode = static_cast<DrawBlendingMode>(rnd() % 6);
+    const DrawFilterMode filter = static_cast<DrawFilterMode>(rnd() % 2);
+    const Rgba color(rnd());
+    const Vec2Si32 a(Si32(rnd() % 260) - 30, Si32(rnd() % 210) - 30);
+    const Vec2Si32 b(Si32(rnd() % 260) - 30, Si32(rnd() % 210) - 30);
+    const Vec2Si32 c(Si32(rnd() % 260) - 30, Si32(rnd() % 210) - 30);
+    switch (rnd() % 9) {
+      case 0:
+        from.Draw(dst, a, mode, filter, color);
+        break;
+      case 1:
+        from.Draw(dst, a, Vec2Si32(b.x / 2 + 1, b.y / 2 + 1), mode, filter,
+          color);
+        break;
+      case 2:
+        from.Draw(static_cast<float>(a.x), static_cast<float>(a.y),
+          static_cast<float>(rnd() % 628) * 0.01f,
+          static_cast<float>(rnd() % 300 + 10) * 0.01f, dst,
+          mode, filter, color);
+        break;
+      case 3:
+        DrawLine(dst, a, b, color, Rgba(rnd()));
+        break;
+      case 4:
+        DrawTriangle(dst, a, b, c, color, Rgba(rnd()), Rgba(rnd()));
+        break;
+      case 5:
+        DrawRectangle(dst, a, Vec2Si32(a.x + b.x / 4, a.y + b.y / 4), color);
+        break;
+      case 6:
+        SetPixel(dst, a.x, a.y, color);
+        break;
+      case 7:
+        checksum = checksum * 31 + GetPixel(to, a.x, a.y).rgba;
+        break;
+      case 8:
+        ReplaceColor(dst, GetPixel(dst, a.x, a.y), color);
+        break;
+    }
+  }
+  return checksum;
+}
+
+void test_deferred_drawing() {
+  std::independent_bits_engine<std::mt19937_64, 32, Ui32> rnd;
+  Sprite from;
+  from.Create(37, 29);
+  for (Si32 i = 0; i < from.Width() * from.Height(); ++i) {
+    from.RgbaData()[i].rgba = rnd();
+  }
+  from.UpdateOpaqueSpans();
+  from.SetPivot(Vec2Si32(11, 7));
+
+  Sprite immediate;
+  immediate.Create(200, 150);
+  const Ui32 immediate_checksum = DrawDeferredTestScene(immediate, from);
+
+  for (Si32 thread_count = 1; thread_count <= 4; thread_count += 3) {
+    Sprite deferred;
+    deferred.Create(200, 150);
+    SetDeferredDrawingThreadCount(thread_count);
+    SetDeferredDrawing(true, deferred);
+    const Ui32 deferred_checksum = DrawDeferredTestScene(deferred, from);
+    FlushDeferredDrawing();
+    SetDeferredDrawing(false, Sprite());
+    TEST_CHECK(immediate_checksum == deferred_checksum);
+    for (Si32 i = 0; i < immediate.Width() * immediate.Height(); ++i) {
+      if (immediate.RgbaData()[i] != deferred.RgbaData()[i]) {
+        TEST_CHECK_(false, "threads=%d pixel=%d %08x != %08x",
+          int(thread_count), int(i),
+          immediate.RgbaData()[i].rgba, deferred.RgbaData()[i].rgba);
+        break;
+      }
+    }
+  }
+  SetDeferredDrawingThreadCount(0);
+}
+
+
+static bool IsCoveredByDirtyRects(const DirtyRects &rects, Si32 x, Si32 y) {
+  for (Si32 idx = 0; idx < rects.Count(); ++idx) {
+    if (x >= rects[idx].x_begin && x < rects[idx].x_end &&
+        y >= rects[idx].y_begin && y < rects[idx].y_end) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void test_dirty_rects() {
+  DirtyRects rects;
+  TEST_CHECK(rects.IsEmpty());
+  rects.Add(10, 10, 10, 20);
+  TEST_CHECK(rects.IsEmpty());
+
+  rects.Add(0, 0, 10, 10);
+  rects.Add(20, 20, 30, 30);
+  TEST_CHECK(rects.Count() == 2);
+  // Overlapping rectangles merge.
+  rects.Add(5, 5, 25, 25);
+  TEST_CHECK(rects.Count() == 1);
+  TEST_CHECK(rects[0].x_begin == 0 && rects[0].y_begin == 0);
+  TEST_CHECK(rects[0].x_end == 30 && rects[0].y_end == 30);
+  rects.Clear();
+  TEST_CHECK(rects.IsEmpty());
+
+  // Rows touching each other merge without growing the area.
+  rects.Add(0, 0, 100, 1);
+  rects.Add(0, 1, 100, 2);
+  TEST_CHECK(rects.Count() == 1);
+  TEST_CHECK(rects[0].Area() == 200);
+  rects.Clear();
+
+  std::independent_bits_engine<std::mt19937_64, 32, Ui32> rnd;
+  std::vector<DirtyRects::Rect> added;
+  for (Si32 i = 0; i < 200; ++i) {
+    DirtyRects::Rect rect;
+    rect.x_begin = static_cast<Si32>(rnd() % 300);
+    rect.y_begin = static_cast<Si32>(rnd() % 200);
+    rect.x_end = rect.x_begin + 1 + static_cast<Si32>(rnd() % 8);
+    rect.y_end = rect.y_begin + 1 + static_cast<Si32>(rnd() % 8);
+    rects.Add(rect.x_begin, rect.y_begin, rect.x_end, rect.y_end);
+    added.push_back(rect);
+    TEST_CHECK(rects.Count() <= kMaxDirtyRects);
+  }
+  for (const DirtyRects::Rect &rect : added) {
+    for (Si32 y = rect.y_begin; y < rect.y_end; ++y) {
+      for (Si32 x = rect.x_begin; x < rect.x_end; ++x) {
+        TEST_CHECK(IsCoveredByDirtyRects(rects, x, y));
+      }
+    }
+  }
+  for (Si32 a = 0; a < rects.Count(); ++a) {
+    for (Si32 b = a + 1; b < rects.Count(); ++b) {
+      TEST_CHECK(rects[a].x_end <= rects[b].x_begin ||
+        rects[b].x_end <= rects[a].x_begin ||
+        rects[a].y_end <= rects[b].y_begin ||
+        rects[b].y_end <= rects[a].y_begin);
+    }
+  }
+}
+
+void test_sound_mix_kernels() {
+  std::independent_bits_engine<std::mt19937_64, 32, Ui32> rnd;
+  const SoundMixKernels &simd = GetSoundMixKernels();
+  const SoundMixKernels &scalar = GetScalarSoundMixKernels();
+  // Odd sizes leave a tail after the last full vector and the last block,
+  // loud voices drive both the compressor and the soft clipper.
+  const Si32 count = kSoundMixBlockFrames * 3 + 7;
+  std::vector<Si16> from(count * 2);
+  std::vector<float> l_scalar(count, 0.f);
+  std::vector<float> r_scalar(count, 0.f);
+  std::vector<float> l_simd(count, 0.f);
+  std::vector<float> r_simd(count, 0.f);
+  for (Si32 voice = 0; voice < 5; ++voice) {
+    for (Si16 &sample : from) {
+      sample = static_cast<Si16>(rnd());
+    }
+    const float volume = static_cast<float>(rnd() % 3000) / 32767000.f;
+    const Si32 size = count - voice * 13;
+    scalar.accumulate_stereo(l_scalar.data(), r_scalar.data(),
+      from.data(), size, volume);
+    simd.accumulate_stereo(l_simd.data(), r_simd.data(),
+      from.data(), size, volume);
+  }
+  for (Si32 i = 0; i < count; ++i) {
+    if (std::abs(l_scalar[i] - l_simd[i]) > 1e-5f ||
+        std::abs(r_scalar[i] - r_simd[i]) > 1e-5f) {
+      TEST_CHECK_(false, "accumulate frame=%d %f %f != %f %f", int(i),
+        l_scalar[i], r_scalar[i], l_simd[i], r_simd[i]);
+      break;
+    }
+  }
+
+  float level_scalar = 1.f;
+  float level_simd = 1.f;
+  scalar.compress_and_clip(l_scalar.data(), r_scalar.data(), count,
+    &level_scalar);
+  simd.compress_and_clip(l_simd.data(), r_simd.data(), count, &level_simd);
+  TEST_CHECK(std::abs(level_scalar - level_simd) < 1e-5f);
+  for (Si32 i = 0; i < count; ++i) {
+    TEST_CHECK(std::abs(l_scalar[i]) <= 1.f && std::abs(r_scalar[i]) <= 1.f);
+    if (std::abs(l_scalar[i] - l_simd[i]) > 1e-5f ||
+        std::abs(r_scalar[i] - r_simd[i]) > 1e-5f) {
+      TEST_CHECK_(false, "compress frame=%d %f %f != %f %f", int(i),
+        l_scalar[i], r_scalar[i], l_simd[i], r_simd[i]);
+      break;
+    }
+  }
+
+  std::vector<Si16> out_scalar(count * 2);
+  std::vector<Si16> out_simd(count * 2);
+  scalar.interleave_to_si16(out_scalar.data(), l_scalar.data(),
+    r_scalar.data(), count);
+  simd.interleave_to_si16(out_simd.data(), l_scalar.data(),
+    r_scalar.data(), count);
+  for (Si32 i = 0; i < count * 2; ++i) {
+    if (std::abs(out_scalar[i] - out_simd[i]) > 1) {
+      TEST_CHECK_(false, "interleave sample=%d %d != %d", int(i),
+        int(out_scalar[i]), int(out_simd[i]));
+      break;
+    }
+  }
+}
+
+void test_sound_frame_ring() {
+  SoundFrameRing ring;
+  ring.Reset(100);
+  TEST_CHECK(ring.BufferedFrames() == 0);
+  const Si32 kTotalFrames = 200000;
+  std::thread producer([&ring] {
+    std::independent_bits_engine<std::mt19937_64, 32, Ui32> rnd;
+    Si32 written = 0;
+    while (written < kTotalFrames) {
+      Si32 span_frames = 0;
+      Si16 *span = ring.WriteSpan(&span_frames);
+      span_frames = std::min(span_frames,
+        std::min(Si32(rnd() % 37), kTotalFrames - written));
+      for (Si32 i = 0; i < span_frames; ++i) {
+        span[i * 2] = static_cast<Si16>(written + i);
+        span[i * 2 + 1] = static_cast<Si16>(~(written + i));
+      }
+      ring.CommitWrite(span_frames);
+      written += span_frames;
+    }
+  });
+  std::independent_bits_engine<std::mt19937_64, 32, Ui32> rnd;
+  Si16 out[64 * 2];
+  Si32 read = 0;
+  bool is_ok = true;
+  // Keeps reading after a mismatch so the producer can finish.
+  while (read < kTotalFrames) {
+    const Si32 size = ring.Read(out, Si32(rnd() % 64));
+    TEST_CHECK(size <= ring.CapacityFrames());
+    for (Si32 i = 0; i < size && is_ok; ++i) {
+      is_ok = (out[i * 2] == static_cast<Si16>(read + i) &&
+        out[i * 2 + 1] == static_cast<Si16>(~(read + i)));
+      TEST_CHECK_(is_ok, "frame %d", int(read + i));
+    }
+    read += size;
+  }
+  producer.join();
+  TEST_CHECK(ring.BufferedFrames() == 0);
+}
+
+void test_make_wav() {
+  std::independent_bits_engine<std::mt19937_64, 32, Ui32> rnd;
+  const Si32 frames = 1001;
+  std::vector<Si16> samples(frames * 2);
+  for (Si16 &sample : samples) {
+    sample = static_cast<Si16>(rnd());
+  }
+  std::vector<Ui8> wav = MakeWav(samples.data(), frames);
+  TEST_CHECK(wav.size() == 44 + frames * 4);
+  std::shared_ptr<SoundInstance> instance = LoadWav(wav.data(),
+    static_cast<Si64>(wav.size()));
+  TEST_CHECK(instance != nullptr);
+  if (instance) {
+    TEST_CHECK(instance->GetDurationSamples() == frames);
+    TEST_CHECK(std::equal(samples.begin(), samples.end(),
+      instance->GetWavData()));
+  }
+}
+
+void test_sound_voice_table() {
+  SoundMixerState state;
+  Sound sounds[3];
+  for (Sound &sound : sounds) {
+    sound.Create(1.0);
+  }
+  std::vector<SoundHandle> handles;
+  for (Si32 idx = 0; idx < 300; ++idx) {
+    SoundTask *task = state.AllocateSoundTask();
+    task->sound = sounds[idx % 3];
+    task->sound.GetInstance()->IncPlaying();
+    task->action = SoundTaskAction::kStart3d;
+    task->is_playing = true;
+    handles.push_back(SoundHandle(task));
+    state.AddSoundTask(task);
+  }
+  state.InputTasksToMixerThread();
+  TEST_CHECK(state.buffers.size() == 300);
+
+  std::vector<Vec3F> positions;
+  for (Si32 idx = 0; idx < 300; ++idx) {
+    positions.push_back(Vec3F(static_cast<float>(idx), 1.f, 2.f));
+  }
+  SoundTask *batch = state.AllocateSoundTask();
+  for (Si32 idx = 0; idx < 300; ++idx) {
+    SoundLocationUpdate update;
+    update.target_task = handles[idx].GetSoundTask();
+    update.target_uid = handles[idx].GetUid();
+    update.position = positions[idx];
+    batch->location_updates.push_back(update);
+  }
+  batch->action = SoundTaskAction::kSetLocations;
+  state.AddSoundTask(batch);
+
+  for (Si32 idx = 0; idx < 300; idx += 10) {
+    SoundTask *stop = state.AllocateSoundTask();
+    stop->action = SoundTaskAction::kStop;
+    stop->target_uid = handles[idx].GetUid();
+    stop->target_task = handles[idx].GetSoundTask();
+    state.AddSoundTask(stop);
+  }
+  SoundTask *stop_all = state.AllocateSoundTask();
+  stop_all->sound = sounds[1];
+  stop_all->action = SoundTaskAction::kStop;
+  state.AddSoundTask(stop_all);
+  state.InputTasksToMixerThread();
+
+  Si32 expected = 0;
+  for (Si32 idx = 0; idx < 300; ++idx) {
+    const bool is_active = (idx % 10 != 0 && idx % 3 != 1);
+    expected += (is_active ? 1 : 0);
+    TEST_CHECK(handles[idx].IsValid() == is_active);
+    if (is_active) {
+      SoundTask *task = handles[idx].GetSoundTask();
+      TEST_CHECK(state.buffers[task->buffer_idx] == task);
+      TEST_CHECK(task->location.displacement.x == positions[idx].x);
+    }
+  }
+  TEST_CHECK(static_cast<Si32>(state.buffers.size()) == expected);
+  TEST_CHECK(sounds[1].GetInstance()->GetFirstVoice() == nullptr);
+  TEST_CHECK(!sounds[1].IsPlaying());
+  TEST_CHECK(sounds[0].IsPlaying());
+
+  // A stale handle must not reach the voice that reuses its task.
+  SoundTask *stale = state.AllocateSoundTask();
+  stale->action = SoundTaskAction::kStop;
+  stale->target_uid = handles[0].GetUid();
+  stale->target_task = handles[0].GetSoundTask();
+  state.AddSoundTask(stale);
+  state.InputTasksToMixerThread();
+  TEST_CHECK(static_cast<Si32>(state.buffers.size()) == expected);
+
+  // Reallocate the task of the stopped voice for a new voice.
+  SoundTask *old_task = handles[0].GetSoundTask();
+  std::vector<SoundTask*> skipped;
+  SoundTask *reused = state.AllocateSoundTask();
+  while (reused && reused != old_task) {
+    skipped.push_back(reused);
+    reused = state.AllocateSoundTask();
+  }
+  for (SoundTask *task : skipped) {
+    state.pool.enqueue(task);
+  }
+  TEST_CHECK(reused == old_task);
+  if (reused) {
+    reused->sound = sounds[0];
+    reused->sound.GetInstance()->IncPlaying();
+    reused->action = SoundTaskAction::kStart3d;
+    reused->is_playing = true;
+    reused->location.displacement = Vec3F(-5.f, 0.f, 0.f);
+    SoundHandle fresh(reused);
+    state.AddSoundTask(reused);
+    state.InputTasksToMixerThread();
+    TEST_CHECK(fresh.IsValid());
+    TEST_CHECK(!handles[0].IsValid());
+
+    SoundTask *stale_batch = state.AllocateSoundTask();
+    SoundLocationUpdate stale_update;
+    stale_update.target_task = handles[0].GetSoundTask();
+    stale_update.target_uid = handles[0].GetUid();
+    stale_update.position = Vec3F(1000.f, 0.f, 0.f);
+    stale_batch->location_updates.push_back(stale_update);
+    stale_batch->action = SoundTaskAction::kSetLocations;
+    state.AddSoundTask(stale_batch);
+    SoundTask *stale_stop = state.AllocateSoundTask();
+    stale_stop->action = SoundTaskAction::kStop;
+    stale_stop->target_uid = handles[0].GetUid();
+    stale_stop->target_task = handles[0].GetSoundTask();
+    state.AddSoundTask(stale_stop);
+    state.InputTasksToMixerThread();
+    TEST_CHECK(fresh.IsValid());
+    TEST_CHECK(static_cast<Si32>(state.buffers.size()) == expected + 1);
+    TEST_CHECK(state.buffers[reused->buffer_idx] == reused);
+    TEST_CHECK(reused->location.displacement.x == -5.f);
+  }
+  for (SoundTask *task : state.buffers) {
+    state.pool.enqueue(task);
+  }
+  state.buffers.clear();
+}
+
+void test_render_sound_blocks() {
+  Sound ramp;
+  ramp.Create(0.2);
+  for (Si32 i = 0; i < ramp.DurationSamples(); ++i) {
+    ramp.RawData()[i * 2] = static_cast<Si16>(i * 3);
+    ramp.RawData()[i * 2 + 1] = 0;
+  }
+  SoundListenerHead head;
+  head.loc.Clear();
+  head.UpdateEars();
+  SoundTask task;
+  task.sound = ramp;
+  task.is_3d = true;
+  task.location.displacement = Vec3F(0.3f, 0.f, 7.f);
+  std::vector<float> dst(4096, 0.f);
+  // The first period settles the delay ramp and the gain.
+  RenderSound<float>(&task, head, 0, dst.data(), 1, 2000, 44100.0, 1.f);
+  const ChannelPlaybackState before = task.channel_playback_state[0];
+  std::fill(dst.begin(), dst.end(), 0.f);
+  RenderSound<float>(&task, head, 0, dst.data(), 1, 1500, 44100.0, 1.f);
+  const ChannelPlaybackState &after = task.channel_playback_state[0];
+  TEST_CHECK(after.delay == before.delay);
+  // Linear interpolation reproduces a linear ramp between the samples.
+  const double pos_0 = (before.play_position - before.delay) * 44100.0;
+  for (Si32 i = 0; i < 1500; ++i) {
+    const float expected = static_cast<float>((pos_0 + i) * 3.0) * after.volume;
+    if (std::abs(dst[i] - expected) > std::abs(after.volume) * 0.05f) {
+      TEST_CHECK_(false, "sample %d %f != %f", int(i), dst[i], expected);
+      break;
+    }
+  }
+  task.sound.Clear();
+
+  SoundMixerState state;
+  state.head.loc.Clear();
+  state.head.UpdateEars();
+  Sound tone;
+  tone.Create(1.0);
+  const Vec3F positions[3] = {Vec3F(0.f, 0.f, 2.f), Vec3F(0.f, 0.f, 5.f),
+    Vec3F(0.f, 0.f, 50.f)};
+  SoundTask *voices[3];
+  for (Si32 idx = 0; idx < 3; ++idx) {
+    voices[idx] = state.AllocateSoundTask();
+    voices[idx]->sound = tone;
+    voices[idx]->sound.GetInstance()->IncPlaying();
+    voices[idx]->location.displacement = positions[idx];
+    voices[idx]->action = SoundTaskAction::kStart3d;
+    state.AddSoundTask(voices[idx]);
+  }
+  state.InputTasksToMixerThread();
+  state.max_3d_distance.store(20.f);
+  state.max_3d_voices.store(1);
+  state.Cull3dVoices();
+  TEST_CHECK(!voices[0]->is_culled);
+  TEST_CHECK(voices[1]->is_culled);
+  TEST_CHECK(voices[2]->is_culled);
+  state.max_3d_voices.store(0);
+  state.Cull3dVoices();
+  TEST_CHECK(!voices[1]->is_culled);
+  TEST_CHECK(voices[2]->is_culled);
+  std::vector<Si16> tmp(1024);
+  state.MixSoundPlanar(512, tmp.data());
+  for (SoundTask *voice : voices) {
+    TEST_CHECK(std::abs(voice->channel_playback_state[0].play_position -
+      512.0 / 44100.0) < 1e-9);
+  }
+  for (SoundTask *task_to_free : state.buffers) {
+    state.pool.enqueue(task_to_free);
+  }
+  state.buffers.clear();
+}
+
+
+void test_input_message() {
+  InputMessage::KeyStateBits bits;
+  for (Si32 key = 0; key < kKeyCount; ++key) {
+    TEST_CHECK(bits[key] == 0);
+  }
+  for (Si32 key = 0; key < kKeyCount; key += 3) {
+    bits.Set(key, true);
+  }
+  bits.Set(kKeyShift, true);
+  bits.Set(kKeyShift, false);
+  for (Si32 key = 0; key < kKeyCount; ++key) {
+    const Ui32 expected = (key % 3 == 0 && key != kKeyShift) ? 1u : 0u;
+    TEST_CHECK_(bits[key] == expected, "key %d", static_cast<int>(key));
+  }
+  // The key state snapshot keeps the message small enough to copy freely.
+  TEST_CHECK(sizeof(InputMessage) <= 256);
+
+  InputMessage in;
+  in.kind = InputMessage::kController;
+  in.keyboard.key = kKeyCount;
+  in.keyboard.state = bits;
+  in.keyboard.characters[0] = 'q';
+  in.mouse.wheel_delta = -3;
+  in.controller.controller_idx = 2;
+  in.controller.buttons = (1u << 0) | (1u << 27);
+  in.controller.axis[kAxis5] = 0.5f;
+  InputMessage out;
+  while (PopInputMessage(&out)) {
+  }
+  PushInputMessage(in);
+  TEST_CHECK(PopInputMessage(&out));
+  TEST_CHECK(out.kind == InputMessage::kController);
+  TEST_CHECK(out.keyboard.key == kKeyCount);
+  TEST_CHECK(out.keyboard.characters[0] == 'q');
+  TEST_CHECK(out.mouse.wheel_delta == -3);
+  TEST_CHECK(out.controller.controller_idx == 2);
+  TEST_CHECK(out.controller.buttons == ((1u << 0) | (1u << 27)));
+  TEST_CHECK(out.controller.axis[kAxis5] == 0.5f);
+  for (Si32 key = 0; key < kKeyCount; ++key) {
+    TEST_CHECK(out.keyboard.state[key] == bits[key]);
+  }
+  TEST_CHECK(!PopInputMessage(&out));
+}
+
+void test_hw_sprite_quad() {
+  std::vector<HwSpriteBatchVertex> vertices;
+  const Rgba color(10, 20, 30, 40);
+  AppendHwSpriteQuad(Vec2F(100.f, 50.f), Vec2F(2.f, 3.f), Vec2Si32(8, 4),
+    Vec2Si32(2, 1), 0.f, color, &vertices);
+  TEST_CHECK(vertices.size() == 6);
+  const Vec2F expected_pos[6] = {
+    Vec2F(96.f, 47.f), Vec2F(112.f, 47.f), Vec2F(112.f, 59.f),
+    Vec2F(96.f, 59.f), Vec2F(96.f, 47.f), Vec2F(112.f, 59.f)};
+  const Vec2F expected_tex[6] = {
+    Vec2F(0.f, 0.f), Vec2F(1.f, 0.f), Vec2F(1.f, 1.f),
+    Vec2F(0.f, 1.f), Vec2F(0.f, 0.f), Vec2F(1.f, 1.f)};
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    TEST_CHECK_(vertices[i].pos.x == expected_pos[i].x
+      && vertices[i].pos.y == expected_pos[i].y, "vertex %d", static_cast<int>(i));
+    TEST_CHECK(vertices[i].tex.x == expected_tex[i].x
+      && vertices[i].tex.y == expected_tex[i].y);
+    TEST_CHECK(vertices[i].color == color);
+  }
+
+  // A quarter turn keeps the pivot in place and rotates the corners around it.
+  AppendHwSpriteQuad(Vec2F(100.f, 50.f), Vec2F(1.f, 1.f), Vec2Si32(8, 4),
+    Vec2Si32(2, 1), 3.14159265f * 0.5f, color, &vertices);
+  TEST_CHECK(vertices.size() == 12);
+  const Vec2F rotated_pos[4] = {
+    Vec2F(101.f, 48.f), Vec2F(101.f, 56.f), Vec2F(97.f, 56.f), Vec2F(97.f, 48.f)};
+  for (Si32 i = 0; i < 4; ++i) {
+    const Vec2F pos = vertices[6 + static_cast<size_t>(i)].pos;
+    TEST_CHECK_(std::abs(pos.x - rotated_pos[i].x) < 0.001f
+      && std::abs(pos.y - rotated_pos[i].y) < 0.001f,
+      "corner %d %f %f", static_cast<int>(i), pos.x, pos.y);
+  }
+}
+
+void test_uniforms_table() {
+  TEST_CHECK(GlUniformValue(Vec2F(1.f, 2.f)) == GlUniformValue(Vec2F(1.f, 2.f)));
+  TEST_CHECK(GlUniformValue(Vec2F(1.f, 2.f)) != GlUniformValue(Vec2F(1.f, 3.f)));
+  TEST_CHECK(GlUniformValue(1) != GlUniformValue(1.f));
+  TEST_CHECK(GlUniformValue(0) != GlUniformValue(Vec4Si32(0, 0, 0, 0)));
+  GlUniformValue copy;
+  copy = GlUniformValue(Vec4F(1.f, 2.f, 3.f, 4.f));
+  TEST_CHECK(copy == GlUniformValue(Vec4F(1.f, 2.f, 3.f, 4.f)));
+  TEST_CHECK(copy.f[3] == 4.f);
+
+  UniformsTable table;
+  TEST_CHECK(table.Size() == 0);
+  table.SetUniform("tint", Vec4F(1.f, 1.f, 1.f, 1.f));
+  table.SetUniform("time", 0.5f);
+  table.SetUniform("tint", Vec4F(0.f, 1.f, 0.f, 1.f));
+  TEST_CHECK(table.Size() == 2);
+  UniformsTable table_copy = table;
+  TEST_CHECK(table_copy.Size() == 2);
+  table.Clear();
+  TEST_CHECK(table.Size() == 0);
+}
+
+void test_scene2f() {
+  Sprite sprite;
+  sprite.Create(4, 4);
+  sprite.Clear(Rgba(255, 0, 0));
+  sprite.SetPivot(Vec2Si32(2, 2));
+
+  Scene2F scene;
+  Si32 root = scene.AddNode();
+  Si32 a = scene.AddSpriteNode(sprite, root);
+  Si32 b = scene.AddSpriteNode(sprite, a);
+  Si32 c = scene.AddSpriteNode(sprite, root);
+  TEST_CHECK(scene.NodeCount() == 4);
+  scene.SetPosition(root, Vec2F(10.f, 20.f));
+  scene.SetPosition(a, Vec2F(5.f, 0.f));
+  Transform2F scaled;
+  scaled.scale = 2.f;
+  scaled.SetPosition(Vec2F(1.f, 1.f));
+  scene.SetTransform(b, scaled);
+  scene.Update();
+  TEST_CHECK(scene.UpdatedNodeCount() == 4);
+  Vec2F pos = scene.GetWorldTransform(b).dc.Transform(Vec2F(0.f, 0.f));
+  TEST_CHECK(pos.x == 16.f && pos.y == 21.f);
+  TEST_CHECK(scene.GetWorldTransform(b).scale == 2.f);
+
+  // Only the moved subtree is recomputed
+  scene.SetPosition(a, Vec2F(0.f, 5.f));
+  scene.SetPosition(b, Vec2F(2.f, 2.f));
+  scene.Update();
+  TEST_CHECK(scene.UpdatedNodeCount() == 2);
+  pos = scene.GetWorldTransform(b).dc.Transform(Vec2F(0.f, 0.f));
+  TEST_CHECK(pos.x == 12.f && pos.y == 27.f);
+
+  // Equal z orders keep the creation order
+  std::vector<Si32> expected = {root, a, b, c};
+  TEST_CHECK(scene.DrawOrder() == expected);
+  scene.SetZOrder(a, 1.f);
+  scene.Update();
+  expected = {root, b, c, a};
+  TEST_CHECK(scene.DrawOrder() == expected);
+  scene.SetRelativeZOrder(b, true);
+  scene.SetZOrder(b, -0.5f);
+  scene.SetZOrder(c, 0.25f);
+  scene.Update();
+  expected = {root, c, b, a};
+  TEST_CHECK(scene.DrawOrder() == expected);
+
+  Sprite target;
+  target.Create(32, 32);
+  target.Clear(Rgba(0, 0, 0));
+  scene.Draw(target);
+  TEST_CHECK(scene.DrawnNodeCount() == 3);
+  TEST_CHECK(target.RgbaData()[27 * target.StridePixels() + 12] ==
+    Rgba(255, 0, 0));
+  scene.SetPosition(root, Vec2F(100.f, 20.f));
+  scene.Draw(target);
+  TEST_CHECK(scene.DrawnNodeCount() == 0);
+  scene.SetPosition(root, Vec2F(10.f, 20.f));
+  scene.SetVisible(a, false);
+  scene.Draw(target);
+  TEST_CHECK(scene.DrawnNodeCount() == 1);
+
+  scene.RemoveNode(a);
+  TEST_CHECK(scene.NodeCount() == 2);
+  TEST_CHECK(!scene.IsAlive(a) && !scene.IsAlive(b));
+  Si32 d = scene.AddSpriteNode(sprite, c);
+  TEST_CHECK(scene.IsAlive(d));
+  scene.Update();
+  expected = {root, d, c};
+  TEST_CHECK(scene.DrawOrder() == expected);
+}
+
+void test_rotated_sprite() {
+  std::independent_bits_engine<std::mt19937_64, 32, Ui32> rnd;
+  // The sprite is a reference into a bigger one with a green frame
+  // that must never be drawn.
+  Sprite framed;
+  framed.Create(41, 35);
+  framed.Clear(Rgba(0, 255, 0));
+  Sprite from;
+  from.Reference(framed, 2, 3, 37, 29);
+  for (Si32 y = 0; y < from.Height(); ++y) {
+    for (Si32 x = 0; x < from.Width(); ++x) {
+      Rgba color(rnd());
+      color.g = 0;
+      Ui32 kind = rnd() % 4;
+      if (kind == 0 || x < 5 || y > 24) {
+        color.a = 0;
+      } else if (kind == 1) {
+        color.a = 255;
+      }
+      from.RgbaData()[y * from.StridePixels() + x] = color;
+    }
+  }
+  from.SetPivot(Vec2Si32(11, 7));
+  framed.UpdateOpaqueSpans();
+
+  // At angle 0 and zoom 1 it draws just like the unrotated sprite.
+  for (Si32 mode = 0; mode < 6; ++mode) {
+    Sprite expected;
+    expected.Create(64, 48);
+    expected.Clear(Rgba(0, 0, 0));
+    Sprite actual;
+    actual.Clone(expected);
+    from.Draw(expected, Vec2Si32(-3, 30), static_cast<DrawBlendingMode>(mode),
+      kFilterNearest, Rgba(200, 100, 50, 128));
+    from.Draw(-3.f, 30.f, 0.f, 1.f, actual,
+      static_cast<DrawBlendingMode>(mode), kFilterNearest,
+      Rgba(200, 100, 50, 128));
+    TEST_CHECK_(memcmp(expected.RgbaData(), actual.RgbaData(),
+      sizeof(Rgba) * 64 * 48) == 0, "mode=%d", int(mode));
+  }
+
+  Sprite plain;
+  plain.Create(from.Width(), from.Height());
+  from.Draw(plain, from.Pivot(), kDrawBlendingModeCopyRgba);
+  plain.SetPivot(from.Pivot());
+  plain.ClearOpaqueSpans();
+  const BlendSimdLevel level = DetectBlendSimdLevel();
+  for (Si32 idx = 0; idx < 40; ++idx) {
+    const DrawBlendingMode mode = static_cast<DrawBlendingMode>(rnd() % 6);
+    const DrawFilterMode filter = static_cast<DrawFilterMode>(rnd() % 2);
+    const Rgba in_color(rnd());
+    const float x = static_cast<float>(rnd() % 800) * 0.1f - 10.f;
+    const float y = static_cast<float>(rnd() % 600) * 0.1f - 10.f;
+    const float angle = static_cast<float>(rnd() % 628) * 0.01f;
+    const float zoom = static_cast<float>(rnd() % 300 + 20) * 0.01f;
+    Sprite to_scalar;
+    to_scalar.Create(64, 48);
+    for (Si32 i = 0; i < to_scalar.Width() * to_scalar.Height(); ++i) {
+      to_scalar.RgbaData()[i].rgba = rnd() & 0xffff00ffu;
+    }
+    Sprite to_simd;
+    to_simd.Clone(to_scalar);
+    Sprite to_plain;
+    to_plain.Clone(to_scalar);
+
+    SetBlendSimdLevel(kBlendSimdScalar);
+    from.Draw(x, y, angle, zoom, to_scalar, mode, filter, in_color);
+    SetBlendSimdLevel(level);
+    from.Draw(x, y, angle, zoom, to_simd, mode, filter, in_color);
+    // The opaque spans only skip work, they never change the result.
+    plain.Draw(x, y, angle, zoom, to_plain, mode, filter, in_color);
+
+    for (Si32 i = 0; i < to_scalar.Width() * to_scalar.Height(); ++i) {
+      if (to_scalar.RgbaData()[i] != to_simd.RgbaData()[i] ||
+          to_scalar.RgbaData()[i] != to_plain.RgbaData()[i]) {
+        TEST_CHECK_(false, "mode=%d filter=%d pixel=%d %08x %08x %08x",
+          int(mode), int(filter), int(i), to_scalar.RgbaData()[i].rgba,
+          to_simd.RgbaData()[i].rgba, to_plain.RgbaData()[i].rgba);
+        break;
+      }
+      if (to_scalar.RgbaData()[i].g != 0 &&
+          mode == kDrawBlendingModeCopyRgba && filter == kFilterNearest) {
+        TEST_CHECK_(false, "pixel=%d is from outside the sprite", int(i));
+        break;
+      }
+    }
+  }
+  SetBlendSimdLevel(level);
+}
+
+static Si32 CountLogLines(const std::string &text, const char *prefix) {
+  Si32 count = 0;
+  std::istringstream lines(text);
+  std::string line;
+  while (std::getline(lines, line)) {
+    if (line.compare(0, strlen(prefix), prefix) == 0) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+void test_logger() {
+  const std::string str("str");
+  const LogArg args[] = {LogArg(42), LogArg(-7LL), LogArg(2.5f),
+    LogArg("text"), LogArg(true), LogArg('c'), LogArg(str), LogArg(7u)};
+  TEST_CHECK(FormatLogMessage("a {} b {} c {} d {} e {} f {} g {} h {}",
+    args, 8) == "a 42 b -7 c 2.5 d text e true f c g str h 7");
+  TEST_CHECK(FormatLogMessage("{} only", args, 2) == "42 only -7");
+  TEST_CHECK(FormatLogMessage("{} {} {}", args, 1) == "42 {} {}");
+  TEST_CHECK(FormatLogMessage(nullptr, args + 3, 1) == "text");
+
+  const size_t log_size = ReadFile("log.txt", true).size();
+  const Ui64 dropped_before = GetLogDroppedMessageCount();
+  const Si32 kMessageCount = 20000;
+  SetLogThreadBufferSize(4096);
+  StartLogger();
+  // The small buffer overflows, with the drop policy each message
+  // is either written or counted as dropped.
+  SetLogOverflowPolicy(kLogOverflowDrop);
+  std::thread dropping([&]() {
+    for (Si32 idx = 0; idx < kMessageCount; ++idx) {
+      ARCTIC_LOG_INFO("logger drop {} {}", idx, 0.5);
+    }
+  });
+  dropping.join();
+  SetLogOverflowPolicy(kLogOverflowBlock);
+  std::thread blocking([&]() {
+    for (Si32 idx = 0; idx < kMessageCount; ++idx) {
+      ARCTIC_LOG_INFO("logger block {}", idx);
+    }
+  });
+  blocking.join();
+  SetLogLevel(kLogLevelWarning);
+  ARCTIC_LOG_INFO("logger level info");
+  ARCTIC_LOG_WARNING("logger level {}", "warning");
+  *Log() << "logger level stream";
+  Log("logger level plain");
+  SetLogLevel(kLogLevelTrace);
+  StopLogger();
+  SetLogThreadBufferSize(65536);
+
+  const std::vector<Ui8> data = ReadFile("log.txt", true);
+  TEST_CHECK(data.size() > log_size);
+  const std::string text(data.begin() + static_cast<std::ptrdiff_t>(
+    std::min(log_size, data.size())), data.end());
+  const Ui64 dropped = GetLogDroppedMessageCount() - dropped_before;
+  TEST_CHECK(static_cast<Ui64>(CountLogLines(text, "logger drop ")) +
+    dropped == static_cast<Ui64>(kMessageCount));
+  TEST_CHECK(CountLogLines(text, "logger block ") == kMessageCount);
+  TEST_CHECK(CountLogLines(text, "logger level info") == 0);
+  TEST_CHECK(CountLogLines(text, "[warning] logger level warning") == 1);
+  TEST_CHECK(CountLogLines(text, "logger level stream") == 0);
+  TEST_CHECK(CountLogLines(text, "logger level plain") == 0);
+  TEST_CHECK((CountLogLines(text, "Log dropped ") > 0) == (dropped > 0));
+}
+
+void test_asset_pack() {
+  std::independent_bits_engine<std::mt19937_64, 32, Ui32> rnd;
+  Sprite sprite;
+  sprite.Create(160, 120);
+  for (Si32 i = 0; i < sprite.Width() * sprite.Height(); ++i) {
+    sprite.RgbaData()[i].rgba = rnd();
+  }
+  sprite.Save("asset_pack_test.tga");
+  const Si32 frames = 1001;
+  std::vector<Si16> samples(frames * 2);
+  for (Si16 &sample : samples) {
+    sample = static_cast<Si16>(rnd());
+  }
+  std::vector<Ui8> wav = MakeWav(samples.data(), frames);
+  WriteFile("asset_pack_test.wav", wav.data(), wav.size());
+  std::vector<Ui8> text(1000, 'a');
+  WriteFile("asset_pack_test.txt", text.data(), text.size());
+  std::vector<std::string> file_names = {
+    "asset_pack_test.tga", "./asset_pack_test.wav", "asset_pack_test.txt"};
+  TEST_CHECK(WriteAssetPack("asset_pack_test_stored.pack", file_names, false));
+  TEST_CHECK(WriteAssetPack("asset_pack_test_deflated.pack", file_names,
+    true));
+  for (const std::string &file_name : file_names) {
+    std::remove(file_name.c_str());
+  }
+
+  for (const char *pack_name : {"asset_pack_test_stored.pack",
+      "asset_pack_test_deflated.pack"}) {
+    TEST_CHECK(MountAssetPack(pack_name));
+    PackedAsset asset;
+    TEST_CHECK(!FindPackedAsset("asset_pack_test.png", &asset));
+    Sprite packed_sprite;
+    packed_sprite.Load("asset_pack_test.tga");
+    TEST_CHECK(packed_sprite.Size() == sprite.Size());
+    if (packed_sprite.Size() == sprite.Size()) {
+      TEST_CHECK(std::equal(sprite.RgbaData(),
+        sprite.RgbaData() + sprite.Width() * sprite.Height(),
+        packed_sprite.RgbaData()));
+    }
+    // Drawing to a packed sprite must not affect the pack, so a stored sprite
+    // loaded again is copied.
+    const bool is_stored = std::string(pack_name) ==
+      "asset_pack_test_stored.pack";
+    packed_sprite.Clear(Rgba(1, 2, 3, 4));
+    const AssetPackStats stats_before_reload = GetAssetPackStats();
+    Sprite reloaded_sprite;
+    reloaded_sprite.Load("asset_pack_test.tga");
+    TEST_CHECK(reloaded_sprite.Size() == sprite.Size() &&
+      reloaded_sprite.RgbaData()[0] == sprite.RgbaData()[0]);
+    if (is_stored) {
+      TEST_CHECK(GetAssetPackStats().copy_count ==
+        stats_before_reload.copy_count + 1);
+    }
+    // The first load of a stored sound uses the pack view in place.
+    const AssetPackStats stats_before = GetAssetPackStats();
+    Sound sound;
+    sound.Load("asset_pack_test.wav");
+    const AssetPackStats stats_after = GetAssetPackStats();
+    TEST_CHECK(stats_after.copy_count == stats_before.copy_count);
+    if (is_stored) {
+      TEST_CHECK(stats_after.view_count == stats_before.view_count + 1);
+    }
+    TEST_CHECK(sound.DurationSamples() == frames);
+    if (sound.DurationSamples() == frames) {
+      TEST_CHECK(std::equal(samples.begin(), samples.end(), sound.RawData()));
+    }
+    TEST_CHECK(ReadFile("asset_pack_test.txt", true) == text);
+    UnmountAssetPacks();
+    TEST_CHECK(ReadFile("asset_pack_test.txt", true).empty());
+    // Loaded assets keep the pack data alive.
+    TEST_CHECK(reloaded_sprite.RgbaData()[0] == sprite.RgbaData()[0]);
+    std::remove(pack_name);
+  }
+}
+
+void test_async_loading() {
+  std::independent_bits_engine<std::mt19937_64, 32, Ui32> rnd;
+  const Si32 sprite_count = 8;
+  std::vector<std::string> sprite_names;
+  for (Si32 idx = 0; idx < sprite_count; ++idx) {
+    Sprite sprite;
+    sprite.Create(17 + idx * 5, 9 + idx * 3);
+    for (Si32 i = 0; i < sprite.Width() * sprite.Height(); ++i) {
+      sprite.RgbaData()[i].rgba = rnd();
+    }
+    std::stringstream name;
+    name << "async_loading_test_" << idx << ".tga";
+    sprite_names.push_back(name.str());
+    sprite.Save(sprite_names.back());
+  }
+  std::vector<Si16> samples(777 * 2);
+  for (Si16 &sample : samples) {
+    sample = static_cast<Si16>(rnd());
+  }
+  std::vector<Ui8> wav = MakeWav(samples.data(), 777);
+  WriteFile("async_loading_test.wav", wav.data(), wav.size());
+
+  SetAsyncLoadingThreadCount(3);
+  std::vector<AsyncAsset<Sprite>> sprites;
+  for (const std::string &name : sprite_names) {
+    sprites.push_back(LoadSpriteAsync(name));
+  }
+  AsyncAsset<Sound> sound = LoadSoundAsync("async_loading_test.wav");
+  TEST_CHECK(GetAsyncLoadCount() == sprite_count + 1);
+  for (Si32 idx = 0; idx < sprite_count; ++idx) {
+    Sprite expected;
+    expected.Load(sprite_names[static_cast<size_t>(idx)]);
+    Sprite &loaded = sprites[static_cast<size_t>(idx)].Get();
+    TEST_CHECK(sprites[static_cast<size_t>(idx)].IsReady());
+    TEST_CHECK(loaded.Size() == expected.Size());
+    if (loaded.Size() == expected.Size()) {
+      TEST_CHECK(std::equal(expected.RgbaData(),
+        expected.RgbaData() + expected.Width() * expected.Height(),
+        loaded.RgbaData()));
+    }
+  }
+  WaitForAsyncLoading();
+  TEST_CHECK(IsAsyncLoadingDone());
+  TEST_CHECK(GetAsyncLoadReadyCount() == sprite_count + 1);
+  TEST_CHECK(sound.IsReady());
+  TEST_CHECK(sound.Get().DurationSamples() == 777);
+  if (sound.Get().DurationSamples() == 777) {
+    TEST_CHECK(std::equal(samples.begin(), samples.end(),
+      sound.Get().RawData()));
+  }
+
+  // A load after the batch was seen done starts a new batch.
+  AsyncAsset<Sprite> sprite = LoadSpriteAsync(sprite_names[0]);
+  TEST_CHECK(GetAsyncLoadCount() == 1);
+  sprite.Get();
+  TEST_CHECK(GetAsyncLoadReadyCount() == 1);
+  SetAsyncLoadingThreadCount(0);
+  for (const std::string &name : sprite_names) {
+    std::remove(name.c_str());
+  }
+  std::remove("async_loading_test.wav");
+}
+
+void test_job_system() {
+  StartJobSystem(3);
+  TEST_CHECK(GetJobWorkerCount() == 3);
+
+  std::atomic<Si64> sum(0);
+  JobCounter counter;
+  TEST_CHECK(counter.IsDone());
+  for (Si32 idx = 1; idx <= 1000; ++idx) {
+    RunJob([&sum, &counter, idx]() {
+      // Jobs started by the jobs are counted by the same counter.
+      RunJob([&sum, idx]() {
+        sum.fetch_add(idx);
+      }, &counter);
+    }, &counter);
+  }
+  WaitForJobs(counter);
+  TEST_CHECK(sum.load() == 500500);
+
+  // A payload too large for the job record goes to the heap.
+  std::array<Si64, 32> big;
+  for (size_t idx = 0; idx < big.size(); ++idx) {
+    big[idx] = static_cast<Si64>(idx);
+  }
+  std::vector<Si64> values(256, 0);
+  JobCounter values_counter;
+  for (size_t idx = 0; idx < values.size(); ++idx) {
+    RunJob([&values, big, idx]() {
+      values[idx] = static_cast<Si64>(idx) + big[idx % big.size()];
+    }, &values_counter);
+  }
+  Si64 total = 0;
+  JobCounter total_counter;
+  RunJobAfter(&values_counter, [&values, &total]() {
+    total = std::accumulate(values.begin(), values.end(), Si64(0));
+  }, &total_counter);
+  WaitForJobs(total_counter);
+  TEST_CHECK(values_counter.IsDone());
+  TEST_CHECK(total == 255 * 256 / 2 + 8 * 31 * 32 / 2);
+
+  // Main thread jobs started by the workers run on the waiting main thread.
+  std::vector<std::thread::id> thread_ids(16);
+  JobCounter main_counter;
+  for (size_t idx = 0; idx < thread_ids.size(); ++idx) {
+    RunJob([&thread_ids, &main_counter, idx]() {
+      RunMainThreadJob([&thread_ids, idx]() {
+        thread_ids[idx] = std::this_thread::get_id();
+      }, &main_counter);
+    }, &main_counter);
+  }
+  WaitForJobs(main_counter);
+  for (const std::thread::id &id : thread_ids) {
+    TEST_CHECK(id == std::this_thread::get_id());
+  }
+
+  for (Si32 grain = 0; grain <= 7; grain += 7) {
+    std::vector<Si32> items(10007, -1);
+    std::atomic<bool> is_grain_ok(true);
+    ParallelFor(0, static_cast<Si32>(items.size()), grain,
+      [&items, &is_grain_ok, grain](Si32 from, Si32 to) {
+        if (from >= to || (grain && to - from > grain)) {
+          is_grain_ok = false;
+        }
+        for (Si32 idx = from; idx < to; ++idx) {
+          items[static_cast<size_t>(idx)] += idx * 3 + 1;
+        }
+      });
+    TEST_CHECK(is_grain_ok.load());
+    bool is_ok = true;
+    for (size_t idx = 0; idx < items.size(); ++idx) {
+      is_ok = is_ok && items[idx] == static_cast<Si32>(idx) * 3;
+    }
+    TEST_CHECK(is_ok);
+  }
+  bool is_empty_range_called = false;
+  ParallelFor(5, 5, 1, [&is_empty_range_called](Si32, Si32) {
+    is_empty_range_called = true;
+  });
+  TEST_CHECK(!is_empty_range_called);
+
+  // A counter reused by several threads keeps dropping to 0 and rising again.
+  JobCounter reused_counter;
+  std::atomic<Si32> reused_sum(0);
+  for (Si32 round = 1; round <= 20; ++round) {
+    std::vector<std::thread> pushers;
+    for (Si32 thread_idx = 0; thread_idx < 4; ++thread_idx) {
+      pushers.emplace_back([&reused_sum, &reused_counter]() {
+        for (Si32 idx = 0; idx < 500; ++idx) {
+          RunJob([&reused_sum]() {
+            reused_sum.fetch_add(1);
+          }, &reused_counter);
+        }
+      });
+    }
+    for (std::thread &pusher : pushers) {
+      pusher.join();
+    }
+    WaitForJobs(reused_counter);
+    TEST_CHECK(reused_sum.load() == round * 4 * 500);
+  }
+
+  StopJobSystem();
+  TEST_CHECK(GetJobWorkerCount() == 0);
+}
+
+void test_mtq_queues() {
+  MpmcBestEffortFixedSizeBufferFixedSizePool<8, 4080> pool;
+  // 64 byte items do not fit a single 4080 byte block 256 at a time.
+  struct Item {
+    Ui64 words[8];
+  };
+  FixedBlockQueue<Item> fifo;
+  bool is_fifo_ok = true;
+  for (Ui64 burst = 0; burst < 4; ++burst) {
+    for (Ui64 idx = 0; idx < 256; ++idx) {
+      Item item;
+      std::fill(std::begin(item.words), std::end(item.words), idx);
+      fifo.push_back(item, &pool);
+    }
+    for (Ui64 idx = 0; idx < 256; ++idx) {
+      is_fifo_ok = is_fifo_ok && !fifo.empty() &&
+        fifo.front(&pool).words[7] == idx;
+      fifo.pop_front(&pool);
+    }
+    is_fifo_ok = is_fifo_ok && fifo.empty();
+  }
+  TEST_CHECK(is_fifo_ok);
+
+  MpscVirtInfArray<Item, TuneDeletePayloadFlag<false>,
+    TuneMemoryPoolFlag<true>> pooled(&pool);
+  MpscVirtInfArray<Item, TuneDeletePayloadFlag<false>,
+    TuneMemoryPoolFlag<false>> unpooled(64);
+  bool is_mpsc_ok = true;
+  for (Ui64 idx = 0; idx < 1000; ++idx) {
+    Item item;
+    std::fill(std::begin(item.words), std::end(item.words), idx);
+    pooled.enqueue(item);
+    unpooled.enqueue(item);
+  }
+  for (Ui64 idx = 0; idx < 1000; ++idx) {
+    Item item;
+    is_mpsc_ok = is_mpsc_ok && pooled.dequeue(&item) && item.words[7] == idx;
+    is_mpsc_ok = is_mpsc_ok && unpooled.dequeue(&item) &&
+      item.words[0] == idx;
+  }
+  Item item;
+  TEST_CHECK(!pooled.dequeue(&item));
+  TEST_CHECK(!unpooled.dequeue(&item));
+  TEST_CHECK(is_mpsc_ok);
+}
+
+void test_mesh_bvh() {
+  std::mt19937 rnd(7);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  // A bumpy grid with a few stray faces above it, large enough for
+  // the parallel build to split the root.
+  const int grid = 50;
+  const int stray_count = 200;
+  const int vertex_count = (grid + 1) * (grid + 1) + stray_count * 3;
+  const int face_count = grid * grid * 2 + stray_count;
+  MeshVertexFormat format;
+  format.mStride = sizeof(Vec3F);
+  format.mNumElems = 1;
+  format.mElems[0].mNumComponents = 3;
+  format.mElems[0].mType = kRMVEDT_Float;
+  Mesh mesh;
+  TEST_CHECK(mesh.Init(1, vertex_count, &format, kRMVEDT_Polys, 1, face_count));
+  Vec3F *vertices = static_cast<Vec3F*>(mesh.mVertexData.mVertexArray[0].mBuffer);
+  for (int y = 0; y <= grid; ++y) {
+    for (int x = 0; x <= grid; ++x) {
+      vertices[y * (grid + 1) + x] = Vec3F(static_cast<float>(x),
+        static_cast<float>(y), unit(rnd));
+    }
+  }
+  MeshFace *faces = mesh.mFaceData.mIndexArray[0].mBuffer;
+  for (int y = 0; y < grid; ++y) {
+    for (int x = 0; x < grid; ++x) {
+      const int v = y * (grid + 1) + x;
+      MeshFace *face = faces + (y * grid + x) * 2;
+      face[0].mIndex[0] = v;
+      face[0].mIndex[1] = v + 1;
+      face[0].mIndex[2] = v + grid + 2;
+      face[1].mIndex[0] = v;
+      face[1].mIndex[1] = v + grid + 2;
+      face[1].mIndex[2] = v + grid + 1;
+    }
+  }
+  for (int i = 0; i < stray_count; ++i) {
+    const int v = (grid + 1) * (grid + 1) + i * 3;
+    const Vec3F center(unit(rnd) * 20.0f + 20.0f, unit(rnd) * 20.0f + 20.0f,
+      unit(rnd) * 3.0f + 4.0f);
+    for (int j = 0; j < 3; ++j) {
+      vertices[v + j] = center + Vec3F(unit(rnd), unit(rnd), unit(rnd));
+      faces[grid * grid * 2 + i].mIndex[j] = v + j;
+    }
+  }
+
+  const int ray_count = 500;
+  std::vector<Vec3F> origins(ray_count);
+  std::vector<Vec3F> directions(ray_count);
+  for (int i = 0; i < ray_count; ++i) {
+    origins[i] = Vec3F(unit(rnd) * 25.0f + 20.0f, unit(rnd) * 25.0f + 20.0f,
+      10.0f);
+    directions[i] = Vec3F(unit(rnd), unit(rnd), -1.0f - unit(rnd));
+    if (i % 5 == 0) {
+      // Straight down through the grid vertices and edges.
+      origins[i] = Vec3F(static_cast<float>(i % grid),
+        static_cast<float>(i / 5 % grid) + 0.5f * static_cast<float>(i % 2),
+        10.0f);
+      directions[i] = Vec3F(0.0f, 0.0f, -1.0f);
+    }
+  }
+
+  for (int pass = 0; pass < 2; ++pass) {
+    MeshBvh bvh;
+    TEST_CHECK(MeshBvh_Init(&bvh, &mesh, 0, 0, pass == 1));
+    for (int refit = 0; refit < 2; ++refit) {
+      if (refit) {
+        for (int i = 0; i < vertex_count; ++i) {
+          vertices[i].z += std::sin(vertices[i].x * 0.3f) * 2.0f;
+        }
+        MeshBvh_Refit(&bvh);
+      }
+      std::vector<MeshRayHit> packet_hits(ray_count);
+      const int packet_hit_count = MeshBvh_IntersectPacket(&bvh,
+        origins.data(), directions.data(), ray_count, 0.0f, 100.0f,
+        packet_hits.data());
+      int hit_count = 0;
+      for (int i = 0; i < ray_count; ++i) {
+        MeshRayHit expected;
+        MeshRayHit hit;
+        const bool is_expected = Mesh_Intersect(&mesh, origins[i],
+          directions[i], 0.0f, 100.0f, &expected);
+        const bool is_hit = MeshBvh_Intersect(&bvh, origins[i],
+          directions[i], 0.0f, 100.0f, &hit);
+        hit_count += is_hit ? 1 : 0;
+        TEST_CHECK_(is_hit == is_expected, "pass=%d refit=%d ray=%d",
+          pass, refit, i);
+        TEST_CHECK(MeshBvh_IntersectAny(&bvh, origins[i], directions[i],
+          0.0f, 100.0f) == is_expected);
+        TEST_CHECK((packet_hits[i].mFaceID >= 0) == is_expected);
+        if (!is_hit || !is_expected) {
+          continue;
+        }
+        // The faces sharing the hit edge may round to the next float.
+        TEST_CHECK_(std::fabs(hit.mT - expected.mT) <= 1e-6f * expected.mT,
+          "pass=%d refit=%d ray=%d", pass, refit, i);
+        TEST_CHECK(std::fabs(packet_hits[i].mT - expected.mT) <=
+          1e-5f * expected.mT);
+        // The face and the barycentrics point at the hit.
+        const MeshFace &face = faces[hit.mFaceID];
+        const Vec3F v0 = vertices[face.mIndex[0]];
+        const Vec3F on_face = v0 + (vertices[face.mIndex[1]] - v0) * hit.mU +
+          (vertices[face.mIndex[2]] - v0) * hit.mV;
+        TEST_CHECK(Length(on_face - (origins[i] + directions[i] * hit.mT)) <
+          1e-3f);
+      }
+      TEST_CHECK(packet_hit_count == hit_count);
+      TEST_CHECK(hit_count > ray_count / 2);
+    }
+    MeshBvh_DeInit(&bvh);
+    for (int i = 0; i < vertex_count; ++i) {
+      vertices[i].z -= std::sin(vertices[i].x * 0.3f) * 2.0f;
+    }
+  }
+  mesh.DeInit();
+}
+
+void test_mesh_half_edges() {
+  // A grid of 8x8 quads, two faces each, with every other vertex raised.
+  const int grid = 8;
+  const int vertex_count = (grid + 1) * (grid + 1);
+  const int face_count = grid * grid * 2;
+  MeshVertexFormat format;
+  format.mStride = sizeof(Vec3F);
+  format.mNumElems = 1;
+  format.mElems[0].mNumComponents = 3;
+  format.mElems[0].mType = kRMVEDT_Float;
+  Mesh mesh;
+  TEST_CHECK(mesh.Init(1, vertex_count, &format, kRMVEDT_Polys, 1, face_count));
+  Vec3F *vertices = static_cast<Vec3F*>(mesh.mVertexData.mVertexArray[0].mBuffer);
+  MeshFace *faces = mesh.mFaceData.mIndexArray[0].mBuffer;
+  for (int y = 0; y <= grid; ++y) {
+    for (int x = 0; x <= grid; ++x) {
+      vertices[y * (grid + 1) + x] = Vec3F(static_cast<float>(x),
+        static_cast<float>(y), ((x + y) % 2) * 0.5f);
+    }
+  }
+  for (int y = 0; y < grid; ++y) {
+    for (int x = 0; x < grid; ++x) {
+      const int v = y * (grid + 1) + x;
+      MeshFace *face = faces + (y * grid + x) * 2;
+      face[0].mIndex[0] = v;
+      face[0].mIndex[1] = v + 1;
+      face[0].mIndex[2] = v + grid + 2;
+      face[1].mIndex[0] = v;
+      face[1].mIndex[1] = v + grid + 2;
+      face[1].mIndex[2] = v + grid + 1;
+    }
+  }
+
+  MeshHalfEdges he;
+  TEST_CHECK(MeshHalfEdges_Init(&he, &mesh));
+  const int edge_count = grid * (grid + 1) * 2 + grid * grid;
+  TEST_CHECK(he.mNumEdges == edge_count);
+  int border_count = 0;
+  for (int h = 0; h < face_count * 3; ++h) {
+    if (he.mTwin[h] == -1) {
+      ++border_count;
+    } else {
+      TEST_CHECK(he.mTwin[he.mTwin[h]] == h);
+      TEST_CHECK(he.mEdge[he.mTwin[h]] == he.mEdge[h]);
+      TEST_CHECK(MeshHalfEdges_GetVertex(&he, he.mTwin[h]) ==
+        MeshHalfEdges_GetVertex(&he, MeshHalfEdges_GetNext(h)));
+    }
+  }
+  TEST_CHECK(border_count == grid * 4);
+  const int center = (grid / 2) * (grid + 1) + grid / 2;
+  const int diagonal = MeshHalfEdges_FindEdge(&he, center, center + grid + 2);
+  TEST_CHECK(diagonal != -1);
+  TEST_CHECK(MeshHalfEdges_FindEdge(&he, center + grid + 2, center) == diagonal);
+  TEST_CHECK(MeshHalfEdges_FindEdge(&he, center, center + grid) == -1);
+  int edge_faces[2];
+  TEST_CHECK(MeshHalfEdges_GetEdgeFaces(&he, diagonal, edge_faces) == 2);
+  TEST_CHECK(MeshHalfEdges_GetEdgeFaces(&he,
+    MeshHalfEdges_FindEdge(&he, 0, 1), edge_faces) == 1);
+  TEST_CHECK(edge_faces[0] == 0);
+  int vertex_face_count = 0;
+  MeshHalfEdges_GetVertexFaces(&he, center, &vertex_face_count);
+  TEST_CHECK(vertex_face_count == 6);
+  int ring[16];
+  TEST_CHECK(MeshHalfEdges_GetOneRing(&he, center, ring, 16) == 6);
+  std::sort(ring, ring + 6);
+  const int expected_ring[6] = {center - grid - 2, center - grid - 1, center - 1,
+    center + 1, center + grid + 1, center + grid + 2};
+  TEST_CHECK(std::equal(ring, ring + 6, expected_ring));
+  TEST_CHECK(MeshHalfEdges_GetOneRing(&he, 0, ring, 16) == 3);
+  MeshHalfEdges_DeInit(&he);
+
+  // Every subdivided vertex is a convex combination of the old ones.
+  TEST_CHECK(Mesh_Subdivide(&mesh, 2, 0));
+  const int sub_vertex_count = vertex_count + face_count + edge_count;
+  const int sub_edge_count = edge_count * 2 + face_count * 6;
+  TEST_CHECK(mesh.mFaceData.mIndexArray[0].mNum == face_count * 36);
+  TEST_CHECK(mesh.mVertexData.mVertexArray[0].mNum ==
+    sub_vertex_count + face_count * 6 + sub_edge_count);
+  vertices = static_cast<Vec3F*>(mesh.mVertexData.mVertexArray[0].mBuffer);
+  for (Ui32 i = 0; i < mesh.mVertexData.mVertexArray[0].mNum; ++i) {
+    const Vec3F &v = vertices[i];
+    TEST_CHECK_(v.x >= 0.0f && v.x <= grid && v.y >= 0.0f && v.y <= grid &&
+      v.z >= 0.0f && v.z <= 0.5f, "vertex %u (%f %f %f)", i, v.x, v.y, v.z);
+  }
+
+  // The pieces keep every face with its positions and only their vertices.
+  Mesh pieces[4];
+  int piece_count = 0;
+  TEST_CHECK(Mesh_Split(pieces, &mesh, 2, 2, 1, &piece_count));
+  TEST_CHECK(piece_count == 4);
+  Ui32 split_face_count = 0;
+  double split_sum[3] = {0.0, 0.0, 0.0};
+  for (int p = 0; p < piece_count; ++p) {
+    const int num_faces = pieces[p].mFaceData.mIndexArray[0].mNum;
+    const int num_vertices = pieces[p].mVertexData.mVertexArray[0].mNum;
+    const Vec3F *piece_vertices =
+      static_cast<Vec3F*>(pieces[p].mVertexData.mVertexArray[0].mBuffer);
+    std::vector<char> is_used(num_vertices, 0);
+    for (int i = 0; i < num_faces; ++i) {
+      for (int k = 0; k < 3; ++k) {
+        const int v = pieces[p].mFaceData.mIndexArray[0].mBuffer[i].mIndex[k];
+        TEST_CHECK(v >= 0 && v < num_vertices);
+        is_used[v] = 1;
+        split_sum[0] += piece_vertices[v].x;
+        split_sum[1] += piece_vertices[v].y;
+        split_sum[2] += piece_vertices[v].z;
+      }
+    }
+    TEST_CHECK(std::count(is_used.begin(), is_used.end(), 1) == num_vertices);
+    split_face_count += num_faces;
+    pieces[p].DeInit();
+  }
+  double sum[3] = {0.0, 0.0, 0.0};
+  for (Ui32 i = 0; i < mesh.mFaceData.mIndexArray[0].mNum; ++i) {
+    for (int k = 0; k < 3; ++k) {
+      const Vec3F &v =
+        vertices[mesh.mFaceData.mIndexArray[0].mBuffer[i].mIndex[k]];
+      sum[0] += v.x;
+      sum[1] += v.y;
+      sum[2] += v.z;
+    }
+  }
+  TEST_CHECK(split_face_count == mesh.mFaceData.mIndexArray[0].mNum);
+  TEST_CHECK(std::abs(split_sum[0] - sum[0]) < 1e-6 * sum[0] &&
+    std::abs(split_sum[1] - sum[1]) < 1e-6 * sum[1] &&
+    std::abs(split_sum[2] - sum[2]) < 1e-6 * sum[2]);
+  mesh.DeInit();
+}
+
+void CheckImportedGrid(Mesh *mesh, int grid, const std::vector<Vec3F> &positions,
+    const std::vector<Vec3F> &normals, const std::vector<Vec2F> &uvs,
+    const char *name) {
+  TEST_CHECK_(mesh->mFaceData.mIndexArray[0].mNum ==
+    static_cast<unsigned>(grid * grid * 2), "%s face count", name);
+  TEST_CHECK_(mesh->mVertexData.mVertexArray[0].mNum == positions.size(),
+    "%s vertex count", name);
+  TEST_CHECK_(mesh->mVertexData.mVertexArray[0].mFormat.mNumElems == 3,
+    "%s vertex format", name);
+  if (mesh->mFaceData.mIndexArray[0].mNum !=
+      static_cast<unsigned>(grid * grid * 2) ||
+      mesh->mVertexData.mVertexArray[0].mFormat.mNumElems != 3) {
+    return;
+  }
+  const int vertex_count = mesh->mVertexData.mVertexArray[0].mNum;
+  int error_count = 0;
+  for (int i = 0; i < grid * grid * 2 && error_count < 4; ++i) {
+    const int v = (i / 2 / grid) * (grid + 1) + (i / 2 % grid);
+    const int quad[4] = {v, v + 1, v + grid + 2, v + grid + 1};
+    const int expected[3] = {quad[0], quad[1 + i % 2], quad[2 + i % 2]};
+    for (int k = 0; k < 3; ++k) {
+      const int id = mesh->mFaceData.mIndexArray[0].mBuffer[i].mIndex[k];
+      if (id < 0 || id >= vertex_count) {
+        TEST_CHECK_(false, "%s face %d index %d", name, i, id);
+        ++error_count;
+        break;
+      }
+      const Vec3F &pos = *static_cast<Vec3F*>(mesh->GetVertexData(0, id, 0));
+      const Vec3F &nor = *static_cast<Vec3F*>(mesh->GetVertexData(0, id, 1));
+      const Vec2F &uv = *static_cast<Vec2F*>(mesh->GetVertexData(0, id, 2));
+      const Vec3F &pos_expected = positions[expected[k]];
+      const Vec3F &nor_expected = normals[expected[k]];
+      const Vec2F &uv_expected = uvs[expected[k]];
+      if (Length(pos - pos_expected) > 1e-5f ||
+          Length(nor - nor_expected) > 1e-6f ||
+          std::abs(uv.x - uv_expected.x) > 1e-6f ||
+          std::abs(uv.y - uv_expected.y) > 1e-6f) {
+        TEST_CHECK_(false, "%s face %d corner %d", name, i, k);
+        ++error_count;
+      }
+    }
+  }
+}
+
+void test_mesh_import() {
+  for (const char *number : {"0", "-0.5", "3.25e-3", "1E+10", "123456789012",
+      ".5", "7.", "-1.17549435e-38", "3.40282347e+38", "0.1", "2.7182818284590452354",
+      "0.000000000000000000000000000000000000000001", "+12e-2"}) {
+    float value = 0.0f;
+    const char *end = number + std::strlen(number);
+    TEST_CHECK(MeshParse_Float(number, end, &value) == end);
+    const float expected = std::strtof(number, nullptr);
+    TEST_CHECK_(value == expected ||
+      std::nextafter(value, expected) == expected, "%s %.9g != %.9g",
+      number, value, expected);
+  }
+  float dummy = 0.0f;
+  for (const char *number : {"-", "e5", ".", ""}) {
+    TEST_CHECK(MeshParse_Float(number, number + std::strlen(number),
+      &dummy) == nullptr);
+  }
+
+  // A grid of quads, large enough for several parsing chunks.
+  std::mt19937 rnd(11);
+  std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+  const int grid = 120;
+  const int vertex_count = (grid + 1) * (grid + 1);
+  std::vector<Vec3F> positions(vertex_count);
+  std::vector<Vec3F> normals(vertex_count);
+  std::vector<Vec2F> uvs(vertex_count);
+  for (int y = 0; y <= grid; ++y) {
+    for (int x = 0; x <= grid; ++x) {
+      const int v = y * (grid + 1) + x;
+      positions[v] = Vec3F(static_cast<float>(x), static_cast<float>(y),
+        unit(rnd));
+      normals[v] = Normalize(Vec3F(unit(rnd), unit(rnd), 1.5f));
+      uvs[v] = Vec2F(static_cast<float>(x) / grid, static_cast<float>(y) / grid);
+    }
+  }
+  char line[256];
+
+  // The faces use the absolute and the relative indices.
+  std::string obj = "# import test\n";
+  for (const Vec3F &p : positions) {
+    snprintf(line, sizeof(line), "v %.9g %.9g %.9g\n", p.x, p.y, p.z);
+    obj += line;
+  }
+  for (int v = 0; v < vertex_count; ++v) {
+    snprintf(line, sizeof(line), "vt %.9g %.9g\r\nvn %.9g %.9g %.9g\n",
+      uvs[v].x, uvs[v].y, normals[v].x, normals[v].y, normals[v].z);
+    obj += line;
+  }
+  for (int y = 0; y < grid; ++y) {
+    for (int x = 0; x < grid; ++x) {
+      const int v = y * (grid + 1) + x;
+      const int quad[4] = {v, v + 1, v + grid + 2, v + grid + 1};
+      obj += "f";
+      for (int k = 0; k < 4; ++k) {
+        const int id = (x % 2) ? quad[k] + 1 : quad[k] - vertex_count;
+        snprintf(line, sizeof(line), " %d/%d/%d", id, id, id);
+        obj += line;
+      }
+      obj += "\n";
+    }
+  }
+  WriteFile("mesh_import_test.obj",
+    reinterpret_cast<const Ui8*>(obj.data()), obj.size());
+  Mesh mesh;
+  if (MeshObj_Read(&mesh, "mesh_import_test.obj", false)) {
+    CheckImportedGrid(&mesh, grid, positions, normals, uvs, "obj");
+    mesh.DeInit();
+  } else {
+    TEST_CHECK_(false, "obj");
+  }
+  // A corner with another uv makes another vertex.
+  const std::string quad = "v 0 0 0\nv 1 0 0\nv 1 1 0\nv 0 1 0\n"
+    "vt 0 0\nvt 1 0\nvt 1 1\nvt 0 1\nvt 0.5 0.5\n"
+    "f 1/1 2/2 3/3\nf 1/5 3/3 4/4 # comment\n";
+  WriteFile("mesh_import_test.obj",
+    reinterpret_cast<const Ui8*>(quad.data()), quad.size());
+  if (MeshObj_Read(&mesh, "mesh_import_test.obj", true)) {
+    const MeshFace *faces = mesh.mFaceData.mIndexArray[0].mBuffer;
+    TEST_CHECK(mesh.mVertexData.mVertexArray[0].mNum == 5);
+    TEST_CHECK(mesh.mFaceData.mIndexArray[0].mNum == 2);
+    TEST_CHECK(faces[0].mIndex[2] == faces[1].mIndex[1]);
+    TEST_CHECK(faces[0].mIndex[0] != faces[1].mIndex[0]);
+    const Vec2F &uv =
+      *static_cast<Vec2F*>(mesh.GetVertexData(0, faces[1].mIndex[0], 2));
+    TEST_CHECK(uv.x == 0.5f && uv.y == 0.5f);
+    for (int i = 0; i < 5; ++i) {
+      const Vec3F &normal = *static_cast<Vec3F*>(mesh.GetVertexData(0, i, 1));
+      TEST_CHECK(Length(normal - Vec3F(0.0f, 0.0f, 1.0f)) < 1e-6f);
+    }
+    mesh.DeInit();
+  } else {
+    TEST_CHECK_(false, "obj quad");
+  }
+  const std::string broken = "v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 4\n";
+  WriteFile("mesh_import_test.obj",
+    reinterpret_cast<const Ui8*>(broken.data()), broken.size());
+  TEST_CHECK(!MeshObj_Read(&mesh, "mesh_import_test.obj", false));
+  std::remove("mesh_import_test.obj");
+
+  // Ascii quads, and the triangles in both byte orders, with the positions
+  // as doubles and a property and an element to skip.
+  for (int format = 0; format < 3; ++format) {
+    const bool is_big_endian = (format == 2);
+    std::string ply = "ply\nformat ";
+    ply += (format == 0) ? "ascii" :
+      (is_big_endian ? "binary_big_endian" : "binary_little_endian");
+    char header[512];
+    snprintf(header, sizeof(header), " 1.0\ncomment import test\n"
+      "element vertex %d\nproperty double x\nproperty double y\n"
+      "property double z\nproperty uchar red\nproperty float nx\n"
+      "property float ny\nproperty float nz\nproperty float u\n"
+      "property float v\nelement face %d\n"
+      "property list uchar int vertex_indices\nelement edge 1\n"
+      "property list uchar uint vertex_pair\nend_header\n",
+      vertex_count, (format == 0) ? grid * grid : grid * grid * 2);
+    ply += header;
+    std::vector<Ui8> body;
+    auto put = [&](const void *value, size_t size) {
+      const Ui8 *bytes = static_cast<const Ui8*>(value);
+      for (size_t i = 0; i < size; ++i) {
+        body.push_back(bytes[is_big_endian ? size - 1 - i : i]);
+      }
+    };
+    for (int v = 0; v < vertex_count; ++v) {
+      const double xyz[3] = {positions[v].x, positions[v].y, positions[v].z};
+      const float rest[5] = {normals[v].x, normals[v].y, normals[v].z,
+        uvs[v].x, uvs[v].y};
+      if (format == 0) {
+        snprintf(line, sizeof(line), "%.17g %.17g %.17g 255 %.9g %.9g %.9g "
+          "%.9g %.9g\n", xyz[0], xyz[1], xyz[2], rest[0], rest[1], rest[2],
+          rest[3], rest[4]);
+        ply += line;
+      } else {
+        for (double value : xyz) {
+          put(&value, sizeof(value));
+        }
+        body.push_back(255);
+        for (float value : rest) {
+          put(&value, sizeof(value));
+        }
+      }
+    }
+    for (int y = 0; y < grid; ++y) {
+      for (int x = 0; x < grid; ++x) {
+        const int v = y * (grid + 1) + x;
+        const int quad[4] = {v, v + 1, v + grid + 2, v + grid + 1};
+        if (format == 0) {
+          snprintf(line, sizeof(line), "4 %d %d %d %d\n",
+            quad[0], quad[1], quad[2], quad[3]);
+          ply += line;
+        } else {
+          for (int t = 0; t < 2; ++t) {
+            const int triangle[3] = {quad[0], quad[1 + t], quad[2 + t]};
+            body.push_back(3);
+            for (int id : triangle) {
+              put(&id, sizeof(id));
+            }
+          }
+        }
+      }
+    }
+    if (format == 0) {
+      ply += "2 0 1\n";
+    } else {
+      body.push_back(2);
+      const Ui32 pair[2] = {0, 1};
+      put(&pair[0], sizeof(Ui32));
+      put(&pair[1], sizeof(Ui32));
+    }
+    ply.append(reinterpret_cast<const char*>(body.data()), body.size());
+    WriteFile("mesh_import_test.ply",
+      reinterpret_cast<const Ui8*>(ply.data()), ply.size());
+    const bool is_read = MeshPly_Read(&mesh, "mesh_import_test.ply", false);
+    TEST_CHECK_(is_read, "ply format %d", format);
+    if (is_read) {
+      CheckImportedGrid(&mesh, grid, positions, normals, uvs,
+        (format == 0) ? "ply ascii" : "ply binary");
+      mesh.DeInit();
+    }
+    // the truncated files are rejected
+    WriteFile("mesh_import_test.ply",
+      reinterpret_cast<const Ui8*>(ply.data()), ply.size() - 20);
+    TEST_CHECK(!MeshPly_Read(&mesh, "mesh_import_test.ply", false));
+  }
+  std::remove("mesh_import_test.ply");
+}
+
+void test_mesh_subdivision() {
+  // An octahedron with positions and uvs.
+  MeshVertexFormat format;
+  format.mStride = 5 * sizeof(float);
+  format.mNumElems = 2;
+  format.mElems[0].mNumComponents = 3;
+  format.mElems[0].mType = kRMVEDT_Float;
+  format.mElems[1].mNumComponents = 2;
+  format.mElems[1].mType = kRMVEDT_Float;
+  const float corners[6][3] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0},
+    {0, 0, 1}, {0, 0, -1}};
+  const int triangles[8][3] = {{0, 2, 4}, {2, 1, 4}, {1, 3, 4}, {3, 0, 4},
+    {2, 0, 5}, {1, 2, 5}, {3, 1, 5}, {0, 3, 5}};
+  Mesh cage;
+  TEST_CHECK(cage.Init(1, 6, &format, kRMVEDT_Polys, 1, 8));
+  for (int i = 0; i < 6; ++i) {
+    float *vertex = static_cast<float*>(cage.GetVertexData(0, i, 0));
+    memcpy(vertex, corners[i], sizeof(corners[i]));
+    vertex[3] = corners[i][0] * 0.5f + 0.5f;
+    vertex[4] = corners[i][1] * 0.5f + 0.5f;
+  }
+  for (int i = 0; i < 8; ++i) {
+    memcpy(cage.mFaceData.mIndexArray[0].mBuffer[i].mIndex, triangles[i],
+      sizeof(triangles[i]));
+  }
+
+  MeshSubdiv subdiv;
+  TEST_CHECK(MeshSubdiv_Init(&subdiv, &cage, kMeshSubdivLoop, 2, nullptr,
+    false));
+  TEST_CHECK(subdiv.mNumVerts == 66);
+  TEST_CHECK(subdiv.mNumFaces == 128);
+  TEST_CHECK(subdiv.mNumFloats == 5);
+  for (int l = 0; l < subdiv.mNumLevels; ++l) {
+    const MeshSubdivLevel &level = subdiv.mLevels[l];
+    for (int i = 0; i < level.mNumVerts; ++i) {
+      float sum = 0.0f;
+      for (int s = level.mStencilStart[i]; s < level.mStencilStart[i + 1];
+          ++s) {
+        TEST_CHECK(level.mStencilWeight[s] > 0.0f);
+        TEST_CHECK(level.mStencilSrc[s] < level.mNumSrcVerts);
+        sum += level.mStencilWeight[s];
+      }
+      TEST_CHECK_(std::abs(sum - 1.0f) < 1e-5f, "level %d vertex %d sum %f",
+        l, i, sum);
+    }
+  }
+  Mesh refined;
+  TEST_CHECK(MeshSubdiv_InitMesh(&subdiv, &refined));
+  MeshSubdiv_Evaluate(&subdiv, &cage, &refined);
+  MeshHalfEdges he;
+  TEST_CHECK(MeshHalfEdges_Init(&he, &refined));
+  TEST_CHECK(he.mNumEdges == 66 + 128 - 2);
+  TEST_CHECK(std::count(he.mTwin, he.mTwin + 128 * 3, -1) == 0);
+  MeshHalfEdges_DeInit(&he);
+  const float corner_radius =
+    Length(*static_cast<Vec3F*>(refined.GetVertexData(0, 0, 0)));
+  for (int i = 0; i < 66; ++i) {
+    const float radius =
+      Length(*static_cast<Vec3F*>(refined.GetVertexData(0, i, 0)));
+    TEST_CHECK(radius > 0.4f && radius <= 1.0f);
+    if (i < 6) {
+      TEST_CHECK(std::abs(radius - corner_radius) < 1e-6f);
+    }
+    const float *uv = static_cast<float*>(refined.GetVertexData(0, i, 1));
+    TEST_CHECK(uv[0] >= 0.0f && uv[0] <= 1.0f && uv[1] >= 0.0f && uv[1] <= 1.0f);
+  }
+
+  // The same stencils follow the moving cage, on the job system as well.
+  Mesh moved;
+  TEST_CHECK(cage.Clone(&moved));
+  for (int i = 0; i < 6; ++i) {
+    Vec3F *position = static_cast<Vec3F*>(moved.GetVertexData(0, i, 0));
+    *position = *position * 2.0f + Vec3F(1.0f, -3.0f, 0.5f);
+  }
+  MeshSubdiv parallel_subdiv;
+  TEST_CHECK(MeshSubdiv_Init(&parallel_subdiv, &cage, kMeshSubdivLoop, 2,
+    nullptr, true));
+  Mesh animated;
+  Mesh parallel_animated;
+  TEST_CHECK(MeshSubdiv_InitMesh(&subdiv, &animated));
+  TEST_CHECK(MeshSubdiv_InitMesh(&parallel_subdiv, &parallel_animated));
+  MeshSubdiv_Evaluate(&subdiv, &moved, &animated);
+  MeshSubdiv_Evaluate(&parallel_subdiv, &moved, &parallel_animated);
+  TEST_CHECK(memcmp(animated.mVertexData.mVertexArray[0].mBuffer,
+    parallel_animated.mVertexData.mVertexArray[0].mBuffer,
+    66 * format.mStride) == 0);
+  for (int i = 0; i < 66; ++i) {
+    const Vec3F expected =
+      *static_cast<Vec3F*>(refined.GetVertexData(0, i, 0)) * 2.0f +
+      Vec3F(1.0f, -3.0f, 0.5f);
+    TEST_CHECK(Length(*static_cast<Vec3F*>(animated.GetVertexData(0, i, 0)) -
+      expected) < 1e-5f);
+  }
+  MeshSubdiv_DeInit(&parallel_subdiv);
+  MeshSubdiv_DeInit(&subdiv);
+  parallel_animated.DeInit();
+  animated.DeInit();
+  moved.DeInit();
+  refined.DeInit();
+
+  // Refining a single face leaves no cracks around it.
+  for (int scheme = kMeshSubdivLoop; scheme <= kMeshSubdivLinear; ++scheme) {
+    const int face_levels[8] = {3, 1, 0, 0, 0, 0, 0, 0};
+    TEST_CHECK(MeshSubdiv_Init(&subdiv, &cage, scheme, 3, face_levels, true));
+    TEST_CHECK(subdiv.mNumFaces > 8 && subdiv.mNumFaces < 8 * 6 * 6 * 6);
+    TEST_CHECK(MeshSubdiv_InitMesh(&subdiv, &refined));
+    MeshSubdiv_Evaluate(&subdiv, &cage, &refined);
+    TEST_CHECK(MeshHalfEdges_Init(&he, &refined));
+    TEST_CHECK(subdiv.mNumVerts - he.mNumEdges + subdiv.mNumFaces == 2);
+    TEST_CHECK(std::count(he.mTwin, he.mTwin + subdiv.mNumFaces * 3, -1) == 0);
+    for (int e = 0; e < he.mNumEdges; ++e) {
+      TEST_CHECK(he.mEdgeValence[e] == 2);
+    }
+    MeshHalfEdges_DeInit(&he);
+    for (int i = 0; i < subdiv.mNumVerts; ++i) {
+      const float radius =
+        Length(*static_cast<Vec3F*>(refined.GetVertexData(0, i, 0)));
+      TEST_CHECK(radius > 0.3f && radius <= 1.0f + 1e-6f);
+    }
+    MeshSubdiv_DeInit(&subdiv);
+    refined.DeInit();
+  }
+
+  // The tessellation keeps the cage vertices where they are.
+  TEST_CHECK(Mesh_Subdivide(&cage, 1, SUBD_TE));
+  TEST_CHECK(cage.mFaceData.mIndexArray[0].mNum == 48);
+  for (int i = 0; i < 6; ++i) {
+    const float *position = static_cast<float*>(cage.GetVertexData(0, i, 0));
+    TEST_CHECK(memcmp(position, corners[i], sizeof(corners[i])) == 0);
+  }
+  cage.DeInit();
+}
+
+void test_mesh_optimize() {
+  // A shuffled grid, positions only.
+  MeshVertexFormat format;
+  format.mStride = 3 * sizeof(float);
+  format.mNumElems = 1;
+  format.mElems[0].mNumComponents = 3;
+  format.mElems[0].mType = kRMVEDT_Float;
+  const int size = 64;
+  const int num_verts = (size + 1) * (size + 1);
+  const int num_faces = size * size * 2;
+  Mesh mesh;
+  TEST_CHECK(mesh.Init(1, num_verts, &format, kRMVEDT_Polys, 1, num_faces));
+  for (int i = 0; i < num_verts; ++i) {
+    float *position = static_cast<float*>(mesh.GetVertexData(0, i, 0));
+    position[0] = static_cast<float>(i % (size + 1));
+    position[1] = static_cast<float>(i / (size + 1));
+    position[2] = 0.0f;
+  }
+  MeshFace *faces = mesh.mFaceData.mIndexArray[0].mBuffer;
+  for (int y = 0; y < size; ++y) {
+    for (int x = 0; x < size; ++x) {
+      const int v = y * (size + 1) + x;
+      const MeshFace a = {{v, v + 1, v + size + 2}};
+      const MeshFace b = {{v, v + size + 2, v + size + 1}};
+      faces[(y * size + x) * 2] = a;
+      faces[(y * size + x) * 2 + 1] = b;
+    }
+  }
+  std::independent_bits_engine<std::mt19937_64, 32, Ui32> rnd;
+  for (int i = num_faces - 1; i > 0; --i) {
+    std::swap(faces[i], faces[rnd() % (i + 1)]);
+  }
+  auto face_key = [&mesh](const MeshFace &face) {
+    // the grid cells of the corners, rotated to start at the lowest one
+    int key[3];
+    for (int k = 0; k < 3; ++k) {
+      const float *position =
+        static_cast<float*>(mesh.GetVertexData(0, face.mIndex[k], 0));
+      key[k] = static_cast<int>(position[1]) * (size + 1) +
+        static_cast<int>(position[0]);
+    }
+    const int first = static_cast<int>(std::min_element(key, key + 3) - key);
+    return static_cast<Ui64>(key[first]) << 40 |
+      static_cast<Ui64>(key[(first + 1) % 3]) << 20 |
+      static_cast<Ui64>(key[(first + 2) % 3]);
+  };
+  std::vector<Ui64> keys;
+  for (int i = 0; i < num_faces; ++i) {
+    keys.push_back(face_key(faces[i]));
+  }
+  std::sort(keys.begin(), keys.end());
+
+  MeshOptimizeStats before;
+  MeshOptimizeStats after;
+  TEST_CHECK(MeshOptimize_Process(&mesh, 16, 1.05f, &before, &after));
+  TEST_CHECK(before.mNumFaces == num_faces && after.mNumFaces == num_faces);
+  TEST_CHECK(before.mNumVerts == num_verts && after.mNumVerts == num_verts);
+  TEST_CHECK(before.mAcmr > 2.0f);
+  TEST_CHECK_(after.mAcmr < 0.8f, "acmr %f", after.mAcmr);
+  TEST_CHECK_(after.mAtvr < 1.6f, "atvr %f", after.mAtvr);
+
+  // Same faces with the same winding, the vertices in first use order.
+  faces = mesh.mFaceData.mIndexArray[0].mBuffer;
+  std::vector<Ui64> optimized_keys;
+  int next_vertex = 0;
+  for (int i = 0; i < num_faces; ++i) {
+    optimized_keys.push_back(face_key(faces[i]));
+    for (int k = 0; k < 3; ++k) {
+      TEST_CHECK(faces[i].mIndex[k] <= next_vertex);
+      if (faces[i].mIndex[k] == next_vertex) {
+        ++next_vertex;
+      }
+    }
+  }
+  std::sort(optimized_keys.begin(), optimized_keys.end());
+  TEST_CHECK(keys == optimized_keys);
+  TEST_CHECK(next_vertex == num_verts);
+  mesh.DeInit();
+}
 
 TEST_LIST = {
 //  {"Tga oom", test_tga_oom},
   {"Rgba", test_rgba},
+  {"Blend simd", test_blend_simd},
+  {"Clone transforms", test_clone_transforms},
+  {"Rotated sprite", test_rotated_sprite},
+  {"Pixel runs", test_pixel_runs},
+  {"Deferred drawing", test_deferred_drawing},
+  {"Dirty rects", test_dirty_rects},
+  {"Sound mix kernels", test_sound_mix_kernels},
+  {"Sound frame ring", test_sound_frame_ring},
+  {"Make wav", test_make_wav},
+  {"Asset pack", test_asset_pack},
+  {"Async loading", test_async_loading},
+  {"Job system", test_job_system},
+  {"Mtq queues", test_mtq_queues},
+  {"Sound voice table", test_sound_voice_table},
+  {"Render sound blocks", test_render_sound_blocks},
+  {"Input message", test_input_message},
+  {"Hw sprite quad", test_hw_sprite_quad},
+  {"Uniforms table", test_uniforms_table},
+  {"Scene2F", test_scene2f},
+  {"Mesh bvh", test_mesh_bvh},
+  {"Mesh half edges", test_mesh_half_edges},
+  {"Mesh import", test_mesh_import},
+  {"Mesh subdivision", test_mesh_subdivision},
+  {"Mesh optimize", test_mesh_optimize},
+  {"Logger", test_logger},
   {"Radix sort", test_radix_sort},
   {"Radix sort correctness", test_radix_sort_correctness},
   {"Rgb", test_rgb},